@@ -0,0 +1,82 @@
+#include "calibration.h"
+#include <math.h>
+
+LiveSpiffCalibration* calibration_new(const char *source, gint64 first_beat_us, gint64 interval_us, guint beats) {
+  LiveSpiffCalibration *c = g_new0(LiveSpiffCalibration, 1);
+  c->source = g_strdup(source);
+  c->first_beat_us = first_beat_us;
+  c->interval_us = MAX(interval_us, 1);
+  c->beats = beats;
+  // The first beats are for finding the rhythm
+  c->warmup_beats = MIN(2, beats / 4);
+  c->last_beat = -1;
+  c->offsets_us = g_array_new(FALSE, FALSE, sizeof(gint64));
+  return c;
+}
+
+void calibration_free(LiveSpiffCalibration *c) {
+  if (!c) return;
+  g_free(c->source);
+  g_array_free(c->offsets_us, TRUE);
+  g_free(c);
+}
+
+gint64 calibration_beat_us(const LiveSpiffCalibration *c, guint beat) {
+  return c->first_beat_us + (gint64)beat * c->interval_us;
+}
+
+gint64 calibration_end_us(const LiveSpiffCalibration *c) {
+  // Half a beat after the last one: later taps belong to no beat
+  return calibration_beat_us(c, c->beats ? c->beats - 1 : 0) + c->interval_us / 2;
+}
+
+gboolean calibration_tap(LiveSpiffCalibration *c, gint64 tap_us) {
+  gint64 rel = tap_us - c->first_beat_us;
+  // Nearest beat, rounding half away from the earlier beat
+  gint64 beat = (rel + c->interval_us / 2) / c->interval_us;
+  if (rel < -c->interval_us / 2) return FALSE;
+  if (beat < (gint64)c->warmup_beats || beat >= (gint64)c->beats) return FALSE;
+  if (beat <= c->last_beat) return FALSE;
+
+  gint64 offset = tap_us - calibration_beat_us(c, (guint)beat);
+  g_array_append_val(c->offsets_us, offset);
+  c->last_beat = (gint)beat;
+  return TRUE;
+}
+
+static gint compare_i64(gconstpointer a, gconstpointer b) {
+  gint64 x = *(const gint64*)a, y = *(const gint64*)b;
+  return (x > y) - (x < y);
+}
+
+gboolean calibration_result(const LiveSpiffCalibration *c, gint64 *out_offset_us, gint64 *out_jitter_us, guint *out_taps) {
+  guint n = c->offsets_us->len;
+  if (out_taps) *out_taps = 0;
+  if (n < CALIBRATION_MIN_TAPS) return FALSE;
+
+  GArray *sorted = g_array_sized_new(FALSE, FALSE, sizeof(gint64), n);
+  g_array_append_vals(sorted, c->offsets_us->data, n);
+  g_array_sort(sorted, compare_i64);
+  gint64 median = g_array_index(sorted, gint64, n / 2);
+  g_array_free(sorted, TRUE);
+
+  // Missed or doubled beats show up as outliers; keep taps near the median
+  gint64 window = c->interval_us / 4;
+  double sum = 0, sum_sq = 0;
+  guint kept = 0;
+  for (guint i = 0; i < n; i++) {
+    gint64 off = g_array_index(c->offsets_us, gint64, i);
+    if (ABS(off - median) > window) continue;
+    sum += (double)off;
+    sum_sq += (double)off * (double)off;
+    kept++;
+  }
+  if (kept < CALIBRATION_MIN_TAPS) return FALSE;
+
+  double mean = sum / kept;
+  double var = sum_sq / kept - mean * mean;
+  if (out_offset_us) *out_offset_us = (gint64)llround(mean);
+  if (out_jitter_us) *out_jitter_us = (gint64)llround(sqrt(var > 0 ? var : 0));
+  if (out_taps) *out_taps = kept;
+  return TRUE;
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <glib.h>
+
+// Tap-along latency measurement for one input source.
+// Beats are scheduled at first_beat_us + k * interval_us (monotonic clock);
+// every tap is matched to the nearest beat and its offset recorded.
+typedef struct {
+  char *source;
+  gint64 first_beat_us;
+  gint64 interval_us;
+  guint beats;
+  guint warmup_beats;   // leading beats whose taps are ignored
+  gint last_beat;       // last beat that received a tap (-1: none)
+  GArray *offsets_us;   // gint64 tap - beat, one per accepted tap
+} LiveSpiffCalibration;
+
+#define CALIBRATION_MIN_TAPS 4
+
+LiveSpiffCalibration* calibration_new(const char *source, gint64 first_beat_us, gint64 interval_us, guint beats);
+void calibration_free(LiveSpiffCalibration *c);
+
+gint64 calibration_beat_us(const LiveSpiffCalibration *c, guint beat);
+// Monotonic time after which no more taps are accepted
+gint64 calibration_end_us(const LiveSpiffCalibration *c);
+
+// FALSE if the tap is outside the measured beats or a beat already has a tap
+gboolean calibration_tap(LiveSpiffCalibration *c, gint64 tap_us);
+
+// Mean offset and jitter (standard deviation) of the taps that lie within a
+// quarter beat of the median; FALSE if fewer than CALIBRATION_MIN_TAPS remain.
+gboolean calibration_result(const LiveSpiffCalibration *c, gint64 *out_offset_us, gint64 *out_jitter_us, guint *out_taps);
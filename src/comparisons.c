@@ -0,0 +1,266 @@
+#include "comparisons.h"
+#include <string.h>
+
+static const char *builtin_names[COMPARISON_BUILTIN_COUNT] = {
+  [COMPARISON_PERSONAL_BEST] = "Personal Best",
+  [COMPARISON_BEST_SEGMENTS] = "Best Segments",
+  [COMPARISON_AVERAGE]       = "Average Segments",
+  [COMPARISON_MEDIAN]        = "Median Segments",
+  [COMPARISON_LATEST]        = "Latest Run",
+};
+
+static gint64* times_new_unknown(guint n) {
+  gint64 *t = g_new(gint64, n > 0 ? n : 1);
+  for (guint i = 0; i < n; i++) t[i] = LIVESPIFF_NO_TIME;
+  return t;
+}
+
+static gint64* cumulative_at(const LiveSpiffComparisons *c, guint comparison) {
+  return (gint64*)g_ptr_array_index(c->cumulative, comparison);
+}
+
+LiveSpiffComparisons* comparisons_new(guint n_segments, TimingMethod method) {
+  LiveSpiffComparisons *c = g_new0(LiveSpiffComparisons, 1);
+  c->n_segments = n_segments;
+  c->method = method;
+  c->names = g_ptr_array_new_with_free_func(g_free);
+  c->cumulative = g_ptr_array_new_with_free_func(g_free);
+  c->active = COMPARISON_PERSONAL_BEST;
+
+  for (guint k = 0; k < COMPARISON_BUILTIN_COUNT; k++) {
+    g_ptr_array_add(c->names, g_strdup(builtin_names[k]));
+    g_ptr_array_add(c->cumulative, times_new_unknown(n_segments));
+  }
+
+  c->pb_final_us = LIVESPIFF_NO_TIME;
+  c->best_segment_us = times_new_unknown(n_segments);
+  c->segment_sum_us = g_new0(gint64, n_segments > 0 ? n_segments : 1);
+  c->segment_count = g_new0(guint, n_segments > 0 ? n_segments : 1);
+  c->segment_sorted = g_new0(GArray*, n_segments > 0 ? n_segments : 1);
+  for (guint i = 0; i < n_segments; i++) {
+    c->segment_sorted[i] = g_array_new(FALSE, FALSE, sizeof(gint64));
+  }
+  c->undo_pb = times_new_unknown(n_segments);
+  c->undo_latest = times_new_unknown(n_segments);
+  c->undo_best_segment_us = times_new_unknown(n_segments);
+  c->undo_added_us = times_new_unknown(n_segments);
+  return c;
+}
+
+void comparisons_free(LiveSpiffComparisons *c) {
+  if (!c) return;
+  g_ptr_array_free(c->names, TRUE);
+  g_ptr_array_free(c->cumulative, TRUE);
+  g_free(c->best_segment_us);
+  g_free(c->segment_sum_us);
+  g_free(c->segment_count);
+  for (guint i = 0; i < c->n_segments; i++) g_array_free(c->segment_sorted[i], TRUE);
+  g_free(c->segment_sorted);
+  g_free(c->undo_pb);
+  g_free(c->undo_latest);
+  g_free(c->undo_best_segment_us);
+  g_free(c->undo_added_us);
+  g_free(c);
+}
+
+/* ------------------------- incremental aggregates ------------------------- */
+
+static void sorted_insert(GArray *arr, gint64 v) {
+  guint lo = 0, hi = arr->len;
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
+    if (g_array_index(arr, gint64, mid) <= v) lo = mid + 1;
+    else hi = mid;
+  }
+  g_array_insert_val(arr, lo, v);
+}
+
+static void sorted_remove(GArray *arr, gint64 v) {
+  guint lo = 0, hi = arr->len;
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
+    if (g_array_index(arr, gint64, mid) < v) lo = mid + 1;
+    else hi = mid;
+  }
+  if (lo < arr->len && g_array_index(arr, gint64, lo) == v) g_array_remove_index(arr, lo);
+}
+
+static gint64 sorted_median(const GArray *arr) {
+  if (arr->len == 0) return LIVESPIFF_NO_TIME;
+  guint mid = arr->len / 2;
+  if (arr->len % 2) return g_array_index(arr, gint64, mid);
+  return (g_array_index(arr, gint64, mid - 1) + g_array_index(arr, gint64, mid)) / 2;
+}
+
+static void accumulate_segment(LiveSpiffComparisons *c, guint i, gint64 seg) {
+  if (c->best_segment_us[i] == LIVESPIFF_NO_TIME || seg < c->best_segment_us[i]) c->best_segment_us[i] = seg;
+  c->segment_sum_us[i] += seg;
+  c->segment_count[i]++;
+  sorted_insert(c->segment_sorted[i], seg);
+}
+
+// Fold one attempt into the per-segment aggregates, PB and latest; added
+// (optional) receives the segment time counted per segment
+static void accumulate(LiveSpiffComparisons *c, const LiveSpiffAttempt *a, gint64 *added) {
+  guint n = c->n_segments;
+
+  for (guint i = 0; i < n; i++) {
+    gint64 prev = (i == 0) ? 0 : attempt_time_us(a, c->method, i - 1);
+    gint64 cur = attempt_time_us(a, c->method, i);
+    if (added) added[i] = LIVESPIFF_NO_TIME;
+    if (prev == LIVESPIFF_NO_TIME || cur == LIVESPIFF_NO_TIME || cur < prev) continue;
+    accumulate_segment(c, i, cur - prev);
+    if (added) added[i] = cur - prev;
+  }
+
+  gint64 *latest = cumulative_at(c, COMPARISON_LATEST);
+  for (guint i = 0; i < n; i++) latest[i] = attempt_time_us(a, c->method, i);
+
+  // Only complete attempts of the current segment layout can become PB
+  if (a->finished && n > 0 && a->split_us->len == n) {
+    gint64 final_us = attempt_time_us(a, c->method, n - 1);
+    if (final_us != LIVESPIFF_NO_TIME &&
+        (c->pb_final_us == LIVESPIFF_NO_TIME || final_us < c->pb_final_us)) {
+      c->pb_final_us = final_us;
+      gint64 *pb = cumulative_at(c, COMPARISON_PERSONAL_BEST);
+      for (guint i = 0; i < n; i++) pb[i] = attempt_time_us(a, c->method, i);
+    }
+  }
+}
+
+// Turn per-segment aggregates back into cumulative arrays: O(segments)
+static void refresh_segment_comparisons(LiveSpiffComparisons *c) {
+  gint64 *best = cumulative_at(c, COMPARISON_BEST_SEGMENTS);
+  gint64 *avg = cumulative_at(c, COMPARISON_AVERAGE);
+  gint64 *med = cumulative_at(c, COMPARISON_MEDIAN);
+  gint64 sum_best = 0, sum_avg = 0, sum_med = 0;
+
+  for (guint i = 0; i < c->n_segments; i++) {
+    gint64 b = c->best_segment_us[i];
+    gint64 a = c->segment_count[i] ? c->segment_sum_us[i] / c->segment_count[i] : LIVESPIFF_NO_TIME;
+    gint64 m = sorted_median(c->segment_sorted[i]);
+
+    // Once one segment is unknown, every later cumulative time is too
+    sum_best = (sum_best == LIVESPIFF_NO_TIME || b == LIVESPIFF_NO_TIME) ? LIVESPIFF_NO_TIME : sum_best + b;
+    sum_avg = (sum_avg == LIVESPIFF_NO_TIME || a == LIVESPIFF_NO_TIME) ? LIVESPIFF_NO_TIME : sum_avg + a;
+    sum_med = (sum_med == LIVESPIFF_NO_TIME || m == LIVESPIFF_NO_TIME) ? LIVESPIFF_NO_TIME : sum_med + m;
+
+    best[i] = sum_best;
+    avg[i] = sum_avg;
+    med[i] = sum_med;
+  }
+}
+
+void comparisons_add_attempt(LiveSpiffComparisons *c, const LiveSpiffAttempt *attempt) {
+  if (!c || !attempt) return;
+  gsize size = sizeof(gint64) * c->n_segments;
+  c->undo_pb_final_us = c->pb_final_us;
+  if (size) {
+    memcpy(c->undo_pb, cumulative_at(c, COMPARISON_PERSONAL_BEST), size);
+    memcpy(c->undo_latest, cumulative_at(c, COMPARISON_LATEST), size);
+    memcpy(c->undo_best_segment_us, c->best_segment_us, size);
+  }
+  accumulate(c, attempt, c->undo_added_us);
+  c->undo_valid = TRUE;
+  refresh_segment_comparisons(c);
+}
+
+gboolean comparisons_remove_last_attempt(LiveSpiffComparisons *c) {
+  if (!c || !c->undo_valid) return FALSE;
+  gsize size = sizeof(gint64) * c->n_segments;
+  for (guint i = 0; i < c->n_segments; i++) {
+    gint64 seg = c->undo_added_us[i];
+    if (seg == LIVESPIFF_NO_TIME) continue;
+    c->segment_sum_us[i] -= seg;
+    c->segment_count[i]--;
+    sorted_remove(c->segment_sorted[i], seg);
+  }
+  c->pb_final_us = c->undo_pb_final_us;
+  if (size) {
+    memcpy(cumulative_at(c, COMPARISON_PERSONAL_BEST), c->undo_pb, size);
+    memcpy(cumulative_at(c, COMPARISON_LATEST), c->undo_latest, size);
+    memcpy(c->best_segment_us, c->undo_best_segment_us, size);
+  }
+  c->undo_valid = FALSE;
+  refresh_segment_comparisons(c);
+  return TRUE;
+}
+
+void comparisons_add_segment_time(LiveSpiffComparisons *c, guint segment, gint64 time_us) {
+  if (!c || segment >= c->n_segments || time_us == LIVESPIFF_NO_TIME || time_us < 0) return;
+  c->undo_valid = FALSE; // the golds saved before the last attempt no longer hold
+  accumulate_segment(c, segment, time_us);
+  refresh_segment_comparisons(c);
+}
+
+LiveSpiffComparisons* comparisons_build(const LiveSpiffRun *run, const GPtrArray *attempts, const char *active_name,
+                                        TimingMethod method) {
+  guint n = (run && run->segments) ? run->segments->len : 0;
+  LiveSpiffComparisons *c = comparisons_new(n, method);
+
+  for (guint i = 0; attempts && i < attempts->len; i++) {
+    accumulate(c, (const LiveSpiffAttempt*)g_ptr_array_index(attempts, i), NULL);
+  }
+  refresh_segment_comparisons(c);
+
+  for (guint i = 0; run && run->comparisons && i < run->comparisons->len; i++) {
+    const LiveSpiffCustomComparison *cc = g_ptr_array_index(run->comparisons, i);
+    comparisons_set_custom(c, cc->name, cc->split_us);
+  }
+
+  if (active_name) comparisons_set_active(c, active_name);
+  return c;
+}
+
+/* ------------------------- lookup ------------------------- */
+
+void comparisons_set_custom(LiveSpiffComparisons *c, const char *name, const GArray *split_us) {
+  if (!c || !name || !name[0]) return;
+
+  int idx = comparisons_find(c, name);
+  if (idx >= 0 && idx < COMPARISON_BUILTIN_COUNT) return; // built-ins are derived, not imported
+
+  gint64 *times = times_new_unknown(c->n_segments);
+  for (guint i = 0; split_us && i < split_us->len && i < c->n_segments; i++) {
+    times[i] = g_array_index(split_us, gint64, i);
+  }
+
+  if (idx >= 0) {
+    g_free(c->cumulative->pdata[idx]);
+    c->cumulative->pdata[idx] = times;
+  } else {
+    g_ptr_array_add(c->names, g_strdup(name));
+    g_ptr_array_add(c->cumulative, times);
+  }
+}
+
+int comparisons_find(const LiveSpiffComparisons *c, const char *name) {
+  if (!c || !name) return -1;
+  for (guint i = 0; i < c->names->len; i++) {
+    if (g_strcmp0((const char*)g_ptr_array_index(c->names, i), name) == 0) return (int)i;
+  }
+  return -1;
+}
+
+gboolean comparisons_set_active(LiveSpiffComparisons *c, const char *name) {
+  int idx = comparisons_find(c, name);
+  if (idx < 0) return FALSE;
+  c->active = (guint)idx;
+  return TRUE;
+}
+
+const char* comparisons_active_name(const LiveSpiffComparisons *c) {
+  if (!c || c->active >= c->names->len) return "";
+  return (const char*)g_ptr_array_index(c->names, c->active);
+}
+
+gint64 comparisons_time_us(const LiveSpiffComparisons *c, guint comparison, guint split) {
+  if (!c || comparison >= c->cumulative->len || split >= c->n_segments) return LIVESPIFF_NO_TIME;
+  return cumulative_at(c, comparison)[split];
+}
+
+gint64 comparisons_delta_us(const LiveSpiffComparisons *c, guint comparison, guint split, gint64 time_us) {
+  gint64 ref = comparisons_time_us(c, comparison, split);
+  if (ref == LIVESPIFF_NO_TIME || time_us == LIVESPIFF_NO_TIME) return LIVESPIFF_NO_TIME;
+  return time_us - ref;
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <glib.h>
+
+#include "storage.h"
+
+// Built-in comparisons always come first, in this order, followed by the
+// run's custom (imported) comparisons.
+typedef enum {
+  COMPARISON_PERSONAL_BEST = 0,
+  COMPARISON_BEST_SEGMENTS,
+  COMPARISON_AVERAGE,
+  COMPARISON_MEDIAN,
+  COMPARISON_LATEST,
+  COMPARISON_BUILTIN_COUNT
+} ComparisonKind;
+
+// Every comparison is kept as a cumulative split time array aligned to the
+// run's segments, so switching the active one is just an index change.
+// A set is built for one timing method; the daemon keeps one per method.
+typedef struct {
+  guint n_segments;
+  TimingMethod method;   // clock the built-ins are derived from
+  GPtrArray *names;      // char*, one per comparison
+  GPtrArray *cumulative; // gint64[n_segments] per comparison, LIVESPIFF_NO_TIME if unknown
+  guint active;
+
+  // Incremental aggregates over history, updated per attempt
+  gint64 pb_final_us;
+  gint64 *best_segment_us;   // gold per segment
+  gint64 *segment_sum_us;    // for the average
+  guint *segment_count;
+  GArray **segment_sorted;   // gint64 segment times kept sorted (median)
+
+  // What the last comparisons_add_attempt() changed, while nothing else has
+  gboolean undo_valid;
+  gint64 undo_pb_final_us;
+  gint64 *undo_pb;           // PB, latest and golds from before it
+  gint64 *undo_latest;
+  gint64 *undo_best_segment_us;
+  gint64 *undo_added_us;     // segment time it added, LIVESPIFF_NO_TIME if none
+} LiveSpiffComparisons;
+
+LiveSpiffComparisons* comparisons_new(guint n_segments, TimingMethod method);
+void comparisons_free(LiveSpiffComparisons *c);
+
+// Rebuild everything for a (new) run from its history, keeping the active
+// comparison by name when it still exists. Custom comparisons carry one set
+// of times and are used as-is whatever the method.
+LiveSpiffComparisons* comparisons_build(const LiveSpiffRun *run, const GPtrArray *attempts, const char *active_name,
+                                        TimingMethod method);
+
+// O(segments) update after one more attempt was recorded
+void comparisons_add_attempt(LiveSpiffComparisons *c, const LiveSpiffAttempt *attempt);
+// Takes back the last comparisons_add_attempt() (an undone finish) in
+// O(segments log attempts). FALSE if it cannot: nothing was added since the
+// set was built, or a segment time came in after it; rebuild then.
+gboolean comparisons_remove_last_attempt(LiveSpiffComparisons *c);
+
+// One segment time outside of a full attempt (practice): counts towards the
+// best, average and median segment comparisons only
+void comparisons_add_segment_time(LiveSpiffComparisons *c, guint segment, gint64 time_us);
+
+// Add or replace a custom comparison (cumulative times, LIVESPIFF_NO_TIME if unknown)
+void comparisons_set_custom(LiveSpiffComparisons *c, const char *name, const GArray *split_us);
+
+int comparisons_find(const LiveSpiffComparisons *c, const char *name); // -1 if missing
+gboolean comparisons_set_active(LiveSpiffComparisons *c, const char *name);
+const char* comparisons_active_name(const LiveSpiffComparisons *c);
+
+// Cumulative comparison time at split index, LIVESPIFF_NO_TIME if unknown
+gint64 comparisons_time_us(const LiveSpiffComparisons *c, guint comparison, guint split);
+
+// time_us - comparison time at split index, LIVESPIFF_NO_TIME if either is unknown
+gint64 comparisons_delta_us(const LiveSpiffComparisons *c, guint comparison, guint split, gint64 time_us);
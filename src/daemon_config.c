@@ -0,0 +1,149 @@
+#include "daemon_config.h"
+
+static void ensure_parent_dir(const char *file_path) {
+  char *dir = g_path_get_dirname(file_path);
+  g_mkdir_with_parents(dir, 0700);
+  g_free(dir);
+}
+
+char* daemon_config_path(void) {
+  const char *base = g_get_user_config_dir();
+  return g_build_filename(base, "livespiff", "daemon.ini", NULL);
+}
+
+void daemon_config_free_fields(LiveSpiffDaemonConfig *c) {
+  if (!c) return;
+  g_free(c->process_name);
+  c->process_name = NULL;
+  g_strfreev(c->hotkey_devices);
+  c->hotkey_devices = NULL;
+  g_free(c->hotkey_start_split);
+  g_free(c->hotkey_pause);
+  g_free(c->hotkey_reset);
+  c->hotkey_start_split = c->hotkey_pause = c->hotkey_reset = NULL;
+  g_free(c->shortcuts_backend);
+  c->shortcuts_backend = NULL;
+  g_free(c->timing_method);
+  c->timing_method = NULL;
+  if (c->latency) g_hash_table_destroy(c->latency);
+  c->latency = NULL;
+}
+
+static GHashTable* latency_table_new(void) {
+  return g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+}
+
+gint64 daemon_config_latency_offset(const LiveSpiffDaemonConfig *c, const char *source) {
+  if (!c || !c->latency || !source) return 0;
+  const LiveSpiffLatency *l = g_hash_table_lookup(c->latency, source);
+  return l ? l->offset_us : 0;
+}
+
+void daemon_config_set_latency(LiveSpiffDaemonConfig *c, const char *source, gint64 offset_us, gint64 jitter_us) {
+  if (!c || !source || !*source) return;
+  if (!c->latency) c->latency = latency_table_new();
+  LiveSpiffLatency *l = g_new0(LiveSpiffLatency, 1);
+  l->offset_us = offset_us;
+  l->jitter_us = jitter_us;
+  g_hash_table_replace(c->latency, g_strdup(source), l);
+}
+
+LiveSpiffDaemonConfig daemon_config_load(void) {
+  LiveSpiffDaemonConfig c = {0};
+  c.auto_start = FALSE;
+  c.auto_pause_on_exit = FALSE;
+  c.plugins_enabled = TRUE;
+  c.plugin_queue_depth = 256;
+  c.practice_ring_size = 100;
+  c.latency = latency_table_new();
+
+  char *path = daemon_config_path();
+  GKeyFile *kf = g_key_file_new();
+
+  if (g_key_file_load_from_file(kf, path, G_KEY_FILE_NONE, NULL)) {
+    if (g_key_file_has_key(kf, "process", "name", NULL))
+      c.process_name = g_key_file_get_string(kf, "process", "name", NULL);
+
+    if (g_key_file_has_key(kf, "process", "auto_start", NULL))
+      c.auto_start = g_key_file_get_boolean(kf, "process", "auto_start", NULL);
+
+    if (g_key_file_has_key(kf, "process", "auto_pause_on_exit", NULL))
+      c.auto_pause_on_exit = g_key_file_get_boolean(kf, "process", "auto_pause_on_exit", NULL);
+
+    // [hotkeys] is only edited by hand; save() leaves it untouched
+    if (g_key_file_has_key(kf, "hotkeys", "devices", NULL))
+      c.hotkey_devices = g_key_file_get_string_list(kf, "hotkeys", "devices", NULL, NULL);
+    c.hotkey_start_split = g_key_file_get_string(kf, "hotkeys", "start_split", NULL);
+    c.hotkey_pause = g_key_file_get_string(kf, "hotkeys", "pause", NULL);
+    c.hotkey_reset = g_key_file_get_string(kf, "hotkeys", "reset", NULL);
+    c.shortcuts_backend = g_key_file_get_string(kf, "shortcuts", "backend", NULL);
+    c.timing_method = g_key_file_get_string(kf, "timer", "method", NULL);
+    if (g_key_file_has_key(kf, "history", "sqlite", NULL))
+      c.history_sqlite = g_key_file_get_boolean(kf, "history", "sqlite", NULL);
+    if (g_key_file_has_key(kf, "timer", "double_press_guard_ms", NULL))
+      c.double_press_guard_ms = (guint)CLAMP(g_key_file_get_integer(kf, "timer", "double_press_guard_ms", NULL), 0, 5000);
+
+    if (g_key_file_has_key(kf, "plugins", "enabled", NULL))
+      c.plugins_enabled = g_key_file_get_boolean(kf, "plugins", "enabled", NULL);
+    if (g_key_file_has_key(kf, "plugins", "queue_depth", NULL))
+      c.plugin_queue_depth = (guint)MAX(g_key_file_get_integer(kf, "plugins", "queue_depth", NULL), 1);
+    if (g_key_file_has_key(kf, "practice", "ring_size", NULL))
+      c.practice_ring_size = (guint)CLAMP(g_key_file_get_integer(kf, "practice", "ring_size", NULL), 1, 100000);
+
+    // [latency] source=offset_us, [latency_jitter] source=jitter_us
+    gchar **sources = g_key_file_get_keys(kf, "latency", NULL, NULL);
+    for (gchar **k = sources; k && *k; k++) {
+      gint64 offset = g_key_file_get_int64(kf, "latency", *k, NULL);
+      gint64 jitter = g_key_file_has_key(kf, "latency_jitter", *k, NULL)
+                        ? g_key_file_get_int64(kf, "latency_jitter", *k, NULL) : 0;
+      daemon_config_set_latency(&c, *k, offset, jitter);
+    }
+    g_strfreev(sources);
+  }
+
+  g_key_file_free(kf);
+  g_free(path);
+  return c;
+}
+
+void daemon_config_save(const LiveSpiffDaemonConfig *c) {
+  if (!c) return;
+
+  char *path = daemon_config_path();
+  ensure_parent_dir(path);
+
+  // Start from the file on disk so unknown keys survive
+  GKeyFile *kf = g_key_file_new();
+  g_key_file_load_from_file(kf, path, G_KEY_FILE_KEEP_COMMENTS, NULL);
+
+  if (c->process_name && c->process_name[0])
+    g_key_file_set_string(kf, "process", "name", c->process_name);
+  else
+    g_key_file_remove_key(kf, "process", "name", NULL);
+
+  g_key_file_set_boolean(kf, "process", "auto_start", c->auto_start);
+  g_key_file_set_boolean(kf, "process", "auto_pause_on_exit", c->auto_pause_on_exit);
+  if (c->timing_method && c->timing_method[0])
+    g_key_file_set_string(kf, "timer", "method", c->timing_method);
+
+  g_key_file_remove_group(kf, "latency", NULL);
+  g_key_file_remove_group(kf, "latency_jitter", NULL);
+  if (c->latency) {
+    GHashTableIter it;
+    gpointer key, value;
+    g_hash_table_iter_init(&it, c->latency);
+    while (g_hash_table_iter_next(&it, &key, &value)) {
+      const LiveSpiffLatency *l = (const LiveSpiffLatency*)value;
+      g_key_file_set_int64(kf, "latency", (const char*)key, l->offset_us);
+      g_key_file_set_int64(kf, "latency_jitter", (const char*)key, l->jitter_us);
+    }
+  }
+
+  gsize len = 0;
+  gchar *data = g_key_file_to_data(kf, &len, NULL);
+  g_file_set_contents(path, data, (gssize)len, NULL);
+
+  g_free(data);
+  g_key_file_free(kf);
+  g_free(path);
+}
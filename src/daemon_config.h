@@ -0,0 +1,54 @@
+#pragma once
+#include <glib.h>
+
+typedef struct {
+  // Game process tracking
+  char *process_name;          // process name or window class; empty: use ui.ini [game] classname
+  gboolean auto_start;         // start the timer when the game launches
+  gboolean auto_pause_on_exit; // pause a running timer when the game exits
+
+  // Direct evdev hotkeys (needs read access to /dev/input, e.g. the input group)
+  char **hotkey_devices;       // [hotkeys] devices; NULL/empty: disabled
+  char *hotkey_start_split;    // chords such as "KEY_KP1" or "KEY_LEFTCTRL+KEY_F1"
+  char *hotkey_pause;
+  char *hotkey_reset;
+
+  // Desktop-wide shortcuts registered by the daemon (keys: ui.ini [hotkeys])
+  char *shortcuts_backend;     // [shortcuts] backend: auto, portal, kglobalaccel, none
+
+  // In-process plugins (livespiff_plugin.h)
+  gboolean plugins_enabled;    // [plugins] enabled, default true
+  guint plugin_queue_depth;    // [plugins] queue_depth: events buffered per plugin
+
+  // Segment practice
+  guint practice_ring_size;    // [practice] ring_size: recent tries kept per segment
+
+  // [history] sqlite: also keep every attempt in history.sqlite (history_db.h;
+  // needs a build with SQLite)
+  gboolean history_sqlite;
+
+  // Clock shown and compared against, set through SetTimingMethod
+  char *timing_method;         // [timer] method: real or game; NULL: real
+  // [timer] double_press_guard_ms: a start/split or pause this soon after
+  // the last one is dropped, from any input source; 0 = off
+  guint double_press_guard_ms;
+
+  // Input latency compensation, per input source ("dbus", "ui", ...)
+  GHashTable *latency;         // char* source -> LiveSpiffLatency*
+} LiveSpiffDaemonConfig;
+
+typedef struct {
+  gint64 offset_us;            // subtracted from the time an input arrives
+  gint64 jitter_us;            // spread measured during calibration (informational)
+} LiveSpiffLatency;
+
+LiveSpiffDaemonConfig daemon_config_load(void);
+void daemon_config_save(const LiveSpiffDaemonConfig *c);
+void daemon_config_free_fields(LiveSpiffDaemonConfig *c);
+
+// Offset for source, 0 if not calibrated
+gint64 daemon_config_latency_offset(const LiveSpiffDaemonConfig *c, const char *source);
+void daemon_config_set_latency(LiveSpiffDaemonConfig *c, const char *source, gint64 offset_us, gint64 jitter_us);
+
+// returns ~/.config/livespiff/daemon.ini (caller frees)
+char* daemon_config_path(void);
@@ -0,0 +1,196 @@
+#include "delta_graph.h"
+#include <string.h>
+
+#define GRAPH_NO_TIME G_MININT64
+#define GRAPH_MIN_SCALE_MS 1000 // at least ±1 s so small deltas are not blown up
+
+struct _LiveSpiffDeltaGraph {
+  GtkWidget parent_instance;
+
+  int height;
+  guint segments;
+  GArray *deltas;            // gint64 ms per completed split
+  gint64 scale_ms;           // y axis spans ±scale_ms
+
+  GskRenderNode *cached;     // midline + completed path
+  int cached_w, cached_h;    // size `cached` was built for
+
+  double live_progress;
+  gint64 live_ms;            // GRAPH_NO_TIME: no tail
+};
+
+G_DEFINE_TYPE(LiveSpiffDeltaGraph, livespiff_delta_graph, GTK_TYPE_WIDGET)
+
+static const GdkRGBA midline_rgba = { 0.48f, 0.50f, 0.53f, 0.6f };
+static const GdkRGBA path_rgba    = { 0.24f, 0.81f, 0.43f, 1.0f };
+static const GdkRGBA tail_rgba    = { 0.90f, 0.33f, 0.29f, 1.0f };
+
+static void clear_cache(LiveSpiffDeltaGraph *g) {
+  if (g->cached) gsk_render_node_unref(g->cached);
+  g->cached = NULL;
+}
+
+static void drop_cache(LiveSpiffDeltaGraph *g) {
+  clear_cache(g);
+  gtk_widget_queue_draw(GTK_WIDGET(g));
+}
+
+static gint64 last_delta(const LiveSpiffDeltaGraph *g) {
+  for (guint i = g->deltas->len; i > 0; i--) {
+    gint64 d = g_array_index(g->deltas, gint64, i - 1);
+    if (d != GRAPH_NO_TIME) return d;
+  }
+  return 0;
+}
+
+// Grows the y range with headroom so a slowly growing tail does not rebuild
+// the path every frame. Returns TRUE if the cached path is now stale.
+static gboolean fit_scale(LiveSpiffDeltaGraph *g, gint64 delta_ms) {
+  if (delta_ms == GRAPH_NO_TIME) return FALSE;
+  gint64 a = delta_ms < 0 ? -delta_ms : delta_ms;
+  if (a <= g->scale_ms) return FALSE;
+  g->scale_ms = MAX(a + a / 4, GRAPH_MIN_SCALE_MS);
+  return TRUE;
+}
+
+static float point_x(const LiveSpiffDeltaGraph *g, double slot, int w) {
+  return (float)(slot * w / MAX(g->segments, 1u));
+}
+
+static float point_y(const LiveSpiffDeltaGraph *g, gint64 delta_ms, int h) {
+  // Behind is up, like LiveSplit
+  double mid = h / 2.0;
+  return (float)(mid - (double)delta_ms / (double)g->scale_ms * (mid - 2));
+}
+
+static void stroke(GtkSnapshot *snapshot, GskPathBuilder *pb, float width, const GdkRGBA *rgba) {
+  GskPath *path = gsk_path_builder_free_to_path(pb);
+  GskStroke *s = gsk_stroke_new(width);
+  gsk_stroke_set_line_join(s, GSK_LINE_JOIN_ROUND);
+  gsk_stroke_set_line_cap(s, GSK_LINE_CAP_ROUND);
+  gtk_snapshot_append_stroke(snapshot, path, s, rgba);
+  gsk_stroke_free(s);
+  gsk_path_unref(path);
+}
+
+// O(splits), once per split / resize / rescale
+static void build_cache(LiveSpiffDeltaGraph *g, int w, int h) {
+  GtkSnapshot *s = gtk_snapshot_new();
+  gtk_snapshot_append_color(s, &midline_rgba, &GRAPHENE_RECT_INIT(0, h / 2.0f, (float)w, 1));
+
+  // Unknown deltas (skipped splits) break the line
+  GskPathBuilder *pb = gsk_path_builder_new();
+  gsk_path_builder_move_to(pb, 0, point_y(g, 0, h));
+  gboolean pen = TRUE;
+  for (guint i = 0; i < g->deltas->len; i++) {
+    gint64 d = g_array_index(g->deltas, gint64, i);
+    if (d == GRAPH_NO_TIME) {
+      pen = FALSE;
+      continue;
+    }
+    float x = point_x(g, i + 1, w), y = point_y(g, d, h);
+    if (pen) gsk_path_builder_line_to(pb, x, y);
+    else gsk_path_builder_move_to(pb, x, y);
+    pen = TRUE;
+  }
+  stroke(s, pb, 2.0f, &path_rgba);
+
+  g->cached = gtk_snapshot_free_to_node(s);
+  g->cached_w = w;
+  g->cached_h = h;
+}
+
+static void livespiff_delta_graph_snapshot(GtkWidget *widget, GtkSnapshot *snapshot) {
+  LiveSpiffDeltaGraph *g = LIVESPIFF_DELTA_GRAPH(widget);
+  int w = gtk_widget_get_width(widget), h = gtk_widget_get_height(widget);
+  if (w <= 0 || h <= 0) return;
+
+  if (g->cached_w != w || g->cached_h != h) clear_cache(g);
+  if (!g->cached) build_cache(g, w, h);
+  if (g->cached) gtk_snapshot_append_node(snapshot, g->cached);
+
+  if (g->live_ms == GRAPH_NO_TIME) return;
+  guint slot = g->deltas->len;
+  GskPathBuilder *pb = gsk_path_builder_new();
+  gsk_path_builder_move_to(pb, point_x(g, slot, w), point_y(g, last_delta(g), h));
+  gsk_path_builder_line_to(pb, point_x(g, slot + g->live_progress, w), point_y(g, g->live_ms, h));
+  stroke(snapshot, pb, 2.0f, &tail_rgba);
+}
+
+static void livespiff_delta_graph_measure(GtkWidget *widget, GtkOrientation orientation, int for_size,
+                                          int *minimum, int *natural, int *min_baseline, int *nat_baseline) {
+  (void)for_size;
+  LiveSpiffDeltaGraph *g = LIVESPIFF_DELTA_GRAPH(widget);
+  int size = orientation == GTK_ORIENTATION_VERTICAL ? g->height : 32;
+  *minimum = size;
+  *natural = size;
+  *min_baseline = -1;
+  *nat_baseline = -1;
+}
+
+static void livespiff_delta_graph_finalize(GObject *obj) {
+  LiveSpiffDeltaGraph *g = LIVESPIFF_DELTA_GRAPH(obj);
+  clear_cache(g);
+  g_array_free(g->deltas, TRUE);
+  G_OBJECT_CLASS(livespiff_delta_graph_parent_class)->finalize(obj);
+}
+
+static void livespiff_delta_graph_class_init(LiveSpiffDeltaGraphClass *klass) {
+  GTK_WIDGET_CLASS(klass)->snapshot = livespiff_delta_graph_snapshot;
+  GTK_WIDGET_CLASS(klass)->measure = livespiff_delta_graph_measure;
+  G_OBJECT_CLASS(klass)->finalize = livespiff_delta_graph_finalize;
+  gtk_widget_class_set_css_name(GTK_WIDGET_CLASS(klass), "deltagraph");
+}
+
+static void livespiff_delta_graph_init(LiveSpiffDeltaGraph *g) {
+  g->deltas = g_array_new(FALSE, FALSE, sizeof(gint64));
+  g->scale_ms = GRAPH_MIN_SCALE_MS;
+  g->live_ms = GRAPH_NO_TIME;
+  g->height = 80;
+}
+
+GtkWidget* livespiff_delta_graph_new(int height) {
+  LiveSpiffDeltaGraph *g = g_object_new(LIVESPIFF_TYPE_DELTA_GRAPH, NULL);
+  g->height = height;
+  return GTK_WIDGET(g);
+}
+
+void livespiff_delta_graph_set_segments(LiveSpiffDeltaGraph *g, guint segments) {
+  if (g->segments == segments) return;
+  g->segments = segments;
+  drop_cache(g);
+}
+
+void livespiff_delta_graph_reset(LiveSpiffDeltaGraph *g) {
+  g_array_set_size(g->deltas, 0);
+  g->scale_ms = GRAPH_MIN_SCALE_MS;
+  g->live_ms = GRAPH_NO_TIME;
+  drop_cache(g);
+}
+
+void livespiff_delta_graph_set_deltas(LiveSpiffDeltaGraph *g, const GArray *delta_ms) {
+  guint n = delta_ms->len;
+  guint kept = MIN(n, g->deltas->len);
+  // Points already drawn must be unchanged too: an undo followed by a split
+  // keeps the length, and a delta may be corrected in place
+  gboolean same_prefix = memcmp(g->deltas->data, delta_ms->data, kept * sizeof(gint64)) == 0;
+  if (same_prefix && n == g->deltas->len) return;
+
+  // The usual case, a split: only the new point is added
+  if (!same_prefix || n != g->deltas->len + 1) g_array_set_size(g->deltas, 0);
+  for (guint i = g->deltas->len; i < n; i++) {
+    gint64 d = g_array_index(delta_ms, gint64, i);
+    fit_scale(g, d);
+    g_array_append_val(g->deltas, d);
+  }
+  drop_cache(g);
+}
+
+void livespiff_delta_graph_set_live(LiveSpiffDeltaGraph *g, double progress, gint64 delta_ms) {
+  progress = CLAMP(progress, 0.0, 1.0);
+  if (g->live_ms == delta_ms && g->live_progress == progress) return;
+  g->live_progress = progress;
+  g->live_ms = delta_ms;
+  if (fit_scale(g, delta_ms)) drop_cache(g);
+  else gtk_widget_queue_draw(GTK_WIDGET(g));
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <gtk/gtk.h>
+
+// Run delta graph: delta vs the comparison per completed split, plus a live
+// tail for the split in progress. The completed path is built once per
+// split into a cached render node; a frame only re-appends that node and
+// strokes the one-segment tail, whatever the number of splits.
+#define LIVESPIFF_TYPE_DELTA_GRAPH (livespiff_delta_graph_get_type())
+G_DECLARE_FINAL_TYPE(LiveSpiffDeltaGraph, livespiff_delta_graph, LIVESPIFF, DELTA_GRAPH, GtkWidget)
+
+GtkWidget* livespiff_delta_graph_new(int height);
+
+// Number of segments in the run (x axis); drops the cached path if changed
+void livespiff_delta_graph_set_segments(LiveSpiffDeltaGraph *g, guint segments);
+// Completed-split deltas (ms, G_MININT64 = unknown). The same points plus one
+// appends a point; any other change, including a changed value, rebuilds the path.
+void livespiff_delta_graph_set_deltas(LiveSpiffDeltaGraph *g, const GArray *delta_ms);
+// Forget all points (comparison changed, run reloaded)
+void livespiff_delta_graph_reset(LiveSpiffDeltaGraph *g);
+// Live tail: progress 0..1 through the current segment and its running
+// delta; G_MININT64 hides it
+void livespiff_delta_graph_set_live(LiveSpiffDeltaGraph *g, double progress, gint64 delta_ms);
@@ -0,0 +1,301 @@
+#define _GNU_SOURCE
+#include "evdev_hotkeys.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define READ_BATCH 64
+
+/* ------------------------- key names ------------------------- */
+
+#define K(name) { #name, KEY_##name }
+#define B(name) { "BTN_" #name, BTN_##name }
+
+static const struct { const char *name; guint16 code; } key_names[] = {
+  K(ESC), K(1), K(2), K(3), K(4), K(5), K(6), K(7), K(8), K(9), K(0),
+  K(MINUS), K(EQUAL), K(BACKSPACE), K(TAB), K(ENTER), K(SPACE), K(CAPSLOCK),
+  K(Q), K(W), K(E), K(R), K(T), K(Y), K(U), K(I), K(O), K(P),
+  K(A), K(S), K(D), K(F), K(G), K(H), K(J), K(K), K(L),
+  K(Z), K(X), K(C), K(V), K(B), K(N), K(M),
+  K(LEFTBRACE), K(RIGHTBRACE), K(SEMICOLON), K(APOSTROPHE), K(GRAVE), K(BACKSLASH),
+  K(COMMA), K(DOT), K(SLASH), K(102ND),
+  K(LEFTCTRL), K(RIGHTCTRL), K(LEFTSHIFT), K(RIGHTSHIFT), K(LEFTALT), K(RIGHTALT),
+  K(LEFTMETA), K(RIGHTMETA), K(COMPOSE),
+  K(F1), K(F2), K(F3), K(F4), K(F5), K(F6), K(F7), K(F8), K(F9), K(F10), K(F11), K(F12),
+  K(F13), K(F14), K(F15), K(F16), K(F17), K(F18), K(F19), K(F20), K(F21), K(F22), K(F23), K(F24),
+  K(SYSRQ), K(SCROLLLOCK), K(PAUSE), K(INSERT), K(DELETE), K(HOME), K(END), K(PAGEUP), K(PAGEDOWN),
+  K(UP), K(DOWN), K(LEFT), K(RIGHT), K(NUMLOCK),
+  K(KP0), K(KP1), K(KP2), K(KP3), K(KP4), K(KP5), K(KP6), K(KP7), K(KP8), K(KP9),
+  K(KPDOT), K(KPENTER), K(KPPLUS), K(KPMINUS), K(KPASTERISK), K(KPSLASH),
+  K(PLAYPAUSE), K(STOPCD), K(NEXTSONG), K(PREVIOUSSONG), K(MUTE), K(VOLUMEUP), K(VOLUMEDOWN),
+  B(LEFT), B(RIGHT), B(MIDDLE), B(SIDE), B(EXTRA), B(FORWARD), B(BACK),
+};
+
+#undef K
+#undef B
+
+static gboolean key_from_name(const char *name, guint16 *out) {
+  char *end = NULL;
+  guint64 code = g_ascii_strtoull(name, &end, 10);
+  if (end && end != name && *end == '\0') {
+    if (code >= KEY_CNT) return FALSE;
+    *out = (guint16)code;
+    return TRUE;
+  }
+
+  const char *bare = g_str_has_prefix(name, "KEY_") ? name + 4 : name;
+  for (guint i = 0; i < G_N_ELEMENTS(key_names); i++) {
+    if (g_ascii_strcasecmp(bare, key_names[i].name) == 0 || g_ascii_strcasecmp(name, key_names[i].name) == 0) {
+      *out = key_names[i].code;
+      return TRUE;
+    }
+  }
+  return FALSE;
+}
+
+gboolean hotkey_chord_parse(const char *text, HotkeyChord *out) {
+  memset(out, 0, sizeof(*out));
+  if (!text) return FALSE;
+
+  gchar **parts = g_strsplit(text, "+", -1);
+  gboolean ok = TRUE;
+  for (gchar **p = parts; *p && ok; p++) {
+    g_strstrip(*p);
+    if (!**p) continue;
+    guint16 code = 0;
+    ok = out->n_keys < HOTKEY_CHORD_MAX && key_from_name(*p, &code);
+    if (ok) out->keys[out->n_keys++] = code;
+  }
+  g_strfreev(parts);
+
+  if (!ok) out->n_keys = 0;
+  return ok && out->n_keys > 0;
+}
+
+const char* hotkey_action_name(HotkeyAction action) {
+  switch (action) {
+    case HOTKEY_START_SPLIT: return "start_split";
+    case HOTKEY_PAUSE: return "pause";
+    case HOTKEY_RESET: return "reset";
+    default: return "none";
+  }
+}
+
+/* ------------------------- matcher ------------------------- */
+
+static gboolean key_is_down(const HotkeyMatcher *m, guint16 code) {
+  return (m->down[code / 8] >> (code % 8)) & 1;
+}
+
+void hotkey_matcher_init(HotkeyMatcher *m, const HotkeyChord chords[HOTKEY_ACTION_COUNT]) {
+  memset(m, 0, sizeof(*m));
+  if (chords) memcpy(m->chords, chords, sizeof(m->chords));
+}
+
+HotkeyAction hotkey_matcher_feed(HotkeyMatcher *m, const struct input_event *ev) {
+  if (ev->type != EV_KEY || ev->code >= KEY_CNT) return HOTKEY_NONE;
+
+  // value: 0 release, 1 press, 2 autorepeat (ignored: one split per press)
+  if (ev->value == 0) {
+    m->down[ev->code / 8] &= (guint8)~(1u << (ev->code % 8));
+    return HOTKEY_NONE;
+  }
+  if (ev->value != 1) return HOTKEY_NONE;
+  m->down[ev->code / 8] |= (guint8)(1u << (ev->code % 8));
+
+  HotkeyAction best = HOTKEY_NONE;
+  guint best_len = 0;
+  for (guint a = HOTKEY_NONE + 1; a < HOTKEY_ACTION_COUNT; a++) {
+    const HotkeyChord *c = &m->chords[a];
+    if (c->n_keys == 0 || c->keys[c->n_keys - 1] != ev->code || c->n_keys <= best_len) continue;
+
+    gboolean held = TRUE;
+    for (guint k = 0; k + 1 < c->n_keys && held; k++) held = key_is_down(m, c->keys[k]);
+    if (held) {
+      best = (HotkeyAction)a;
+      best_len = c->n_keys;
+    }
+  }
+  return best;
+}
+
+/* ------------------------- reader thread ------------------------- */
+
+typedef struct {
+  char *path;
+  int fd;
+  gboolean replay;           // regular file: recorded stream, stamped on read
+  gboolean pipe;             // FIFO: recorded stream, stamps kept
+  guint8 carry[sizeof(struct input_event)]; // pipes may end a read mid-event
+  gsize carry_len;
+} HotkeyDevice;
+
+struct LiveSpiffHotkeyReader {
+  GThread *thread;
+  int wake_fd;               // eventfd, written by hotkey_reader_stop()
+  GMainContext *context;
+  GArray *devices;           // HotkeyDevice
+  HotkeyMatcher matcher;     // only touched by the reader thread
+  HotkeyCallback callback;
+  gpointer user_data;
+};
+
+typedef struct {
+  HotkeyCallback callback;
+  gpointer user_data;
+  HotkeyAction action;
+  gint64 timestamp_us;
+} HotkeyHit;
+
+static gboolean dispatch_hit(gpointer data) {
+  HotkeyHit *hit = (HotkeyHit*)data;
+  hit->callback(hit->action, hit->timestamp_us, hit->user_data);
+  return G_SOURCE_REMOVE;
+}
+
+static void device_close(HotkeyDevice *d) {
+  if (d->fd >= 0) close(d->fd);
+  d->fd = -1;
+}
+
+static gpointer reader_thread(gpointer data) {
+  LiveSpiffHotkeyReader *r = (LiveSpiffHotkeyReader*)data;
+  guint n = r->devices->len;
+  struct pollfd *fds = g_new0(struct pollfd, n + 1);
+  struct input_event events[READ_BATCH];
+
+  for (;;) {
+    guint open_devices = 0;
+    for (guint i = 0; i < n; i++) {
+      HotkeyDevice *d = &g_array_index(r->devices, HotkeyDevice, i);
+      fds[i].fd = d->fd; // negative fds are ignored by poll()
+      fds[i].events = POLLIN;
+      fds[i].revents = 0;
+      if (d->fd >= 0) open_devices++;
+    }
+    fds[n].fd = r->wake_fd;
+    fds[n].events = POLLIN;
+    fds[n].revents = 0;
+
+    if (open_devices == 0) break;
+    if (poll(fds, n + 1, -1) < 0) {
+      if (errno == EINTR) continue;
+      break;
+    }
+    if (fds[n].revents) break;
+
+    for (guint i = 0; i < n; i++) {
+      if (!fds[i].revents) continue;
+      HotkeyDevice *d = &g_array_index(r->devices, HotkeyDevice, i);
+
+      guint8 *buf = (guint8*)events;
+      memcpy(buf, d->carry, d->carry_len);
+      ssize_t len = read(d->fd, buf + d->carry_len, sizeof(events) - d->carry_len);
+      if (len <= 0) {
+        // EOF of a recording or pipe, or the device was unplugged (ENODEV)
+        if (len == 0 || (errno != EAGAIN && errno != EINTR)) device_close(d);
+        continue;
+      }
+      gsize total = d->carry_len + (gsize)len;
+      gsize n_events = total / sizeof(struct input_event);
+      d->carry_len = total % sizeof(struct input_event);
+      memcpy(d->carry, buf + n_events * sizeof(struct input_event), d->carry_len);
+
+      for (gsize e = 0; e < n_events; e++) {
+        HotkeyAction action = hotkey_matcher_feed(&r->matcher, &events[e]);
+        if (action == HOTKEY_NONE) continue;
+
+        HotkeyHit *hit = g_new0(HotkeyHit, 1);
+        hit->callback = r->callback;
+        hit->user_data = r->user_data;
+        hit->action = action;
+        hit->timestamp_us = d->replay ? g_get_monotonic_time() : hotkey_event_time_us(&events[e]);
+        g_main_context_invoke_full(r->context, G_PRIORITY_HIGH, dispatch_hit, hit, g_free);
+      }
+    }
+  }
+
+  g_free(fds);
+  return NULL;
+}
+
+static gboolean device_open(HotkeyDevice *d, GString *errors) {
+  d->fd = open(d->path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+  if (d->fd < 0) {
+    g_string_append_printf(errors, "%s: %s\n", d->path, g_strerror(errno));
+    return FALSE;
+  }
+
+  struct stat st;
+  gboolean have_stat = fstat(d->fd, &st) == 0;
+  d->replay = have_stat && S_ISREG(st.st_mode);
+  d->pipe = have_stat && S_ISFIFO(st.st_mode);
+  if (!d->replay && !d->pipe) {
+    // Stamp events on the monotonic clock so they compare with the timer
+    int clk = CLOCK_MONOTONIC;
+    if (ioctl(d->fd, EVIOCSCLOCKID, &clk) != 0) {
+      g_string_append_printf(errors, "%s: not an evdev device\n", d->path);
+      device_close(d);
+      return FALSE;
+    }
+  }
+  return TRUE;
+}
+
+LiveSpiffHotkeyReader* hotkey_reader_start(char **devices, const HotkeyChord chords[HOTKEY_ACTION_COUNT],
+                                           HotkeyCallback callback, gpointer user_data, char **out_error) {
+  GString *errors = g_string_new(NULL);
+  GArray *opened = g_array_new(FALSE, TRUE, sizeof(HotkeyDevice));
+
+  for (char **p = devices; p && *p; p++) {
+    if (!**p) continue;
+    HotkeyDevice d = { g_strdup(*p), -1, FALSE, FALSE, {0}, 0 };
+    if (device_open(&d, errors)) g_array_append_val(opened, d);
+    else g_free(d.path);
+  }
+
+  if (opened->len == 0) {
+    if (out_error) *out_error = errors->len ? g_strstrip(g_string_free(errors, FALSE)) : g_strdup("No input devices configured");
+    else g_string_free(errors, TRUE);
+    g_array_free(opened, TRUE);
+    return NULL;
+  }
+  // Devices that failed are reported but do not stop the others
+  if (out_error) *out_error = errors->len ? g_strstrip(g_string_free(errors, FALSE)) : NULL;
+  else g_string_free(errors, TRUE);
+
+  LiveSpiffHotkeyReader *r = g_new0(LiveSpiffHotkeyReader, 1);
+  r->devices = opened;
+  r->callback = callback;
+  r->user_data = user_data;
+  r->context = g_main_context_ref_thread_default();
+  r->wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  hotkey_matcher_init(&r->matcher, chords);
+  r->thread = g_thread_new("livespiff-evdev", reader_thread, r);
+  return r;
+}
+
+void hotkey_reader_stop(LiveSpiffHotkeyReader *r) {
+  if (!r) return;
+
+  guint64 one = 1;
+  if (write(r->wake_fd, &one, sizeof(one)) < 0) { /* thread also exits once all devices close */ }
+  g_thread_join(r->thread);
+
+  for (guint i = 0; i < r->devices->len; i++) {
+    HotkeyDevice *d = &g_array_index(r->devices, HotkeyDevice, i);
+    device_close(d);
+    g_free(d->path);
+  }
+  g_array_free(r->devices, TRUE);
+  close(r->wake_fd);
+  g_main_context_unref(r->context);
+  g_free(r);
+}
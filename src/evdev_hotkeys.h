@@ -0,0 +1,55 @@
+#pragma once
+#include <glib.h>
+#include <linux/input.h>
+
+typedef enum {
+  HOTKEY_NONE = 0,
+  HOTKEY_START_SPLIT,
+  HOTKEY_PAUSE,
+  HOTKEY_RESET,
+  HOTKEY_ACTION_COUNT
+} HotkeyAction;
+
+#define HOTKEY_CHORD_MAX 4
+
+// Keys held together; the last one is the trigger, the rest must already be down
+typedef struct {
+  guint16 keys[HOTKEY_CHORD_MAX];
+  guint n_keys;              // 0: unbound
+} HotkeyChord;
+
+// "KEY_LEFTCTRL+KEY_F1", "LEFTCTRL+F1" or raw codes ("29+59"); FALSE if unknown
+gboolean hotkey_chord_parse(const char *text, HotkeyChord *out);
+const char* hotkey_action_name(HotkeyAction action);
+
+// Pure chord matching over an evdev event stream (no I/O), shared by the
+// reader thread and the replay tool
+typedef struct {
+  HotkeyChord chords[HOTKEY_ACTION_COUNT];
+  guint8 down[KEY_CNT / 8 + 1];
+} HotkeyMatcher;
+
+void hotkey_matcher_init(HotkeyMatcher *m, const HotkeyChord chords[HOTKEY_ACTION_COUNT]);
+// Returns the action completed by this key press, if any; the longest chord wins
+HotkeyAction hotkey_matcher_feed(HotkeyMatcher *m, const struct input_event *ev);
+
+static inline gint64 hotkey_event_time_us(const struct input_event *ev) {
+  return (gint64)ev->input_event_sec * G_USEC_PER_SEC + ev->input_event_usec;
+}
+
+// Called on the main context that started the reader. timestamp_us is the
+// kernel's CLOCK_MONOTONIC stamp of the key press (same clock as
+// g_get_monotonic_time()); for replayed files it is the time of reading, for
+// pipes the stamp as written into the pipe.
+typedef void (*HotkeyCallback)(HotkeyAction action, gint64 timestamp_us, gpointer user_data);
+
+// Reads key events from devices on a dedicated thread. Devices are not
+// grabbed, so the game still sees every key. A path may also be a regular
+// file holding a raw recording (e.g. `cat /dev/input/eventN > keys.bin`),
+// which is replayed through the same path and closed at its end, or a pipe
+// or FIFO carrying such a stream, read until the writer closes it.
+typedef struct LiveSpiffHotkeyReader LiveSpiffHotkeyReader;
+
+LiveSpiffHotkeyReader* hotkey_reader_start(char **devices, const HotkeyChord chords[HOTKEY_ACTION_COUNT],
+                                           HotkeyCallback callback, gpointer user_data, char **out_error);
+void hotkey_reader_stop(LiveSpiffHotkeyReader *r);
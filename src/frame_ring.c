@@ -0,0 +1,194 @@
+#define _GNU_SOURCE
+#include "frame_ring.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define READ_ATTEMPTS 4
+
+struct FrameRing {
+  char *name;                  // with the leading '/'
+  gboolean writer;
+  int fd;
+  guint8 *map;
+  gsize map_size;
+  FrameRingHeader *hdr;
+  guint64 pending;             // writer: frame being drawn
+};
+
+static gsize align64(gsize n) {
+  return (n + 63) & ~(gsize)63;
+}
+
+static char* shm_name(const char *name) {
+  return g_str_has_prefix(name, "/") ? g_strdup(name) : g_strconcat("/", name, NULL);
+}
+
+static FrameSlotHeader* slot_at(FrameRing *r, guint64 frame) {
+  guint64 index = frame % r->hdr->slots;
+  return (FrameSlotHeader*)(r->map + sizeof(FrameRingHeader) + index * r->hdr->slot_size);
+}
+
+static guint8* slot_pixels(FrameSlotHeader *slot) {
+  return (guint8*)slot + sizeof(FrameSlotHeader);
+}
+
+static void set_error(char **out_error, const char *what, const char *name) {
+  if (out_error) *out_error = g_strdup_printf("%s %s: %s", what, name, g_strerror(errno));
+}
+
+FrameRing* frame_ring_create(const char *name, guint width, guint height, guint slots, guint fps, char **out_error) {
+  if (out_error) *out_error = NULL;
+  if (width == 0 || height == 0 || slots < 2) {
+    if (out_error) *out_error = g_strdup("Frame ring needs a size and at least two slots");
+    return NULL;
+  }
+
+  FrameRing *r = g_new0(FrameRing, 1);
+  r->name = shm_name(name);
+  r->writer = TRUE;
+
+  guint stride = width * 4;
+  gsize slot_size = align64(sizeof(FrameSlotHeader) + (gsize)stride * height);
+  r->map_size = sizeof(FrameRingHeader) + slot_size * slots;
+
+  // Replace any ring left behind by a crashed writer (readers keep their old mapping)
+  shm_unlink(r->name);
+  r->fd = shm_open(r->name, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+  if (r->fd < 0 || ftruncate(r->fd, (off_t)r->map_size) != 0) {
+    set_error(out_error, "Cannot create shared memory", r->name);
+    if (r->fd >= 0) close(r->fd);
+    g_free(r->name);
+    g_free(r);
+    return NULL;
+  }
+
+  r->map = mmap(NULL, r->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, r->fd, 0);
+  if (r->map == MAP_FAILED) {
+    set_error(out_error, "Cannot map", r->name);
+    close(r->fd);
+    shm_unlink(r->name);
+    g_free(r->name);
+    g_free(r);
+    return NULL;
+  }
+
+  // ftruncate zero-fills: every slot starts with seq 0 and latest 0
+  r->hdr = (FrameRingHeader*)r->map;
+  r->hdr->version = FRAME_RING_VERSION;
+  r->hdr->width = width;
+  r->hdr->height = height;
+  r->hdr->stride = stride;
+  r->hdr->slots = slots;
+  r->hdr->format = FRAME_FORMAT_BGRA8_PREMUL;
+  r->hdr->fps = fps;
+  r->hdr->slot_size = slot_size;
+  r->hdr->writer_pid = (uint32_t)getpid();
+  // Magic last, so a reader that sees it also sees the geometry
+  __atomic_store_n(&r->hdr->magic, FRAME_RING_MAGIC, __ATOMIC_RELEASE);
+  return r;
+}
+
+guint8* frame_ring_begin(FrameRing *r) {
+  r->pending = __atomic_load_n(&r->hdr->latest, __ATOMIC_RELAXED) + 1;
+  FrameSlotHeader *slot = slot_at(r, r->pending);
+
+  guint32 seq = __atomic_load_n(&slot->seq, __ATOMIC_RELAXED);
+  __atomic_store_n(&slot->seq, seq + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  return slot_pixels(slot);
+}
+
+void frame_ring_commit(FrameRing *r, gint64 monotonic_us) {
+  FrameSlotHeader *slot = slot_at(r, r->pending);
+  slot->frame = r->pending;
+  slot->monotonic_us = monotonic_us;
+
+  guint32 seq = __atomic_load_n(&slot->seq, __ATOMIC_RELAXED);
+  __atomic_store_n(&slot->seq, seq + 1, __ATOMIC_RELEASE);
+  __atomic_store_n(&r->hdr->latest, r->pending, __ATOMIC_RELEASE);
+}
+
+FrameRing* frame_ring_open(const char *name, char **out_error) {
+  if (out_error) *out_error = NULL;
+
+  FrameRing *r = g_new0(FrameRing, 1);
+  r->name = shm_name(name);
+  r->fd = shm_open(r->name, O_RDONLY | O_CLOEXEC, 0);
+  struct stat st;
+  if (r->fd < 0 || fstat(r->fd, &st) != 0 || (gsize)st.st_size < sizeof(FrameRingHeader)) {
+    set_error(out_error, "Cannot open shared memory", r->name);
+    if (r->fd >= 0) close(r->fd);
+    g_free(r->name);
+    g_free(r);
+    return NULL;
+  }
+
+  r->map_size = (gsize)st.st_size;
+  r->map = mmap(NULL, r->map_size, PROT_READ, MAP_SHARED, r->fd, 0);
+  if (r->map == MAP_FAILED) {
+    set_error(out_error, "Cannot map", r->name);
+    close(r->fd);
+    g_free(r->name);
+    g_free(r);
+    return NULL;
+  }
+  r->hdr = (FrameRingHeader*)r->map;
+
+  gboolean valid = __atomic_load_n(&r->hdr->magic, __ATOMIC_ACQUIRE) == FRAME_RING_MAGIC &&
+                   r->hdr->version == FRAME_RING_VERSION &&
+                   r->hdr->slots >= 2 &&
+                   r->hdr->slot_size >= sizeof(FrameSlotHeader) + (guint64)r->hdr->stride * r->hdr->height &&
+                   sizeof(FrameRingHeader) + r->hdr->slot_size * r->hdr->slots <= r->map_size;
+  if (!valid) {
+    if (out_error) *out_error = g_strdup_printf("%s is not a LiveSpiff frame ring (or another version)", r->name);
+    frame_ring_close(r);
+    return NULL;
+  }
+  return r;
+}
+
+gboolean frame_ring_read_latest(FrameRing *r, guint8 *dst, guint64 *out_frame, gint64 *out_monotonic_us) {
+  gsize bytes = (gsize)r->hdr->stride * r->hdr->height;
+
+  for (int attempt = 0; attempt < READ_ATTEMPTS; attempt++) {
+    guint64 latest = __atomic_load_n(&r->hdr->latest, __ATOMIC_ACQUIRE);
+    if (latest == 0) return FALSE;
+
+    FrameSlotHeader *slot = slot_at(r, latest);
+    guint32 before = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+    if (before & 1) continue;
+
+    guint64 frame = slot->frame;
+    gint64 mono = slot->monotonic_us;
+    memcpy(dst, slot_pixels(slot), bytes);
+
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) != before) continue;
+
+    if (out_frame) *out_frame = frame;
+    if (out_monotonic_us) *out_monotonic_us = mono;
+    return TRUE;
+  }
+  return FALSE;
+}
+
+const FrameRingHeader* frame_ring_header(const FrameRing *r) {
+  return r->hdr;
+}
+
+void frame_ring_close(FrameRing *r) {
+  if (!r) return;
+  if (r->writer) {
+    __atomic_store_n(&r->hdr->writer_pid, 0, __ATOMIC_RELEASE);
+    shm_unlink(r->name);
+  }
+  munmap(r->map, r->map_size);
+  close(r->fd);
+  g_free(r->name);
+  g_free(r);
+}
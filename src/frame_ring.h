@@ -0,0 +1,66 @@
+#pragma once
+#include <glib.h>
+#include <stdint.h>
+
+// Shared-memory ring of rendered timer frames (POSIX shm, /dev/shm/<name>).
+//
+// Layout, all little-endian, every block 64-byte aligned:
+//   FrameRingHeader
+//   slots x { FrameSlotHeader, stride * height bytes of pixels }
+//
+// Pixels are BGRA8 premultiplied (Cairo ARGB32 on little-endian), rows
+// `stride` bytes apart. One writer, any number of readers; readers never
+// block the writer. Each slot is a seqlock: the writer makes seq odd,
+// writes the pixels, makes it even again and then publishes the frame
+// number in `latest`. A reader picks slot (latest % slots), copies it and
+// keeps the copy only if seq was even and unchanged around the copy.
+
+#define FRAME_RING_MAGIC   0x5246534cu // "LSFR"
+#define FRAME_RING_VERSION 1u
+#define FRAME_RING_DEFAULT_NAME "livespiff-frames"
+
+enum { FRAME_FORMAT_BGRA8_PREMUL = 0 };
+
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t width;
+  uint32_t height;
+  uint32_t stride;
+  uint32_t slots;
+  uint32_t format;
+  uint32_t fps;                // target rate; frames are only published when the picture changes
+  uint64_t slot_size;          // bytes from one FrameSlotHeader to the next
+  uint64_t latest;             // frame number of the newest complete frame; 0: none yet
+  uint32_t writer_pid;         // 0 once the writer has exited
+  uint8_t reserved[12];
+} FrameRingHeader;
+
+typedef struct {
+  uint32_t seq;                // odd while being written
+  uint32_t reserved0;
+  uint64_t frame;              // frame number held by this slot
+  int64_t monotonic_us;        // CLOCK_MONOTONIC time the frame shows
+  uint8_t reserved[40];
+} FrameSlotHeader;
+
+G_STATIC_ASSERT(sizeof(FrameRingHeader) == 64);
+G_STATIC_ASSERT(sizeof(FrameSlotHeader) == 64);
+
+typedef struct FrameRing FrameRing;
+
+// Writer: creates (or replaces) the shared-memory object
+FrameRing* frame_ring_create(const char *name, guint width, guint height, guint slots, guint fps, char **out_error);
+// Pixels of the next slot to draw into; commit publishes it
+guint8* frame_ring_begin(FrameRing *r);
+void frame_ring_commit(FrameRing *r, gint64 monotonic_us);
+
+// Reader: maps an existing ring read-only
+FrameRing* frame_ring_open(const char *name, char **out_error);
+// Copies the newest frame into dst (stride * height bytes). Returns FALSE if
+// no frame has been published, or if the writer kept overwriting it.
+gboolean frame_ring_read_latest(FrameRing *r, guint8 *dst, guint64 *out_frame, gint64 *out_monotonic_us);
+
+const FrameRingHeader* frame_ring_header(const FrameRing *r);
+// Writer: marks the ring abandoned and unlinks it. Reader: unmaps.
+void frame_ring_close(FrameRing *r);
@@ -0,0 +1,434 @@
+#include "global_shortcuts.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define PORTAL_BUS_NAME  "org.freedesktop.portal.Desktop"
+#define PORTAL_OBJ_PATH  "/org/freedesktop/portal/desktop"
+#define PORTAL_IFACE     "org.freedesktop.portal.GlobalShortcuts"
+#define PORTAL_REQUEST   "org.freedesktop.portal.Request"
+#define PORTAL_SESSION   "org.freedesktop.portal.Session"
+
+#define KDE_BUS_NAME     "org.kde.kglobalaccel"
+#define KDE_OBJ_PATH     "/kglobalaccel"
+#define KDE_IFACE        "org.kde.KGlobalAccel"
+#define KDE_COMPONENT    "org.kde.kglobalaccel.Component"
+#define KDE_COMPONENT_ID "livespiff"
+#define KDE_SET_PRESENT  2u // KGlobalAccel::SetPresent; stored user keys still win
+
+// Activation timestamps further than this from "now" are not on our clock
+#define TIMESTAMP_TRUST_US (2 * G_USEC_PER_SEC)
+
+static const char *action_descriptions[HOTKEY_ACTION_COUNT] = {
+  [HOTKEY_START_SPLIT] = "Start / Split",
+  [HOTKEY_PAUSE] = "Pause / Resume",
+  [HOTKEY_RESET] = "Reset",
+};
+
+static void portal_start(LiveSpiffGlobalShortcuts *gs);
+static void portal_stop(LiveSpiffGlobalShortcuts *gs);
+static void kde_start(LiveSpiffGlobalShortcuts *gs);
+
+LiveSpiffShortcutsBackend shortcuts_backend_from_string(const char *name) {
+  if (g_strcmp0(name, "portal") == 0) return SHORTCUTS_PORTAL;
+  if (g_strcmp0(name, "kglobalaccel") == 0) return SHORTCUTS_KGLOBALACCEL;
+  if (g_strcmp0(name, "none") == 0) return SHORTCUTS_NONE;
+  return SHORTCUTS_AUTO;
+}
+
+static void set_status(LiveSpiffGlobalShortcuts *gs, const char *active, const char *status) {
+  gs->active = active;
+  g_free(gs->status);
+  gs->status = g_strdup(status);
+}
+
+static HotkeyAction action_from_id(const char *id) {
+  for (guint a = HOTKEY_NONE + 1; a < HOTKEY_ACTION_COUNT; a++) {
+    if (g_strcmp0(id, hotkey_action_name((HotkeyAction)a)) == 0) return (HotkeyAction)a;
+  }
+  return HOTKEY_NONE;
+}
+
+static gint64 activation_time_us(gint64 timestamp_ms) {
+  gint64 now = g_get_monotonic_time();
+  gint64 t = timestamp_ms * 1000;
+  return (t <= now && now - t < TIMESTAMP_TRUST_US) ? t : now;
+}
+
+static void fire(LiveSpiffGlobalShortcuts *gs, const char *id, gint64 timestamp_ms) {
+  HotkeyAction action = action_from_id(id);
+  if (action != HOTKEY_NONE) gs->callback(action, activation_time_us(timestamp_ms), gs->user_data);
+}
+
+static gboolean is_cancelled(const GError *err) {
+  return err && g_error_matches(err, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+}
+
+/* ------------------------- trigger labels ------------------------- */
+
+// "Ctrl+Alt+S" -> "CTRL+ALT+s" (XDG shortcuts spec: modifiers, then a keysym name)
+static char* label_to_xdg_trigger(const char *label) {
+  if (!label || !*label) return NULL;
+
+  gchar **parts = g_strsplit(label, "+", -1);
+  GString *out = g_string_new(NULL);
+  for (gchar **p = parts; *p; p++) {
+    g_strstrip(*p);
+    if (!**p) continue;
+    const char *mod = NULL;
+    if (!g_ascii_strcasecmp(*p, "ctrl") || !g_ascii_strcasecmp(*p, "control")) mod = "CTRL";
+    else if (!g_ascii_strcasecmp(*p, "alt")) mod = "ALT";
+    else if (!g_ascii_strcasecmp(*p, "shift")) mod = "SHIFT";
+    else if (!g_ascii_strcasecmp(*p, "meta") || !g_ascii_strcasecmp(*p, "super") ||
+             !g_ascii_strcasecmp(*p, "win") || !g_ascii_strcasecmp(*p, "logo")) mod = "LOGO";
+
+    if (out->len) g_string_append_c(out, '+');
+    if (mod) g_string_append(out, mod);
+    else if (strlen(*p) == 1) g_string_append_c(out, g_ascii_tolower(**p));
+    else g_string_append(out, *p);
+  }
+  g_strfreev(parts);
+  return g_string_free(out, out->len == 0);
+}
+
+// Same label as a Qt key code for KGlobalAccel; 0 if it cannot be expressed
+static gint32 label_to_qt_key(const char *label) {
+  if (!label || !*label) return 0;
+
+  gint32 mods = 0, key = 0;
+  gchar **parts = g_strsplit(label, "+", -1);
+  for (gchar **p = parts; *p; p++) {
+    g_strstrip(*p);
+    if (!g_ascii_strcasecmp(*p, "ctrl") || !g_ascii_strcasecmp(*p, "control")) mods |= 0x04000000;
+    else if (!g_ascii_strcasecmp(*p, "alt")) mods |= 0x08000000;
+    else if (!g_ascii_strcasecmp(*p, "shift")) mods |= 0x02000000;
+    else if (!g_ascii_strcasecmp(*p, "meta") || !g_ascii_strcasecmp(*p, "super") ||
+             !g_ascii_strcasecmp(*p, "win") || !g_ascii_strcasecmp(*p, "logo")) mods |= 0x10000000;
+    else if (strlen(*p) == 1 && g_ascii_isalnum(**p)) key = g_ascii_toupper(**p);
+    else if (!g_ascii_strcasecmp(*p, "space")) key = 0x20;
+    else if ((**p == 'F' || **p == 'f') && g_ascii_isdigit((*p)[1])) {
+      gint n = atoi(*p + 1);
+      if (n >= 1 && n <= 35) key = 0x01000030 + n - 1;
+    }
+  }
+  g_strfreev(parts);
+  return key ? (mods | key) : 0;
+}
+
+/* ------------------------- portal ------------------------- */
+
+static char* portal_request_path(LiveSpiffGlobalShortcuts *gs, const char *token) {
+  // /org/freedesktop/portal/desktop/request/<sender without ':' and '.'->'_'>/<token>
+  char *sender = g_strdup(g_dbus_connection_get_unique_name(gs->bus) + 1);
+  g_strdelimit(sender, ".", '_');
+  char *path = g_strdup_printf("%s/request/%s/%s", PORTAL_OBJ_PATH, sender, token);
+  g_free(sender);
+  return path;
+}
+
+// Subscribe before calling, so a fast Response cannot be missed
+static char* portal_expect_response(LiveSpiffGlobalShortcuts *gs, GDBusSignalCallback callback) {
+  if (gs->request_sub) g_dbus_connection_signal_unsubscribe(gs->bus, gs->request_sub);
+  char *token = g_strdup_printf("livespiff%u", ++gs->token_serial);
+  char *path = portal_request_path(gs, token);
+  gs->request_sub = g_dbus_connection_signal_subscribe(gs->bus, PORTAL_BUS_NAME, PORTAL_REQUEST, "Response",
+                                                       path, NULL, G_DBUS_SIGNAL_FLAGS_NONE,
+                                                       callback, gs, NULL);
+  g_free(path);
+  return token;
+}
+
+static void portal_failed(LiveSpiffGlobalShortcuts *gs, const char *why) {
+  // A session that failed later (e.g. in BindShortcuts) must not keep firing
+  portal_stop(gs);
+  if (gs->requested == SHORTCUTS_AUTO) {
+    kde_start(gs);
+    return;
+  }
+  char *msg = g_strdup_printf("Global shortcuts portal: %s", why);
+  set_status(gs, "none", msg);
+  g_free(msg);
+}
+
+static void on_portal_activated(GDBusConnection *connection, const gchar *sender, const gchar *object_path,
+                                const gchar *interface_name, const gchar *signal_name,
+                                GVariant *params, gpointer user_data) {
+  (void)connection; (void)sender; (void)object_path; (void)interface_name; (void)signal_name;
+  LiveSpiffGlobalShortcuts *gs = (LiveSpiffGlobalShortcuts*)user_data;
+  if (!g_variant_is_of_type(params, G_VARIANT_TYPE("(osta{sv})"))) return;
+
+  const char *session = NULL, *id = NULL;
+  guint64 timestamp = 0;
+  g_variant_get(params, "(&o&sta{sv})", &session, &id, &timestamp, NULL);
+  if (g_strcmp0(session, gs->session_handle) == 0) fire(gs, id, (gint64)timestamp);
+}
+
+static void on_portal_bound(GDBusConnection *connection, const gchar *sender, const gchar *object_path,
+                            const gchar *interface_name, const gchar *signal_name,
+                            GVariant *params, gpointer user_data) {
+  (void)connection; (void)sender; (void)object_path; (void)interface_name; (void)signal_name;
+  LiveSpiffGlobalShortcuts *gs = (LiveSpiffGlobalShortcuts*)user_data;
+  g_dbus_connection_signal_unsubscribe(gs->bus, gs->request_sub);
+  gs->request_sub = 0;
+
+  guint32 response = 2;
+  GVariant *results = NULL;
+  g_variant_get(params, "(u@a{sv})", &response, &results);
+  if (response != 0) {
+    portal_failed(gs, response == 1 ? "binding cancelled by the user" : "binding failed");
+    g_variant_unref(results);
+    return;
+  }
+
+  // "Start / Split: Ctrl+Alt+S, ..." from the triggers the compositor chose
+  GString *status = g_string_new("Registered with the desktop portal");
+  GVariant *shortcuts = g_variant_lookup_value(results, "shortcuts", G_VARIANT_TYPE("a(sa{sv})"));
+  if (shortcuts) {
+    GVariantIter it;
+    const char *id = NULL;
+    GVariant *props = NULL;
+    g_variant_iter_init(&it, shortcuts);
+    while (g_variant_iter_next(&it, "(&s@a{sv})", &id, &props)) {
+      const char *trigger = NULL;
+      HotkeyAction a = action_from_id(id);
+      if (a != HOTKEY_NONE && g_variant_lookup(props, "trigger_description", "&s", &trigger)) {
+        g_string_append_printf(status, "\n%s: %s", action_descriptions[a], *trigger ? trigger : "(unassigned)");
+      }
+      g_variant_unref(props);
+    }
+    g_variant_unref(shortcuts);
+  }
+  set_status(gs, "portal", status->str);
+  g_string_free(status, TRUE);
+  g_variant_unref(results);
+}
+
+static void on_portal_call_done(GObject *source, GAsyncResult *res, gpointer user_data) {
+  GError *err = NULL;
+  GVariant *ret = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source), res, &err);
+  if (ret) {
+    g_variant_unref(ret);
+    return;
+  }
+  if (!is_cancelled(err)) portal_failed((LiveSpiffGlobalShortcuts*)user_data, err->message);
+  g_error_free(err);
+}
+
+static void portal_bind(LiveSpiffGlobalShortcuts *gs) {
+  GVariantBuilder shortcuts;
+  g_variant_builder_init(&shortcuts, G_VARIANT_TYPE("a(sa{sv})"));
+  for (guint a = HOTKEY_NONE + 1; a < HOTKEY_ACTION_COUNT; a++) {
+    GVariantBuilder props;
+    g_variant_builder_init(&props, G_VARIANT_TYPE("a{sv}"));
+    g_variant_builder_add(&props, "{sv}", "description", g_variant_new_string(action_descriptions[a]));
+    char *trigger = label_to_xdg_trigger(gs->triggers[a]);
+    if (trigger) g_variant_builder_add(&props, "{sv}", "preferred_trigger", g_variant_new_string(trigger));
+    g_free(trigger);
+    g_variant_builder_add(&shortcuts, "(sa{sv})", hotkey_action_name((HotkeyAction)a), &props);
+  }
+
+  char *token = portal_expect_response(gs, on_portal_bound);
+  GVariantBuilder options;
+  g_variant_builder_init(&options, G_VARIANT_TYPE("a{sv}"));
+  g_variant_builder_add(&options, "{sv}", "handle_token", g_variant_new_string(token));
+  g_dbus_connection_call(gs->bus, PORTAL_BUS_NAME, PORTAL_OBJ_PATH, PORTAL_IFACE, "BindShortcuts",
+                         g_variant_new("(oa(sa{sv})sa{sv})", gs->session_handle, &shortcuts, "", &options),
+                         G_VARIANT_TYPE("(o)"), G_DBUS_CALL_FLAGS_NONE, -1, gs->cancellable,
+                         on_portal_call_done, gs);
+  g_free(token);
+}
+
+static void on_portal_session_created(GDBusConnection *connection, const gchar *sender, const gchar *object_path,
+                                      const gchar *interface_name, const gchar *signal_name,
+                                      GVariant *params, gpointer user_data) {
+  (void)connection; (void)sender; (void)object_path; (void)interface_name; (void)signal_name;
+  LiveSpiffGlobalShortcuts *gs = (LiveSpiffGlobalShortcuts*)user_data;
+  g_dbus_connection_signal_unsubscribe(gs->bus, gs->request_sub);
+  gs->request_sub = 0;
+
+  guint32 response = 2;
+  GVariant *results = NULL;
+  g_variant_get(params, "(u@a{sv})", &response, &results);
+  // Returned as a string by the spec, as an object path by some implementations
+  GVariant *handle = response == 0 ? g_variant_lookup_value(results, "session_handle", NULL) : NULL;
+  if (!handle || !(g_variant_is_of_type(handle, G_VARIANT_TYPE_STRING) ||
+                   g_variant_is_of_type(handle, G_VARIANT_TYPE_OBJECT_PATH))) {
+    portal_failed(gs, "could not create a session");
+  } else {
+    g_free(gs->session_handle);
+    gs->session_handle = g_variant_dup_string(handle, NULL);
+    gs->activated_sub = g_dbus_connection_signal_subscribe(gs->bus, PORTAL_BUS_NAME, PORTAL_IFACE, "Activated",
+                                                           PORTAL_OBJ_PATH, gs->session_handle,
+                                                           G_DBUS_SIGNAL_FLAGS_NONE,
+                                                           on_portal_activated, gs, NULL);
+    portal_bind(gs);
+  }
+  if (handle) g_variant_unref(handle);
+  g_variant_unref(results);
+}
+
+static void portal_create_session(LiveSpiffGlobalShortcuts *gs) {
+  char *token = portal_expect_response(gs, on_portal_session_created);
+  char *session_token = g_strdup_printf("livespiff_session%u", gs->token_serial);
+
+  GVariantBuilder options;
+  g_variant_builder_init(&options, G_VARIANT_TYPE("a{sv}"));
+  g_variant_builder_add(&options, "{sv}", "handle_token", g_variant_new_string(token));
+  g_variant_builder_add(&options, "{sv}", "session_handle_token", g_variant_new_string(session_token));
+  g_dbus_connection_call(gs->bus, PORTAL_BUS_NAME, PORTAL_OBJ_PATH, PORTAL_IFACE, "CreateSession",
+                         g_variant_new("(a{sv})", &options), G_VARIANT_TYPE("(o)"),
+                         G_DBUS_CALL_FLAGS_NONE, -1, gs->cancellable, on_portal_call_done, gs);
+  g_free(session_token);
+  g_free(token);
+}
+
+static void on_portal_version(GObject *source, GAsyncResult *res, gpointer user_data) {
+  GError *err = NULL;
+  GVariant *ret = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source), res, &err);
+  if (!ret) {
+    if (!is_cancelled(err)) portal_failed((LiveSpiffGlobalShortcuts*)user_data, "not available");
+    g_error_free(err);
+    return;
+  }
+  g_variant_unref(ret);
+  portal_create_session((LiveSpiffGlobalShortcuts*)user_data);
+}
+
+static void portal_start(LiveSpiffGlobalShortcuts *gs) {
+  set_status(gs, "none", "Connecting to the desktop portal...");
+  g_dbus_connection_call(gs->bus, PORTAL_BUS_NAME, PORTAL_OBJ_PATH, "org.freedesktop.DBus.Properties", "Get",
+                         g_variant_new("(ss)", PORTAL_IFACE, "version"), G_VARIANT_TYPE("(v)"),
+                         G_DBUS_CALL_FLAGS_NO_AUTO_START, 2000, gs->cancellable, on_portal_version, gs);
+}
+
+static void portal_stop(LiveSpiffGlobalShortcuts *gs) {
+  if (gs->request_sub) g_dbus_connection_signal_unsubscribe(gs->bus, gs->request_sub);
+  if (gs->activated_sub) g_dbus_connection_signal_unsubscribe(gs->bus, gs->activated_sub);
+  gs->request_sub = gs->activated_sub = 0;
+  if (gs->session_handle) {
+    g_dbus_connection_call(gs->bus, PORTAL_BUS_NAME, gs->session_handle, PORTAL_SESSION, "Close",
+                           NULL, NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL, NULL, NULL);
+    g_free(gs->session_handle);
+    gs->session_handle = NULL;
+  }
+}
+
+/* ------------------------- KGlobalAccel ------------------------- */
+
+static void on_kde_pressed(GDBusConnection *connection, const gchar *sender, const gchar *object_path,
+                           const gchar *interface_name, const gchar *signal_name,
+                           GVariant *params, gpointer user_data) {
+  (void)connection; (void)sender; (void)object_path; (void)interface_name; (void)signal_name;
+  if (!g_variant_is_of_type(params, G_VARIANT_TYPE("(ssx)"))) return;
+  const char *component = NULL, *id = NULL;
+  gint64 timestamp = 0;
+  g_variant_get(params, "(&s&sx)", &component, &id, &timestamp);
+  if (g_strcmp0(component, KDE_COMPONENT_ID) == 0) fire((LiveSpiffGlobalShortcuts*)user_data, id, timestamp);
+}
+
+static void on_kde_component(GObject *source, GAsyncResult *res, gpointer user_data) {
+  GError *err = NULL;
+  GVariant *ret = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source), res, &err);
+  if (!ret) {
+    if (!is_cancelled(err)) {
+      LiveSpiffGlobalShortcuts *gs = (LiveSpiffGlobalShortcuts*)user_data;
+      char *msg = g_strdup_printf("No global shortcut service (portal or KGlobalAccel): %s", err->message);
+      set_status(gs, "none", msg);
+      g_free(msg);
+    }
+    g_error_free(err);
+    return;
+  }
+
+  LiveSpiffGlobalShortcuts *gs = (LiveSpiffGlobalShortcuts*)user_data;
+  const char *path = NULL;
+  g_variant_get(ret, "(&o)", &path);
+  if (gs->kde_sub) g_dbus_connection_signal_unsubscribe(gs->bus, gs->kde_sub);
+  gs->kde_sub = g_dbus_connection_signal_subscribe(gs->bus, KDE_BUS_NAME, KDE_COMPONENT, "globalShortcutPressed",
+                                                   path, NULL, G_DBUS_SIGNAL_FLAGS_NONE, on_kde_pressed, gs, NULL);
+  set_status(gs, "kglobalaccel",
+             "Registered with KDE: change the keys in System Settings → Shortcuts → LiveSpiff");
+  g_variant_unref(ret);
+}
+
+static void kde_start(LiveSpiffGlobalShortcuts *gs) {
+  set_status(gs, "none", "Registering with KGlobalAccel...");
+
+  // Calls on one connection are delivered in order, so no need to chain them
+  for (guint a = HOTKEY_NONE + 1; a < HOTKEY_ACTION_COUNT; a++) {
+    const char *action_id[] = { KDE_COMPONENT_ID, hotkey_action_name((HotkeyAction)a), "LiveSpiff", action_descriptions[a], NULL };
+    g_dbus_connection_call(gs->bus, KDE_BUS_NAME, KDE_OBJ_PATH, KDE_IFACE, "doRegister",
+                           g_variant_new("(^as)", action_id), NULL, G_DBUS_CALL_FLAGS_NONE, -1,
+                           gs->cancellable, NULL, NULL);
+
+    GVariantBuilder keys;
+    g_variant_builder_init(&keys, G_VARIANT_TYPE("ai"));
+    gint32 qt_key = label_to_qt_key(gs->triggers[a]);
+    if (qt_key) g_variant_builder_add(&keys, "i", qt_key);
+    g_dbus_connection_call(gs->bus, KDE_BUS_NAME, KDE_OBJ_PATH, KDE_IFACE, "setShortcut",
+                           g_variant_new("(^asaiu)", action_id, &keys, KDE_SET_PRESENT), NULL,
+                           G_DBUS_CALL_FLAGS_NONE, -1, gs->cancellable, NULL, NULL);
+  }
+
+  g_dbus_connection_call(gs->bus, KDE_BUS_NAME, KDE_OBJ_PATH, KDE_IFACE, "getComponent",
+                         g_variant_new("(s)", KDE_COMPONENT_ID), G_VARIANT_TYPE("(o)"),
+                         G_DBUS_CALL_FLAGS_NONE, 2000, gs->cancellable, on_kde_component, gs);
+}
+
+/* ------------------------- lifecycle ------------------------- */
+
+static void store_triggers(LiveSpiffGlobalShortcuts *gs, const char * const triggers[HOTKEY_ACTION_COUNT]) {
+  for (guint a = 0; a < HOTKEY_ACTION_COUNT; a++) {
+    g_free(gs->triggers[a]);
+    // Kept as the user typed them; converted per backend
+    gs->triggers[a] = (triggers && triggers[a] && *triggers[a]) ? g_strdup(triggers[a]) : NULL;
+  }
+}
+
+static void start(LiveSpiffGlobalShortcuts *gs) {
+  switch (gs->requested) {
+    case SHORTCUTS_AUTO:
+    case SHORTCUTS_PORTAL: portal_start(gs); break;
+    case SHORTCUTS_KGLOBALACCEL: kde_start(gs); break;
+    default: set_status(gs, "none", "Global shortcuts disabled in daemon.ini"); break;
+  }
+}
+
+static void stop(LiveSpiffGlobalShortcuts *gs) {
+  g_cancellable_cancel(gs->cancellable);
+  g_object_unref(gs->cancellable);
+  gs->cancellable = g_cancellable_new();
+  portal_stop(gs);
+  if (gs->kde_sub) g_dbus_connection_signal_unsubscribe(gs->bus, gs->kde_sub);
+  gs->kde_sub = 0;
+}
+
+LiveSpiffGlobalShortcuts* global_shortcuts_new(GDBusConnection *bus, LiveSpiffShortcutsBackend backend,
+                                               const char * const triggers[HOTKEY_ACTION_COUNT],
+                                               HotkeyCallback callback, gpointer user_data) {
+  LiveSpiffGlobalShortcuts *gs = g_new0(LiveSpiffGlobalShortcuts, 1);
+  gs->bus = g_object_ref(bus);
+  gs->cancellable = g_cancellable_new();
+  gs->requested = backend;
+  gs->callback = callback;
+  gs->user_data = user_data;
+  store_triggers(gs, triggers);
+  start(gs);
+  return gs;
+}
+
+void global_shortcuts_rebind(LiveSpiffGlobalShortcuts *gs, const char * const triggers[HOTKEY_ACTION_COUNT]) {
+  if (!gs) return;
+  stop(gs);
+  store_triggers(gs, triggers);
+  start(gs);
+}
+
+void global_shortcuts_free(LiveSpiffGlobalShortcuts *gs) {
+  if (!gs) return;
+  stop(gs);
+  g_object_unref(gs->cancellable);
+  for (guint a = 0; a < HOTKEY_ACTION_COUNT; a++) g_free(gs->triggers[a]);
+  g_free(gs->status);
+  g_object_unref(gs->bus);
+  g_free(gs);
+}
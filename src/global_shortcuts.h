@@ -0,0 +1,52 @@
+#pragma once
+#include <gio/gio.h>
+
+#include "evdev_hotkeys.h" // HotkeyAction, HotkeyCallback
+
+// Which service registers the daemon's global shortcuts
+typedef enum {
+  SHORTCUTS_AUTO = 0,        // portal, else KGlobalAccel
+  SHORTCUTS_PORTAL,          // org.freedesktop.portal.GlobalShortcuts only
+  SHORTCUTS_KGLOBALACCEL,    // org.kde.kglobalaccel only
+  SHORTCUTS_NONE
+} LiveSpiffShortcutsBackend;
+
+// "auto", "portal", "kglobalaccel", "none"
+LiveSpiffShortcutsBackend shortcuts_backend_from_string(const char *name);
+
+// Registers Start/Split, Pause and Reset as desktop-wide shortcuts and
+// reports activations on the main loop. Everything is asynchronous; the
+// connection can be any bus that hosts the services (e.g. a private bus
+// with a mock portal).
+//
+// Timestamps: the compositor's activation time when it is on the monotonic
+// clock (KWin sends CLOCK_MONOTONIC ms), otherwise the arrival time.
+typedef struct {
+  GDBusConnection *bus;
+  GCancellable *cancellable;
+  LiveSpiffShortcutsBackend requested;
+  const char *active;        // "portal", "kglobalaccel" or "none"
+  char *status;              // human-readable state, e.g. the bound triggers
+  char *triggers[HOTKEY_ACTION_COUNT]; // preferred triggers as labels, may be NULL
+
+  // portal
+  char *session_handle;
+  guint request_sub;         // Response of the pending portal request
+  guint activated_sub;
+  guint token_serial;
+
+  // KGlobalAccel
+  guint kde_sub;
+
+  HotkeyCallback callback;
+  gpointer user_data;
+} LiveSpiffGlobalShortcuts;
+
+// triggers: user-facing labels such as "Ctrl+Alt+S" (NULL entries allowed)
+LiveSpiffGlobalShortcuts* global_shortcuts_new(GDBusConnection *bus, LiveSpiffShortcutsBackend backend,
+                                               const char * const triggers[HOTKEY_ACTION_COUNT],
+                                               HotkeyCallback callback, gpointer user_data);
+void global_shortcuts_free(LiveSpiffGlobalShortcuts *gs);
+
+// Drops the current registration and registers again with new preferred triggers
+void global_shortcuts_rebind(LiveSpiffGlobalShortcuts *gs, const char * const triggers[HOTKEY_ACTION_COUNT]);
@@ -0,0 +1,503 @@
+#include "history_db.h"
+#include <sqlite3.h>
+
+// Jobs committed in one transaction at most (an import queues thousands)
+#define HISTORY_DB_BATCH_MAX 1024
+// PRAGMA user_version of schema_sql. Older databases lack columns; being a
+// mirror of the logs, they are dropped and imported again as runs are loaded.
+#define HISTORY_DB_SCHEMA_VERSION 1
+
+static const char *drop_sql =
+  "DROP TABLE IF EXISTS split_times;"
+  "DROP TABLE IF EXISTS attempts;"
+  "DROP TABLE IF EXISTS segments;"
+  "DROP TABLE IF EXISTS runs;";
+
+static const char *schema_sql =
+  "PRAGMA journal_mode = WAL;"
+  "PRAGMA synchronous = NORMAL;"
+  "PRAGMA foreign_keys = ON;"
+  "CREATE TABLE IF NOT EXISTS runs ("
+  "  id INTEGER PRIMARY KEY, path TEXT NOT NULL UNIQUE, history TEXT NOT NULL UNIQUE, game TEXT, category TEXT);"
+  "CREATE TABLE IF NOT EXISTS segments ("
+  "  run_id INTEGER NOT NULL REFERENCES runs(id) ON DELETE CASCADE, idx INTEGER NOT NULL, name TEXT NOT NULL,"
+  "  PRIMARY KEY (run_id, idx)) WITHOUT ROWID;"
+  "CREATE TABLE IF NOT EXISTS attempts ("
+  "  id INTEGER PRIMARY KEY, run_id INTEGER NOT NULL REFERENCES runs(id) ON DELETE CASCADE,"
+  "  started_at_us INTEGER NOT NULL, finished INTEGER NOT NULL, splits INTEGER NOT NULL,"
+  "  final_us INTEGER, has_game_time INTEGER NOT NULL, reset_us INTEGER, reset_game_us INTEGER);"
+  "CREATE INDEX IF NOT EXISTS attempts_by_run ON attempts (run_id, id);"
+  "CREATE TABLE IF NOT EXISTS split_times ("
+  "  attempt_id INTEGER NOT NULL REFERENCES attempts(id) ON DELETE CASCADE, idx INTEGER NOT NULL,"
+  "  split_us INTEGER, game_us INTEGER, PRIMARY KEY (attempt_id, idx)) WITHOUT ROWID;"
+  "PRAGMA user_version = 1;";
+
+typedef enum {
+  W_BEGIN = 0,
+  W_COMMIT,
+  W_ROLLBACK,
+  W_SAVEPOINT,
+  W_RELEASE,
+  W_ROLLBACK_TO,
+  W_RUN_ENSURE,
+  W_RUN_UPDATE,
+  W_SEGMENTS_CLEAR,
+  W_SEGMENT_INSERT,
+  W_ATTEMPT_COUNT,
+  W_ATTEMPT_INSERT,
+  W_SPLIT_INSERT,
+  W_ATTEMPT_DELETE_LAST,
+  W_COUNT
+} WriterStatement;
+
+typedef enum {
+  R_ATTEMPTS = 0,
+  R_ATTEMPT_COUNT,
+  R_COUNT
+} ReaderStatement;
+
+static const char *writer_sql[W_COUNT] = {
+  [W_BEGIN]          = "BEGIN",
+  [W_COMMIT]         = "COMMIT",
+  [W_ROLLBACK]       = "ROLLBACK",
+  [W_SAVEPOINT]      = "SAVEPOINT attempt",
+  [W_RELEASE]        = "RELEASE attempt",
+  [W_ROLLBACK_TO]    = "ROLLBACK TO attempt",
+  [W_RUN_ENSURE]     = "INSERT OR IGNORE INTO runs (path, history) VALUES (?1, ?2)",
+  [W_RUN_UPDATE]     = "UPDATE runs SET game = ?2, category = ?3 WHERE path = ?1",
+  [W_SEGMENTS_CLEAR] = "DELETE FROM segments WHERE run_id = (SELECT id FROM runs WHERE path = ?1)",
+  [W_SEGMENT_INSERT] = "INSERT INTO segments (run_id, idx, name) VALUES ((SELECT id FROM runs WHERE path = ?1), ?2, ?3)",
+  [W_ATTEMPT_COUNT]  = "SELECT count(*) FROM attempts WHERE run_id = (SELECT id FROM runs WHERE history = ?1)",
+  [W_ATTEMPT_INSERT] = "INSERT INTO attempts (run_id, started_at_us, finished, splits, final_us, has_game_time, "
+                       "reset_us, reset_game_us) "
+                       "VALUES ((SELECT id FROM runs WHERE history = ?1), ?2, ?3, ?4, ?5, ?6, ?7, ?8)",
+  [W_SPLIT_INSERT]   = "INSERT INTO split_times (attempt_id, idx, split_us, game_us) VALUES (?1, ?2, ?3, ?4)",
+  // Only if the last row is the attempt being undone (its append may have failed)
+  [W_ATTEMPT_DELETE_LAST] = "DELETE FROM attempts WHERE id = (SELECT max(id) FROM attempts "
+                            "WHERE run_id = (SELECT id FROM runs WHERE history = ?1)) AND started_at_us = ?2",
+};
+
+// R_ATTEMPTS: one row per split (a single NULL split row for attempts without any), in order
+static const char *reader_sql[R_COUNT] = {
+  [R_ATTEMPTS] = "SELECT a.id, a.started_at_us, a.finished, a.has_game_time, a.reset_us, a.reset_game_us, "
+                 "s.idx, s.split_us, s.game_us "
+                 "FROM attempts a LEFT JOIN split_times s ON s.attempt_id = a.id "
+                 "WHERE a.run_id = (SELECT id FROM runs WHERE history = ?1) ORDER BY a.id, s.idx",
+  [R_ATTEMPT_COUNT] = "SELECT count(*) FROM attempts WHERE run_id = (SELECT id FROM runs WHERE history = ?1)",
+};
+
+typedef enum {
+  JOB_RUN,      // run metadata, plus the attempts the database may lack
+  JOB_ATTEMPT,
+  JOB_REMOVE_LAST,
+  JOB_FLUSH,
+  JOB_STOP
+} DbJobKind;
+
+typedef struct {
+  DbJobKind kind;
+  char *run_path;              // JOB_RUN
+  char *history_path;          // the run's log path, which names it in the database
+  char *game;
+  char *category;
+  char **segments;             // JOB_RUN
+  GPtrArray *attempts;         // JOB_RUN, NULL = metadata only
+  LiveSpiffAttempt *attempt;   // JOB_ATTEMPT
+  gint64 started_at_us;        // JOB_REMOVE_LAST
+  gboolean *done;              // JOB_FLUSH, set under the flush lock once committed
+} DbJob;
+
+struct LiveSpiffHistoryDb {
+  sqlite3 *writer;             // the writer thread's, once started
+  sqlite3 *reader;             // any thread's, one at a time under read_lock
+  sqlite3_stmt *w[W_COUNT];
+  sqlite3_stmt *r[R_COUNT];
+  GMutex read_lock;
+  GAsyncQueue *queue;          // DbJob*
+  GThread *thread;
+  GMutex flush_lock;
+  GCond flushed;
+};
+
+char* history_db_default_path(void) {
+  char *data_dir = livespiff_data_dir();
+  char *path = g_build_filename(data_dir, "history.sqlite", NULL);
+  g_free(data_dir);
+  return path;
+}
+
+static void job_free(DbJob *job) {
+  g_free(job->run_path);
+  g_free(job->history_path);
+  g_free(job->game);
+  g_free(job->category);
+  g_strfreev(job->segments);
+  if (job->attempts) g_ptr_array_free(job->attempts, TRUE);
+  attempt_free(job->attempt);
+  g_free(job);
+}
+
+static LiveSpiffAttempt* attempt_copy(const LiveSpiffAttempt *a) {
+  LiveSpiffAttempt *c = attempt_new();
+  c->started_at_us = a->started_at_us;
+  c->finished = a->finished;
+  c->reset_us = a->reset_us;
+  c->reset_game_us = a->reset_game_us;
+  g_array_append_vals(c->split_us, a->split_us->data, a->split_us->len);
+  if (a->game_us) {
+    c->game_us = g_array_sized_new(FALSE, FALSE, sizeof(gint64), a->game_us->len);
+    g_array_append_vals(c->game_us, a->game_us->data, a->game_us->len);
+  }
+  return c;
+}
+
+/* ------------------------- writer thread ------------------------- */
+
+static void bind_time(sqlite3_stmt *st, int col, gint64 t) {
+  if (t == LIVESPIFF_NO_TIME) sqlite3_bind_null(st, col);
+  else sqlite3_bind_int64(st, col, t);
+}
+
+// Runs a statement to completion and resets it for the next use
+static gboolean exec_stmt(sqlite3 *conn, sqlite3_stmt *st) {
+  int rc = sqlite3_step(st);
+  gboolean ok = rc == SQLITE_DONE || rc == SQLITE_ROW;
+  if (!ok) g_printerr("History database: %s\n", sqlite3_errmsg(conn));
+  sqlite3_reset(st);
+  sqlite3_clear_bindings(st);
+  return ok;
+}
+
+static gboolean insert_attempt(LiveSpiffHistoryDb *db, const char *history_path, const LiveSpiffAttempt *a) {
+  gint64 final_us = LIVESPIFF_NO_TIME;
+  for (guint i = a->split_us->len; i > 0 && final_us == LIVESPIFF_NO_TIME; i--) {
+    final_us = g_array_index(a->split_us, gint64, i - 1);
+  }
+
+  sqlite3_stmt *st = db->w[W_ATTEMPT_INSERT];
+  sqlite3_bind_text(st, 1, history_path, -1, SQLITE_STATIC);
+  sqlite3_bind_int64(st, 2, a->started_at_us);
+  sqlite3_bind_int(st, 3, a->finished ? 1 : 0);
+  sqlite3_bind_int(st, 4, (int)a->split_us->len);
+  bind_time(st, 5, final_us);
+  sqlite3_bind_int(st, 6, a->game_us ? 1 : 0);
+  bind_time(st, 7, a->reset_us);
+  bind_time(st, 8, a->reset_game_us);
+  if (!exec_stmt(db->writer, st)) return FALSE;
+
+  sqlite3_int64 id = sqlite3_last_insert_rowid(db->writer);
+  st = db->w[W_SPLIT_INSERT];
+  for (guint i = 0; i < a->split_us->len; i++) {
+    sqlite3_bind_int64(st, 1, id);
+    sqlite3_bind_int(st, 2, (int)i);
+    bind_time(st, 3, g_array_index(a->split_us, gint64, i));
+    if (a->game_us) bind_time(st, 4, attempt_time_us(a, TIMING_GAME, i)); // else NULL
+    if (!exec_stmt(db->writer, st)) return FALSE;
+  }
+  return TRUE;
+}
+
+// All or nothing: a row that fails takes the attempt back to its savepoint,
+// and the rest of the batch still commits
+static void write_attempt(LiveSpiffHistoryDb *db, const char *history_path, const LiveSpiffAttempt *a) {
+  if (!exec_stmt(db->writer, db->w[W_SAVEPOINT])) return;
+  if (!insert_attempt(db, history_path, a)) {
+    exec_stmt(db->writer, db->w[W_ROLLBACK_TO]);
+    g_printerr("History database: attempt of %s left out\n", history_path);
+  }
+  exec_stmt(db->writer, db->w[W_RELEASE]);
+}
+
+static void write_run(LiveSpiffHistoryDb *db, DbJob *job) {
+  sqlite3_stmt *st = db->w[W_RUN_ENSURE];
+  sqlite3_bind_text(st, 1, job->run_path, -1, SQLITE_STATIC);
+  sqlite3_bind_text(st, 2, job->history_path, -1, SQLITE_STATIC);
+  if (!exec_stmt(db->writer, st)) return;
+
+  st = db->w[W_RUN_UPDATE];
+  sqlite3_bind_text(st, 1, job->run_path, -1, SQLITE_STATIC);
+  sqlite3_bind_text(st, 2, job->game, -1, SQLITE_STATIC);
+  sqlite3_bind_text(st, 3, job->category, -1, SQLITE_STATIC);
+  exec_stmt(db->writer, st);
+
+  st = db->w[W_SEGMENTS_CLEAR];
+  sqlite3_bind_text(st, 1, job->run_path, -1, SQLITE_STATIC);
+  exec_stmt(db->writer, st);
+  st = db->w[W_SEGMENT_INSERT];
+  for (guint i = 0; job->segments && job->segments[i]; i++) {
+    sqlite3_bind_text(st, 1, job->run_path, -1, SQLITE_STATIC);
+    sqlite3_bind_int(st, 2, (int)i);
+    sqlite3_bind_text(st, 3, job->segments[i], -1, SQLITE_STATIC);
+    exec_stmt(db->writer, st);
+  }
+  if (!job->attempts) return;
+
+  // Attempts only come and go at the end, so what the database has is a
+  // prefix of what the run was loaded with (more once it took over the run)
+  st = db->w[W_ATTEMPT_COUNT];
+  sqlite3_bind_text(st, 1, job->history_path, -1, SQLITE_STATIC);
+  gint64 have = sqlite3_step(st) == SQLITE_ROW ? sqlite3_column_int64(st, 0) : 0;
+  sqlite3_reset(st);
+  sqlite3_clear_bindings(st);
+  for (guint i = (guint)MIN(have, (gint64)job->attempts->len); i < job->attempts->len; i++) {
+    write_attempt(db, job->history_path, g_ptr_array_index(job->attempts, i));
+  }
+}
+
+static void remove_last(LiveSpiffHistoryDb *db, DbJob *job) {
+  sqlite3_stmt *st = db->w[W_ATTEMPT_DELETE_LAST];
+  sqlite3_bind_text(st, 1, job->history_path, -1, SQLITE_STATIC);
+  sqlite3_bind_int64(st, 2, job->started_at_us);
+  // split_times go with it
+  if (exec_stmt(db->writer, st) && sqlite3_changes(db->writer) == 0) {
+    g_printerr("History database: last attempt of %s is not the undone one, kept\n", job->history_path);
+  }
+}
+
+static gpointer writer_thread(gpointer data) {
+  LiveSpiffHistoryDb *db = (LiveSpiffHistoryDb*)data;
+  GPtrArray *flushes = g_ptr_array_new();
+  gboolean running = TRUE;
+
+  while (running) {
+    DbJob *job = (DbJob*)g_async_queue_pop(db->queue);
+    exec_stmt(db->writer, db->w[W_BEGIN]);
+    for (guint n = 0; job; n++) {
+      switch (job->kind) {
+        case JOB_RUN:     write_run(db, job); break;
+        case JOB_ATTEMPT: write_attempt(db, job->history_path, job->attempt); break;
+        case JOB_REMOVE_LAST: remove_last(db, job); break;
+        case JOB_FLUSH:   g_ptr_array_add(flushes, job->done); break;
+        case JOB_STOP:    running = FALSE; break;
+      }
+      job_free(job);
+      job = running && n + 1 < HISTORY_DB_BATCH_MAX ? (DbJob*)g_async_queue_try_pop(db->queue) : NULL;
+    }
+    if (!exec_stmt(db->writer, db->w[W_COMMIT])) exec_stmt(db->writer, db->w[W_ROLLBACK]);
+
+    if (flushes->len) {
+      g_mutex_lock(&db->flush_lock);
+      for (guint i = 0; i < flushes->len; i++) *(gboolean*)g_ptr_array_index(flushes, i) = TRUE;
+      g_cond_broadcast(&db->flushed);
+      g_mutex_unlock(&db->flush_lock);
+      g_ptr_array_set_size(flushes, 0);
+    }
+  }
+
+  g_ptr_array_free(flushes, TRUE);
+  return NULL;
+}
+
+/* ------------------------- open / close ------------------------- */
+
+static gboolean open_connection(const char *path, sqlite3 **out, char **out_error) {
+  int rc = sqlite3_open_v2(path, out, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX, NULL);
+  if (rc != SQLITE_OK) {
+    if (out_error) *out_error = g_strdup_printf("Cannot open %s: %s", path, *out ? sqlite3_errmsg(*out) : "out of memory");
+    sqlite3_close(*out);
+    *out = NULL;
+    return FALSE;
+  }
+  sqlite3_busy_timeout(*out, 5000);
+  return TRUE;
+}
+
+static gint schema_version(sqlite3 *conn) {
+  sqlite3_stmt *st = NULL;
+  gint version = 0;
+  if (sqlite3_prepare_v2(conn, "PRAGMA user_version", -1, &st, NULL) == SQLITE_OK && sqlite3_step(st) == SQLITE_ROW) {
+    version = sqlite3_column_int(st, 0);
+  }
+  sqlite3_finalize(st);
+  return version;
+}
+
+static gboolean prepare_all(sqlite3 *conn, const char **sql, sqlite3_stmt **stmts, guint n, char **out_error) {
+  for (guint i = 0; i < n; i++) {
+    if (sqlite3_prepare_v3(conn, sql[i], -1, SQLITE_PREPARE_PERSISTENT, &stmts[i], NULL) != SQLITE_OK) {
+      if (out_error) *out_error = g_strdup_printf("History database: %s", sqlite3_errmsg(conn));
+      return FALSE;
+    }
+  }
+  return TRUE;
+}
+
+static void finalize_all(sqlite3_stmt **stmts, guint n) {
+  for (guint i = 0; i < n; i++) sqlite3_finalize(stmts[i]);
+}
+
+static void db_free(LiveSpiffHistoryDb *db) {
+  finalize_all(db->w, W_COUNT);
+  finalize_all(db->r, R_COUNT);
+  sqlite3_close(db->writer);
+  sqlite3_close(db->reader);
+  if (db->queue) g_async_queue_unref(db->queue);
+  g_mutex_clear(&db->read_lock);
+  g_mutex_clear(&db->flush_lock);
+  g_cond_clear(&db->flushed);
+  g_free(db);
+}
+
+LiveSpiffHistoryDb* history_db_open(const char *path, char **out_error) {
+  char *dir = g_path_get_dirname(path);
+  g_mkdir_with_parents(dir, 0700);
+  g_free(dir);
+
+  LiveSpiffHistoryDb *db = g_new0(LiveSpiffHistoryDb, 1);
+  g_mutex_init(&db->read_lock);
+  g_mutex_init(&db->flush_lock);
+  g_cond_init(&db->flushed);
+
+  char *err = NULL;
+  gboolean ok = open_connection(path, &db->writer, out_error);
+  if (ok && schema_version(db->writer) < HISTORY_DB_SCHEMA_VERSION &&
+      sqlite3_exec(db->writer, drop_sql, NULL, NULL, &err) != SQLITE_OK) {
+    if (out_error) *out_error = g_strdup_printf("History database %s: %s", path, err);
+    sqlite3_free(err);
+    ok = FALSE;
+  }
+  if (ok && sqlite3_exec(db->writer, schema_sql, NULL, NULL, &err) != SQLITE_OK) {
+    if (out_error) *out_error = g_strdup_printf("History database %s: %s", path, err);
+    sqlite3_free(err);
+    ok = FALSE;
+  }
+  ok = ok && prepare_all(db->writer, writer_sql, db->w, W_COUNT, out_error);
+  ok = ok && open_connection(path, &db->reader, out_error);
+  ok = ok && prepare_all(db->reader, reader_sql, db->r, R_COUNT, out_error);
+  if (!ok) {
+    db_free(db);
+    return NULL;
+  }
+
+  db->queue = g_async_queue_new();
+  db->thread = g_thread_new("history-db", writer_thread, db);
+  return db;
+}
+
+void history_db_close(LiveSpiffHistoryDb *db) {
+  if (!db) return;
+  DbJob *job = g_new0(DbJob, 1);
+  job->kind = JOB_STOP;
+  g_async_queue_push(db->queue, job);
+  g_thread_join(db->thread);
+  db_free(db);
+}
+
+/* ------------------------- queued writes ------------------------- */
+
+void history_db_sync_run(LiveSpiffHistoryDb *db, const char *run_path, const LiveSpiffRun *run,
+                         const GPtrArray *attempts) {
+  if (!db || !run_path || !run) return;
+  DbJob *job = g_new0(DbJob, 1);
+  job->kind = JOB_RUN;
+  job->run_path = g_strdup(run_path);
+  job->history_path = run_history_path(run_path);
+  job->game = g_strdup(run->game ? run->game : "");
+  job->category = g_strdup(run->category ? run->category : "");
+  job->segments = g_new0(char*, run->segments->len + 1);
+  for (guint i = 0; i < run->segments->len; i++) job->segments[i] = g_strdup(g_ptr_array_index(run->segments, i));
+  if (attempts) {
+    job->attempts = g_ptr_array_new_full(attempts->len, (GDestroyNotify)attempt_free);
+    for (guint i = 0; i < attempts->len; i++) g_ptr_array_add(job->attempts, attempt_copy(g_ptr_array_index(attempts, i)));
+  }
+  g_async_queue_push(db->queue, job);
+}
+
+void history_db_append(LiveSpiffHistoryDb *db, const char *history_path, const LiveSpiffAttempt *attempt) {
+  if (!db || !history_path || !attempt) return;
+  DbJob *job = g_new0(DbJob, 1);
+  job->kind = JOB_ATTEMPT;
+  job->history_path = g_strdup(history_path);
+  job->attempt = attempt_copy(attempt);
+  g_async_queue_push(db->queue, job);
+}
+
+void history_db_remove_last(LiveSpiffHistoryDb *db, const char *history_path, gint64 started_at_us) {
+  if (!db || !history_path) return;
+  DbJob *job = g_new0(DbJob, 1);
+  job->kind = JOB_REMOVE_LAST;
+  job->history_path = g_strdup(history_path);
+  job->started_at_us = started_at_us;
+  g_async_queue_push(db->queue, job);
+}
+
+void history_db_flush(LiveSpiffHistoryDb *db) {
+  if (!db) return;
+  gboolean done = FALSE;
+  DbJob *job = g_new0(DbJob, 1);
+  job->kind = JOB_FLUSH;
+  job->done = &done;
+  g_mutex_lock(&db->flush_lock);
+  g_async_queue_push(db->queue, job);
+  while (!done) g_cond_wait(&db->flushed, &db->flush_lock);
+  g_mutex_unlock(&db->flush_lock);
+}
+
+/* ------------------------- reads ------------------------- */
+
+static gint64 column_time(sqlite3_stmt *st, int col) {
+  return sqlite3_column_type(st, col) == SQLITE_NULL ? LIVESPIFF_NO_TIME : sqlite3_column_int64(st, col);
+}
+
+gboolean history_db_foreach(LiveSpiffHistoryDb *db, const char *history_path, HistoryAttemptFunc func,
+                            gpointer user_data, char **out_error) {
+  if (!db || !func) return FALSE;
+
+  // One attempt reused for every row group, as history_foreach() does
+  g_mutex_lock(&db->read_lock);
+  sqlite3_stmt *st = db->r[R_ATTEMPTS];
+  sqlite3_bind_text(st, 1, history_path, -1, SQLITE_STATIC);
+  LiveSpiffAttempt attempt = { 0, FALSE, g_array_new(FALSE, FALSE, sizeof(gint64)), NULL,
+                               LIVESPIFF_NO_TIME, LIVESPIFF_NO_TIME };
+  GArray *game_us = g_array_new(FALSE, FALSE, sizeof(gint64));
+  sqlite3_int64 current = 0;
+  gboolean have = FALSE, keep_going = TRUE;
+  int rc = SQLITE_DONE;
+
+  while ((rc = sqlite3_step(st)) == SQLITE_ROW) {
+    sqlite3_int64 id = sqlite3_column_int64(st, 0);
+    if (!have || id != current) {
+      if (have && !(keep_going = func(&attempt, user_data))) break;
+      current = id;
+      have = TRUE;
+      attempt.started_at_us = sqlite3_column_int64(st, 1);
+      attempt.finished = sqlite3_column_int(st, 2) != 0;
+      attempt.game_us = sqlite3_column_int(st, 3) ? game_us : NULL;
+      attempt.reset_us = column_time(st, 4);
+      attempt.reset_game_us = column_time(st, 5);
+      g_array_set_size(attempt.split_us, 0);
+      g_array_set_size(game_us, 0);
+    }
+    if (sqlite3_column_type(st, 6) == SQLITE_NULL) continue; // no splits reached
+    gint64 t = column_time(st, 7), g = column_time(st, 8);
+    g_array_append_val(attempt.split_us, t);
+    g_array_append_val(game_us, g);
+  }
+
+  gboolean ok = rc == SQLITE_DONE || (rc == SQLITE_ROW && !keep_going);
+  if (rc == SQLITE_DONE && have) func(&attempt, user_data);
+  if (!ok && out_error) *out_error = g_strdup_printf("History database: %s", sqlite3_errmsg(db->reader));
+
+  sqlite3_reset(st);
+  sqlite3_clear_bindings(st);
+  g_mutex_unlock(&db->read_lock);
+  g_array_free(attempt.split_us, TRUE);
+  g_array_free(game_us, TRUE);
+  return ok;
+}
+
+// Single-value query on the reader, -1 if there is no row or on error
+static gint64 read_int(LiveSpiffHistoryDb *db, ReaderStatement which, const char *history_path) {
+  g_mutex_lock(&db->read_lock);
+  sqlite3_stmt *st = db->r[which];
+  sqlite3_bind_text(st, 1, history_path, -1, SQLITE_STATIC);
+  gint64 n = sqlite3_step(st) == SQLITE_ROW ? sqlite3_column_int64(st, 0) : -1;
+  sqlite3_reset(st);
+  sqlite3_clear_bindings(st);
+  g_mutex_unlock(&db->read_lock);
+  return n;
+}
+
+gint64 history_db_count(LiveSpiffHistoryDb *db, const char *history_path) {
+  return db ? read_int(db, R_ATTEMPT_COUNT, history_path) : -1;
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <glib.h>
+
+#include "storage.h"
+
+// Attempt history in a local SQLite database, for ad-hoc queries (sqlite3
+// CLI, notebooks) across every run. One file for all runs, in WAL mode so
+// readers never block the writer:
+//
+//   runs(id, path, history, game, category)   history = the run's log path
+//   segments(run_id, idx, name)
+//   attempts(id, run_id, started_at_us, finished, splits, final_us, has_game_time, reset_us, reset_game_us)
+//   split_times(attempt_id, idx, split_us, game_us)   NULL = no time
+//
+// Writes are queued and committed by a writer thread, batched into one
+// transaction per wakeup (each attempt under its own savepoint); the caller
+// never waits on the disk. Reads use a second connection, one thread at a
+// time. Statements of both connections are prepared once, at open.
+//
+// The JSON logs stay the history the rest of LiveSpiff reads; the database
+// is a mirror, and only the writer thread waits on it. Runs are named by the
+// path of their log (run_history_path()).
+typedef struct LiveSpiffHistoryDb LiveSpiffHistoryDb;
+
+// ~/.local/share/livespiff/history.sqlite (caller frees)
+char* history_db_default_path(void);
+
+LiveSpiffHistoryDb* history_db_open(const char *path, char **out_error);
+// Commits what is still queued, then closes
+void history_db_close(LiveSpiffHistoryDb *db);
+
+// Queued: game, category and segment names of the run at run_path, and the
+// attempts of its log the database does not have yet (attempts is the whole
+// log, NULL for metadata only; copied)
+void history_db_sync_run(LiveSpiffHistoryDb *db, const char *run_path, const LiveSpiffRun *run,
+                         const GPtrArray *attempts);
+// Queued: one more attempt of the run (copied)
+void history_db_append(LiveSpiffHistoryDb *db, const char *history_path, const LiveSpiffAttempt *attempt);
+// Queued: drop the last attempt of the run if it is the one started at
+// started_at_us, as history_remove_last() does
+void history_db_remove_last(LiveSpiffHistoryDb *db, const char *history_path, gint64 started_at_us);
+// Blocks until everything queued so far is committed
+void history_db_flush(LiveSpiffHistoryDb *db);
+
+// Committed attempts of the run in insertion order, streamed like history_foreach()
+gboolean history_db_foreach(LiveSpiffHistoryDb *db, const char *history_path, HistoryAttemptFunc func,
+                            gpointer user_data, char **out_error);
+// Number of committed attempts of the run, -1 on error
+gint64 history_db_count(LiveSpiffHistoryDb *db, const char *history_path);
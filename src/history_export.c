@@ -0,0 +1,203 @@
+#include "history_export.h"
+#include "storage.h"
+#include <glib/gstdio.h>
+#include <string.h>
+
+typedef struct {
+  FILE *f;
+  HistoryExportFormat format;
+  guint n_segments;
+  guint64 rows;
+  gboolean write_failed;
+
+  // Columnar batch buffers: (2 + n_segments) columns of HISTORY_EXPORT_BATCH_ROWS
+  guint batch_rows;
+  gint64 *started_at;
+  guint8 *finished;
+  gint64 *splits;      // n_segments columns, column-major
+
+  GString *line;       // CSV row buffer
+} ExportCtx;
+
+gboolean history_export_format_from_string(const char *name, HistoryExportFormat *out_format) {
+  if (g_strcmp0(name, "csv") == 0) {
+    *out_format = HISTORY_EXPORT_CSV;
+    return TRUE;
+  }
+  if (g_strcmp0(name, "columnar") == 0) {
+    *out_format = HISTORY_EXPORT_COLUMNAR;
+    return TRUE;
+  }
+  return FALSE;
+}
+
+static void ctx_write(ExportCtx *ctx, const void *data, gsize len) {
+  if (ctx->write_failed || len == 0) return;
+  if (fwrite(data, 1, len, ctx->f) != len) ctx->write_failed = TRUE;
+}
+
+static void write_u32(ExportCtx *ctx, guint32 v) {
+  guint32 le = GUINT32_TO_LE(v);
+  ctx_write(ctx, &le, sizeof(le));
+}
+
+static void write_i64_column(ExportCtx *ctx, gint64 *col, guint rows) {
+#if G_BYTE_ORDER != G_LITTLE_ENDIAN
+  for (guint i = 0; i < rows; i++) col[i] = GINT64_TO_LE(col[i]);
+#endif
+  ctx_write(ctx, col, rows * sizeof(gint64));
+}
+
+/* ------------------------- CSV ------------------------- */
+
+static void csv_append_field(GString *s, const char *field) {
+  if (!strpbrk(field, ",\"\r\n")) {
+    g_string_append(s, field);
+    return;
+  }
+  g_string_append_c(s, '"');
+  for (const char *p = field; *p; p++) {
+    if (*p == '"') g_string_append_c(s, '"');
+    g_string_append_c(s, *p);
+  }
+  g_string_append_c(s, '"');
+}
+
+static void csv_write_header(ExportCtx *ctx, const char * const *segment_names) {
+  g_string_assign(ctx->line, "attempt,started_at_us,finished");
+  for (guint i = 0; i < ctx->n_segments; i++) {
+    g_string_append_c(ctx->line, ',');
+    csv_append_field(ctx->line, segment_names[i] ? segment_names[i] : "");
+  }
+  g_string_append_c(ctx->line, '\n');
+  ctx_write(ctx, ctx->line->str, ctx->line->len);
+}
+
+static void csv_write_row(ExportCtx *ctx, const LiveSpiffAttempt *a) {
+  g_string_printf(ctx->line, "%" G_GUINT64_FORMAT ",%" G_GINT64_FORMAT ",%d",
+                  ctx->rows + 1, a->started_at_us, a->finished ? 1 : 0);
+  for (guint i = 0; i < ctx->n_segments; i++) {
+    gint64 t = attempt_split_us(a, i);
+    if (t == LIVESPIFF_NO_TIME) {
+      g_string_append_c(ctx->line, ',');
+    } else {
+      const char *sign = t < 0 ? "-" : "";
+      guint64 abs_us = (guint64)(t < 0 ? -t : t);
+      g_string_append_printf(ctx->line, ",%s%" G_GUINT64_FORMAT ".%03u",
+                             sign, abs_us / 1000, (guint)(abs_us % 1000));
+    }
+  }
+  g_string_append_c(ctx->line, '\n');
+  ctx_write(ctx, ctx->line->str, ctx->line->len);
+}
+
+/* ------------------------- columnar ------------------------- */
+
+static void columnar_write_header(ExportCtx *ctx, const char * const *segment_names) {
+  ctx_write(ctx, "LSHCOL1\n", 8);
+  write_u32(ctx, ctx->n_segments);
+  for (guint i = 0; i < ctx->n_segments; i++) {
+    const char *name = segment_names[i] ? segment_names[i] : "";
+    guint32 len = (guint32)strlen(name);
+    write_u32(ctx, len);
+    ctx_write(ctx, name, len);
+  }
+}
+
+static void columnar_flush_batch(ExportCtx *ctx) {
+  guint rows = ctx->batch_rows;
+  if (rows == 0) return;
+
+  write_u32(ctx, rows);
+  write_i64_column(ctx, ctx->started_at, rows);
+  ctx_write(ctx, ctx->finished, rows);
+  for (guint s = 0; s < ctx->n_segments; s++) {
+    write_i64_column(ctx, ctx->splits + (gsize)s * HISTORY_EXPORT_BATCH_ROWS, rows);
+  }
+  ctx->batch_rows = 0;
+}
+
+static void columnar_add_row(ExportCtx *ctx, const LiveSpiffAttempt *a) {
+  guint r = ctx->batch_rows++;
+  ctx->started_at[r] = a->started_at_us;
+  ctx->finished[r] = a->finished ? 1 : 0;
+  for (guint s = 0; s < ctx->n_segments; s++) {
+    ctx->splits[(gsize)s * HISTORY_EXPORT_BATCH_ROWS + r] = attempt_split_us(a, s);
+  }
+  if (ctx->batch_rows == HISTORY_EXPORT_BATCH_ROWS) columnar_flush_batch(ctx);
+}
+
+/* ------------------------- driver ------------------------- */
+
+static gboolean export_attempt(const LiveSpiffAttempt *attempt, gpointer user_data) {
+  ExportCtx *ctx = (ExportCtx*)user_data;
+  if (ctx->format == HISTORY_EXPORT_CSV) csv_write_row(ctx, attempt);
+  else columnar_add_row(ctx, attempt);
+  ctx->rows++;
+  return !ctx->write_failed;
+}
+
+gboolean history_export(const char *history_path,
+                        const char * const *segment_names, guint n_segments,
+                        const char *out_path, HistoryExportFormat format,
+                        guint64 *out_rows, char **out_error) {
+  if (!out_path || !*out_path) {
+    if (out_error) *out_error = g_strdup("No output path");
+    return FALSE;
+  }
+
+  char *part_path = g_strconcat(out_path, ".part", NULL);
+  FILE *f = g_fopen(part_path, "wb");
+  if (!f) {
+    if (out_error) *out_error = g_strdup_printf("Failed to create %s", part_path);
+    g_free(part_path);
+    return FALSE;
+  }
+  setvbuf(f, NULL, _IOFBF, 1 << 16);
+
+  ExportCtx ctx = {0};
+  ctx.f = f;
+  ctx.format = format;
+  ctx.n_segments = n_segments;
+
+  if (format == HISTORY_EXPORT_CSV) {
+    ctx.line = g_string_sized_new(64 + 16 * n_segments);
+    csv_write_header(&ctx, segment_names);
+  } else {
+    ctx.started_at = g_new(gint64, HISTORY_EXPORT_BATCH_ROWS);
+    ctx.finished = g_new(guint8, HISTORY_EXPORT_BATCH_ROWS);
+    ctx.splits = g_new(gint64, (gsize)HISTORY_EXPORT_BATCH_ROWS * MAX(n_segments, 1));
+    columnar_write_header(&ctx, segment_names);
+  }
+
+  char *read_error = NULL;
+  gboolean ok = history_foreach(history_path, export_attempt, &ctx, &read_error);
+
+  if (format == HISTORY_EXPORT_COLUMNAR) {
+    columnar_flush_batch(&ctx);
+    write_u32(&ctx, 0);
+  }
+
+  if (fclose(f) != 0) ctx.write_failed = TRUE;
+
+  if (ok && ctx.write_failed) {
+    read_error = g_strdup_printf("Failed to write %s", part_path);
+    ok = FALSE;
+  }
+  if (ok && g_rename(part_path, out_path) != 0) {
+    read_error = g_strdup_printf("Failed to rename %s to %s", part_path, out_path);
+    ok = FALSE;
+  }
+  if (!ok) g_remove(part_path);
+
+  if (ok && out_rows) *out_rows = ctx.rows;
+  if (!ok && out_error) *out_error = read_error;
+  else g_free(read_error);
+
+  if (ctx.line) g_string_free(ctx.line, TRUE);
+  g_free(ctx.started_at);
+  g_free(ctx.finished);
+  g_free(ctx.splits);
+  g_free(part_path);
+  return ok;
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <glib.h>
+
+typedef enum {
+  HISTORY_EXPORT_CSV,
+  HISTORY_EXPORT_COLUMNAR
+} HistoryExportFormat;
+
+// "csv" or "columnar"
+gboolean history_export_format_from_string(const char *name, HistoryExportFormat *out_format);
+
+// Streams the attempts in history_path to out_path, in batches of
+// HISTORY_EXPORT_BATCH_ROWS, so memory is independent of history size.
+// The file is written as out_path.part and renamed on success.
+//
+// CSV: attempt,started_at_us,finished,<segment 1>,...,<segment n>
+//      split cells are cumulative times in ms (3 decimals), empty if unknown.
+//
+// Columnar (all integers little-endian):
+//   "LSHCOL1\n"
+//   u32 segment_count, then per segment: u32 name_len, UTF-8 name bytes
+//   batches: u32 rows (> 0)
+//            i64[rows] started_at_us
+//            u8[rows]  finished
+//            per segment: i64[rows] cumulative split_us (INT64_MIN if unknown)
+//   u32 0 (end of data)
+#define HISTORY_EXPORT_BATCH_ROWS 4096
+
+gboolean history_export(const char *history_path,
+                        const char * const *segment_names, guint n_segments,
+                        const char *out_path, HistoryExportFormat format,
+                        guint64 *out_rows, char **out_error);
@@ -0,0 +1,249 @@
+#include "history_model.h"
+
+#define HISTORY_PAGE_ROWS 200
+#define HISTORY_PAGE_CACHE 8   // decoded pages kept, least recently used dropped
+
+/* ------------------------- item ------------------------- */
+
+struct _LiveSpiffAttemptItem {
+  GObject parent_instance;
+  LiveSpiffAttemptRow row;
+};
+
+G_DEFINE_TYPE(LiveSpiffAttemptItem, livespiff_attempt_item, G_TYPE_OBJECT)
+
+static void livespiff_attempt_item_class_init(LiveSpiffAttemptItemClass *klass) { (void)klass; }
+static void livespiff_attempt_item_init(LiveSpiffAttemptItem *item) { (void)item; }
+
+static LiveSpiffAttemptItem* attempt_item_new(const LiveSpiffAttemptRow *row) {
+  LiveSpiffAttemptItem *item = g_object_new(LIVESPIFF_TYPE_ATTEMPT_ITEM, NULL);
+  item->row = *row;
+  return item;
+}
+
+const LiveSpiffAttemptRow* livespiff_attempt_item_get_row(LiveSpiffAttemptItem *item) {
+  return &item->row;
+}
+
+/* ------------------------- model ------------------------- */
+
+typedef struct {
+  guint index;
+  GArray *rows;              // LiveSpiffAttemptRow
+  GList *link;               // in the model's LRU queue
+} Page;
+
+struct _LiveSpiffHistoryModel {
+  GObject parent_instance;
+
+  GDBusProxy *proxy;
+  char *sort;
+  char *filter;
+  char *error;
+
+  guint n_items;
+  guint revision;            // daemon history revision the pages belong to
+  gboolean awaiting_first;   // query changed, the next reply sets n_items
+  guint generation;          // replies to older queries are dropped
+
+  GHashTable *pages;         // GUINT_TO_POINTER(index) -> Page*
+  GQueue lru;                // Page*, most recently used first
+  GHashTable *pending;       // page indexes being fetched
+};
+
+static void livespiff_history_model_iface_init(GListModelInterface *iface);
+
+G_DEFINE_TYPE_WITH_CODE(LiveSpiffHistoryModel, livespiff_history_model, G_TYPE_OBJECT,
+                        G_IMPLEMENT_INTERFACE(G_TYPE_LIST_MODEL, livespiff_history_model_iface_init))
+
+static void page_free(Page *p) {
+  g_array_free(p->rows, TRUE);
+  g_free(p);
+}
+
+static void drop_pages(LiveSpiffHistoryModel *m) {
+  g_hash_table_remove_all(m->pages);
+  g_queue_clear(&m->lru);
+  g_hash_table_remove_all(m->pending);
+}
+
+static void page_store(LiveSpiffHistoryModel *m, Page *p) {
+  g_queue_push_head(&m->lru, p);
+  p->link = m->lru.head;
+  g_hash_table_insert(m->pages, GUINT_TO_POINTER(p->index), p);
+
+  while (m->lru.length > HISTORY_PAGE_CACHE) {
+    Page *old = (Page*)g_queue_pop_tail(&m->lru);
+    g_hash_table_remove(m->pages, GUINT_TO_POINTER(old->index));
+  }
+}
+
+typedef struct {
+  LiveSpiffHistoryModel *model; // ref
+  guint generation;
+  guint index;
+} PageRequest;
+
+static void on_page_reply(GObject *source, GAsyncResult *res, gpointer user_data) {
+  PageRequest *req = (PageRequest*)user_data;
+  LiveSpiffHistoryModel *m = req->model;
+  GVariant *ret = g_dbus_proxy_call_finish(G_DBUS_PROXY(source), res, NULL);
+
+  if (req->generation != m->generation) goto out;
+  g_hash_table_remove(m->pending, GUINT_TO_POINTER(req->index));
+
+  gboolean ok = FALSE;
+  const char *msg = NULL;
+  guint32 revision = 0, total = 0;
+  GVariantIter *it = NULL;
+  if (ret) g_variant_get(ret, "(b&suua(uxbxub))", &ok, &msg, &revision, &total, &it);
+
+  g_free(m->error);
+  m->error = NULL;
+  if (!ok) {
+    m->error = g_strdup(ret ? msg : "Daemon not reachable");
+    guint old = m->n_items;
+    m->n_items = 0;
+    m->awaiting_first = FALSE;
+    drop_pages(m);
+    if (it) g_variant_iter_free(it);
+    g_list_model_items_changed(G_LIST_MODEL(m), 0, old, 0);
+    goto out;
+  }
+
+  Page *p = g_new0(Page, 1);
+  p->index = req->index;
+  p->rows = g_array_sized_new(FALSE, FALSE, sizeof(LiveSpiffAttemptRow), HISTORY_PAGE_ROWS);
+  LiveSpiffAttemptRow row = { .loaded = TRUE };
+  while (g_variant_iter_next(it, "(uxbxub)", &row.id, &row.started_at_us, &row.finished,
+                             &row.time_ms, &row.splits_reached, &row.pb)) {
+    g_array_append_val(p->rows, row);
+  }
+  g_variant_iter_free(it);
+
+  // A new query, or the history moved under us: everything restarts from
+  // this page's revision
+  if (m->awaiting_first || revision != m->revision) {
+    guint old = m->n_items;
+    drop_pages(m);
+    m->awaiting_first = FALSE;
+    m->revision = revision;
+    m->n_items = total;
+    page_store(m, p);
+    g_list_model_items_changed(G_LIST_MODEL(m), 0, old, total);
+    goto out;
+  }
+
+  page_store(m, p);
+  guint first = p->index * HISTORY_PAGE_ROWS;
+  guint n = MIN(p->rows->len, m->n_items > first ? m->n_items - first : 0);
+  if (n) g_list_model_items_changed(G_LIST_MODEL(m), first, n, n);
+
+out:
+  if (ret) g_variant_unref(ret);
+  g_object_unref(req->model);
+  g_free(req);
+}
+
+static void request_page(LiveSpiffHistoryModel *m, guint index) {
+  if (!m->proxy || g_hash_table_contains(m->pending, GUINT_TO_POINTER(index))) return;
+  g_hash_table_add(m->pending, GUINT_TO_POINTER(index));
+
+  PageRequest *req = g_new0(PageRequest, 1);
+  req->model = g_object_ref(m);
+  req->generation = m->generation;
+  req->index = index;
+  g_dbus_proxy_call(m->proxy, "ListAttempts",
+                    g_variant_new("(ssuu)", m->sort, m->filter, index * HISTORY_PAGE_ROWS, HISTORY_PAGE_ROWS),
+                    G_DBUS_CALL_FLAGS_NONE, 2000, NULL, on_page_reply, req);
+}
+
+static GType history_model_get_item_type(GListModel *list) {
+  (void)list;
+  return LIVESPIFF_TYPE_ATTEMPT_ITEM;
+}
+
+static guint history_model_get_n_items(GListModel *list) {
+  return LIVESPIFF_HISTORY_MODEL(list)->n_items;
+}
+
+static gpointer history_model_get_item(GListModel *list, guint position) {
+  LiveSpiffHistoryModel *m = LIVESPIFF_HISTORY_MODEL(list);
+  if (position >= m->n_items) return NULL;
+
+  guint index = position / HISTORY_PAGE_ROWS;
+  Page *p = (Page*)g_hash_table_lookup(m->pages, GUINT_TO_POINTER(index));
+  if (p && position % HISTORY_PAGE_ROWS < p->rows->len) {
+    g_queue_unlink(&m->lru, p->link);
+    g_queue_push_head_link(&m->lru, p->link);
+    return attempt_item_new(&g_array_index(p->rows, LiveSpiffAttemptRow, position % HISTORY_PAGE_ROWS));
+  }
+
+  // Placeholder now, the real row via items-changed once the page is in
+  request_page(m, index);
+  LiveSpiffAttemptRow placeholder = { .time_ms = G_MININT64 };
+  return attempt_item_new(&placeholder);
+}
+
+static void livespiff_history_model_iface_init(GListModelInterface *iface) {
+  iface->get_item_type = history_model_get_item_type;
+  iface->get_n_items = history_model_get_n_items;
+  iface->get_item = history_model_get_item;
+}
+
+static void livespiff_history_model_finalize(GObject *obj) {
+  LiveSpiffHistoryModel *m = LIVESPIFF_HISTORY_MODEL(obj);
+  g_queue_clear(&m->lru);
+  g_hash_table_destroy(m->pages);
+  g_hash_table_destroy(m->pending);
+  if (m->proxy) g_object_unref(m->proxy);
+  g_free(m->sort);
+  g_free(m->filter);
+  g_free(m->error);
+  G_OBJECT_CLASS(livespiff_history_model_parent_class)->finalize(obj);
+}
+
+static void livespiff_history_model_class_init(LiveSpiffHistoryModelClass *klass) {
+  G_OBJECT_CLASS(klass)->finalize = livespiff_history_model_finalize;
+}
+
+static void livespiff_history_model_init(LiveSpiffHistoryModel *m) {
+  m->pages = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, (GDestroyNotify)page_free);
+  m->pending = g_hash_table_new(g_direct_hash, g_direct_equal);
+  g_queue_init(&m->lru);
+  m->sort = g_strdup("newest");
+  m->filter = g_strdup("all");
+}
+
+LiveSpiffHistoryModel* livespiff_history_model_new(GDBusProxy *proxy) {
+  LiveSpiffHistoryModel *m = g_object_new(LIVESPIFF_TYPE_HISTORY_MODEL, NULL);
+  m->proxy = proxy ? g_object_ref(proxy) : NULL;
+  livespiff_history_model_refresh(m);
+  return m;
+}
+
+void livespiff_history_model_set_query(LiveSpiffHistoryModel *m, const char *sort, const char *filter) {
+  g_free(m->sort);
+  g_free(m->filter);
+  m->sort = g_strdup(sort);
+  m->filter = g_strdup(filter);
+  livespiff_history_model_refresh(m);
+}
+
+// The old rows stay listed (as placeholders) until the first reply replaces
+// them all, so the view does not flash empty on every recorded attempt.
+void livespiff_history_model_refresh(LiveSpiffHistoryModel *m) {
+  m->generation++;
+  m->awaiting_first = TRUE;
+  drop_pages(m);
+  if (!m->proxy) {
+    g_free(m->error);
+    m->error = g_strdup("Daemon not connected");
+    return;
+  }
+  request_page(m, 0);
+}
+
+const char* livespiff_history_model_get_error(LiveSpiffHistoryModel *m) {
+  return m->error;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <gio/gio.h>
+
+// One attempt as listed by the daemon's ListAttempts
+typedef struct {
+  guint32 id;                // index in the run's history (AttemptSplits)
+  gint64 started_at_us;      // unix us
+  gboolean finished;
+  gint64 time_ms;            // final time, reset time, or last split reached; G_MININT64 if none
+  guint32 splits_reached;
+  gboolean pb;
+  gboolean loaded;           // FALSE: placeholder while its page is fetched
+} LiveSpiffAttemptRow;
+
+#define LIVESPIFF_TYPE_ATTEMPT_ITEM (livespiff_attempt_item_get_type())
+G_DECLARE_FINAL_TYPE(LiveSpiffAttemptItem, livespiff_attempt_item, LIVESPIFF, ATTEMPT_ITEM, GObject)
+
+const LiveSpiffAttemptRow* livespiff_attempt_item_get_row(LiveSpiffAttemptItem *item);
+
+// GListModel of LiveSpiffAttemptItem over the daemon's attempt history.
+// Only the row count is known up front; rows are fetched in pages as the
+// view asks for them, and a small LRU keeps recently used pages decoded.
+// Sorting and filtering happen in the daemon.
+#define LIVESPIFF_TYPE_HISTORY_MODEL (livespiff_history_model_get_type())
+G_DECLARE_FINAL_TYPE(LiveSpiffHistoryModel, livespiff_history_model, LIVESPIFF, HISTORY_MODEL, GObject)
+
+LiveSpiffHistoryModel* livespiff_history_model_new(GDBusProxy *proxy);
+// sort: newest, oldest, fastest, slowest; filter: all, finished, reset, pb.
+// The rows are replaced once the first page of the new query arrives.
+void livespiff_history_model_set_query(LiveSpiffHistoryModel *m, const char *sort, const char *filter);
+// Re-query after the history changed (attempt recorded, run loaded)
+void livespiff_history_model_refresh(LiveSpiffHistoryModel *m);
+// Last daemon error, NULL if the last reply was fine
+const char* livespiff_history_model_get_error(LiveSpiffHistoryModel *m);
@@ -0,0 +1,131 @@
+#include "history_view.h"
+
+static const char *sort_names[] = { "newest", "oldest", "fastest", "slowest" };
+static const char *filter_names[] = { "all", "finished", "reset", "pb" };
+
+static gboolean name_lookup(const char *s, const char **names, guint n, guint *out) {
+  if (!s || !*s) {
+    *out = 0;
+    return TRUE;
+  }
+  for (guint i = 0; i < n; i++) {
+    if (g_strcmp0(s, names[i]) == 0) {
+      *out = i;
+      return TRUE;
+    }
+  }
+  return FALSE;
+}
+
+gboolean history_sort_from_string(const char *s, HistorySort *out) {
+  guint i = 0;
+  if (!name_lookup(s, sort_names, G_N_ELEMENTS(sort_names), &i)) return FALSE;
+  *out = (HistorySort)i;
+  return TRUE;
+}
+
+gboolean history_filter_from_string(const char *s, HistoryFilter *out) {
+  guint i = 0;
+  if (!name_lookup(s, filter_names, G_N_ELEMENTS(filter_names), &i)) return FALSE;
+  *out = (HistoryFilter)i;
+  return TRUE;
+}
+
+gint64 history_attempt_time_us(const LiveSpiffAttempt *a, TimingMethod method) {
+  gint64 reset = a->finished ? LIVESPIFF_NO_TIME : attempt_reset_time_us(a, method);
+  if (reset != LIVESPIFF_NO_TIME) return reset;
+  for (guint i = a->split_us->len; i > 0; i--) {
+    gint64 t = attempt_time_us(a, method, i - 1);
+    if (t != LIVESPIFF_NO_TIME) return t;
+  }
+  return LIVESPIFF_NO_TIME;
+}
+
+typedef struct {
+  const GPtrArray *attempts;
+  HistorySort sort;
+  TimingMethod method;
+} SortCtx;
+
+static gint cmp_i64(gint64 a, gint64 b) {
+  return a < b ? -1 : (a > b ? 1 : 0);
+}
+
+// Fastest order: finished by time, then resets by splits reached (more is
+// better) and time; unknown times last. Ties fall back to the start time.
+static gint cmp_fastest(const LiveSpiffAttempt *a, const LiveSpiffAttempt *b, TimingMethod method) {
+  if (a->finished != b->finished) return a->finished ? -1 : 1;
+  if (!a->finished && a->split_us->len != b->split_us->len) return a->split_us->len > b->split_us->len ? -1 : 1;
+  gint64 ta = history_attempt_time_us(a, method), tb = history_attempt_time_us(b, method);
+  if ((ta == LIVESPIFF_NO_TIME) != (tb == LIVESPIFF_NO_TIME)) return ta == LIVESPIFF_NO_TIME ? 1 : -1;
+  gint c = cmp_i64(ta, tb);
+  return c ? c : cmp_i64(a->started_at_us, b->started_at_us);
+}
+
+static gint cmp_rows(gconstpointer pa, gconstpointer pb, gpointer user_data) {
+  const SortCtx *ctx = (const SortCtx*)user_data;
+  guint ia = *(const guint*)pa, ib = *(const guint*)pb;
+  const LiveSpiffAttempt *a = (const LiveSpiffAttempt*)g_ptr_array_index(ctx->attempts, ia);
+  const LiveSpiffAttempt *b = (const LiveSpiffAttempt*)g_ptr_array_index(ctx->attempts, ib);
+
+  gint c = 0;
+  switch (ctx->sort) {
+    case HISTORY_SORT_OLDEST:  c = cmp_i64(a->started_at_us, b->started_at_us); break;
+    case HISTORY_SORT_FASTEST: c = cmp_fastest(a, b, ctx->method); break;
+    case HISTORY_SORT_SLOWEST: c = -cmp_fastest(a, b, ctx->method); break;
+    case HISTORY_SORT_NEWEST:
+    default:                   c = cmp_i64(b->started_at_us, a->started_at_us); break;
+  }
+  // Stable across rebuilds: log order decides ties
+  return c ? c : (ia < ib ? -1 : (ia > ib ? 1 : 0));
+}
+
+LiveSpiffHistoryView* history_view_build(const GPtrArray *attempts, guint revision, HistorySort sort,
+                                         HistoryFilter filter, TimingMethod method, guint n_segments) {
+  LiveSpiffHistoryView *v = g_new0(LiveSpiffHistoryView, 1);
+  v->revision = revision;
+  v->sort = sort;
+  v->filter = filter;
+  v->method = method;
+  v->n_segments = n_segments;
+  v->order = g_array_sized_new(FALSE, FALSE, sizeof(guint), attempts->len);
+  v->pb = g_array_sized_new(FALSE, TRUE, sizeof(gboolean), attempts->len);
+  g_array_set_size(v->pb, attempts->len);
+
+  // PB flags in log (chronological) order, like stats.c counts them; runs
+  // from an older layout with another number of splits never count
+  gint64 best = LIVESPIFF_NO_TIME;
+  for (guint i = 0; i < attempts->len; i++) {
+    const LiveSpiffAttempt *a = (const LiveSpiffAttempt*)g_ptr_array_index(attempts, i);
+    gboolean full = a->finished && n_segments > 0 && a->split_us->len == n_segments;
+    gint64 t = full ? history_attempt_time_us(a, method) : LIVESPIFF_NO_TIME;
+    if (t != LIVESPIFF_NO_TIME && (best == LIVESPIFF_NO_TIME || t < best)) {
+      best = t;
+      g_array_index(v->pb, gboolean, i) = TRUE;
+    }
+  }
+
+  for (guint i = 0; i < attempts->len; i++) {
+    const LiveSpiffAttempt *a = (const LiveSpiffAttempt*)g_ptr_array_index(attempts, i);
+    gboolean keep = TRUE;
+    switch (filter) {
+      case HISTORY_FILTER_FINISHED: keep = a->finished; break;
+      case HISTORY_FILTER_RESET:    keep = !a->finished; break;
+      case HISTORY_FILTER_PB:       keep = g_array_index(v->pb, gboolean, i); break;
+      case HISTORY_FILTER_ALL:
+      default:                      break;
+    }
+    if (keep) g_array_append_val(v->order, i);
+  }
+
+  SortCtx ctx = { attempts, sort, method };
+  g_array_sort_with_data(v->order, cmp_rows, &ctx);
+  return v;
+}
+
+void history_view_free(LiveSpiffHistoryView *v) {
+  if (!v) return;
+  g_array_free(v->order, TRUE);
+  g_array_free(v->pb, TRUE);
+  g_free(v);
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <glib.h>
+
+#include "storage.h"
+
+typedef enum {
+  HISTORY_SORT_NEWEST = 0,
+  HISTORY_SORT_OLDEST,
+  HISTORY_SORT_FASTEST,      // finished by final time, then resets by progress
+  HISTORY_SORT_SLOWEST
+} HistorySort;
+
+typedef enum {
+  HISTORY_FILTER_ALL = 0,
+  HISTORY_FILTER_FINISHED,
+  HISTORY_FILTER_RESET,
+  HISTORY_FILTER_PB          // finished attempts that set a new PB
+} HistoryFilter;
+
+// One sorted, filtered ordering of a run's attempts. Built in O(n log n)
+// once per (query, history revision) so that paging through it is a slice.
+typedef struct {
+  guint revision;            // history revision it was built from
+  HistorySort sort;
+  HistoryFilter filter;
+  TimingMethod method;       // clock the times (and so PBs) are read on
+  guint n_segments;          // only finished runs of this many splits are PBs
+  GArray *order;             // guint indexes into the attempts array
+  GArray *pb;                // gboolean per attempt (not per row)
+} LiveSpiffHistoryView;
+
+gboolean history_sort_from_string(const char *s, HistorySort *out);     // "newest" ... "" = newest
+gboolean history_filter_from_string(const char *s, HistoryFilter *out); // "all" ... "" = all
+
+LiveSpiffHistoryView* history_view_build(const GPtrArray *attempts, guint revision, HistorySort sort,
+                                         HistoryFilter filter, TimingMethod method, guint n_segments);
+void history_view_free(LiveSpiffHistoryView *v);
+
+// Final time if finished, else the time of the reset, or the last split reached
+// for resets logged without one (LIVESPIFF_NO_TIME if none)
+gint64 history_attempt_time_us(const LiveSpiffAttempt *a, TimingMethod method);
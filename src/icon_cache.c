@@ -0,0 +1,284 @@
+#include "icon_cache.h"
+#include <glib/gstdio.h>
+#include <string.h>
+
+typedef struct {
+  char *key;
+  GdkTexture *texture;
+  gsize bytes;
+  GList *link;               // in lru
+} IconEntry;
+
+typedef struct {
+  IconReadyFunc func;
+  gpointer user_data;
+  GDestroyNotify notify;
+} IconWaiter;
+
+struct LiveSpiffIconCache {
+  gsize max_bytes;
+  gsize bytes;
+  char *thumb_dir;
+  GHashTable *entries;       // key -> IconEntry*
+  GQueue lru;                // IconEntry*, most recent first
+  GHashTable *pending;       // key -> GPtrArray of IconWaiter*
+  GCancellable *cancellable;
+};
+
+typedef struct {
+  char *key;
+  char *path;
+  int size;
+  char *thumb_dir;
+} IconJob;
+
+// Header of a thumbnail file, followed by height * stride bytes of pixels
+typedef struct {
+  char magic[4];             // "LSI1"
+  guint32 width;
+  guint32 height;
+  guint32 stride;
+  guint32 has_alpha;
+} ThumbHeader;
+
+static void waiter_free(IconWaiter *w) {
+  if (w->notify) w->notify(w->user_data);
+  g_free(w);
+}
+
+static void entry_free(IconEntry *e) {
+  g_free(e->key);
+  g_object_unref(e->texture);
+  g_free(e);
+}
+
+static void job_free(IconJob *job) {
+  g_free(job->key);
+  g_free(job->path);
+  g_free(job->thumb_dir);
+  g_free(job);
+}
+
+char* icon_cache_default_dir(void) {
+  return g_build_filename(g_get_user_cache_dir(), "livespiff", "icons", NULL);
+}
+
+LiveSpiffIconCache* icon_cache_new(gsize max_bytes, const char *thumb_dir) {
+  LiveSpiffIconCache *c = g_new0(LiveSpiffIconCache, 1);
+  c->max_bytes = max_bytes;
+  c->thumb_dir = g_strdup(thumb_dir);
+  c->entries = g_hash_table_new(g_str_hash, g_str_equal);
+  g_queue_init(&c->lru);
+  c->pending = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)g_ptr_array_unref);
+  c->cancellable = g_cancellable_new();
+  return c;
+}
+
+/* ------------------------- worker ------------------------- */
+
+static GdkTexture* texture_from_pixels(int width, int height, int stride, gboolean has_alpha, GBytes *pixels) {
+  return gdk_memory_texture_new(width, height, has_alpha ? GDK_MEMORY_R8G8B8A8 : GDK_MEMORY_R8G8B8, pixels, (gsize)stride);
+}
+
+static GdkTexture* thumb_load(const char *thumb_path) {
+  char *data = NULL;
+  gsize len = 0;
+  if (!g_file_get_contents(thumb_path, &data, &len, NULL)) return NULL;
+
+  ThumbHeader h;
+  GdkTexture *texture = NULL;
+  if (len >= sizeof(h)) {
+    memcpy(&h, data, sizeof(h));
+    gsize need = sizeof(h) + (gsize)h.height * h.stride;
+    if (memcmp(h.magic, "LSI1", 4) == 0 && h.width && h.height && h.width <= 4096 && h.height <= 4096 &&
+        h.stride >= h.width * (h.has_alpha ? 4u : 3u) && len == need) {
+      GBytes *pixels = g_bytes_new(data + sizeof(h), len - sizeof(h));
+      texture = texture_from_pixels((int)h.width, (int)h.height, (int)h.stride, h.has_alpha != 0, pixels);
+      g_bytes_unref(pixels);
+    }
+  }
+  g_free(data);
+  return texture;
+}
+
+static void thumb_store(const char *thumb_dir, const char *thumb_path, GdkPixbuf *pb) {
+  if (g_mkdir_with_parents(thumb_dir, 0700) != 0) return;
+  ThumbHeader h = {
+    .magic = { 'L', 'S', 'I', '1' },
+    .width = (guint32)gdk_pixbuf_get_width(pb),
+    .height = (guint32)gdk_pixbuf_get_height(pb),
+    .stride = (guint32)gdk_pixbuf_get_rowstride(pb),
+    .has_alpha = gdk_pixbuf_get_has_alpha(pb) ? 1 : 0,
+  };
+  gsize pixels_len = gdk_pixbuf_get_byte_length(pb);
+  gsize len = sizeof(h) + (gsize)h.height * h.stride;
+  guint8 *buf = g_malloc0(len);
+  memcpy(buf, &h, sizeof(h));
+  memcpy(buf + sizeof(h), gdk_pixbuf_read_pixels(pb), MIN(pixels_len, len - sizeof(h)));
+  g_file_set_contents(thumb_path, (const char*)buf, (gssize)len, NULL); // atomic; best effort
+  g_free(buf);
+}
+
+static void icon_load_thread(GTask *task, gpointer source, gpointer task_data, GCancellable *cancellable) {
+  (void)source;
+  IconJob *job = (IconJob*)task_data;
+  GError *err = NULL;
+
+  GMappedFile *mf = g_mapped_file_new(job->path, FALSE, &err);
+  if (!mf) {
+    g_task_return_error(task, err);
+    return;
+  }
+  GBytes *bytes = g_mapped_file_get_bytes(mf);
+  g_mapped_file_unref(mf);
+
+  // Hashing is far cheaper than decoding, and survives renames
+  char *thumb_path = NULL;
+  if (job->thumb_dir) {
+    char *hash = g_compute_checksum_for_bytes(G_CHECKSUM_SHA256, bytes);
+    char *name = g_strdup_printf("%s-%d.lsicon", hash, job->size);
+    thumb_path = g_build_filename(job->thumb_dir, name, NULL);
+    g_free(name);
+    g_free(hash);
+
+    GdkTexture *texture = thumb_load(thumb_path);
+    if (texture) {
+      g_bytes_unref(bytes);
+      g_free(thumb_path);
+      g_task_return_pointer(task, texture, g_object_unref);
+      return;
+    }
+  }
+
+  GInputStream *in = g_memory_input_stream_new_from_bytes(bytes);
+  GdkPixbuf *pb = gdk_pixbuf_new_from_stream_at_scale(in, job->size, job->size, TRUE, cancellable, &err);
+  g_object_unref(in);
+  g_bytes_unref(bytes);
+  if (!pb) {
+    g_free(thumb_path);
+    g_task_return_error(task, err);
+    return;
+  }
+
+  if (thumb_path) thumb_store(job->thumb_dir, thumb_path, pb);
+  g_free(thumb_path);
+
+  GBytes *pixels = gdk_pixbuf_read_pixel_bytes(pb);
+  GdkTexture *texture = texture_from_pixels(gdk_pixbuf_get_width(pb), gdk_pixbuf_get_height(pb),
+                                            gdk_pixbuf_get_rowstride(pb), gdk_pixbuf_get_has_alpha(pb), pixels);
+  g_bytes_unref(pixels);
+  g_object_unref(pb);
+  g_task_return_pointer(task, texture, g_object_unref);
+}
+
+/* ------------------------- LRU ------------------------- */
+
+static void evict(LiveSpiffIconCache *c) {
+  while (c->bytes > c->max_bytes && c->lru.length > 1) {
+    IconEntry *e = (IconEntry*)g_queue_pop_tail(&c->lru);
+    g_hash_table_remove(c->entries, e->key);
+    c->bytes -= e->bytes;
+    entry_free(e);
+  }
+}
+
+static void insert(LiveSpiffIconCache *c, const char *key, GdkTexture *texture) {
+  IconEntry *e = g_new0(IconEntry, 1);
+  e->key = g_strdup(key);
+  e->texture = g_object_ref(texture);
+  e->bytes = (gsize)gdk_texture_get_width(texture) * (gsize)gdk_texture_get_height(texture) * 4;
+  g_queue_push_head(&c->lru, e);
+  e->link = c->lru.head;
+  g_hash_table_insert(c->entries, e->key, e);
+  c->bytes += e->bytes;
+  evict(c);
+}
+
+static void on_icon_loaded(GObject *source, GAsyncResult *res, gpointer user_data) {
+  (void)source;
+  GTask *task = G_TASK(res);
+  // A freed cache cancels first; nothing of it may be touched then
+  if (g_cancellable_is_cancelled(g_task_get_cancellable(task))) return;
+
+  LiveSpiffIconCache *c = (LiveSpiffIconCache*)user_data;
+  IconJob *job = (IconJob*)g_task_get_task_data(task);
+  GError *err = NULL;
+  GdkTexture *texture = g_task_propagate_pointer(task, &err);
+  if (!texture) {
+    g_printerr("Icon %s: %s\n", job->path, err ? err->message : "failed to load");
+    g_clear_error(&err);
+  } else {
+    insert(c, job->key, texture);
+  }
+
+  GPtrArray *waiters = NULL;
+  char *key = NULL;
+  if (g_hash_table_steal_extended(c->pending, job->key, (gpointer*)&key, (gpointer*)&waiters)) {
+    for (guint i = 0; i < waiters->len; i++) {
+      IconWaiter *w = (IconWaiter*)g_ptr_array_index(waiters, i);
+      w->func(texture, w->user_data);
+    }
+    g_ptr_array_unref(waiters);
+    g_free(key);
+  }
+  if (texture) g_object_unref(texture);
+}
+
+void icon_cache_request(LiveSpiffIconCache *c, const char *path, int size,
+                        IconReadyFunc func, gpointer user_data, GDestroyNotify notify) {
+  GStatBuf st;
+  if (!path || !*path || g_stat(path, &st) != 0) {
+    func(NULL, user_data);
+    if (notify) notify(user_data);
+    return;
+  }
+
+  char *key = g_strdup_printf("%s|%lld|%d", path, (long long)st.st_mtime, size);
+  IconEntry *e = (IconEntry*)g_hash_table_lookup(c->entries, key);
+  if (e) {
+    g_queue_unlink(&c->lru, e->link);
+    g_queue_push_head_link(&c->lru, e->link);
+    func(e->texture, user_data);
+    if (notify) notify(user_data);
+    g_free(key);
+    return;
+  }
+
+  IconWaiter *w = g_new0(IconWaiter, 1);
+  w->func = func;
+  w->user_data = user_data;
+  w->notify = notify;
+
+  GPtrArray *waiters = (GPtrArray*)g_hash_table_lookup(c->pending, key);
+  if (waiters) {
+    g_ptr_array_add(waiters, w);
+    g_free(key);
+    return;
+  }
+  waiters = g_ptr_array_new_with_free_func((GDestroyNotify)waiter_free);
+  g_ptr_array_add(waiters, w);
+  g_hash_table_insert(c->pending, g_strdup(key), waiters);
+
+  IconJob *job = g_new0(IconJob, 1);
+  job->key = key;
+  job->path = g_strdup(path);
+  job->size = size;
+  job->thumb_dir = g_strdup(c->thumb_dir);
+
+  GTask *task = g_task_new(NULL, c->cancellable, on_icon_loaded, c);
+  g_task_set_task_data(task, job, (GDestroyNotify)job_free);
+  g_task_run_in_thread(task, icon_load_thread);
+  g_object_unref(task);
+}
+
+void icon_cache_free(LiveSpiffIconCache *c) {
+  if (!c) return;
+  g_cancellable_cancel(c->cancellable);
+  g_object_unref(c->cancellable);
+  g_hash_table_destroy(c->pending); // notifies waiters still queued
+  g_queue_foreach(&c->lru, (GFunc)entry_free, NULL);
+  g_queue_clear(&c->lru);
+  g_hash_table_destroy(c->entries);
+  g_free(c->thumb_dir);
+  g_free(c);
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <gtk/gtk.h>
+
+// Segment icons, decoded and downscaled off the main thread.
+//
+// Textures are kept in an LRU bounded by max_bytes of pixel data, keyed by
+// path + mtime + display size, so an edited icon is picked up on the next
+// request. The downscaled pixels are also written to thumb_dir under the
+// SHA-256 of the source file and the size, as raw pixels: later launches
+// (or a moved or renamed icon) load them without decoding the image at all.
+typedef struct LiveSpiffIconCache LiveSpiffIconCache;
+
+// texture is NULL if the icon could not be loaded; borrowed for the call
+typedef void (*IconReadyFunc)(GdkTexture *texture, gpointer user_data);
+
+// thumb_dir NULL = no on-disk cache
+LiveSpiffIconCache* icon_cache_new(gsize max_bytes, const char *thumb_dir);
+// ~/.cache/livespiff/icons (caller frees)
+char* icon_cache_default_dir(void);
+
+// Calls func right away on a memory hit, otherwise once the worker is done;
+// concurrent requests for the same key share one load. notify (may be NULL)
+// frees user_data after func ran, or if the cache is freed first.
+void icon_cache_request(LiveSpiffIconCache *c, const char *path, int size,
+                        IconReadyFunc func, gpointer user_data, GDestroyNotify notify);
+void icon_cache_free(LiveSpiffIconCache *c);
@@ -0,0 +1,256 @@
+#include "layout.h"
+#include <string.h>
+
+static const struct {
+  const char *name;
+  guint deps;
+} node_types[LAYOUT_NODE_TYPES] = {
+  [LAYOUT_TIMER]            = { "timer", LAYOUT_DEP_CLOCK | LAYOUT_DEP_STATE },
+  [LAYOUT_STATE]            = { "state", LAYOUT_DEP_STATE | LAYOUT_DEP_CURRENT | LAYOUT_DEP_SEGMENTS },
+  [LAYOUT_SPLIT_LIST]       = { "split_list", LAYOUT_DEP_STATE | LAYOUT_DEP_CURRENT | LAYOUT_DEP_SEGMENTS |
+                                              LAYOUT_DEP_SPLITS | LAYOUT_DEP_COMPARISON },
+  [LAYOUT_DELTA_GRAPH]      = { "delta_graph", LAYOUT_DEP_CLOCK | LAYOUT_DEP_STATE | LAYOUT_DEP_CURRENT |
+                                               LAYOUT_DEP_SEGMENTS | LAYOUT_DEP_SPLITS | LAYOUT_DEP_COMPARISON },
+  [LAYOUT_PREVIOUS_SEGMENT] = { "previous_segment", LAYOUT_DEP_SPLITS | LAYOUT_DEP_CURRENT },
+  [LAYOUT_SUM_OF_BEST]      = { "sum_of_best", LAYOUT_DEP_SUM_OF_BEST },
+  [LAYOUT_TEXT]             = { "text", 0 },
+};
+
+char* layout_path(void) {
+  return g_build_filename(g_get_user_config_dir(), "livespiff", "layout.ini", NULL);
+}
+
+const char* layout_node_type_name(LayoutNodeType type) {
+  return type < LAYOUT_NODE_TYPES ? node_types[type].name : "unknown";
+}
+
+guint layout_node_type_deps(LayoutNodeType type) {
+  return type < LAYOUT_NODE_TYPES ? node_types[type].deps : 0;
+}
+
+static gboolean type_from_name(const char *name, LayoutNodeType *out) {
+  for (guint t = 0; t < LAYOUT_NODE_TYPES; t++) {
+    if (g_strcmp0(name, node_types[t].name) == 0) {
+      *out = (LayoutNodeType)t;
+      return TRUE;
+    }
+  }
+  return FALSE;
+}
+
+static LayoutNode* node_new(LayoutNodeType type, const char *id) {
+  LayoutNode *n = g_new0(LayoutNode, 1);
+  n->type = type;
+  n->id = g_strdup(id);
+  n->deps = node_types[type].deps;
+  n->height = 80;
+  n->icon_size = 24;
+  return n;
+}
+
+static void node_free(LayoutNode *n) {
+  if (!n) return;
+  g_free(n->id);
+  g_free(n->text);
+  g_free(n);
+}
+
+static LiveSpiffLayout* layout_new(void) {
+  LiveSpiffLayout *l = g_new0(LiveSpiffLayout, 1);
+  l->nodes = g_ptr_array_new_with_free_func((GDestroyNotify)node_free);
+  return l;
+}
+
+LiveSpiffLayout* layout_default(void) {
+  LiveSpiffLayout *l = layout_new();
+  g_ptr_array_add(l->nodes, node_new(LAYOUT_TIMER, "timer"));
+  g_ptr_array_add(l->nodes, node_new(LAYOUT_STATE, "state"));
+  return l;
+}
+
+void layout_free(LiveSpiffLayout *l) {
+  if (!l) return;
+  g_ptr_array_free(l->nodes, TRUE);
+  g_free(l);
+}
+
+/*
+ * [layout]
+ * components=timer;splits;graph;note
+ *
+ * [splits]
+ * type=split_list
+ * rows=8
+ *
+ * [note]
+ * type=text
+ * text=Any% NMG
+ *
+ * A component without a type= is looked up by its group name ("timer").
+ */
+LiveSpiffLayout* layout_load(const char *path, char **out_warnings) {
+  if (out_warnings) *out_warnings = NULL;
+
+  GKeyFile *kf = g_key_file_new();
+  GError *err = NULL;
+  if (!g_key_file_load_from_file(kf, path, G_KEY_FILE_NONE, &err)) {
+    if (out_warnings && !g_error_matches(err, G_FILE_ERROR, G_FILE_ERROR_NOENT)) {
+      *out_warnings = g_strdup_printf("%s: %s", path, err->message);
+    }
+    g_error_free(err);
+    g_key_file_free(kf);
+    return layout_default();
+  }
+
+  GString *warnings = g_string_new(NULL);
+  LiveSpiffLayout *l = layout_new();
+  gchar **ids = g_key_file_get_string_list(kf, "layout", "components", NULL, NULL);
+
+  for (gchar **id = ids; id && *id; id++) {
+    g_strstrip(*id);
+    if (!**id) continue;
+
+    char *type_name = g_key_file_get_string(kf, *id, "type", NULL);
+    LayoutNodeType type;
+    if (!type_from_name(type_name ? type_name : *id, &type)) {
+      g_string_append_printf(warnings, "[%s]: unknown component type '%s'\n", *id, type_name ? type_name : *id);
+      g_free(type_name);
+      continue;
+    }
+    g_free(type_name);
+
+    LayoutNode *n = node_new(type, *id);
+    n->text = g_key_file_get_string(kf, *id, "text", NULL);
+    if (g_key_file_has_key(kf, *id, "rows", NULL)) n->rows = MAX(g_key_file_get_integer(kf, *id, "rows", NULL), 0);
+    if (g_key_file_has_key(kf, *id, "icon_size", NULL)) {
+      n->icon_size = CLAMP(g_key_file_get_integer(kf, *id, "icon_size", NULL), 0, 256);
+    }
+    if (g_key_file_has_key(kf, *id, "height", NULL)) {
+      n->height = CLAMP(g_key_file_get_integer(kf, *id, "height", NULL), 16, 1000);
+    }
+    if (type == LAYOUT_TEXT && !n->text) {
+      g_string_append_printf(warnings, "[%s]: text component without text=\n", *id);
+      node_free(n);
+      continue;
+    }
+    g_ptr_array_add(l->nodes, n);
+  }
+  g_strfreev(ids);
+  g_key_file_free(kf);
+
+  if (l->nodes->len == 0) {
+    g_string_append(warnings, "no usable components, using the default layout\n");
+    layout_free(l);
+    l = layout_default();
+  }
+
+  if (out_warnings && warnings->len) *out_warnings = g_strstrip(g_string_free(warnings, FALSE));
+  else g_string_free(warnings, TRUE);
+  return l;
+}
+
+/* ------------------------- model ------------------------- */
+
+void layout_model_init(LayoutModel *m) {
+  memset(m, 0, sizeof(*m));
+  m->segments = g_ptr_array_new_with_free_func(g_free);
+  m->icons = g_ptr_array_new_with_free_func(g_free);
+  m->split_ms = g_array_new(FALSE, FALSE, sizeof(gint64));
+  m->delta_ms = g_array_new(FALSE, FALSE, sizeof(gint64));
+  m->comparison_ms = g_array_new(FALSE, FALSE, sizeof(gint64));
+  m->sum_of_best_ms = LAYOUT_NO_TIME;
+  m->changed = LAYOUT_DEP_ALL;
+}
+
+void layout_model_clear(LayoutModel *m) {
+  g_free(m->state);
+  g_free(m->comparison);
+  g_ptr_array_free(m->segments, TRUE);
+  g_ptr_array_free(m->icons, TRUE);
+  g_array_free(m->split_ms, TRUE);
+  g_array_free(m->delta_ms, TRUE);
+  g_array_free(m->comparison_ms, TRUE);
+  memset(m, 0, sizeof(*m));
+}
+
+void layout_model_set_connected(LayoutModel *m, gboolean connected) {
+  if (m->connected == connected) return;
+  m->connected = connected;
+  m->changed |= LAYOUT_DEP_ALL;
+}
+
+void layout_model_set_state(LayoutModel *m, const char *state) {
+  if (g_strcmp0(m->state, state) == 0) return;
+  g_free(m->state);
+  m->state = g_strdup(state);
+  m->changed |= LAYOUT_DEP_STATE | LAYOUT_DEP_CLOCK;
+}
+
+void layout_model_set_position(LayoutModel *m, gint current_split, gint split_count) {
+  if (m->current_split == current_split && m->split_count == split_count) return;
+  m->current_split = current_split;
+  m->split_count = split_count;
+  m->changed |= LAYOUT_DEP_CURRENT;
+}
+
+void layout_model_set_clock(LayoutModel *m, gint64 elapsed_ms, gint64 mono_us) {
+  m->elapsed_ms = elapsed_ms;
+  m->mono_us = mono_us;
+  m->changed |= LAYOUT_DEP_CLOCK;
+}
+
+void layout_model_set_comparison(LayoutModel *m, const char *name) {
+  if (g_strcmp0(m->comparison, name) == 0) return;
+  g_free(m->comparison);
+  m->comparison = g_strdup(name);
+  m->changed |= LAYOUT_DEP_COMPARISON;
+}
+
+void layout_model_set_sum_of_best(LayoutModel *m, gint64 ms) {
+  if (m->sum_of_best_ms == ms) return;
+  m->sum_of_best_ms = ms;
+  m->changed |= LAYOUT_DEP_SUM_OF_BEST;
+}
+
+static gboolean strings_equal(const GPtrArray *a, const GPtrArray *b) {
+  guint n = b ? b->len : 0;
+  if (a->len != n) return FALSE;
+  for (guint i = 0; i < n; i++) {
+    if (g_strcmp0(g_ptr_array_index(a, i), g_ptr_array_index(b, i)) != 0) return FALSE;
+  }
+  return TRUE;
+}
+
+static void strings_copy(GPtrArray *dst, const GPtrArray *src) {
+  g_ptr_array_set_size(dst, 0);
+  for (guint i = 0; src && i < src->len; i++) g_ptr_array_add(dst, g_strdup(g_ptr_array_index(src, i)));
+}
+
+void layout_model_set_segments(LayoutModel *m, const GPtrArray *names, const GPtrArray *icons) {
+  if (strings_equal(m->segments, names) && strings_equal(m->icons, icons)) return;
+  strings_copy(m->segments, names);
+  strings_copy(m->icons, icons);
+  m->changed |= LAYOUT_DEP_SEGMENTS;
+}
+
+static void array_set(GArray *a, gint i, gint64 v) {
+  gint64 none = LAYOUT_NO_TIME;
+  while (a->len <= (guint)i) g_array_append_val(a, none);
+  g_array_index(a, gint64, i) = v;
+}
+
+void layout_model_set_split(LayoutModel *m, gint index, gint64 split_ms, gint64 delta_ms) {
+  if (index < 0) return;
+  array_set(m->split_ms, index, split_ms);
+  array_set(m->delta_ms, index, delta_ms);
+  m->changed |= LAYOUT_DEP_SPLITS;
+}
+
+gint64 layout_model_elapsed_ms(const LayoutModel *m) {
+  if (g_strcmp0(m->state, "Running") != 0) return m->elapsed_ms;
+  return m->elapsed_ms + (g_get_monotonic_time() - m->mono_us) / 1000;
+}
+
+gint64 layout_model_at(const GArray *a, gint index) {
+  return (index >= 0 && (guint)index < a->len) ? g_array_index(a, gint64, index) : LAYOUT_NO_TIME;
+}
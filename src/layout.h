@@ -0,0 +1,100 @@
+#pragma once
+#include <glib.h>
+
+// Timer fields a layout component can depend on. The UI collects the bits
+// that changed since the last frame and only re-renders components whose
+// dependencies intersect them: while the timer runs, only CLOCK changes per
+// frame, so only clock-driven components are touched however many others
+// the layout has.
+typedef enum {
+  LAYOUT_DEP_CLOCK       = 1 << 0, // running time (every frame while running)
+  LAYOUT_DEP_STATE       = 1 << 1, // timer state, daemon connection
+  LAYOUT_DEP_CURRENT     = 1 << 2, // current split index
+  LAYOUT_DEP_SEGMENTS    = 1 << 3, // segment names and count
+  LAYOUT_DEP_SPLITS      = 1 << 4, // completed split times and their deltas
+  LAYOUT_DEP_COMPARISON  = 1 << 5, // active comparison and its split times
+  LAYOUT_DEP_SUM_OF_BEST = 1 << 6,
+  LAYOUT_DEP_ALL         = 0x7f
+} LayoutDeps;
+
+typedef enum {
+  LAYOUT_TIMER = 0,          // main clock
+  LAYOUT_STATE,              // state and "Split: n / m"
+  LAYOUT_SPLIT_LIST,         // segment names, split times, deltas
+  LAYOUT_DELTA_GRAPH,        // delta vs comparison per completed split, live tail
+  LAYOUT_PREVIOUS_SEGMENT,   // time gained/lost on the last segment
+  LAYOUT_SUM_OF_BEST,
+  LAYOUT_TEXT,               // static text
+  LAYOUT_NODE_TYPES
+} LayoutNodeType;
+
+// One component from the layout file, in display order
+typedef struct {
+  LayoutNodeType type;
+  char *id;                  // group name in layout.ini
+  guint deps;                // LayoutDeps it is re-rendered on
+  char *text;                // text: content; others: caption (may be NULL)
+  gint rows;                 // split_list: visible rows, 0 = all
+  gint icon_size;            // split_list: segment icon pixels, 0 = no icons
+  gint height;               // delta_graph: pixels
+} LayoutNode;
+
+typedef struct {
+  GPtrArray *nodes;          // LayoutNode*
+} LiveSpiffLayout;
+
+// ~/.config/livespiff/layout.ini (caller frees)
+char* layout_path(void);
+
+// The built-in layout: timer, then state
+LiveSpiffLayout* layout_default(void);
+
+// Parses a layout file once. Falls back to layout_default() if it is missing
+// or lists no usable component; problems with single components are skipped
+// and described in out_warnings (caller frees, NULL if none).
+LiveSpiffLayout* layout_load(const char *path, char **out_warnings);
+void layout_free(LiveSpiffLayout *l);
+
+const char* layout_node_type_name(LayoutNodeType type);
+guint layout_node_type_deps(LayoutNodeType type);
+
+// What the layout renders from: a mirror of the daemon, filled by the UI.
+// The setters record what actually changed in `changed`.
+typedef struct {
+  guint changed;             // LayoutDeps since the last frame
+
+  gboolean connected;
+  char *state;
+  gint current_split;
+  gint split_count;
+  gint64 elapsed_ms;         // at mono_us
+  gint64 mono_us;
+  GPtrArray *segments;       // char*
+  GPtrArray *icons;          // char* absolute path per segment, "" = none
+  GArray *split_ms;          // gint64 per completed split
+  GArray *delta_ms;          // gint64 per completed split, vs the active comparison
+  GArray *comparison_ms;     // gint64 cumulative times of the active comparison
+  char *comparison;
+  gint64 sum_of_best_ms;     // G_MININT64 if unknown
+} LayoutModel;
+
+#define LAYOUT_NO_TIME G_MININT64
+
+void layout_model_init(LayoutModel *m);
+void layout_model_clear(LayoutModel *m);
+
+void layout_model_set_connected(LayoutModel *m, gboolean connected);
+void layout_model_set_state(LayoutModel *m, const char *state);
+void layout_model_set_position(LayoutModel *m, gint current_split, gint split_count);
+void layout_model_set_clock(LayoutModel *m, gint64 elapsed_ms, gint64 mono_us);
+void layout_model_set_comparison(LayoutModel *m, const char *name);
+void layout_model_set_sum_of_best(LayoutModel *m, gint64 ms);
+// Copies names and icons (either may be NULL = none) if they differ
+void layout_model_set_segments(LayoutModel *m, const GPtrArray *names, const GPtrArray *icons);
+// For bulk replacement of split_ms / delta_ms / comparison_ms
+static inline void layout_model_touch(LayoutModel *m, guint deps) { m->changed |= deps; }
+void layout_model_set_split(LayoutModel *m, gint index, gint64 split_ms, gint64 delta_ms);
+
+// Elapsed time now, extrapolated while running
+gint64 layout_model_elapsed_ms(const LayoutModel *m);
+gint64 layout_model_at(const GArray *a, gint index);
@@ -0,0 +1,458 @@
+#include "layout_view.h"
+#include "delta_graph.h"
+#include "icon_cache.h"
+#include "split_tree.h"
+
+typedef struct LayoutViewNode LayoutViewNode;
+// `changed`: the LayoutDeps that triggered this render
+typedef void (*NodeRenderFunc)(LayoutViewNode *n, const LayoutModel *m, guint changed);
+
+typedef struct {
+  GtkWidget *icon;           // NULL without an icon column
+  GtkWidget *name;
+  GtkWidget *delta;
+  GtkWidget *time;
+} SplitRow;
+
+struct LayoutViewNode {
+  const LayoutNode *def;
+  GtkWidget *widget;         // top-level widget of the component
+  GtkLabel *value;           // timer, state, previous segment, sum of best
+  GtkGrid *grid;             // split list
+  GArray *rows;              // SplitRow per tree node, split list
+  LiveSpiffSplitTree *tree;  // split list
+  gboolean *opened;          // per tree node: section expanded by the user
+  GArray *visible;           // guint node indexes shown, rebuilt per render
+  const LayoutModel *model;  // last rendered, for re-rendering on clicks
+  LiveSpiffIconCache *icons; // the view's, NULL if no component shows icons
+  NodeRenderFunc render;
+};
+
+struct LayoutView {
+  GtkWidget *root;
+  GPtrArray *nodes;          // LayoutViewNode*
+  guint deps;
+  LiveSpiffIconCache *icons;
+};
+
+#define ICON_CACHE_BYTES (8u << 20)
+
+/* ------------------------- formatting ------------------------- */
+
+static char* format_time_ms(gint64 ms) {
+  if (ms == LAYOUT_NO_TIME) return g_strdup("-");
+  if (ms < 0) ms = 0;
+  gint64 total_sec = ms / 1000;
+  return g_strdup_printf("%02lld:%02lld:%02lld.%03lld",
+                         (long long)(total_sec / 3600),
+                         (long long)((total_sec / 60) % 60),
+                         (long long)(total_sec % 60),
+                         (long long)(ms % 1000));
+}
+
+static char* format_delta_ms(gint64 ms) {
+  if (ms == LAYOUT_NO_TIME) return g_strdup("");
+  char sign = ms < 0 ? '-' : '+';
+  gint64 a = ms < 0 ? -ms : ms;
+  if (a >= 60000) {
+    return g_strdup_printf("%c%lld:%02lld.%01lld", sign,
+                           (long long)(a / 60000), (long long)((a / 1000) % 60), (long long)((a % 1000) / 100));
+  }
+  return g_strdup_printf("%c%lld.%02lld", sign, (long long)(a / 1000), (long long)((a % 1000) / 10));
+}
+
+// Setting an identical text still invalidates the label; skip it
+static void set_text(GtkLabel *label, const char *text) {
+  if (g_strcmp0(gtk_label_get_text(label), text) != 0) gtk_label_set_text(label, text);
+}
+
+static void set_delta_class(GtkWidget *w, gint64 delta) {
+  gtk_widget_remove_css_class(w, "ahead");
+  gtk_widget_remove_css_class(w, "behind");
+  if (delta != LAYOUT_NO_TIME) gtk_widget_add_css_class(w, delta <= 0 ? "ahead" : "behind");
+}
+
+// Index of the last completed split, -1 if none
+static gint last_done(const LayoutModel *m) {
+  return (gint)m->split_ms->len - 1;
+}
+
+/* ------------------------- components ------------------------- */
+
+static void render_timer(LayoutViewNode *n, const LayoutModel *m, guint changed) {
+  (void)changed;
+  if (!m->connected) {
+    set_text(n->value, "--:--:--.---");
+    return;
+  }
+  char *t = format_time_ms(layout_model_elapsed_ms(m));
+  set_text(n->value, t);
+  g_free(t);
+
+  // Game time held by a load dims like a pause
+  if (g_strcmp0(m->state, "Paused") == 0 || g_strcmp0(m->state, "Loading") == 0) gtk_widget_add_css_class(n->widget, "dim");
+  else gtk_widget_remove_css_class(n->widget, "dim");
+}
+
+static void render_state(LayoutViewNode *n, const LayoutModel *m, guint changed) {
+  (void)changed;
+  if (!m->connected) {
+    set_text(n->value, "Daemon not running");
+    return;
+  }
+  char *s = g_strdup_printf("%s    Split: %d / %d", m->state ? m->state : "Unknown",
+                            m->current_split + 1, m->split_count);
+  set_text(n->value, s);
+  g_free(s);
+}
+
+static void render_previous_segment(LayoutViewNode *n, const LayoutModel *m, guint changed) {
+  (void)changed;
+  gint i = last_done(m);
+  gint64 cur = layout_model_at(m->delta_ms, i);
+  gint64 prev = i > 0 ? layout_model_at(m->delta_ms, i - 1) : 0;
+  gint64 gained = (cur == LAYOUT_NO_TIME || prev == LAYOUT_NO_TIME) ? LAYOUT_NO_TIME : cur - prev;
+
+  char *s = gained == LAYOUT_NO_TIME ? g_strdup("-") : format_delta_ms(gained);
+  set_text(n->value, s);
+  g_free(s);
+  set_delta_class(GTK_WIDGET(n->value), gained);
+}
+
+static void render_sum_of_best(LayoutViewNode *n, const LayoutModel *m, guint changed) {
+  (void)changed;
+  char *s = format_time_ms(m->sum_of_best_ms);
+  set_text(n->value, s);
+  g_free(s);
+}
+
+static void render_split_list(LayoutViewNode *n, const LayoutModel *m, guint changed);
+
+static void on_section_clicked(GtkGestureClick *gesture, int n_press, double x, double y, gpointer user_data) {
+  (void)n_press; (void)x; (void)y;
+  LayoutViewNode *n = (LayoutViewNode*)user_data;
+  GtkWidget *label = gtk_event_controller_get_widget(GTK_EVENT_CONTROLLER(gesture));
+  guint node = GPOINTER_TO_UINT(g_object_get_data(G_OBJECT(label), "split-node"));
+  if (!n->tree || node >= n->tree->n_nodes || !n->model) return;
+  n->opened[node] = !n->opened[node];
+  render_split_list(n, n->model, 0);
+}
+
+static void on_icon_ready(GdkTexture *texture, gpointer user_data) {
+  gtk_image_set_from_paintable(GTK_IMAGE(user_data), texture ? GDK_PAINTABLE(texture) : NULL);
+}
+
+// Icon of a node: its own, or a section's closing subsplit's
+static const char* node_icon(const LayoutModel *m, const SplitNode *sn) {
+  guint seg = sn->first_segment + sn->n_segments - 1;
+  const char *path = seg < m->icons->len ? (const char*)g_ptr_array_index(m->icons, seg) : NULL;
+  return path && *path ? path : NULL;
+}
+
+// One row per tree node; sections get a click target to expand them.
+// Icons are decoded on a worker and set when ready.
+static void split_list_rebuild(LayoutViewNode *n, const LayoutModel *m) {
+  for (guint i = 0; i < n->rows->len; i++) {
+    SplitRow *r = &g_array_index(n->rows, SplitRow, i);
+    if (r->icon) gtk_grid_remove(n->grid, r->icon);
+    gtk_grid_remove(n->grid, r->name);
+    gtk_grid_remove(n->grid, r->delta);
+    gtk_grid_remove(n->grid, r->time);
+  }
+  g_array_set_size(n->rows, 0);
+  split_tree_free(n->tree);
+  g_free(n->opened);
+
+  n->tree = split_tree_new(m->segments);
+  n->opened = g_new0(gboolean, MAX(n->tree->n_nodes, 1));
+
+  gboolean with_icons = FALSE;
+  for (guint i = 0; n->icons && i < n->tree->n_nodes && !with_icons; i++) {
+    with_icons = node_icon(m, &n->tree->nodes[i]) != NULL;
+  }
+  int col = with_icons ? 1 : 0;
+
+  for (guint i = 0; i < n->tree->n_nodes; i++) {
+    const SplitNode *sn = &n->tree->nodes[i];
+    SplitRow r = {
+      NULL,
+      gtk_label_new(sn->name),
+      gtk_label_new(""),
+      gtk_label_new(""),
+    };
+    if (with_icons) {
+      r.icon = gtk_image_new();
+      gtk_image_set_pixel_size(GTK_IMAGE(r.icon), n->def->icon_size);
+      const char *path = node_icon(m, sn);
+      if (path) icon_cache_request(n->icons, path, n->def->icon_size, on_icon_ready, g_object_ref(r.icon), g_object_unref);
+      gtk_grid_attach(n->grid, r.icon, 0, (int)i, 1, 1);
+    }
+    gtk_label_set_xalign(GTK_LABEL(r.name), 0.0f);
+    gtk_label_set_ellipsize(GTK_LABEL(r.name), PANGO_ELLIPSIZE_END);
+    gtk_widget_set_hexpand(r.name, TRUE);
+    gtk_widget_set_margin_start(r.name, (int)sn->depth * 12);
+    gtk_label_set_xalign(GTK_LABEL(r.delta), 1.0f);
+    gtk_label_set_xalign(GTK_LABEL(r.time), 1.0f);
+    if (sn->section) {
+      gtk_widget_add_css_class(r.name, "section");
+      g_object_set_data(G_OBJECT(r.name), "split-node", GUINT_TO_POINTER(i));
+      GtkGesture *click = gtk_gesture_click_new();
+      g_signal_connect(click, "released", G_CALLBACK(on_section_clicked), n);
+      gtk_widget_add_controller(r.name, GTK_EVENT_CONTROLLER(click));
+    }
+    gtk_grid_attach(n->grid, r.name, col, (int)i, 1, 1);
+    gtk_grid_attach(n->grid, r.delta, col + 1, (int)i, 1, 1);
+    gtk_grid_attach(n->grid, r.time, col + 2, (int)i, 1, 1);
+    g_array_append_val(n->rows, r);
+  }
+}
+
+static void set_row_visible(SplitRow *r, gboolean shown) {
+  if (r->icon) gtk_widget_set_visible(r->icon, shown);
+  gtk_widget_set_visible(r->name, shown);
+  gtk_widget_set_visible(r->delta, shown);
+  gtk_widget_set_visible(r->time, shown);
+}
+
+// Sections are collapsed to one row showing their totals, unless they hold
+// the current split or the user opened them
+static void render_split_list(LayoutViewNode *n, const LayoutModel *m, guint changed) {
+  n->model = m;
+  if ((changed & LAYOUT_DEP_SEGMENTS) || !n->tree || n->tree->n_segments != m->segments->len) {
+    split_list_rebuild(n, m);
+  }
+
+  const LiveSpiffSplitTree *t = n->tree;
+  gboolean active = m->connected && g_strcmp0(m->state, "Idle") != 0;
+  gint current_section = active && m->current_split >= 0 ? split_tree_section_of(t, (guint)m->current_split) : -1;
+  gint current_row = -1;
+
+  g_array_set_size(n->visible, 0);
+  for (guint i = 0; i < t->n_nodes; ) {
+    const SplitNode *sn = &t->nodes[i];
+    gboolean expanded = sn->section && (n->opened[i] || (gint)i == current_section);
+    if (active && m->current_split >= (gint)sn->first_segment &&
+        m->current_split < (gint)(sn->first_segment + sn->n_segments) && !expanded) {
+      current_row = (gint)n->visible->len;
+    }
+    g_array_append_val(n->visible, i);
+
+    SplitRow *r = &g_array_index(n->rows, SplitRow, i);
+    if (sn->section) {
+      char *label = g_strdup_printf("%s %s", expanded ? "\u25BE" : "\u25B8", sn->name);
+      set_text(GTK_LABEL(r->name), label);
+      g_free(label);
+    }
+    // A collapsed section skips its whole subtree
+    if (sn->section && !expanded) {
+      for (guint j = i + 1; j < i + sn->span; j++) set_row_visible(&g_array_index(n->rows, SplitRow, j), FALSE);
+      i += sn->span;
+    } else {
+      i++;
+    }
+  }
+
+  // Keep the current split in view when the list is limited
+  gint total = (gint)n->visible->len;
+  gint visible = n->def->rows > 0 ? MIN(n->def->rows, total) : total;
+  gint first = CLAMP(current_row - visible / 2, 0, MAX(total - visible, 0));
+
+  for (gint v = 0; v < total; v++) {
+    guint i = g_array_index(n->visible, guint, v);
+    const SplitNode *sn = &t->nodes[i];
+    SplitRow *r = &g_array_index(n->rows, SplitRow, i);
+    gboolean shown = v >= first && v < first + visible;
+    set_row_visible(r, shown);
+    if (!shown) continue;
+
+    if (v == current_row) gtk_widget_add_css_class(r->name, "current");
+    else gtk_widget_remove_css_class(r->name, "current");
+
+    // An expanded section's totals show on its last subsplit
+    if (sn->section && v + 1 < total && g_array_index(n->visible, guint, v + 1) == i + 1) {
+      set_text(GTK_LABEL(r->time), "");
+      set_text(GTK_LABEL(r->delta), "");
+      set_delta_class(r->delta, LAYOUT_NO_TIME);
+      continue;
+    }
+
+    // Completed: own split time; upcoming: the comparison's, dimmed.
+    // Section totals are differences of the cumulative arrays.
+    gint64 split = split_tree_node_split(sn, m->split_ms);
+    gint64 delta = split_tree_node_split(sn, m->delta_ms);
+    gboolean done = split != LAYOUT_NO_TIME;
+    char *ts = format_time_ms(done ? split : split_tree_node_split(sn, m->comparison_ms));
+    char *ds = format_delta_ms(done ? delta : LAYOUT_NO_TIME);
+    set_text(GTK_LABEL(r->time), ts);
+    set_text(GTK_LABEL(r->delta), ds);
+    g_free(ts);
+    g_free(ds);
+
+    if (done) gtk_widget_remove_css_class(r->time, "dim");
+    else gtk_widget_add_css_class(r->time, "dim");
+    set_delta_class(r->delta, done ? delta : LAYOUT_NO_TIME);
+  }
+}
+
+static void render_delta_graph(LayoutViewNode *n, const LayoutModel *m, guint changed) {
+  LiveSpiffDeltaGraph *g = LIVESPIFF_DELTA_GRAPH(n->widget);
+  if (changed & (LAYOUT_DEP_SEGMENTS | LAYOUT_DEP_COMPARISON)) livespiff_delta_graph_reset(g);
+  livespiff_delta_graph_set_segments(g, m->segments->len);
+  livespiff_delta_graph_set_deltas(g, m->delta_ms);
+
+  // Live tail for the split in progress, once it is losing time against
+  // the last split's delta (as LiveSplit shows it)
+  gint cur = m->current_split;
+  gint64 comp_end = layout_model_at(m->comparison_ms, cur);
+  gboolean timing = g_strcmp0(m->state, "Running") == 0 || g_strcmp0(m->state, "Paused") == 0 ||
+                    g_strcmp0(m->state, "Loading") == 0;
+  if (!m->connected || !timing || comp_end == LAYOUT_NO_TIME || (guint)cur != m->delta_ms->len) {
+    livespiff_delta_graph_set_live(g, 0.0, LAYOUT_NO_TIME);
+    return;
+  }
+
+  gint64 last = 0;
+  for (gint i = cur - 1; i >= 0; i--) {
+    gint64 d = g_array_index(m->delta_ms, gint64, i);
+    if (d != LAYOUT_NO_TIME) {
+      last = d;
+      break;
+    }
+  }
+  gint64 elapsed = layout_model_elapsed_ms(m);
+  gint64 comp_start = cur > 0 ? layout_model_at(m->comparison_ms, cur - 1) : 0;
+  gint64 seg_start = cur > 0 ? layout_model_at(m->split_ms, cur - 1) : 0;
+  double progress = 1.0;
+  if (comp_start != LAYOUT_NO_TIME && seg_start != LAYOUT_NO_TIME && comp_end > comp_start) {
+    progress = (double)(elapsed - seg_start) / (double)(comp_end - comp_start);
+  }
+  livespiff_delta_graph_set_live(g, progress, MAX(elapsed - comp_end, last));
+}
+
+/* ------------------------- building ------------------------- */
+
+static GtkWidget* captioned(LayoutViewNode *n, const char *default_caption) {
+  GtkWidget *box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 8);
+  GtkWidget *caption = gtk_label_new(n->def->text ? n->def->text : default_caption);
+  gtk_label_set_xalign(GTK_LABEL(caption), 0.0f);
+  gtk_widget_set_hexpand(caption, TRUE);
+  gtk_widget_add_css_class(caption, "meta");
+
+  n->value = GTK_LABEL(gtk_label_new("-"));
+  gtk_widget_add_css_class(GTK_WIDGET(n->value), "meta");
+  gtk_box_append(GTK_BOX(box), caption);
+  gtk_box_append(GTK_BOX(box), GTK_WIDGET(n->value));
+  return box;
+}
+
+static LayoutViewNode* node_build(const LayoutNode *def, LiveSpiffIconCache *icons) {
+  LayoutViewNode *n = g_new0(LayoutViewNode, 1);
+  n->def = def;
+  n->icons = def->icon_size > 0 ? icons : NULL;
+
+  switch (def->type) {
+    case LAYOUT_TIMER:
+      n->value = GTK_LABEL(gtk_label_new("--:--:--.---"));
+      gtk_widget_add_css_class(GTK_WIDGET(n->value), "time");
+      gtk_widget_set_halign(GTK_WIDGET(n->value), GTK_ALIGN_CENTER);
+      n->widget = GTK_WIDGET(n->value);
+      n->render = render_timer;
+      break;
+    case LAYOUT_STATE:
+      n->value = GTK_LABEL(gtk_label_new("Connecting..."));
+      gtk_widget_add_css_class(GTK_WIDGET(n->value), "meta");
+      gtk_widget_set_halign(GTK_WIDGET(n->value), GTK_ALIGN_CENTER);
+      n->widget = GTK_WIDGET(n->value);
+      n->render = render_state;
+      break;
+    case LAYOUT_SPLIT_LIST:
+      n->grid = GTK_GRID(gtk_grid_new());
+      gtk_grid_set_column_spacing(n->grid, 12);
+      gtk_grid_set_row_spacing(n->grid, 2);
+      n->rows = g_array_new(FALSE, TRUE, sizeof(SplitRow));
+      n->visible = g_array_new(FALSE, FALSE, sizeof(guint));
+      n->widget = GTK_WIDGET(n->grid);
+      n->render = render_split_list;
+      break;
+    case LAYOUT_DELTA_GRAPH:
+      n->widget = livespiff_delta_graph_new(def->height);
+      n->render = render_delta_graph;
+      break;
+    case LAYOUT_PREVIOUS_SEGMENT:
+      n->widget = captioned(n, "Previous Segment");
+      n->render = render_previous_segment;
+      break;
+    case LAYOUT_SUM_OF_BEST:
+      n->widget = captioned(n, "Sum of Best");
+      n->render = render_sum_of_best;
+      break;
+    case LAYOUT_TEXT:
+    default:
+      n->widget = gtk_label_new(def->text ? def->text : "");
+      gtk_label_set_wrap(GTK_LABEL(n->widget), TRUE);
+      gtk_widget_add_css_class(n->widget, "meta");
+      n->render = NULL; // static: no dependencies
+      break;
+  }
+  gtk_widget_add_css_class(n->widget, layout_node_type_name(def->type));
+  return n;
+}
+
+static void node_free(LayoutViewNode *n) {
+  if (n->rows) g_array_free(n->rows, TRUE);
+  if (n->visible) g_array_free(n->visible, TRUE);
+  split_tree_free(n->tree);
+  g_free(n->opened);
+  g_free(n);
+}
+
+LayoutView* layout_view_new(const LiveSpiffLayout *layout) {
+  LayoutView *v = g_new0(LayoutView, 1);
+  v->nodes = g_ptr_array_new_with_free_func((GDestroyNotify)node_free);
+  v->root = gtk_box_new(GTK_ORIENTATION_VERTICAL, 8);
+
+  for (guint i = 0; i < layout->nodes->len && !v->icons; i++) {
+    const LayoutNode *def = (const LayoutNode*)g_ptr_array_index(layout->nodes, i);
+    if (def->type == LAYOUT_SPLIT_LIST && def->icon_size > 0) {
+      char *dir = icon_cache_default_dir();
+      v->icons = icon_cache_new(ICON_CACHE_BYTES, dir);
+      g_free(dir);
+    }
+  }
+
+  for (guint i = 0; i < layout->nodes->len; i++) {
+    const LayoutNode *def = (const LayoutNode*)g_ptr_array_index(layout->nodes, i);
+    LayoutViewNode *n = node_build(def, v->icons);
+    gtk_box_append(GTK_BOX(v->root), n->widget);
+    g_ptr_array_add(v->nodes, n);
+    v->deps |= def->deps;
+  }
+  return v;
+}
+
+GtkWidget* layout_view_widget(LayoutView *v) {
+  return v->root;
+}
+
+guint layout_view_deps(const LayoutView *v) {
+  return v->deps;
+}
+
+void layout_view_update(LayoutView *v, LayoutModel *model) {
+  guint changed = model->changed;
+  model->changed = 0;
+  if (!(changed & v->deps)) return;
+
+  for (guint i = 0; i < v->nodes->len; i++) {
+    LayoutViewNode *n = (LayoutViewNode*)g_ptr_array_index(v->nodes, i);
+    if (n->render && (n->def->deps & changed)) n->render(n, model, changed);
+  }
+}
+
+void layout_view_free(LayoutView *v) {
+  if (!v) return;
+  // Widgets belong to the window; only the tree bookkeeping is ours
+  g_ptr_array_free(v->nodes, TRUE);
+  icon_cache_free(v->icons);
+  g_free(v);
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include <gtk/gtk.h>
+
+#include "layout.h"
+
+// GTK render tree for a parsed layout: one widget subtree per component,
+// built once. layout_view_update() re-renders only the components whose
+// dependencies intersect model->changed, then clears it.
+typedef struct LayoutView LayoutView;
+
+LayoutView* layout_view_new(const LiveSpiffLayout *layout);
+GtkWidget* layout_view_widget(LayoutView *v);
+void layout_view_update(LayoutView *v, LayoutModel *model);
+// Union of all components' dependencies (e.g. whether CLOCK needs frames)
+guint layout_view_deps(const LayoutView *v);
+void layout_view_free(LayoutView *v);
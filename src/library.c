@@ -0,0 +1,479 @@
+#include "library.h"
+#include <json-glib/json-glib.h>
+#include <string.h>
+
+#include "storage.h"
+
+#define LIBRARY_INDEX_VERSION 1
+#define LIBRARY_SAVE_DELAY_S  2
+
+static void entry_free(gpointer data) {
+  LiveSpiffLibraryEntry *e = (LiveSpiffLibraryEntry*)data;
+  if (!e) return;
+  g_free(e->path);
+  g_free(e->game);
+  g_free(e->category);
+  g_free(e->haystack);
+  g_free(e);
+}
+
+/* ------------------------- text normalization ------------------------- */
+
+// Casefold and turn common filename separators into spaces
+static char* normalize_text(const char *s) {
+  char *folded = g_utf8_casefold(s ? s : "", -1);
+  for (char *p = folded; *p; p++) {
+    if (*p == '_' || *p == '-' || *p == '.' || *p == '\t') *p = ' ';
+  }
+  return folded;
+}
+
+static char* build_haystack(const LiveSpiffLibraryEntry *e) {
+  char *base = g_path_get_basename(e->path);
+  if (g_str_has_suffix(base, ".json")) base[strlen(base) - strlen(".json")] = '\0';
+
+  char *raw = g_strjoin(" ", "", e->game, e->category, base, NULL);
+  char *hay = normalize_text(raw);
+  g_free(raw);
+  g_free(base);
+  return hay;
+}
+
+static guint trigram_at(const char *s) {
+  return ((guint)(guchar)s[0] << 16) | ((guint)(guchar)s[1] << 8) | (guint)(guchar)s[2];
+}
+
+/* ------------------------- trigram index ------------------------- */
+
+static void index_add(LiveSpiffLibrary *lib, LiveSpiffLibraryEntry *e) {
+  gsize len = strlen(e->haystack);
+  GHashTable *seen = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+  for (gsize i = 0; i + 3 <= len; i++) {
+    guint tg = trigram_at(e->haystack + i);
+    if (!g_hash_table_add(seen, GUINT_TO_POINTER(tg))) continue;
+
+    GPtrArray *posting = g_hash_table_lookup(lib->trigrams, GUINT_TO_POINTER(tg));
+    if (!posting) {
+      posting = g_ptr_array_new();
+      g_hash_table_insert(lib->trigrams, GUINT_TO_POINTER(tg), posting);
+    }
+    g_ptr_array_add(posting, e);
+  }
+  g_hash_table_destroy(seen);
+}
+
+static void index_remove(LiveSpiffLibrary *lib, LiveSpiffLibraryEntry *e) {
+  gsize len = strlen(e->haystack);
+  for (gsize i = 0; i + 3 <= len; i++) {
+    guint tg = trigram_at(e->haystack + i);
+    GPtrArray *posting = g_hash_table_lookup(lib->trigrams, GUINT_TO_POINTER(tg));
+    if (!posting) continue;
+    g_ptr_array_remove_fast(posting, e);
+    if (posting->len == 0) g_hash_table_remove(lib->trigrams, GUINT_TO_POINTER(tg));
+  }
+}
+
+static void library_insert(LiveSpiffLibrary *lib, LiveSpiffLibraryEntry *e) {
+  if (!e->haystack) e->haystack = build_haystack(e);
+  index_add(lib, e);
+  g_ptr_array_add(lib->sorted, e);
+  lib->sorted_dirty = TRUE;
+  g_hash_table_replace(lib->by_path, e->path, e);
+}
+
+static void library_remove(LiveSpiffLibrary *lib, const char *path) {
+  LiveSpiffLibraryEntry *e = g_hash_table_lookup(lib->by_path, path);
+  if (!e) return;
+  index_remove(lib, e);
+  g_ptr_array_remove_fast(lib->sorted, e);
+  lib->sorted_dirty = TRUE;
+  g_hash_table_remove(lib->by_path, path); // frees e
+}
+
+/* ------------------------- run files ------------------------- */
+
+static gint64 file_mtime_us(const char *path) {
+  GFile *f = g_file_new_for_path(path);
+  GFileInfo *info = g_file_query_info(f, G_FILE_ATTRIBUTE_TIME_MODIFIED "," G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC,
+                                      G_FILE_QUERY_INFO_NONE, NULL, NULL);
+  gint64 mtime = -1;
+  if (info) {
+    GDateTime *dt = g_file_info_get_modification_date_time(info);
+    if (dt) {
+      mtime = g_date_time_to_unix(dt) * G_USEC_PER_SEC + g_date_time_get_microsecond(dt);
+      g_date_time_unref(dt);
+    }
+    g_object_unref(info);
+  }
+  g_object_unref(f);
+  return mtime;
+}
+
+// Newest of the run file and its history log, -1 if the run file is gone
+static gint64 run_mtime_us(const char *path) {
+  gint64 run_mtime = file_mtime_us(path);
+  if (run_mtime < 0) return -1;
+
+  char *hist_path = run_history_path(path);
+  gint64 hist_mtime = file_mtime_us(hist_path);
+  g_free(hist_path);
+  return MAX(run_mtime, hist_mtime);
+}
+
+// Counts attempts and keeps the best full-layout finish, one attempt at a time
+static gboolean scan_attempt(const LiveSpiffAttempt *a, gpointer user_data) {
+  LiveSpiffLibraryEntry *e = (LiveSpiffLibraryEntry*)user_data;
+  e->attempt_count++;
+  if (!a->finished || a->split_us->len != e->segment_count) return TRUE;
+  gint64 final_us = attempt_split_us(a, e->segment_count - 1);
+  if (final_us != LIVESPIFF_NO_TIME && (e->pb_us == LIVESPIFF_NO_TIME || final_us < e->pb_us)) e->pb_us = final_us;
+  return TRUE;
+}
+
+static LiveSpiffLibraryEntry* entry_read(const char *path, gint64 mtime_us) {
+  LiveSpiffRun *run = NULL;
+  if (!run_load_json(path, &run, NULL)) return NULL;
+
+  LiveSpiffLibraryEntry *e = g_new0(LiveSpiffLibraryEntry, 1);
+  e->path = g_strdup(path);
+  e->game = g_strdup(run->game);
+  e->category = g_strdup(run->category);
+  e->segment_count = run->segments->len;
+  e->pb_us = LIVESPIFF_NO_TIME;
+  e->mtime_us = mtime_us;
+  run_free(run);
+
+  char *hist_path = run_history_path(path);
+  if (!history_foreach(hist_path, scan_attempt, e, NULL)) {
+    // Unreadable log: indexed as if it had no attempts, as before
+    e->attempt_count = 0;
+    e->pb_us = LIVESPIFF_NO_TIME;
+  }
+  g_free(hist_path);
+  return e;
+}
+
+static gboolean is_run_file(const char *name) {
+  return name && g_str_has_suffix(name, ".json");
+}
+
+/* ------------------------- persistence ------------------------- */
+
+static gboolean library_save(LiveSpiffLibrary *lib) {
+  JsonBuilder *b = json_builder_new();
+  json_builder_begin_object(b);
+  json_builder_set_member_name(b, "version");
+  json_builder_add_int_value(b, LIBRARY_INDEX_VERSION);
+  json_builder_set_member_name(b, "runs");
+  json_builder_begin_array(b);
+
+  GHashTableIter it;
+  gpointer value;
+  g_hash_table_iter_init(&it, lib->by_path);
+  while (g_hash_table_iter_next(&it, NULL, &value)) {
+    const LiveSpiffLibraryEntry *e = value;
+    json_builder_begin_object(b);
+    json_builder_set_member_name(b, "path");      json_builder_add_string_value(b, e->path);
+    json_builder_set_member_name(b, "game");      json_builder_add_string_value(b, e->game);
+    json_builder_set_member_name(b, "category");  json_builder_add_string_value(b, e->category);
+    json_builder_set_member_name(b, "segments");  json_builder_add_int_value(b, e->segment_count);
+    json_builder_set_member_name(b, "pb_us");
+    if (e->pb_us == LIVESPIFF_NO_TIME) json_builder_add_null_value(b);
+    else json_builder_add_int_value(b, e->pb_us);
+    json_builder_set_member_name(b, "attempts");  json_builder_add_int_value(b, e->attempt_count);
+    json_builder_set_member_name(b, "mtime_us");  json_builder_add_int_value(b, e->mtime_us);
+    json_builder_end_object(b);
+  }
+
+  json_builder_end_array(b);
+  json_builder_end_object(b);
+
+  JsonNode *root = json_builder_get_root(b);
+  JsonGenerator *gen = json_generator_new();
+  json_generator_set_root(gen, root);
+
+  char *dir = g_path_get_dirname(lib->index_path);
+  g_mkdir_with_parents(dir, 0700);
+  g_free(dir);
+
+  GError *err = NULL;
+  gboolean ok = json_generator_to_file(gen, lib->index_path, &err);
+  if (!ok) {
+    g_printerr("Failed to save run library index: %s\n", err ? err->message : "unknown error");
+    if (err) g_error_free(err);
+  }
+
+  g_object_unref(gen);
+  json_node_free(root);
+  g_object_unref(b);
+  return ok;
+}
+
+static void library_load_index(LiveSpiffLibrary *lib) {
+  JsonParser *parser = json_parser_new();
+  if (!json_parser_load_from_file(parser, lib->index_path, NULL)) {
+    g_object_unref(parser);
+    return;
+  }
+
+  JsonNode *root = json_parser_get_root(parser);
+  if (root && JSON_NODE_HOLDS_OBJECT(root)) {
+    JsonObject *obj = json_node_get_object(root);
+    gint64 version = json_object_get_int_member_with_default(obj, "version", 0);
+    JsonArray *runs = json_object_has_member(obj, "runs") ? json_object_get_array_member(obj, "runs") : NULL;
+    guint n = (version == LIBRARY_INDEX_VERSION && runs) ? json_array_get_length(runs) : 0;
+
+    for (guint i = 0; i < n; i++) {
+      JsonObject *ro = json_array_get_object_element(runs, i);
+      const char *path = ro ? json_object_get_string_member_with_default(ro, "path", NULL) : NULL;
+      if (!path || g_hash_table_contains(lib->by_path, path)) continue;
+
+      LiveSpiffLibraryEntry *e = g_new0(LiveSpiffLibraryEntry, 1);
+      e->path = g_strdup(path);
+      e->game = g_strdup(json_object_get_string_member_with_default(ro, "game", ""));
+      e->category = g_strdup(json_object_get_string_member_with_default(ro, "category", ""));
+      e->segment_count = (guint)json_object_get_int_member_with_default(ro, "segments", 0);
+      JsonNode *pb = json_object_get_member(ro, "pb_us");
+      e->pb_us = (pb && JSON_NODE_HOLDS_VALUE(pb)) ? json_node_get_int(pb) : LIVESPIFF_NO_TIME;
+      e->attempt_count = (guint)json_object_get_int_member_with_default(ro, "attempts", 0);
+      e->mtime_us = json_object_get_int_member_with_default(ro, "mtime_us", 0);
+      library_insert(lib, e);
+    }
+  }
+
+  g_object_unref(parser);
+}
+
+static gboolean on_save_timeout(gpointer user_data) {
+  LiveSpiffLibrary *lib = (LiveSpiffLibrary*)user_data;
+  lib->save_id = 0;
+  library_save(lib);
+  return G_SOURCE_REMOVE;
+}
+
+// Coalesce bursts of changes into one index write
+static void schedule_save(LiveSpiffLibrary *lib) {
+  if (lib->save_id) return;
+  lib->save_id = g_timeout_add_seconds(LIBRARY_SAVE_DELAY_S, on_save_timeout, lib);
+}
+
+/* ------------------------- incremental updates ------------------------- */
+
+static void library_refresh_path(LiveSpiffLibrary *lib, const char *path) {
+  gint64 mtime = run_mtime_us(path);
+  LiveSpiffLibraryEntry *existing = g_hash_table_lookup(lib->by_path, path);
+
+  if (mtime < 0) {
+    if (!existing) return;
+    library_remove(lib, path);
+    schedule_save(lib);
+    return;
+  }
+
+  if (existing && existing->mtime_us == mtime) return;
+
+  LiveSpiffLibraryEntry *e = entry_read(path, mtime);
+  if (existing) library_remove(lib, path);
+  if (e) library_insert(lib, e);
+  schedule_save(lib);
+}
+
+// A history log change refreshes the run it belongs to
+static void refresh_file(LiveSpiffLibrary *lib, GFile *file) {
+  if (!file) return;
+  char *path = g_file_get_path(file);
+  if (!path) return;
+
+  if (g_str_has_suffix(path, ".history.jsonl")) {
+    char *stem = g_strndup(path, strlen(path) - strlen(".history.jsonl"));
+    char *run_path = g_strconcat(stem, ".json", NULL);
+    library_refresh_path(lib, run_path);
+    g_free(run_path);
+    g_free(stem);
+  } else if (is_run_file(path)) {
+    library_refresh_path(lib, path);
+  }
+  g_free(path);
+}
+
+static void on_dir_changed(GFileMonitor *monitor, GFile *file, GFile *other_file,
+                           GFileMonitorEvent event, gpointer user_data) {
+  (void)monitor;
+  LiveSpiffLibrary *lib = (LiveSpiffLibrary*)user_data;
+
+  switch (event) {
+    case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
+    case G_FILE_MONITOR_EVENT_CREATED:
+    case G_FILE_MONITOR_EVENT_DELETED:
+    case G_FILE_MONITOR_EVENT_MOVED_IN:
+    case G_FILE_MONITOR_EVENT_MOVED_OUT:
+      refresh_file(lib, file);
+      break;
+    case G_FILE_MONITOR_EVENT_RENAMED:
+      refresh_file(lib, file);
+      refresh_file(lib, other_file);
+      break;
+    default:
+      break; // CHANGED fires per write; wait for CHANGES_DONE_HINT
+  }
+}
+
+/* ------------------------- public API ------------------------- */
+
+LiveSpiffLibrary* library_open(const char *dir, const char *index_path) {
+  LiveSpiffLibrary *lib = g_new0(LiveSpiffLibrary, 1);
+  lib->dir = g_strdup(dir);
+  lib->index_path = g_strdup(index_path);
+  lib->by_path = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, entry_free);
+  lib->sorted = g_ptr_array_new();
+  lib->trigrams = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, (GDestroyNotify)g_ptr_array_unref);
+
+  library_load_index(lib);
+
+  g_mkdir_with_parents(dir, 0700);
+  GFile *gdir = g_file_new_for_path(dir);
+  GError *err = NULL;
+  lib->monitor = g_file_monitor_directory(gdir, G_FILE_MONITOR_WATCH_MOVES, NULL, &err);
+  if (lib->monitor) {
+    g_signal_connect(lib->monitor, "changed", G_CALLBACK(on_dir_changed), lib);
+  } else {
+    g_printerr("Run library: cannot watch %s: %s\n", dir, err ? err->message : "unknown error");
+    if (err) g_error_free(err);
+  }
+  g_object_unref(gdir);
+
+  return lib;
+}
+
+void library_close(LiveSpiffLibrary *lib) {
+  if (!lib) return;
+  if (lib->monitor) {
+    g_file_monitor_cancel(lib->monitor);
+    g_object_unref(lib->monitor);
+  }
+  if (lib->save_id) {
+    g_source_remove(lib->save_id);
+    library_save(lib);
+  }
+  g_hash_table_destroy(lib->trigrams);
+  g_ptr_array_free(lib->sorted, TRUE);
+  g_hash_table_destroy(lib->by_path);
+  g_free(lib->index_path);
+  g_free(lib->dir);
+  g_free(lib);
+}
+
+void library_sync(LiveSpiffLibrary *lib) {
+  GHashTable *seen = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+
+  GDir *d = g_dir_open(lib->dir, 0, NULL);
+  if (d) {
+    const char *name;
+    while ((name = g_dir_read_name(d)) != NULL) {
+      if (!is_run_file(name)) continue;
+      char *path = g_build_filename(lib->dir, name, NULL);
+      library_refresh_path(lib, path);
+      g_hash_table_add(seen, path);
+    }
+    g_dir_close(d);
+  }
+
+  // Drop index entries for files deleted while the daemon was not running
+  GPtrArray *stale = g_ptr_array_new_with_free_func(g_free);
+  GHashTableIter it;
+  gpointer key;
+  g_hash_table_iter_init(&it, lib->by_path);
+  while (g_hash_table_iter_next(&it, &key, NULL)) {
+    if (!g_hash_table_contains(seen, key)) g_ptr_array_add(stale, g_strdup((const char*)key));
+  }
+  for (guint i = 0; i < stale->len; i++) library_remove(lib, g_ptr_array_index(stale, i));
+  if (stale->len > 0) schedule_save(lib);
+
+  g_ptr_array_free(stale, TRUE);
+  g_hash_table_destroy(seen);
+}
+
+static gint compare_entries(gconstpointer a, gconstpointer b) {
+  const LiveSpiffLibraryEntry *ea = *(LiveSpiffLibraryEntry* const*)a;
+  const LiveSpiffLibraryEntry *eb = *(LiveSpiffLibraryEntry* const*)b;
+  int c = g_utf8_collate(ea->game, eb->game);
+  if (c) return c;
+  c = g_utf8_collate(ea->category, eb->category);
+  if (c) return c;
+  return g_strcmp0(ea->path, eb->path);
+}
+
+static void ensure_sorted(LiveSpiffLibrary *lib) {
+  if (!lib->sorted_dirty) return;
+  g_ptr_array_sort(lib->sorted, compare_entries);
+  lib->sorted_dirty = FALSE;
+}
+
+guint library_count(LiveSpiffLibrary *lib) {
+  return lib ? lib->sorted->len : 0;
+}
+
+GPtrArray* library_list(LiveSpiffLibrary *lib, guint offset, guint limit) {
+  GPtrArray *out = g_ptr_array_new();
+  if (!lib) return out;
+
+  ensure_sorted(lib);
+  for (guint i = offset; i < lib->sorted->len && out->len < limit; i++) {
+    g_ptr_array_add(out, g_ptr_array_index(lib->sorted, i));
+  }
+  return out;
+}
+
+GPtrArray* library_search(LiveSpiffLibrary *lib, const char *query, guint limit) {
+  GPtrArray *out = g_ptr_array_new();
+  if (!lib) return out;
+
+  char *norm = normalize_text(query);
+  gchar **terms = g_strsplit(norm, " ", -1);
+  g_free(norm);
+
+  // Short terms only match word prefixes (" ma"), longer ones any substring
+  GPtrArray *needles = g_ptr_array_new_with_free_func(g_free);
+  for (gchar **t = terms; *t; t++) {
+    if (!(*t)[0]) continue;
+    g_ptr_array_add(needles, strlen(*t) < 3 ? g_strconcat(" ", *t, NULL) : g_strdup(*t));
+  }
+  g_strfreev(terms);
+
+  if (needles->len == 0) {
+    g_ptr_array_free(needles, TRUE);
+    g_ptr_array_free(out, TRUE);
+    return library_list(lib, 0, limit);
+  }
+
+  // Smallest posting list over every needle trigram bounds the candidates
+  ensure_sorted(lib);
+  GPtrArray *candidates = lib->sorted;
+  gboolean empty = FALSE;
+  for (guint n = 0; n < needles->len && !empty; n++) {
+    const char *needle = g_ptr_array_index(needles, n);
+    gsize len = strlen(needle);
+    for (gsize i = 0; i + 3 <= len; i++) {
+      GPtrArray *posting = g_hash_table_lookup(lib->trigrams, GUINT_TO_POINTER(trigram_at(needle + i)));
+      if (!posting) { empty = TRUE; break; }
+      if (posting->len < candidates->len) candidates = posting;
+    }
+  }
+
+  if (!empty) {
+    for (guint i = 0; i < candidates->len; i++) {
+      LiveSpiffLibraryEntry *e = g_ptr_array_index(candidates, i);
+      gboolean match = TRUE;
+      for (guint n = 0; n < needles->len && match; n++) {
+        match = strstr(e->haystack, (const char*)g_ptr_array_index(needles, n)) != NULL;
+      }
+      if (match) g_ptr_array_add(out, e);
+    }
+    if (candidates != lib->sorted) g_ptr_array_sort(out, compare_entries);
+    if (out->len > limit) g_ptr_array_set_size(out, limit);
+  }
+
+  g_ptr_array_free(needles, TRUE);
+  return out;
+}
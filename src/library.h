@@ -0,0 +1,43 @@
+#pragma once
+#include <gio/gio.h>
+
+// One run file in livespiff_runs_dir()
+typedef struct {
+  char *path;
+  char *game;
+  char *category;
+  guint segment_count;
+  gint64 pb_us;          // LIVESPIFF_NO_TIME if no finished attempt
+  guint attempt_count;
+  gint64 mtime_us;       // newest of run file and its history log
+
+  char *haystack;        // " game category basename", casefolded (search)
+} LiveSpiffLibraryEntry;
+
+// Persistent, incrementally updated index of the runs directory.
+// Search uses a trigram index over each entry's haystack; the leading
+// space on every word makes 2-char word prefixes trigrams as well.
+typedef struct {
+  char *dir;
+  char *index_path;
+  GHashTable *by_path;    // path -> LiveSpiffLibraryEntry* (owns entries)
+  GPtrArray *sorted;      // entries ordered by game, category, path
+  gboolean sorted_dirty;
+  GHashTable *trigrams;   // GUINT_TO_POINTER(trigram) -> GPtrArray* of entries
+  GFileMonitor *monitor;
+  guint save_id;
+} LiveSpiffLibrary;
+
+// Loads the saved index and starts watching dir; call library_sync() once
+// (e.g. from an idle callback) to pick up changes made while not running.
+LiveSpiffLibrary* library_open(const char *dir, const char *index_path);
+void library_close(LiveSpiffLibrary *lib);
+
+// Re-stat every run file and re-read only the ones whose mtime changed
+void library_sync(LiveSpiffLibrary *lib);
+
+guint library_count(LiveSpiffLibrary *lib);
+// Borrowed entries in list order; caller frees the array only
+GPtrArray* library_list(LiveSpiffLibrary *lib, guint offset, guint limit);
+// All whitespace-separated terms must match (case-insensitive substring)
+GPtrArray* library_search(LiveSpiffLibrary *lib, const char *query, guint limit);
@@ -0,0 +1,107 @@
+// File: src/livespiff-evdev-replay.c
+// LiveSpiff evdev replay -> runs recorded key streams through the hotkey matcher
+//
+// Usage:
+//   sudo cat /dev/input/by-id/usb-...-event-kbd > keys.bin   (record, Ctrl+C to stop)
+//   livespiff-evdev-replay keys.bin                          (chords from daemon.ini [hotkeys])
+//   livespiff-evdev-replay --start-split KEY_KP1 --reset KEY_LEFTCTRL+KEY_KP0 keys.bin
+//
+// Output: one line per matched chord, "<ms since first event>\t<action>", then
+// a summary. Output depends only on the recording and the chords, so
+// recordings with their expected output double as regression checks for the
+// matcher, without a real device.
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "daemon_config.h"
+#include "evdev_hotkeys.h"
+
+static gboolean replay_file(const char *path, HotkeyMatcher *m, guint *counts) {
+  FILE *f = g_fopen(path, "rb");
+  if (!f) {
+    g_printerr("%s: cannot open\n", path);
+    return FALSE;
+  }
+
+  struct input_event ev;
+  gint64 first_us = -1;
+  guint64 events = 0;
+  while (fread(&ev, sizeof(ev), 1, f) == 1) {
+    gint64 t = hotkey_event_time_us(&ev);
+    if (first_us < 0) first_us = t;
+    events++;
+
+    HotkeyAction action = hotkey_matcher_feed(m, &ev);
+    if (action == HOTKEY_NONE) continue;
+    counts[action]++;
+    g_print("%.3f\t%s\n", (t - first_us) / 1000.0, hotkey_action_name(action));
+  }
+
+  gboolean torn = !feof(f) || ftell(f) % (long)sizeof(ev) != 0;
+  fclose(f);
+  if (torn) g_printerr("%s: trailing partial event ignored (recorded on another architecture?)\n", path);
+  g_printerr("%s: %" G_GUINT64_FORMAT " events\n", path, events);
+  return TRUE;
+}
+
+int main(int argc, char **argv) {
+  gchar *bind[HOTKEY_ACTION_COUNT] = {0};
+  GOptionEntry entries[] = {
+    { "start-split", 's', 0, G_OPTION_ARG_STRING, &bind[HOTKEY_START_SPLIT], "Start/split chord (default: daemon.ini)", "CHORD" },
+    { "pause", 'p', 0, G_OPTION_ARG_STRING, &bind[HOTKEY_PAUSE], "Pause chord (default: daemon.ini)", "CHORD" },
+    { "reset", 'r', 0, G_OPTION_ARG_STRING, &bind[HOTKEY_RESET], "Reset chord (default: daemon.ini)", "CHORD" },
+    { NULL }
+  };
+
+  GOptionContext *opts = g_option_context_new("FILE... - replay recorded evdev streams through the hotkey matcher");
+  g_option_context_add_main_entries(opts, entries, NULL);
+  GError *err = NULL;
+  if (!g_option_context_parse(opts, &argc, &argv, &err) || argc < 2) {
+    if (err) {
+      g_printerr("%s\n", err->message);
+      g_error_free(err);
+    } else {
+      char *help = g_option_context_get_help(opts, TRUE, NULL);
+      g_printerr("%s", help);
+      g_free(help);
+    }
+    g_option_context_free(opts);
+    return 1;
+  }
+  g_option_context_free(opts);
+
+  LiveSpiffDaemonConfig cfg = daemon_config_load();
+  const char *fallback[HOTKEY_ACTION_COUNT] = {
+    [HOTKEY_START_SPLIT] = cfg.hotkey_start_split,
+    [HOTKEY_PAUSE] = cfg.hotkey_pause,
+    [HOTKEY_RESET] = cfg.hotkey_reset,
+  };
+
+  HotkeyChord chords[HOTKEY_ACTION_COUNT] = {0};
+  int rc = 0;
+  for (guint a = HOTKEY_NONE + 1; a < HOTKEY_ACTION_COUNT; a++) {
+    const char *text = bind[a] ? bind[a] : fallback[a];
+    if (text && *text && !hotkey_chord_parse(text, &chords[a])) {
+      g_printerr("Unknown key in %s chord: %s\n", hotkey_action_name((HotkeyAction)a), text);
+      rc = 1;
+    }
+  }
+
+  guint counts[HOTKEY_ACTION_COUNT] = {0};
+  for (int i = 1; rc == 0 && i < argc; i++) {
+    // Each recording starts with no keys held
+    HotkeyMatcher m;
+    hotkey_matcher_init(&m, chords);
+    if (!replay_file(argv[i], &m, counts)) rc = 1;
+  }
+
+  if (rc == 0) {
+    g_print("# start_split=%u pause=%u reset=%u\n",
+            counts[HOTKEY_START_SPLIT], counts[HOTKEY_PAUSE], counts[HOTKEY_RESET]);
+  }
+
+  for (guint a = 0; a < HOTKEY_ACTION_COUNT; a++) g_free(bind[a]);
+  daemon_config_free_fields(&cfg);
+  return rc;
+}
@@ -0,0 +1,123 @@
+// File: src/livespiff-export.c
+// LiveSpiff history export -> CSV or columnar binary, for pandas / DuckDB
+//
+// Usage:
+//   livespiff-export [--format csv|columnar] OUT           (current run, via the daemon)
+//   livespiff-export [--format csv|columnar] --run RUN OUT (any run file, no daemon needed)
+//
+// Notes:
+// - Both paths stream the history log in fixed-size batches (history_export.h),
+//   so memory does not grow with the number of attempts.
+// - Through the daemon the export runs on a worker thread; the timer is unaffected.
+
+#include <gio/gio.h>
+#include <glib.h>
+
+#include "history_export.h"
+#include "storage.h"
+
+#define LS_BUS_NAME   "com.livespiff.LiveSpiff"
+#define LS_OBJ_PATH   "/com/livespiff/LiveSpiff"
+#define LS_IFACE_NAME "com.livespiff.LiveSpiff.Control"
+
+static int export_local(const char *run_path, const char *out_path, HistoryExportFormat format) {
+  LiveSpiffRun *run = NULL;
+  char *err_str = NULL;
+  if (!run_load_json(run_path, &run, &err_str)) {
+    g_printerr("%s\n", err_str ? err_str : "Failed to load run");
+    g_free(err_str);
+    return 1;
+  }
+
+  // The run owns the strings; only the pointer array is ours
+  const char **names = g_new0(const char*, run->segments->len + 1);
+  for (guint i = 0; i < run->segments->len; i++) names[i] = g_ptr_array_index(run->segments, i);
+
+  char *hist_path = run_history_path(run_path);
+  guint64 rows = 0;
+  gboolean ok = history_export(hist_path, names, run->segments->len, out_path, format, &rows, &err_str);
+  if (ok) g_print("Exported %" G_GUINT64_FORMAT " attempts to %s\n", rows, out_path);
+  else g_printerr("%s\n", err_str ? err_str : "Export failed");
+
+  g_free(err_str);
+  g_free(hist_path);
+  g_free(names);
+  run_free(run);
+  return ok ? 0 : 1;
+}
+
+static int export_via_daemon(const char *out_path, const char *format_name) {
+  GError *err = NULL;
+  GDBusConnection *bus = g_bus_get_sync(G_BUS_TYPE_SESSION, NULL, &err);
+  if (!bus) {
+    g_printerr("%s\n", err->message);
+    g_error_free(err);
+    return 1;
+  }
+
+  // The daemon has its own working directory
+  char *abs_path = g_canonicalize_filename(out_path, NULL);
+  GVariant *ret = g_dbus_connection_call_sync(bus, LS_BUS_NAME, LS_OBJ_PATH, LS_IFACE_NAME,
+                                              "ExportHistory", g_variant_new("(ss)", abs_path, format_name),
+                                              G_VARIANT_TYPE("(bs)"), G_DBUS_CALL_FLAGS_NONE,
+                                              G_MAXINT, NULL, &err);
+  g_free(abs_path);
+  g_object_unref(bus);
+
+  if (!ret) {
+    g_printerr("%s\n", err->message);
+    g_error_free(err);
+    return 1;
+  }
+
+  gboolean ok = FALSE;
+  const char *msg = NULL;
+  g_variant_get(ret, "(b&s)", &ok, &msg);
+  if (ok) g_print("%s\n", msg);
+  else g_printerr("%s\n", msg);
+  g_variant_unref(ret);
+  return ok ? 0 : 1;
+}
+
+int main(int argc, char **argv) {
+  gchar *format_name = NULL;
+  gchar *run_path = NULL;
+  GOptionEntry entries[] = {
+    { "format", 'f', 0, G_OPTION_ARG_STRING, &format_name, "csv (default) or columnar", "FORMAT" },
+    { "run", 'r', 0, G_OPTION_ARG_FILENAME, &run_path, "Export this run file directly instead of asking the daemon", "RUN" },
+    { NULL }
+  };
+
+  GOptionContext *opts = g_option_context_new("OUT - export LiveSpiff attempt history");
+  g_option_context_add_main_entries(opts, entries, NULL);
+  GError *err = NULL;
+  if (!g_option_context_parse(opts, &argc, &argv, &err)) {
+    g_printerr("%s\n", err->message);
+    g_error_free(err);
+    g_option_context_free(opts);
+    return 1;
+  }
+  if (argc != 2) {
+    char *help = g_option_context_get_help(opts, TRUE, NULL);
+    g_printerr("%s", help);
+    g_free(help);
+    g_option_context_free(opts);
+    return 1;
+  }
+  g_option_context_free(opts);
+
+  HistoryExportFormat format = HISTORY_EXPORT_CSV;
+  if (format_name && !history_export_format_from_string(format_name, &format)) {
+    g_printerr("Unknown format '%s' (expected csv or columnar)\n", format_name);
+    g_free(format_name);
+    g_free(run_path);
+    return 1;
+  }
+
+  int rc = run_path ? export_local(run_path, argv[1], format)
+                    : export_via_daemon(argv[1], format_name ? format_name : "csv");
+
+  g_free(format_name);
+  g_free(run_path);
+  return rc;
+}
@@ -0,0 +1,108 @@
+// File: src/livespiff-frame-dump.c
+// LiveSpiff frame reader -> reads livespiff-render's shared-memory frame ring
+//
+// Usage:
+//   livespiff-frame-dump --png frame.png                (newest frame, then exit)
+//   livespiff-frame-dump --raw | ffmpeg -f rawvideo -pix_fmt bgra -s 360x480 -r 30 -i -
+//       -f v4l2 -pix_fmt yuv420p /dev/video10           (one line; v4l2loopback webcam for OBS & co.)
+//
+// --raw writes the newest frame at the ring's frame rate, repeating it while
+// the timer is idle, so consumers get a constant-rate stream. The geometry is
+// printed on stderr. Also the reference reader for the layout in frame_ring.h.
+
+#include <cairo.h>
+#include <glib.h>
+#include <stdio.h>
+
+#include "frame_ring.h"
+
+static gboolean write_png(const FrameRingHeader *hdr, guint8 *pixels, const char *path) {
+  cairo_surface_t *s = cairo_image_surface_create_for_data(pixels, CAIRO_FORMAT_ARGB32,
+                                                           (int)hdr->width, (int)hdr->height, (int)hdr->stride);
+  cairo_status_t st = cairo_surface_write_to_png(s, path);
+  cairo_surface_destroy(s);
+  if (st != CAIRO_STATUS_SUCCESS) g_printerr("%s: %s\n", path, cairo_status_to_string(st));
+  return st == CAIRO_STATUS_SUCCESS;
+}
+
+static int stream_raw(FrameRing *ring, guint8 *pixels) {
+  const FrameRingHeader *hdr = frame_ring_header(ring);
+  gsize bytes = (gsize)hdr->stride * hdr->height;
+  gint64 interval_us = G_USEC_PER_SEC / (hdr->fps ? hdr->fps : 30);
+  gint64 next = g_get_monotonic_time();
+  gboolean have = FALSE;
+
+  g_printerr("%ux%u bgra @ %u fps\n", hdr->width, hdr->height, hdr->fps);
+  for (;;) {
+    // A torn read keeps the previous frame; the stream never stalls
+    if (frame_ring_read_latest(ring, pixels, NULL, NULL)) have = TRUE;
+    if (have && fwrite(pixels, 1, bytes, stdout) != bytes) return 0; // reader went away
+    if (have) fflush(stdout);
+    if (__atomic_load_n(&hdr->writer_pid, __ATOMIC_ACQUIRE) == 0) {
+      g_printerr("Renderer exited\n");
+      return 0;
+    }
+
+    next += interval_us;
+    gint64 now = g_get_monotonic_time();
+    if (next > now) g_usleep((gulong)(next - now));
+    else next = now;
+  }
+}
+
+int main(int argc, char **argv) {
+  gchar *shm = NULL, *png = NULL;
+  gboolean raw = FALSE;
+  GOptionEntry entries[] = {
+    { "shm", 's', 0, G_OPTION_ARG_STRING, &shm, "Shared-memory name (default " FRAME_RING_DEFAULT_NAME ")", "NAME" },
+    { "png", 0, 0, G_OPTION_ARG_FILENAME, &png, "Write the newest frame as PNG and exit", "FILE" },
+    { "raw", 0, 0, G_OPTION_ARG_NONE, &raw, "Stream raw BGRA frames to stdout", NULL },
+    { NULL }
+  };
+
+  GOptionContext *opts = g_option_context_new("- read frames rendered by livespiff-render");
+  g_option_context_add_main_entries(opts, entries, NULL);
+  GError *err = NULL;
+  if (!g_option_context_parse(opts, &argc, &argv, &err) || (!png && !raw)) {
+    if (err) {
+      g_printerr("%s\n", err->message);
+      g_error_free(err);
+    } else {
+      g_printerr("Pass --png FILE or --raw\n");
+    }
+    g_option_context_free(opts);
+    return 1;
+  }
+  g_option_context_free(opts);
+
+  char *err_str = NULL;
+  FrameRing *ring = frame_ring_open(shm ? shm : FRAME_RING_DEFAULT_NAME, &err_str);
+  if (!ring) {
+    g_printerr("%s\n", err_str);
+    g_free(err_str);
+    return 1;
+  }
+
+  const FrameRingHeader *hdr = frame_ring_header(ring);
+  guint8 *pixels = g_malloc((gsize)hdr->stride * hdr->height);
+  int rc = 0;
+  if (raw) {
+    rc = stream_raw(ring, pixels);
+  } else {
+    guint64 frame = 0;
+    if (!frame_ring_read_latest(ring, pixels, &frame, NULL)) {
+      g_printerr("No complete frame yet\n");
+      rc = 1;
+    } else if (!write_png(hdr, pixels, png)) {
+      rc = 1;
+    } else {
+      g_print("frame %" G_GUINT64_FORMAT " -> %s\n", frame, png);
+    }
+  }
+
+  g_free(pixels);
+  frame_ring_close(ring);
+  g_free(shm);
+  g_free(png);
+  return rc;
+}
@@ -0,0 +1,230 @@
+// File: src/livespiff-history-bench.c
+// LiveSpiff history benchmark -> JSON append log vs SQLite history database
+//
+// Features:
+// - Generates N synthetic attempts of an S-segment run (fixed seed, a share
+//   of them reset early, some with game time) in a scratch directory
+// - Insert: history_append() per attempt (what the daemon does) vs
+//   history_db_append() per attempt plus the final flush, and the time the
+//   caller spends queueing alone
+// - Query: a full scan through history_foreach() vs history_db_foreach(),
+//   and the best finished time by scanning the log vs one SQL aggregate
+//
+// Nothing outside the scratch directory is touched; --keep leaves it behind
+// for a look with the sqlite3 shell.
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <sqlite3.h>
+
+#include "history_db.h"
+#include "storage.h"
+
+#define QUERY_REPEATS 5
+
+static GPtrArray* make_attempts(guint count, guint segments) {
+  GPtrArray *attempts = g_ptr_array_new_full(count, (GDestroyNotify)attempt_free);
+  GRand *rand = g_rand_new_with_seed(20240101);
+  gint64 started = g_get_real_time() - (gint64)count * 600 * G_USEC_PER_SEC;
+
+  for (guint n = 0; n < count; n++) {
+    LiveSpiffAttempt *a = attempt_new();
+    a->started_at_us = started + (gint64)n * 600 * G_USEC_PER_SEC;
+    guint reached = g_rand_int_range(rand, 0, 4) == 0 ? (guint)g_rand_int_range(rand, 0, (gint32)segments) : segments;
+    a->finished = reached == segments;
+    gboolean game = g_rand_int_range(rand, 0, 3) == 0;
+    if (game) a->game_us = g_array_new(FALSE, FALSE, sizeof(gint64));
+
+    gint64 t = 0, loads = 0;
+    for (guint i = 0; i < reached; i++) {
+      t += g_rand_int_range(rand, 30, 90) * (gint64)G_USEC_PER_SEC + g_rand_int_range(rand, 0, 1000000);
+      loads += g_rand_int_range(rand, 0, 3000000);
+      g_array_append_val(a->split_us, t);
+      if (game) {
+        gint64 g = t - loads;
+        g_array_append_val(a->game_us, g);
+      }
+    }
+    g_ptr_array_add(attempts, a);
+  }
+  g_rand_free(rand);
+  return attempts;
+}
+
+static void report(const char *what, const char *backend, guint count, gint64 us) {
+  g_print("%-18s %-7s %10.1f ms  %12.0f attempts/s\n", what, backend, us / 1000.0,
+          us > 0 ? count * 1e6 / (double)us : 0.0);
+}
+
+typedef struct {
+  guint attempts;
+  guint64 splits;
+  gint64 best_us;
+} ScanTotals;
+
+static gboolean on_attempt(const LiveSpiffAttempt *a, gpointer user_data) {
+  ScanTotals *t = (ScanTotals*)user_data;
+  t->attempts++;
+  t->splits += a->split_us->len;
+  if (a->finished && a->split_us->len > 0) {
+    gint64 final_us = g_array_index(a->split_us, gint64, a->split_us->len - 1);
+    if (t->best_us == LIVESPIFF_NO_TIME || final_us < t->best_us) t->best_us = final_us;
+  }
+  return TRUE;
+}
+
+// Best of QUERY_REPEATS full scans
+static gint64 time_json_scan(const char *log_path, ScanTotals *out) {
+  gint64 best = G_MAXINT64;
+  for (guint r = 0; r < QUERY_REPEATS; r++) {
+    *out = (ScanTotals){ 0, 0, LIVESPIFF_NO_TIME };
+    gint64 t0 = g_get_monotonic_time();
+    history_foreach(log_path, on_attempt, out, NULL);
+    best = MIN(best, g_get_monotonic_time() - t0);
+  }
+  return best;
+}
+
+static gint64 time_db_scan(LiveSpiffHistoryDb *db, const char *log_path, ScanTotals *out) {
+  gint64 best = G_MAXINT64;
+  for (guint r = 0; r < QUERY_REPEATS; r++) {
+    *out = (ScanTotals){ 0, 0, LIVESPIFF_NO_TIME };
+    gint64 t0 = g_get_monotonic_time();
+    history_db_foreach(db, log_path, on_attempt, out, NULL);
+    best = MIN(best, g_get_monotonic_time() - t0);
+  }
+  return best;
+}
+
+// The ad-hoc way: one aggregate over the attempts table, on its own connection
+static gint64 time_sql_best(const char *db_path, const char *log_path, gint64 *best_us) {
+  sqlite3 *conn = NULL;
+  sqlite3_stmt *st = NULL;
+  gint64 best = G_MAXINT64;
+  *best_us = LIVESPIFF_NO_TIME;
+  if (sqlite3_open_v2(db_path, &conn, SQLITE_OPEN_READONLY, NULL) != SQLITE_OK ||
+      sqlite3_prepare_v2(conn, "SELECT min(final_us) FROM attempts WHERE finished = 1 AND "
+                               "run_id = (SELECT id FROM runs WHERE history = ?1)", -1, &st, NULL) != SQLITE_OK) {
+    g_printerr("%s: %s\n", db_path, sqlite3_errmsg(conn));
+    sqlite3_close(conn);
+    return -1;
+  }
+  for (guint r = 0; r < QUERY_REPEATS; r++) {
+    gint64 t0 = g_get_monotonic_time();
+    sqlite3_bind_text(st, 1, log_path, -1, SQLITE_STATIC);
+    if (sqlite3_step(st) == SQLITE_ROW && sqlite3_column_type(st, 0) != SQLITE_NULL) *best_us = sqlite3_column_int64(st, 0);
+    sqlite3_reset(st);
+    best = MIN(best, g_get_monotonic_time() - t0);
+  }
+  sqlite3_finalize(st);
+  sqlite3_close(conn);
+  return best;
+}
+
+int main(int argc, char **argv) {
+  gint count = 10000, segments = 20;
+  gboolean keep = FALSE;
+  GOptionEntry entries[] = {
+    { "count", 'n', 0, G_OPTION_ARG_INT, &count, "Attempts to generate (default 10000)", "N" },
+    { "segments", 's', 0, G_OPTION_ARG_INT, &segments, "Segments per run (default 20)", "S" },
+    { "keep", 'k', 0, G_OPTION_ARG_NONE, &keep, "Keep the scratch directory", NULL },
+    { NULL }
+  };
+
+  GOptionContext *opts = g_option_context_new("- compare the JSON history log with the SQLite history database");
+  g_option_context_add_main_entries(opts, entries, NULL);
+  GError *err = NULL;
+  if (!g_option_context_parse(opts, &argc, &argv, &err)) {
+    g_printerr("%s\n", err->message);
+    g_error_free(err);
+    g_option_context_free(opts);
+    return 1;
+  }
+  g_option_context_free(opts);
+  count = MAX(count, 1);
+  segments = CLAMP(segments, 1, 1000);
+
+  char *dir = g_dir_make_tmp("livespiff-history-bench-XXXXXX", &err);
+  if (!dir) {
+    g_printerr("%s\n", err->message);
+    g_error_free(err);
+    return 1;
+  }
+  char *run_path = g_build_filename(dir, "bench.json", NULL);
+  char *log_path = run_history_path(run_path);
+  char *db_path = g_build_filename(dir, "history.sqlite", NULL);
+
+  LiveSpiffRun *run = run_new_default();
+  g_ptr_array_set_size(run->segments, 0);
+  for (gint i = 0; i < segments; i++) g_ptr_array_add(run->segments, g_strdup_printf("Segment %d", i + 1));
+  GPtrArray *attempts = make_attempts((guint)count, (guint)segments);
+  g_print("%d attempts, %d segments, in %s\n\n", count, segments, dir);
+
+  // Insert
+  gint64 t0 = g_get_monotonic_time();
+  for (guint i = 0; i < attempts->len; i++) history_append(log_path, g_ptr_array_index(attempts, i), NULL);
+  report("insert", "jsonl", attempts->len, g_get_monotonic_time() - t0);
+
+  char *err_str = NULL;
+  LiveSpiffHistoryDb *db = history_db_open(db_path, &err_str);
+  int status = 0;
+  if (!db) {
+    g_printerr("%s\n", err_str ? err_str : "Failed to open the history database");
+    g_free(err_str);
+    status = 1;
+    goto out;
+  }
+  history_db_sync_run(db, run_path, run, NULL);
+  history_db_flush(db);
+  t0 = g_get_monotonic_time();
+  for (guint i = 0; i < attempts->len; i++) history_db_append(db, log_path, g_ptr_array_index(attempts, i));
+  gint64 queued = g_get_monotonic_time() - t0;
+  history_db_flush(db);
+  report("insert", "sqlite", attempts->len, g_get_monotonic_time() - t0);
+  report("  (caller only)", "sqlite", attempts->len, queued);
+
+  // Query
+  ScanTotals json_totals, db_totals;
+  report("full scan", "jsonl", attempts->len, time_json_scan(log_path, &json_totals));
+  report("full scan", "sqlite", attempts->len, time_db_scan(db, log_path, &db_totals));
+  if (json_totals.attempts != db_totals.attempts || json_totals.splits != db_totals.splits) {
+    g_printerr("Mismatch: jsonl %u attempts / %" G_GUINT64_FORMAT " splits, sqlite %u / %" G_GUINT64_FORMAT "\n",
+               json_totals.attempts, json_totals.splits, db_totals.attempts, db_totals.splits);
+    status = 1;
+  }
+
+  gint64 sql_best_us = LIVESPIFF_NO_TIME;
+  report("best time", "jsonl", attempts->len, time_json_scan(log_path, &json_totals));
+  gint64 sql_us = time_sql_best(db_path, log_path, &sql_best_us);
+  if (sql_us >= 0) report("best time", "sql", attempts->len, sql_us);
+  if (sql_us >= 0 && sql_best_us != json_totals.best_us) {
+    g_printerr("Mismatch: best time %" G_GINT64_FORMAT " us (jsonl) vs %" G_GINT64_FORMAT " us (sql)\n",
+               json_totals.best_us, sql_best_us);
+    status = 1;
+  }
+
+  GStatBuf st;
+  gint64 log_bytes = g_stat(log_path, &st) == 0 ? (gint64)st.st_size : 0;
+  gint64 db_bytes = g_stat(db_path, &st) == 0 ? (gint64)st.st_size : 0;
+  g_print("\nsize: jsonl %.1f MiB, sqlite %.1f MiB (before checkpoint)\n",
+          log_bytes / 1048576.0, db_bytes / 1048576.0);
+
+out:
+  history_db_close(db);
+  if (!keep) {
+    const char *names[] = { "bench.history.jsonl", "history.sqlite", "history.sqlite-wal", "history.sqlite-shm" };
+    for (guint i = 0; i < G_N_ELEMENTS(names); i++) {
+      char *path = g_build_filename(dir, names[i], NULL);
+      g_unlink(path);
+      g_free(path);
+    }
+    g_rmdir(dir);
+  }
+  g_ptr_array_free(attempts, TRUE);
+  run_free(run);
+  g_free(db_path);
+  g_free(log_path);
+  g_free(run_path);
+  g_free(dir);
+  return status;
+}
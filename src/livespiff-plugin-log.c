@@ -0,0 +1,71 @@
+// File: src/livespiff-plugin-log.c
+// Example LiveSpiff plugin -> appends every timer event to a text file
+//
+// Install:
+//   cp build/livespiff-plugin-log.so ~/.local/share/livespiff/plugins/
+//   (restart livespiffd; events go to $XDG_RUNTIME_DIR/livespiff-events.log, else /tmp)
+//
+// Deliberately plain C with no GLib: only livespiff_plugin.h is needed to
+// build a plugin. All callbacks run on the plugin's own thread, so blocking
+// I/O here never delays the timer.
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "livespiff_plugin.h"
+
+typedef struct {
+  FILE *out;
+  uint64_t last_sequence;
+} LogState;
+
+static int log_init(void **state) {
+  const char *dir = getenv("XDG_RUNTIME_DIR");
+  char path[512];
+  snprintf(path, sizeof(path), "%s/livespiff-events.log", dir && *dir ? dir : "/tmp");
+
+  LogState *s = calloc(1, sizeof(*s));
+  if (!s) return -1;
+  s->out = fopen(path, "a");
+  if (!s->out) {
+    free(s);
+    return -1;
+  }
+  *state = s;
+  return 0;
+}
+
+static void log_event(void *state, const LiveSpiffPluginEvent *ev) {
+  LogState *s = (LogState*)state;
+  if (s->last_sequence && ev->sequence != s->last_sequence + 1) {
+    fprintf(s->out, "# %" PRIu64 " events dropped\n", ev->sequence - s->last_sequence - 1);
+  }
+  s->last_sequence = ev->sequence;
+
+  fprintf(s->out, "%" PRId64 "\t%s\tstate=%u\tsplit=%d/%d\telapsed_us=%" PRId64,
+          ev->monotonic_us, ev->name, ev->state, ev->current_split, ev->split_count, ev->elapsed_us);
+  if (ev->delta_us != LIVESPIFF_EVENT_NO_TIME) fprintf(s->out, "\tdelta_us=%" PRId64, ev->delta_us);
+  fputc('\n', s->out);
+  fflush(s->out);
+}
+
+static void log_shutdown(void *state) {
+  LogState *s = (LogState*)state;
+  if (!s) return;
+  fclose(s->out);
+  free(s);
+}
+
+static const LiveSpiffPluginDesc desc = {
+  .abi_version = LIVESPIFF_PLUGIN_ABI_VERSION,
+  .name = "log",
+  .init = log_init,
+  .on_event = log_event,
+  .shutdown = log_shutdown,
+};
+
+__attribute__((visibility("default")))
+const LiveSpiffPluginDesc* livespiff_plugin_describe(void) {
+  return &desc;
+}
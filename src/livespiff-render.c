@@ -0,0 +1,381 @@
+// File: src/livespiff-render.c
+// LiveSpiff headless renderer -> draws the timer offscreen into a shared-memory frame ring
+//
+// Features:
+// - Mirrors livespiffd through liblivespiff-client (like livespiff-tui), no window
+// - Cairo image surface, published at a fixed rate into /dev/shm/<name> (see frame_ring.h)
+// - PNG snapshots: --png FILE (render once and exit) or the SavePng D-Bus method
+//
+// Notes:
+// - Frames are only drawn while the clock moves or something changed; an idle
+//   timer costs no CPU and readers keep showing the last frame.
+// - livespiff-frame-dump reads the ring (PNG, or raw BGRA for ffmpeg / v4l2loopback).
+
+#define _GNU_SOURCE
+#include <cairo.h>
+#include <gio/gio.h>
+#include <glib.h>
+#include <glib-unix.h>
+#include <signal.h>
+#include <string.h>
+
+#include "frame_ring.h"
+#include "livespiff_client.h"
+
+#define RENDER_BUS_NAME   "com.livespiff.LiveSpiff.Render"
+#define RENDER_OBJ_PATH   "/com/livespiff/LiveSpiff/Render"
+#define RENDER_IFACE_NAME "com.livespiff.LiveSpiff.Render"
+
+#define NO_TIME LIVESPIFF_NO_TIME_MS
+
+#define FRAME_SLOTS 3
+
+static const gchar render_introspection_xml[] =
+  "<node>"
+  "  <interface name='" RENDER_IFACE_NAME "'>"
+  "    <method name='SavePng'>"
+  "      <arg type='s' name='path' direction='in'/>"
+  "      <arg type='b' name='ok' direction='out'/>"
+  "      <arg type='s' name='message' direction='out'/>"
+  "    </method>"
+  "    <method name='FrameInfo'>"
+  "      <arg type='s' name='shm_name' direction='out'/>"
+  "      <arg type='u' name='width' direction='out'/>"
+  "      <arg type='u' name='height' direction='out'/>"
+  "      <arg type='u' name='fps' direction='out'/>"
+  "      <arg type='t' name='frames' direction='out'/>"
+  "    </method>"
+  "  </interface>"
+  "</node>";
+
+typedef struct {
+  GMainLoop *loop;
+  LiveSpiffClient *client;     // mirrored daemon state
+  guint own_id;
+  guint frame_id;
+  guint fps;
+  GDBusNodeInfo *introspection;
+
+  // Output
+  char *shm_name;
+  FrameRing *ring;             // NULL with --png
+  cairo_surface_t *surface;    // private canvas; copied into the ring on publish
+  guint64 frames;
+  gboolean dirty;
+  char *oneshot_png;
+} Render;
+
+/* ------------------------- formatting ------------------------- */
+
+static char* format_time_ms(gint64 ms) {
+  if (ms < 0) ms = 0;
+  gint64 total_sec = ms / 1000;
+  if (total_sec >= 3600) {
+    return g_strdup_printf("%lld:%02lld:%02lld.%02lld",
+                           (long long)(total_sec / 3600), (long long)((total_sec / 60) % 60),
+                           (long long)(total_sec % 60), (long long)((ms % 1000) / 10));
+  }
+  return g_strdup_printf("%lld:%02lld.%02lld",
+                         (long long)(total_sec / 60), (long long)(total_sec % 60), (long long)((ms % 1000) / 10));
+}
+
+static char* format_delta_ms(gint64 ms) {
+  if (ms == NO_TIME) return g_strdup("");
+  char sign = ms < 0 ? '-' : '+';
+  gint64 a = ms < 0 ? -ms : ms;
+  if (a >= 60000) {
+    return g_strdup_printf("%c%lld:%02lld.%01lld", sign,
+                           (long long)(a / 60000), (long long)((a / 1000) % 60), (long long)((a % 1000) / 100));
+  }
+  return g_strdup_printf("%c%lld.%02lld", sign, (long long)(a / 1000), (long long)((a % 1000) / 10));
+}
+
+/* ------------------------- drawing ------------------------- */
+
+static gint64 array_at(const GArray *a, int i) {
+  return (i >= 0 && (guint)i < a->len) ? g_array_index(a, gint64, i) : NO_TIME;
+}
+
+static void set_rgb(cairo_t *cr, guint32 rgb) {
+  cairo_set_source_rgb(cr, ((rgb >> 16) & 0xff) / 255.0, ((rgb >> 8) & 0xff) / 255.0, (rgb & 0xff) / 255.0);
+}
+
+// Draws text with its left edge at x (right edge if right_align), clipped to max_w
+static void draw_text(cairo_t *cr, const char *text, double x, double baseline, double max_w, gboolean right_align) {
+  cairo_text_extents_t ext;
+  cairo_text_extents(cr, text, &ext);
+  double left = right_align ? x - ext.x_advance : x;
+
+  cairo_save(cr);
+  cairo_rectangle(cr, right_align ? x - max_w : x, baseline - 64, max_w, 96);
+  cairo_clip(cr);
+  cairo_move_to(cr, left, baseline);
+  cairo_show_text(cr, text);
+  cairo_restore(cr);
+}
+
+static void draw(Render *r) {
+  int w = cairo_image_surface_get_width(r->surface);
+  int h = cairo_image_surface_get_height(r->surface);
+  cairo_t *cr = cairo_create(r->surface);
+  LiveSpiffClient *c = r->client;
+
+  set_rgb(cr, 0x101418);
+  cairo_paint(cr);
+
+  const double pad = 10;
+  cairo_select_font_face(cr, "Sans", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+  cairo_set_font_size(cr, 15);
+
+  if (!livespiff_client_is_connected(c)) {
+    set_rgb(cr, 0x7a8088);
+    draw_text(cr, "Daemon not running", pad, 26, w - 2 * pad, FALSE);
+    cairo_destroy(cr);
+    return;
+  }
+
+  const char *state = livespiff_client_get_state(c);
+  const char *comparison = livespiff_client_get_comparison(c);
+  const GPtrArray *segments = livespiff_client_get_segments(c);
+  const GArray *split_ms = livespiff_client_get_split_ms(c);
+  const GArray *delta_ms = livespiff_client_get_delta_ms(c);
+  int current_split = livespiff_client_get_current_split(c);
+
+  set_rgb(cr, 0x7a8088);
+  draw_text(cr, state ? state : "", pad, 26, w / 2.0 - pad, FALSE);
+  if (comparison) draw_text(cr, comparison, w - pad, 26, w / 2.0 - pad, TRUE);
+
+  // Split table: keep the current split in view
+  const double row_h = 26;
+  double list_top = 40;
+  int list_rows = (int)((h - list_top - 70) / row_h);
+  int n = (int)segments->len;
+  int first = 0;
+  if (list_rows > 0 && n > list_rows) {
+    first = current_split - list_rows / 2;
+    if (first < 0) first = 0;
+    if (first > n - list_rows) first = n - list_rows;
+  }
+
+  double time_w = 90, delta_w = 70;
+  for (int i = first; i < n && i - first < list_rows; i++) {
+    double y = list_top + (i - first) * row_h;
+    gboolean current = (i == current_split && g_strcmp0(state, "Idle") != 0);
+    if (current) {
+      set_rgb(cr, 0x1f3a52);
+      cairo_rectangle(cr, 0, y, w, row_h);
+      cairo_fill(cr);
+    }
+    double baseline = y + row_h - 8;
+
+    set_rgb(cr, 0xe6e9ee);
+    draw_text(cr, (const char*)g_ptr_array_index(segments, i), pad, baseline,
+              w - 2 * pad - time_w - delta_w, FALSE);
+
+    gint64 delta = array_at(delta_ms, i);
+    if (delta != NO_TIME) {
+      char *ds = format_delta_ms(delta);
+      set_rgb(cr, delta <= 0 ? 0x3ccf6e : 0xe5534b);
+      draw_text(cr, ds, w - pad - time_w, baseline, delta_w, TRUE);
+      g_free(ds);
+    }
+
+    gint64 split = array_at(split_ms, i);
+    if (split != NO_TIME) {
+      char *ts = format_time_ms(split);
+      set_rgb(cr, 0xe6e9ee);
+      draw_text(cr, ts, w - pad, baseline, time_w, TRUE);
+      g_free(ts);
+    }
+  }
+
+  // Main clock: green while ahead on the last completed split, grey when paused or loading
+  gint64 last_delta = array_at(delta_ms, current_split - 1);
+  guint32 clock_rgb = 0xffffff;
+  if (g_strcmp0(state, "Paused") == 0 || g_strcmp0(state, "Loading") == 0) clock_rgb = 0x7a8088;
+  else if (last_delta != NO_TIME) clock_rgb = last_delta <= 0 ? 0x3ccf6e : 0xe5534b;
+
+  char *time_str = format_time_ms(livespiff_client_get_elapsed_ms(c));
+  cairo_select_font_face(cr, "Sans", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_BOLD);
+  cairo_set_font_size(cr, 44);
+  set_rgb(cr, clock_rgb);
+  draw_text(cr, time_str, w - pad, h - 18, w - 2 * pad, TRUE);
+  g_free(time_str);
+
+  cairo_destroy(cr);
+}
+
+static void publish(Render *r) {
+  draw(r);
+  r->dirty = FALSE;
+  if (!r->ring) return;
+
+  cairo_surface_flush(r->surface);
+  const FrameRingHeader *hdr = frame_ring_header(r->ring);
+  const guint8 *src = cairo_image_surface_get_data(r->surface);
+  int src_stride = cairo_image_surface_get_stride(r->surface);
+
+  guint8 *dst = frame_ring_begin(r->ring);
+  for (guint y = 0; y < hdr->height; y++) {
+    memcpy(dst + (gsize)y * hdr->stride, src + (gsize)y * src_stride, hdr->stride);
+  }
+  frame_ring_commit(r->ring, g_get_monotonic_time());
+  r->frames++;
+}
+
+static gboolean on_frame(gpointer user_data) {
+  Render *r = (Render*)user_data;
+  if (r->dirty || g_strcmp0(livespiff_client_get_state(r->client), "Running") == 0) publish(r);
+  return G_SOURCE_CONTINUE;
+}
+
+static gboolean save_png(Render *r, const char *path, char **out_msg) {
+  draw(r);
+  cairo_status_t st = cairo_surface_write_to_png(r->surface, path);
+  if (out_msg) *out_msg = g_strdup(st == CAIRO_STATUS_SUCCESS ? path : cairo_status_to_string(st));
+  return st == CAIRO_STATUS_SUCCESS;
+}
+
+/* ------------------------- daemon mirror ------------------------- */
+
+static void on_client_changed(LiveSpiffClient *client, guint changes, gpointer user_data) {
+  (void)client; (void)changes;
+  ((Render*)user_data)->dirty = TRUE;
+}
+
+// --png: one frame of whatever the mirror holds (connected or not), then quit
+static gboolean finish_oneshot(gpointer user_data) {
+  Render *r = (Render*)user_data;
+  char *msg = NULL;
+  if (!save_png(r, r->oneshot_png, &msg)) g_printerr("%s: %s\n", r->oneshot_png, msg);
+  g_free(msg);
+  g_main_loop_quit(r->loop);
+  return G_SOURCE_REMOVE;
+}
+
+/* ------------------------- Render D-Bus object ------------------------- */
+
+static void on_render_method(GDBusConnection *connection, const gchar *sender, const gchar *object_path,
+                             const gchar *interface_name, const gchar *method_name, GVariant *parameters,
+                             GDBusMethodInvocation *invocation, gpointer user_data) {
+  (void)connection; (void)sender; (void)object_path; (void)interface_name;
+  Render *r = (Render*)user_data;
+
+  if (g_strcmp0(method_name, "SavePng") == 0) {
+    const char *path = NULL;
+    g_variant_get(parameters, "(&s)", &path);
+    char *msg = NULL;
+    gboolean ok = save_png(r, path, &msg);
+    g_dbus_method_invocation_return_value(invocation, g_variant_new("(bs)", ok, msg));
+    g_free(msg);
+    return;
+  }
+  if (g_strcmp0(method_name, "FrameInfo") == 0) {
+    g_dbus_method_invocation_return_value(invocation, g_variant_new("(suuut)", r->shm_name,
+      (guint32)cairo_image_surface_get_width(r->surface), (guint32)cairo_image_surface_get_height(r->surface),
+      r->fps, (guint64)r->frames));
+    return;
+  }
+  g_dbus_method_invocation_return_dbus_error(invocation, "com.livespiff.LiveSpiff.Error.UnknownMethod",
+                                             "Unknown method");
+}
+
+static const GDBusInterfaceVTable render_vtable = {
+  .method_call = on_render_method,
+  .get_property = NULL,
+  .set_property = NULL
+};
+
+static void on_render_bus_acquired(GDBusConnection *connection, const gchar *name, gpointer user_data) {
+  (void)name;
+  Render *r = (Render*)user_data;
+  if (!g_dbus_connection_register_object(connection, RENDER_OBJ_PATH, r->introspection->interfaces[0],
+                                         &render_vtable, r, NULL, NULL)) {
+    g_printerr("Failed to register %s\n", RENDER_OBJ_PATH);
+  }
+}
+
+static void on_render_name_lost(GDBusConnection *connection, const gchar *name, gpointer user_data) {
+  (void)connection; (void)user_data;
+  g_printerr("Could not own %s (another renderer running?); SavePng unavailable\n", name);
+}
+
+static gboolean on_quit_signal(gpointer user_data) {
+  g_main_loop_quit(((Render*)user_data)->loop);
+  return G_SOURCE_CONTINUE;
+}
+
+int main(int argc, char **argv) {
+  gint width = 360, height = 480, fps = 30;
+  gchar *shm = NULL, *png = NULL;
+  GOptionEntry entries[] = {
+    { "width", 'W', 0, G_OPTION_ARG_INT, &width, "Frame width in pixels (default 360)", "PX" },
+    { "height", 'H', 0, G_OPTION_ARG_INT, &height, "Frame height in pixels (default 480)", "PX" },
+    { "fps", 'f', 0, G_OPTION_ARG_INT, &fps, "Frame rate while the timer runs (default 30)", "N" },
+    { "shm", 's', 0, G_OPTION_ARG_STRING, &shm, "Shared-memory name (default " FRAME_RING_DEFAULT_NAME ")", "NAME" },
+    { "png", 0, 0, G_OPTION_ARG_FILENAME, &png, "Render one frame to a PNG file and exit", "FILE" },
+    { NULL }
+  };
+
+  GOptionContext *opts = g_option_context_new("- render the LiveSpiff timer offscreen for capture");
+  g_option_context_add_main_entries(opts, entries, NULL);
+  GError *err = NULL;
+  if (!g_option_context_parse(opts, &argc, &argv, &err)) {
+    g_printerr("%s\n", err->message);
+    g_error_free(err);
+    g_option_context_free(opts);
+    return 1;
+  }
+  g_option_context_free(opts);
+
+  Render r = {0};
+  r.fps = (guint)CLAMP(fps, 1, 240);
+  r.shm_name = shm ? shm : g_strdup(FRAME_RING_DEFAULT_NAME);
+  r.oneshot_png = png;
+  r.client = livespiff_client_new(&err);
+  if (!r.client) {
+    g_printerr("%s\n", err->message);
+    g_error_free(err);
+    return 1;
+  }
+  g_signal_connect(r.client, "changed", G_CALLBACK(on_client_changed), &r);
+  r.surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, CLAMP(width, 16, 4096), CLAMP(height, 16, 4096));
+  r.dirty = TRUE;
+  r.loop = g_main_loop_new(NULL, FALSE);
+
+  if (!r.oneshot_png) {
+    char *err_str = NULL;
+    r.ring = frame_ring_create(r.shm_name, (guint)cairo_image_surface_get_width(r.surface),
+                               (guint)cairo_image_surface_get_height(r.surface), FRAME_SLOTS, r.fps, &err_str);
+    if (!r.ring) {
+      g_printerr("%s\n", err_str);
+      g_free(err_str);
+      return 1;
+    }
+    g_print("Rendering %dx%d @ %u fps into /dev/shm/%s\n", cairo_image_surface_get_width(r.surface),
+            cairo_image_surface_get_height(r.surface), r.fps, r.shm_name);
+
+    r.introspection = g_dbus_node_info_new_for_xml(render_introspection_xml, NULL);
+    r.own_id = g_bus_own_name(G_BUS_TYPE_SESSION, RENDER_BUS_NAME, G_BUS_NAME_OWNER_FLAGS_NONE,
+                              on_render_bus_acquired, NULL, on_render_name_lost, &r, NULL);
+    r.frame_id = g_timeout_add(1000 / r.fps, on_frame, &r);
+  }
+
+  g_unix_signal_add(SIGINT, on_quit_signal, &r);
+  g_unix_signal_add(SIGTERM, on_quit_signal, &r);
+
+  if (r.oneshot_png) g_idle_add(finish_oneshot, &r);
+
+  g_main_loop_run(r.loop);
+
+  if (r.own_id) g_bus_unown_name(r.own_id);
+  if (r.frame_id) g_source_remove(r.frame_id);
+  g_object_unref(r.client);
+  if (r.introspection) g_dbus_node_info_unref(r.introspection);
+  frame_ring_close(r.ring);
+  cairo_surface_destroy(r.surface);
+  g_main_loop_unref(r.loop);
+  g_free(r.shm_name);
+  g_free(r.oneshot_png);
+  return 0;
+}
@@ -0,0 +1,193 @@
+// File: src/livespiff-rtt.c
+// LiveSpiff transport benchmark -> D-Bus round trips to livespiffd, session bus vs peer-to-peer socket
+//
+// Features:
+// - Times N calls of a cheap method (Snapshot) on each path, after a warm-up
+// - Reports min / median / p99 / max and calls per second per path
+// - Signal latency: call sent -> TimerEvent received, per path (--signals;
+//   flips the active comparison back and forth and restores it, which
+//   leaves the timer and history alone but makes other clients resync)
+//
+// The daemon must be running; the peer path uses $LIVESPIFF_ADDRESS or the
+// socket in $XDG_RUNTIME_DIR, like liblivespiff-client.
+
+#include <gio/gio.h>
+#include <glib.h>
+
+#include "livespiff_client.h"
+
+#define WARMUP_CALLS 100
+
+typedef struct {
+  const char *name;
+  GDBusConnection *connection;
+  const char *bus_name; // NULL on a peer connection
+} Path;
+
+static int cmp_i64(const void *a, const void *b) {
+  gint64 x = *(const gint64*)a, y = *(const gint64*)b;
+  return (x > y) - (x < y);
+}
+
+static void report(const char *path, const char *what, GArray *samples_us) {
+  if (samples_us->len == 0) {
+    g_print("%-6s %-8s no samples\n", path, what);
+    return;
+  }
+  g_array_sort(samples_us, cmp_i64);
+  gint64 *v = (gint64*)samples_us->data;
+  guint n = samples_us->len;
+  gint64 sum = 0;
+  for (guint i = 0; i < n; i++) sum += v[i];
+  g_print("%-6s %-8s n=%-6u min %6.1f  median %6.1f  p99 %6.1f  max %7.1f us  (%.0f/s)\n",
+          path, what, n, (double)v[0], (double)v[n / 2], (double)v[MIN(n - 1, n * 99 / 100)],
+          (double)v[n - 1], sum > 0 ? n * 1e6 / (double)sum : 0.0);
+}
+
+static GVariant* call(const Path *p, const char *method, GVariant *params) {
+  return g_dbus_connection_call_sync(p->connection, p->bus_name, LIVESPIFF_OBJECT_PATH,
+                                     "com.livespiff.LiveSpiff.Control", method, params, NULL,
+                                     G_DBUS_CALL_FLAGS_NO_AUTO_START, 2000, NULL, NULL);
+}
+
+static gboolean bench_calls(const Path *p, guint count) {
+  GArray *samples = g_array_sized_new(FALSE, FALSE, sizeof(gint64), count);
+  for (guint i = 0; i < WARMUP_CALLS + count; i++) {
+    gint64 t0 = g_get_monotonic_time();
+    GVariant *ret = call(p, "Snapshot", NULL);
+    gint64 dt = g_get_monotonic_time() - t0;
+    if (!ret) {
+      g_printerr("%s: Snapshot failed (daemon not running?)\n", p->name);
+      g_array_free(samples, TRUE);
+      return FALSE;
+    }
+    g_variant_unref(ret);
+    if (i >= WARMUP_CALLS) g_array_append_val(samples, dt);
+  }
+  report(p->name, "call", samples);
+  g_array_free(samples, TRUE);
+  return TRUE;
+}
+
+typedef struct {
+  GMainLoop *loop;
+  gint64 received_us;
+} SignalWait;
+
+static void on_signal(GDBusConnection *connection, const gchar *sender, const gchar *object_path,
+                      const gchar *interface_name, const gchar *signal_name, GVariant *params, gpointer user_data) {
+  (void)connection; (void)sender; (void)object_path; (void)interface_name; (void)signal_name; (void)params;
+  SignalWait *w = (SignalWait*)user_data;
+  if (!w->received_us) w->received_us = g_get_monotonic_time();
+  g_main_loop_quit(w->loop);
+}
+
+static gboolean on_signal_timeout(gpointer user_data) {
+  g_main_loop_quit(((SignalWait*)user_data)->loop);
+  return G_SOURCE_REMOVE;
+}
+
+// SetComparison sent -> its "comparison" TimerEvent received
+static void bench_signals(const Path *p, guint count) {
+  GVariant *ret = call(p, "ListComparisons", NULL);
+  if (!ret) return;
+  const char *names[2] = { NULL, NULL }; // other, active
+  GVariantIter *it = NULL;
+  const char *name = NULL;
+  g_variant_get(ret, "(as&s)", &it, &names[1]);
+  while (!names[0] && g_variant_iter_next(it, "&s", &name)) {
+    if (g_strcmp0(name, names[1]) != 0) names[0] = name;
+  }
+  if (!names[0]) {
+    g_print("%-6s %-8s needs a second comparison\n", p->name, "signal");
+    g_variant_iter_free(it);
+    g_variant_unref(ret);
+    return;
+  }
+
+  SignalWait w = { g_main_loop_new(NULL, FALSE), 0 };
+  guint sub = g_dbus_connection_signal_subscribe(p->connection, p->bus_name, "com.livespiff.LiveSpiff.Control",
+                                                 "TimerEvent", LIVESPIFF_OBJECT_PATH, NULL,
+                                                 G_DBUS_SIGNAL_FLAGS_NONE, on_signal, &w, NULL);
+  GArray *samples = g_array_sized_new(FALSE, FALSE, sizeof(gint64), count);
+  for (guint i = 0; i < count; i++) {
+    w.received_us = 0;
+    gint64 t0 = g_get_monotonic_time();
+    g_dbus_connection_call(p->connection, p->bus_name, LIVESPIFF_OBJECT_PATH, "com.livespiff.LiveSpiff.Control",
+                           "SetComparison", g_variant_new("(s)", names[i % 2]), NULL,
+                           G_DBUS_CALL_FLAGS_NO_AUTO_START, 2000, NULL, NULL, NULL);
+    guint timeout_id = g_timeout_add(2000, on_signal_timeout, &w);
+    g_main_loop_run(w.loop);
+    if (w.received_us) g_source_remove(timeout_id);
+    else break;
+    gint64 dt = w.received_us - t0;
+    g_array_append_val(samples, dt);
+  }
+  report(p->name, "signal", samples);
+  g_array_free(samples, TRUE);
+  g_dbus_connection_signal_unsubscribe(p->connection, sub);
+  g_main_loop_unref(w.loop);
+
+  GVariant *restored = call(p, "SetComparison", g_variant_new("(s)", names[1]));
+  if (restored) g_variant_unref(restored);
+  g_variant_iter_free(it);
+  g_variant_unref(ret);
+}
+
+int main(int argc, char **argv) {
+  gint count = 10000;
+  gboolean signals = FALSE;
+  GOptionEntry entries[] = {
+    { "count", 'n', 0, G_OPTION_ARG_INT, &count, "Round trips per path (default 10000)", "N" },
+    { "signals", 's', 0, G_OPTION_ARG_NONE, &signals,
+      "Also time TimerEvent delivery (switches the active comparison back and forth)", NULL },
+    { NULL }
+  };
+
+  GOptionContext *opts = g_option_context_new("- compare LiveSpiff D-Bus latency over the bus and the peer socket");
+  g_option_context_add_main_entries(opts, entries, NULL);
+  GError *err = NULL;
+  if (!g_option_context_parse(opts, &argc, &argv, &err)) {
+    g_printerr("%s\n", err->message);
+    g_error_free(err);
+    g_option_context_free(opts);
+    return 1;
+  }
+  g_option_context_free(opts);
+  if (count < 1) count = 1;
+
+  Path paths[2];
+  guint n_paths = 0;
+
+  GDBusConnection *bus = g_bus_get_sync(G_BUS_TYPE_SESSION, NULL, &err);
+  if (bus) {
+    paths[n_paths++] = (Path){ "bus", bus, LIVESPIFF_BUS_NAME };
+  } else {
+    g_printerr("Session bus: %s\n", err->message);
+    g_clear_error(&err);
+  }
+
+  char *address = livespiff_client_peer_address();
+  GDBusConnection *peer = address ? g_dbus_connection_new_for_address_sync(
+    address, G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT, NULL, NULL, &err) : NULL;
+  if (peer) {
+    paths[n_paths++] = (Path){ "peer", peer, NULL };
+  } else {
+    g_printerr("Peer socket: %s\n", err ? err->message : "none (daemon not running, or too old)");
+    g_clear_error(&err);
+  }
+  g_free(address);
+
+  int status = n_paths ? 0 : 1;
+  for (guint i = 0; i < n_paths; i++) {
+    if (!bench_calls(&paths[i], (guint)count)) {
+      status = 1;
+      continue;
+    }
+    if (signals) bench_signals(&paths[i], MIN((guint)count, 1000u));
+  }
+
+  if (peer) g_object_unref(peer);
+  if (bus) g_object_unref(bus);
+  return status;
+}
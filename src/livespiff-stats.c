@@ -0,0 +1,179 @@
+// File: src/livespiff-stats.c
+// LiveSpiff library statistics -> totals per run, per game and overall
+//
+// Usage:
+//   livespiff-stats [--dir DIR] [--threads N] [--json]
+//
+// Notes:
+// - Reads run files and histories directly (no daemon needed); the daemon
+//   exposes the same numbers through LibraryStats.
+// - Files are parsed in parallel, one worker per core by default.
+
+#include <glib.h>
+#include <json-glib/json-glib.h>
+
+#include "stats.h"
+#include "storage.h"
+
+static char* format_duration(gint64 us) {
+  if (us == LIVESPIFF_NO_TIME) return g_strdup("-");
+  gint64 s = us / G_USEC_PER_SEC;
+  return g_strdup_printf("%" G_GINT64_FORMAT ":%02d:%02d.%03d",
+                         s / 3600, (int)(s / 60 % 60), (int)(s % 60), (int)(us / 1000 % 1000));
+}
+
+static void print_totals_row(const char *label, const LiveSpiffStatsTotals *t, gint64 pb_us) {
+  char *play = format_duration(t->play_time_us);
+  char *pb = format_duration(pb_us);
+  g_print("%-40s %8" G_GUINT64_FORMAT " %8" G_GUINT64_FORMAT " %14s %5u %6u %14s\n",
+          label, t->attempts, t->finished, play, t->pbs, t->golds, pb);
+  g_free(play);
+  g_free(pb);
+}
+
+static void merge_into(LiveSpiffStatsTotals *into, const LiveSpiffStatsTotals *from) {
+  into->attempts += from->attempts;
+  into->finished += from->finished;
+  into->play_time_us += from->play_time_us;
+  into->pbs += from->pbs;
+  into->golds += from->golds;
+}
+
+static void print_text(const LiveSpiffStats *stats) {
+  const char *header = "%-40s %8s %8s %14s %5s %6s %14s\n";
+
+  g_print(header, "Run", "Attempts", "Finished", "Play time", "PBs", "Golds", "PB");
+  for (guint i = 0; i < stats->runs->len; i++) {
+    const LiveSpiffRunStats *rs = g_ptr_array_index(stats->runs, i);
+    char *label = g_strdup_printf("%s / %s", rs->game, rs->category);
+    print_totals_row(label, &rs->totals, rs->pb_us);
+    g_free(label);
+  }
+
+  // Per game across categories, in first-seen order
+  GHashTable *by_game = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, g_free);
+  GPtrArray *games = g_ptr_array_new();
+  for (guint i = 0; i < stats->runs->len; i++) {
+    const LiveSpiffRunStats *rs = g_ptr_array_index(stats->runs, i);
+    LiveSpiffStatsTotals *t = g_hash_table_lookup(by_game, rs->game);
+    if (!t) {
+      t = g_new0(LiveSpiffStatsTotals, 1);
+      g_hash_table_insert(by_game, rs->game, t);
+      g_ptr_array_add(games, rs->game);
+    }
+    merge_into(t, &rs->totals);
+  }
+
+  g_print("\n");
+  g_print(header, "Game", "Attempts", "Finished", "Play time", "PBs", "Golds", "");
+  for (guint i = 0; i < games->len; i++) {
+    const char *game = g_ptr_array_index(games, i);
+    print_totals_row(game, g_hash_table_lookup(by_game, game), LIVESPIFF_NO_TIME);
+  }
+  g_ptr_array_free(games, TRUE);
+  g_hash_table_destroy(by_game);
+
+  g_print("\n");
+  print_totals_row("Total", &stats->totals, LIVESPIFF_NO_TIME);
+  g_print("%u run files", stats->files);
+  if (stats->errors) g_print(", %u unreadable", stats->errors);
+  g_print("\n");
+}
+
+static void add_totals_members(JsonBuilder *b, const LiveSpiffStatsTotals *t) {
+  json_builder_set_member_name(b, "attempts");
+  json_builder_add_int_value(b, (gint64)t->attempts);
+  json_builder_set_member_name(b, "finished");
+  json_builder_add_int_value(b, (gint64)t->finished);
+  json_builder_set_member_name(b, "play_time_ms");
+  json_builder_add_int_value(b, t->play_time_us / 1000);
+  json_builder_set_member_name(b, "pbs");
+  json_builder_add_int_value(b, t->pbs);
+  json_builder_set_member_name(b, "golds");
+  json_builder_add_int_value(b, t->golds);
+  json_builder_set_member_name(b, "first_attempt_us");
+  json_builder_add_int_value(b, t->first_attempt_us);
+  json_builder_set_member_name(b, "last_attempt_us");
+  json_builder_add_int_value(b, t->last_attempt_us);
+}
+
+static void print_json(const LiveSpiffStats *stats) {
+  JsonBuilder *b = json_builder_new();
+  json_builder_begin_object(b);
+  json_builder_set_member_name(b, "files");
+  json_builder_add_int_value(b, stats->files);
+  json_builder_set_member_name(b, "errors");
+  json_builder_add_int_value(b, stats->errors);
+  add_totals_members(b, &stats->totals);
+
+  json_builder_set_member_name(b, "runs");
+  json_builder_begin_array(b);
+  for (guint i = 0; i < stats->runs->len; i++) {
+    const LiveSpiffRunStats *rs = g_ptr_array_index(stats->runs, i);
+    json_builder_begin_object(b);
+    json_builder_set_member_name(b, "path");
+    json_builder_add_string_value(b, rs->path);
+    json_builder_set_member_name(b, "game");
+    json_builder_add_string_value(b, rs->game ? rs->game : "");
+    json_builder_set_member_name(b, "category");
+    json_builder_add_string_value(b, rs->category ? rs->category : "");
+    json_builder_set_member_name(b, "pb_ms");
+    if (rs->pb_us == LIVESPIFF_NO_TIME) json_builder_add_null_value(b);
+    else json_builder_add_int_value(b, rs->pb_us / 1000);
+    add_totals_members(b, &rs->totals);
+    json_builder_end_object(b);
+  }
+  json_builder_end_array(b);
+  json_builder_end_object(b);
+
+  JsonNode *root = json_builder_get_root(b);
+  JsonGenerator *gen = json_generator_new();
+  json_generator_set_pretty(gen, TRUE);
+  json_generator_set_root(gen, root);
+  char *out = json_generator_to_data(gen, NULL);
+  g_print("%s\n", out);
+
+  g_free(out);
+  g_object_unref(gen);
+  json_node_free(root);
+  g_object_unref(b);
+}
+
+int main(int argc, char **argv) {
+  gchar *dir = NULL;
+  gint threads = 0;
+  gboolean as_json = FALSE;
+  GOptionEntry entries[] = {
+    { "dir", 'd', 0, G_OPTION_ARG_FILENAME, &dir, "Runs directory (default ~/.local/share/livespiff/runs)", "DIR" },
+    { "threads", 't', 0, G_OPTION_ARG_INT, &threads, "Worker threads (default: one per core)", "N" },
+    { "json", 'j', 0, G_OPTION_ARG_NONE, &as_json, "Print JSON instead of tables", NULL },
+    { NULL }
+  };
+
+  GOptionContext *opts = g_option_context_new("- LiveSpiff library statistics");
+  g_option_context_add_main_entries(opts, entries, NULL);
+  GError *err = NULL;
+  if (!g_option_context_parse(opts, &argc, &argv, &err)) {
+    g_printerr("%s\n", err->message);
+    g_error_free(err);
+    g_option_context_free(opts);
+    return 1;
+  }
+  g_option_context_free(opts);
+
+  if (!dir) dir = livespiff_runs_dir();
+
+  gint64 t0 = g_get_monotonic_time();
+  LiveSpiffStats *stats = stats_collect(dir, (guint)MAX(threads, 0));
+  gint64 t1 = g_get_monotonic_time();
+
+  if (as_json) print_json(stats);
+  else {
+    print_text(stats);
+    g_print("Scanned in %.1f ms\n", (t1 - t0) / 1000.0);
+  }
+
+  stats_free(stats);
+  g_free(dir);
+  return 0;
+}
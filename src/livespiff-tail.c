@@ -0,0 +1,179 @@
+// File: src/livespiff-tail.c
+// LiveSpiff event tail (GLib/GIO only) -> one JSON line per TimerEvent on stdout
+//
+// Features:
+// - Follows the daemon's TimerEvent signal through liblivespiff-client
+//   (peer-to-peer socket when there is one, else the bus); never polls
+// - Line-buffered output, suitable for `livespiff-tail | jq` or bot scripts
+// - Segment names come from the client's mirror, refetched only when a run is loaded
+// - Emits "connected"/"disconnected" lines when the daemon appears/vanishes
+//
+// Output (times in ms, unknown values as null):
+//   {"event":"split","state":"Running","split_index":2,"segment":"Forest",
+//    "current_split":3,"split_count":10,"elapsed_ms":81234,"split_ms":81234,
+//    "delta_ms":-1520,"wall_us":1700000000000000}
+
+#define _GNU_SOURCE
+#include <gio/gio.h>
+#include <glib.h>
+#include <glib-unix.h>
+#include <signal.h>
+#include <stdio.h>
+
+#include "livespiff_client.h"
+
+#define NO_TIME LIVESPIFF_NO_TIME_MS
+
+typedef struct {
+  GMainLoop *loop;
+  LiveSpiffClient *client;
+  gboolean connected;  // as last reported
+  gchar **only_events; // NULL: all events
+  GString *line;
+} Tail;
+
+static void json_append_string(GString *s, const char *str) {
+  g_string_append_c(s, '"');
+  for (const char *p = str ? str : ""; *p; p++) {
+    switch (*p) {
+      case '"':  g_string_append(s, "\\\""); break;
+      case '\\': g_string_append(s, "\\\\"); break;
+      case '\n': g_string_append(s, "\\n"); break;
+      case '\r': g_string_append(s, "\\r"); break;
+      case '\t': g_string_append(s, "\\t"); break;
+      default:
+        if ((guchar)*p < 0x20) g_string_append_printf(s, "\\u%04x", (guchar)*p);
+        else g_string_append_c(s, *p);
+    }
+  }
+  g_string_append_c(s, '"');
+}
+
+static void json_append_time(GString *s, const char *key, gint64 ms) {
+  g_string_append_printf(s, ",\"%s\":", key);
+  if (ms == NO_TIME) g_string_append(s, "null");
+  else g_string_append_printf(s, "%" G_GINT64_FORMAT, ms);
+}
+
+static void write_line(Tail *t) {
+  g_string_append_c(t->line, '\n');
+  fwrite(t->line->str, 1, t->line->len, stdout);
+  // stdout is line buffered; the flush reports a reader that went away (EPIPE)
+  if (fflush(stdout) != 0) g_main_loop_quit(t->loop);
+}
+
+static gboolean event_wanted(Tail *t, const char *event) {
+  return !t->only_events || g_strv_contains((const gchar * const *)t->only_events, event);
+}
+
+static void emit_presence(Tail *t, const char *event) {
+  if (!event_wanted(t, event)) return;
+  g_string_truncate(t->line, 0);
+  g_string_append(t->line, "{\"event\":");
+  json_append_string(t->line, event);
+  g_string_append_printf(t->line, ",\"wall_us\":%" G_GINT64_FORMAT "}", g_get_real_time());
+  write_line(t);
+}
+
+static void on_client_signal(LiveSpiffClient *client, const gchar *signal_name, GVariant *params,
+                             gpointer user_data) {
+  Tail *t = (Tail*)user_data;
+  if (g_strcmp0(signal_name, "TimerEvent") != 0) return;
+  if (!g_variant_is_of_type(params, G_VARIANT_TYPE("(ssiiixxxx)"))) return;
+
+  const char *event = NULL, *state = NULL;
+  gint32 split_index = -1, cur = 0, count = 0;
+  gint64 elapsed = 0, mono = 0, split = NO_TIME, delta = NO_TIME;
+  g_variant_get(params, "(&s&siiixxxx)", &event, &state, &split_index, &cur, &count,
+                &elapsed, &mono, &split, &delta);
+
+  if (!event_wanted(t, event)) return;
+  const GPtrArray *segments = livespiff_client_get_segments(client); // already refetched on "load"
+
+  g_string_truncate(t->line, 0);
+  g_string_append(t->line, "{\"event\":");
+  json_append_string(t->line, event);
+  g_string_append(t->line, ",\"state\":");
+  json_append_string(t->line, state);
+  g_string_append_printf(t->line, ",\"split_index\":%d", split_index);
+  if (split_index >= 0 && (guint)split_index < segments->len) {
+    g_string_append(t->line, ",\"segment\":");
+    json_append_string(t->line, g_ptr_array_index(segments, split_index));
+  }
+  g_string_append_printf(t->line, ",\"current_split\":%d,\"split_count\":%d", cur, count);
+  json_append_time(t->line, "elapsed_ms", elapsed);
+  json_append_time(t->line, "split_ms", split);
+  json_append_time(t->line, "delta_ms", delta);
+  g_string_append_printf(t->line, ",\"wall_us\":%" G_GINT64_FORMAT "}", g_get_real_time());
+  write_line(t);
+}
+
+static void on_client_changed(LiveSpiffClient *client, guint changes, gpointer user_data) {
+  Tail *t = (Tail*)user_data;
+  if (!(changes & LIVESPIFF_CLIENT_CONNECTION)) return;
+  gboolean connected = livespiff_client_is_connected(client);
+  if (connected == t->connected) return; // e.g. a switch between socket and bus
+  t->connected = connected;
+  emit_presence(t, connected ? "connected" : "disconnected");
+}
+
+static gboolean on_quit_signal(gpointer user_data) {
+  g_main_loop_quit(((Tail*)user_data)->loop);
+  return G_SOURCE_CONTINUE;
+}
+
+int main(int argc, char **argv) {
+  gchar *events = NULL;
+  GOptionEntry entries[] = {
+    { "events", 'e', 0, G_OPTION_ARG_STRING, &events,
+      "Only print these events (comma separated, e.g. split,finish,reset)", "LIST" },
+    { NULL }
+  };
+
+  GOptionContext *opts = g_option_context_new("- print LiveSpiff timer events as JSON lines");
+  g_option_context_add_main_entries(opts, entries, NULL);
+  GError *err = NULL;
+  if (!g_option_context_parse(opts, &argc, &argv, &err)) {
+    g_printerr("%s\n", err->message);
+    g_error_free(err);
+    g_option_context_free(opts);
+    return 1;
+  }
+  g_option_context_free(opts);
+
+  setvbuf(stdout, NULL, _IOLBF, 0);
+  // A closed reader (e.g. `| head`) makes writes fail with EPIPE instead of
+  // killing the process, which then leaves the loop and exits normally
+  signal(SIGPIPE, SIG_IGN);
+
+  Tail t = {0};
+  t.client = livespiff_client_new(&err);
+  if (!t.client) {
+    g_printerr("%s\n", err->message);
+    g_error_free(err);
+    g_free(events);
+    return 1;
+  }
+  t.line = g_string_sized_new(256);
+  if (events && *events) {
+    t.only_events = g_strsplit(events, ",", -1);
+    for (guint i = 0; t.only_events[i]; i++) g_strstrip(t.only_events[i]);
+  }
+  g_free(events);
+  t.loop = g_main_loop_new(NULL, FALSE);
+
+  g_unix_signal_add(SIGINT, on_quit_signal, &t);
+  g_unix_signal_add(SIGTERM, on_quit_signal, &t);
+
+  g_signal_connect(t.client, "changed", G_CALLBACK(on_client_changed), &t);
+  g_signal_connect(t.client, "signal", G_CALLBACK(on_client_signal), &t);
+  on_client_changed(t.client, LIVESPIFF_CLIENT_CONNECTION, &t);
+
+  g_main_loop_run(t.loop);
+
+  g_object_unref(t.client);
+  g_main_loop_unref(t.loop);
+  g_strfreev(t.only_events);
+  g_string_free(t.line, TRUE);
+  return 0;
+}
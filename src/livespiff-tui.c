@@ -0,0 +1,366 @@
+// File: src/livespiff-tui.c
+// LiveSpiff terminal client (GLib/GIO only) -> mirrors livespiffd through liblivespiff-client
+//
+// Features:
+// - Shows time/state/splits/deltas in a terminal (alternate screen)
+// - Driven by the client's mirror; running time is extrapolated locally
+// - Diff-redraw: only cells that changed since the last frame are written
+//
+// Notes:
+// - Frames are only scheduled while the timer runs; idle/paused costs no CPU.
+// - Ctrl+C quits and restores the terminal.
+
+#define _GNU_SOURCE
+#include <gio/gio.h>
+#include <glib.h>
+#include <glib-unix.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include "livespiff_client.h"
+
+#define NO_TIME LIVESPIFF_NO_TIME_MS
+
+typedef enum {
+  ATTR_NORMAL = 0,
+  ATTR_BOLD,
+  ATTR_DIM,
+  ATTR_AHEAD,
+  ATTR_BEHIND,
+  ATTR_CURRENT,
+  ATTR_INVALID = 0xff // never drawn: forces a cell to be rewritten
+} CellAttr;
+
+static const char *attr_sgr[] = {
+  [ATTR_NORMAL]  = "\033[0m",
+  [ATTR_BOLD]    = "\033[0;1m",
+  [ATTR_DIM]     = "\033[0;2m",
+  [ATTR_AHEAD]   = "\033[0;32m",
+  [ATTR_BEHIND]  = "\033[0;31m",
+  [ATTR_CURRENT] = "\033[0;1;36m",
+};
+
+typedef struct {
+  gunichar ch; // 0: right half of a wide character
+  guint8 attr;
+} Cell;
+
+typedef struct {
+  int rows, cols;
+  Cell *front; // what the terminal currently shows
+  Cell *back;  // frame being composed
+  GString *out;
+} Screen;
+
+typedef struct {
+  GMainLoop *loop;
+  LiveSpiffClient *client; // mirrored daemon state
+  guint frame_id;
+  guint fps;
+  Screen screen;
+} Tui;
+
+/* ------------------------- screen ------------------------- */
+
+static void screen_resize(Screen *s) {
+  struct winsize ws = {0};
+  int rows = 24, cols = 80;
+  if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_row > 0 && ws.ws_col > 0) {
+    rows = ws.ws_row;
+    cols = ws.ws_col;
+  }
+
+  g_free(s->front);
+  g_free(s->back);
+  s->rows = rows;
+  s->cols = cols;
+  s->front = g_new(Cell, (gsize)rows * cols);
+  s->back = g_new(Cell, (gsize)rows * cols);
+
+  // Everything differs from the (cleared) terminal on the next flush
+  for (int i = 0; i < rows * cols; i++) {
+    s->front[i].ch = ' ';
+    s->front[i].attr = ATTR_INVALID;
+  }
+  g_string_append(s->out, "\033[0m\033[2J");
+}
+
+static void screen_clear(Screen *s) {
+  for (int i = 0; i < s->rows * s->cols; i++) {
+    s->back[i].ch = ' ';
+    s->back[i].attr = ATTR_NORMAL;
+  }
+}
+
+// Draw UTF-8 text at (row, col), clipped to width columns; returns columns used
+static int screen_put(Screen *s, int row, int col, const char *text, CellAttr attr, int width) {
+  if (row < 0 || row >= s->rows || !text) return 0;
+  if (col + width > s->cols) width = s->cols - col;
+
+  int used = 0;
+  for (const char *p = text; *p && used < width; p = g_utf8_next_char(p)) {
+    gunichar ch = g_utf8_get_char_validated(p, -1);
+    if (ch == (gunichar)-1 || ch == (gunichar)-2) break;
+    int w = g_unichar_iswide(ch) ? 2 : 1;
+    if (used + w > width) break;
+
+    Cell *c = &s->back[row * s->cols + col + used];
+    c->ch = ch;
+    c->attr = attr;
+    if (w == 2) {
+      c[1].ch = 0;
+      c[1].attr = attr;
+    }
+    used += w;
+  }
+  return used;
+}
+
+static int text_width(const char *text) {
+  int w = 0;
+  for (const char *p = text; *p; p = g_utf8_next_char(p)) w += g_unichar_iswide(g_utf8_get_char(p)) ? 2 : 1;
+  return w;
+}
+
+static void screen_put_right(Screen *s, int row, int right_col, const char *text, CellAttr attr) {
+  int w = text_width(text);
+  int col = right_col - w;
+  if (col < 0) col = 0;
+  screen_put(s, row, col, text, attr, w);
+}
+
+// Emit only changed cells, moving the cursor only across gaps
+static void screen_flush(Screen *s) {
+  int cur_row = -1, cur_col = -1;
+  int cur_attr = -1;
+
+  for (int r = 0; r < s->rows; r++) {
+    for (int c = 0; c < s->cols; c++) {
+      Cell *b = &s->back[r * s->cols + c];
+      Cell *f = &s->front[r * s->cols + c];
+      if (b->ch == f->ch && b->attr == f->attr) continue;
+      if (b->ch == 0) { *f = *b; continue; } // covered by the wide char before it
+
+      if (r != cur_row || c != cur_col) g_string_append_printf(s->out, "\033[%d;%dH", r + 1, c + 1);
+      if (b->attr != cur_attr) {
+        g_string_append(s->out, attr_sgr[b->attr]);
+        cur_attr = b->attr;
+      }
+      g_string_append_unichar(s->out, b->ch);
+
+      *f = *b;
+      cur_row = r;
+      cur_col = c + (g_unichar_iswide(b->ch) ? 2 : 1);
+    }
+  }
+
+  if (s->out->len == 0) return;
+  const char *p = s->out->str;
+  gsize left = s->out->len;
+  while (left > 0) {
+    ssize_t n = write(STDOUT_FILENO, p, left);
+    if (n <= 0) break;
+    p += n;
+    left -= (gsize)n;
+  }
+  g_string_truncate(s->out, 0);
+}
+
+/* ------------------------- formatting ------------------------- */
+
+static char* format_time_ms(gint64 ms) {
+  if (ms < 0) ms = 0;
+  gint64 total_sec = ms / 1000;
+  return g_strdup_printf("%02lld:%02lld:%02lld.%03lld",
+                         (long long)(total_sec / 3600),
+                         (long long)((total_sec / 60) % 60),
+                         (long long)(total_sec % 60),
+                         (long long)(ms % 1000));
+}
+
+static char* format_delta_ms(gint64 ms) {
+  if (ms == NO_TIME) return g_strdup("");
+  char sign = ms < 0 ? '-' : '+';
+  gint64 a = ms < 0 ? -ms : ms;
+  if (a >= 60000) {
+    return g_strdup_printf("%c%lld:%02lld.%03lld", sign,
+                           (long long)(a / 60000), (long long)((a / 1000) % 60), (long long)(a % 1000));
+  }
+  return g_strdup_printf("%c%lld.%03lld", sign, (long long)(a / 1000), (long long)(a % 1000));
+}
+
+/* ------------------------- render ------------------------- */
+
+static gint64 array_at(const GArray *a, int i) {
+  return (i >= 0 && (guint)i < a->len) ? g_array_index(a, gint64, i) : NO_TIME;
+}
+
+static void render(Tui *t) {
+  Screen *s = &t->screen;
+  LiveSpiffClient *c = t->client;
+  screen_clear(s);
+
+  if (!livespiff_client_is_connected(c)) {
+    screen_put(s, 0, 0, "LiveSpiff  Daemon not running", ATTR_DIM, s->cols);
+    screen_flush(s);
+    return;
+  }
+
+  screen_put(s, 0, 0, "LiveSpiff", ATTR_BOLD, s->cols);
+  const char *state = livespiff_client_get_state(c);
+  const char *comparison = livespiff_client_get_comparison(c);
+  const GPtrArray *segments = livespiff_client_get_segments(c);
+  int current_split = livespiff_client_get_current_split(c);
+  screen_put(s, 0, 11, state ? state : "", ATTR_NORMAL, s->cols);
+  if (comparison) screen_put_right(s, 0, s->cols, comparison, ATTR_DIM);
+
+  // Split list: keep the current split in view
+  int list_top = 2;
+  int list_rows = s->rows - 5;
+  int n = (int)segments->len;
+  int first = 0;
+  if (list_rows > 0 && n > list_rows) {
+    first = current_split - list_rows / 2;
+    if (first < 0) first = 0;
+    if (first > n - list_rows) first = n - list_rows;
+  }
+
+  int time_col = s->cols - 12;
+  int delta_col = time_col - 2;
+  for (int i = first; i < n && i - first < list_rows; i++) {
+    int row = list_top + (i - first);
+    gboolean current = (i == current_split && g_strcmp0(state, "Idle") != 0);
+    CellAttr name_attr = current ? ATTR_CURRENT : ATTR_NORMAL;
+
+    screen_put(s, row, 0, current ? ">" : " ", name_attr, 1);
+    screen_put(s, row, 2, (const char*)g_ptr_array_index(segments, i), name_attr, delta_col - 14);
+
+    gint64 split = array_at(livespiff_client_get_split_ms(c), i);
+    if (split != NO_TIME) {
+      char *ts = format_time_ms(split);
+      screen_put_right(s, row, s->cols, ts, ATTR_NORMAL);
+      g_free(ts);
+    }
+
+    gint64 delta = array_at(livespiff_client_get_delta_ms(c), i);
+    if (delta != NO_TIME) {
+      char *ds = format_delta_ms(delta);
+      screen_put_right(s, row, delta_col, ds, delta <= 0 ? ATTR_AHEAD : ATTR_BEHIND);
+      g_free(ds);
+    }
+  }
+
+  char *time_str = format_time_ms(livespiff_client_get_elapsed_ms(c));
+  screen_put_right(s, s->rows - 2, s->cols, time_str, ATTR_BOLD);
+  g_free(time_str);
+
+  char *split_str = g_strdup_printf("Split: %d / %d", current_split + 1, livespiff_client_get_split_count(c));
+  screen_put(s, s->rows - 2, 0, split_str, ATTR_DIM, s->cols / 2);
+  g_free(split_str);
+
+  screen_flush(s);
+}
+
+static gboolean on_frame(gpointer user_data) {
+  render((Tui*)user_data);
+  return G_SOURCE_CONTINUE;
+}
+
+// Frames only while running: the clock is the only thing that moves
+static void update_frame_timer(Tui *t) {
+  gboolean running = livespiff_client_is_connected(t->client) &&
+                     g_strcmp0(livespiff_client_get_state(t->client), "Running") == 0;
+  if (running && !t->frame_id) {
+    t->frame_id = g_timeout_add(1000 / t->fps, on_frame, t);
+  } else if (!running && t->frame_id) {
+    g_source_remove(t->frame_id);
+    t->frame_id = 0;
+  }
+}
+
+/* ------------------------- daemon mirror ------------------------- */
+
+static void on_client_changed(LiveSpiffClient *client, guint changes, gpointer user_data) {
+  (void)client; (void)changes;
+  Tui *t = (Tui*)user_data;
+  update_frame_timer(t);
+  render(t);
+}
+
+/* ------------------------- terminal ------------------------- */
+
+static void terminal_enter(void) {
+  const char seq[] = "\033[?1049h\033[?25l";
+  if (write(STDOUT_FILENO, seq, sizeof(seq) - 1) < 0) return;
+}
+
+static void terminal_leave(void) {
+  const char seq[] = "\033[0m\033[?25h\033[?1049l";
+  if (write(STDOUT_FILENO, seq, sizeof(seq) - 1) < 0) return;
+}
+
+static gboolean on_quit_signal(gpointer user_data) {
+  g_main_loop_quit(((Tui*)user_data)->loop);
+  return G_SOURCE_CONTINUE;
+}
+
+static gboolean on_winch(gpointer user_data) {
+  Tui *t = (Tui*)user_data;
+  screen_resize(&t->screen);
+  render(t);
+  return G_SOURCE_CONTINUE;
+}
+
+int main(int argc, char **argv) {
+  gint fps = 20;
+  GOptionEntry entries[] = {
+    { "fps", 'f', 0, G_OPTION_ARG_INT, &fps, "Redraw rate while the timer runs (default 20)", "N" },
+    { NULL }
+  };
+
+  GOptionContext *opts = g_option_context_new("- LiveSpiff terminal timer");
+  g_option_context_add_main_entries(opts, entries, NULL);
+  GError *err = NULL;
+  if (!g_option_context_parse(opts, &argc, &argv, &err)) {
+    g_printerr("%s\n", err->message);
+    g_error_free(err);
+    g_option_context_free(opts);
+    return 1;
+  }
+  g_option_context_free(opts);
+
+  Tui t = {0};
+  t.fps = (guint)CLAMP(fps, 1, 120);
+  t.client = livespiff_client_new(&err);
+  if (!t.client) {
+    g_printerr("%s\n", err->message);
+    g_error_free(err);
+    return 1;
+  }
+  t.screen.out = g_string_new(NULL);
+  t.loop = g_main_loop_new(NULL, FALSE);
+
+  terminal_enter();
+  screen_resize(&t.screen);
+  g_signal_connect(t.client, "changed", G_CALLBACK(on_client_changed), &t);
+  update_frame_timer(&t);
+  render(&t);
+
+  g_unix_signal_add(SIGINT, on_quit_signal, &t);
+  g_unix_signal_add(SIGTERM, on_quit_signal, &t);
+  g_unix_signal_add(SIGWINCH, on_winch, &t);
+
+  g_main_loop_run(t.loop);
+
+  terminal_leave();
+
+  if (t.frame_id) g_source_remove(t.frame_id);
+  g_object_unref(t.client);
+  g_main_loop_unref(t.loop);
+  g_string_free(t.screen.out, TRUE);
+  g_free(t.screen.front);
+  g_free(t.screen.back);
+  return 0;
+}
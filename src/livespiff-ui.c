@@ -2,12 +2,16 @@
 // LiveSpiff GUI (GTK4) -> talks to livespiffd via D-Bus
 //
 // Features:
-// - Shows time/state/splits
+// - Shows the timer through a configurable layout (layout.ini, see layout.h)
 // - Edit custom splits (names) and apply them (writes run JSON + calls LoadRun on daemon)
-// - Hotkey setup helper for KDE Wayland (global hotkeys via KDE Global Shortcuts calling qdbus6)
+// - Hotkey setup: preferred keys for the daemon's global shortcuts (portal / KGlobalAccel)
+// - Game window picker (kdotool, async + cached), tells the daemon which process to watch
+// - Input latency calibration (tap along to a metronome, per input source)
+// - Attempt history browser (paged from the daemon, sorted/filtered there)
 //
 // Notes:
-// - Wayland: global hotkeys should be set in KDE shortcuts.
+// - Wayland: the compositor owns global hotkeys; the daemon registers them and the
+//   final keys are confirmed in the desktop's shortcut settings.
 // - Wayland: always-on-top cannot be enforced reliably by GTK4.
 
 #include <gtk/gtk.h>
@@ -15,30 +19,39 @@
 #include <glib.h>
 #include <string.h>
 
+#include "history_model.h"
+#include "layout_view.h"
+#include "livespiff_client.h"
+#include "split_tree.h"
 #include "ui_settings.h" // we reuse ui_settings_path() to store extra settings in the same ini
+#include "window_picker.h"
 
-#define LS_BUS_NAME   "com.livespiff.LiveSpiff"
-#define LS_OBJ_PATH   "/com/livespiff/LiveSpiff"
-#define LS_IFACE_NAME "com.livespiff.LiveSpiff.Control"
+// Input source reported for the window's own buttons (latency compensation)
+#define LS_INPUT_SOURCE "ui"
 
 typedef struct {
   GtkApplication *app;
   GtkWindow *win;
 
-  GtkLabel *time_label;
-  GtkLabel *state_label;
-  GtkLabel *split_label;
+  LiveSpiffLayout *layout;
+  LayoutView *view;
+  LayoutModel model;         // mirror of the daemon, kept current by TimerEvent
 
   GtkButton *btn_settings;
   GtkButton *btn_splits;
   GtkButton *btn_hotkeys;
+  GtkButton *btn_history;
   GtkButton *btn_start_split;
   GtkButton *btn_pause;
   GtkButton *btn_reset;
+  GtkButton *btn_undo;
+  GtkButton *btn_skip;
 
-  GDBusProxy *proxy_ls;
+  LiveSpiffClient *client;    // timer mirror (liblivespiff-client)
   guint tick_id;
 
+  LiveSpiffWindowPicker *picker;
+
   // UI preferences
   gint refresh_ms;
 } Ui;
@@ -208,136 +221,129 @@ static gboolean write_run_json(const char *path, GPtrArray *splits, char **out_e
 
 /* ------------------------- D-Bus calls ------------------------- */
 
-static gboolean ls_call_i64(Ui *ui, const char *method, gint64 *out_val) {
-  if (!ui->proxy_ls) return FALSE;
-  GError *err = NULL;
-  GVariant *ret = g_dbus_proxy_call_sync(ui->proxy_ls, method, NULL,
-                                        G_DBUS_CALL_FLAGS_NONE, 200, NULL, &err);
-  if (!ret) { if (err) g_error_free(err); return FALSE; }
-  gint64 v = 0; g_variant_get(ret, "(x)", &v);
-  g_variant_unref(ret);
-  if (out_val) *out_val = v;
-  return TRUE;
-}
-
-static gboolean ls_call_i32(Ui *ui, const char *method, gint32 *out_val) {
-  if (!ui->proxy_ls) return FALSE;
-  GError *err = NULL;
-  GVariant *ret = g_dbus_proxy_call_sync(ui->proxy_ls, method, NULL,
-                                        G_DBUS_CALL_FLAGS_NONE, 200, NULL, &err);
-  if (!ret) { if (err) g_error_free(err); return FALSE; }
-  gint32 v = 0; g_variant_get(ret, "(i)", &v);
-  g_variant_unref(ret);
-  if (out_val) *out_val = v;
-  return TRUE;
-}
-
-static gboolean ls_call_str(Ui *ui, const char *method, char **out_str) {
-  if (!ui->proxy_ls) return FALSE;
-  GError *err = NULL;
-  GVariant *ret = g_dbus_proxy_call_sync(ui->proxy_ls, method, NULL,
-                                        G_DBUS_CALL_FLAGS_NONE, 200, NULL, &err);
-  if (!ret) { if (err) g_error_free(err); return FALSE; }
-  const char *s = NULL; g_variant_get(ret, "(&s)", &s);
-  if (out_str) *out_str = g_strdup(s ? s : "");
-  g_variant_unref(ret);
-  return TRUE;
+// The client's proxy in use (peer socket or bus), NULL while neither; it
+// changes with the transport, so it is looked up per call. Calls go through
+// the generated bindings and never wait on the reply.
+static LiveSpiffControl* ls_proxy(Ui *ui) {
+  return ui->client ? livespiff_client_get_proxy(ui->client) : NULL;
 }
 
-static void ls_call_void(Ui *ui, const char *method) {
-  if (!ui->proxy_ls) return;
-  GError *err = NULL;
-  GVariant *ret = g_dbus_proxy_call_sync(ui->proxy_ls, method, NULL,
-                                        G_DBUS_CALL_FLAGS_NONE, 200, NULL, &err);
-  if (ret) g_variant_unref(ret);
-  if (err) g_error_free(err);
+static void ls_watch_process(Ui *ui, const char *name) {
+  LiveSpiffControl *proxy = ls_proxy(ui);
+  if (proxy) live_spiff_control_call_watch_process(proxy, name ? name : "", NULL, NULL, NULL);
 }
 
-// LoadRun(path) -> (b ok, s message)
-static gboolean ls_call_load_run(Ui *ui, const char *path, char **out_msg) {
-  if (out_msg) *out_msg = NULL;
-  if (!ui->proxy_ls) {
-    if (out_msg) *out_msg = g_strdup("Daemon not connected");
-    return FALSE;
-  }
+/* ------------------------- daemon mirror ------------------------- */
 
-  GVariant *params = g_variant_new("(s)", path);
-  GError *err = NULL;
+#define SUM_OF_BEST_COMPARISON "Best Segments"
 
-  GVariant *ret = g_dbus_proxy_call_sync(
-    ui->proxy_ls, "LoadRun", params,
-    G_DBUS_CALL_FLAGS_NONE, 2000, NULL, &err
-  );
+typedef struct {
+  Ui *ui;
+  char *name;
+  gboolean sum_of_best; // for the sum of best rather than the active comparison
+} ComparisonRequest;
 
-  if (!ret) {
-    if (out_msg) *out_msg = g_strdup(err ? err->message : "LoadRun failed");
-    if (err) g_error_free(err);
-    return FALSE;
+static void on_comparison_times(GObject *source, GAsyncResult *res, gpointer user_data) {
+  ComparisonRequest *req = (ComparisonRequest*)user_data;
+  LayoutModel *m = &req->ui->model;
+  gboolean ok = FALSE;
+  GVariant *times = NULL;
+  if (!live_spiff_control_call_comparison_times_ms_finish(LIVE_SPIFF_CONTROL(source), &ok, &times, res, NULL)) {
+    ok = FALSE;
+  }
+  gsize n = 0;
+  const gint64 *v = ok ? g_variant_get_fixed_array(times, &n, sizeof(gint64)) : NULL;
+
+  if (req->sum_of_best) {
+    // Sum of best = last cumulative time of the "Best Segments" comparison
+    layout_model_set_sum_of_best(m, n ? v[n - 1] : LAYOUT_NO_TIME);
+  } else if (g_strcmp0(req->name, m->comparison) == 0) { // not switched again meanwhile
+    g_array_set_size(m->comparison_ms, 0);
+    g_array_append_vals(m->comparison_ms, v, (guint)n);
+    layout_model_touch(m, LAYOUT_DEP_SPLITS | LAYOUT_DEP_COMPARISON);
   }
 
-  gboolean ok = FALSE;
-  const char *msg = NULL;
-  g_variant_get(ret, "(bs)", &ok, &msg);
-  if (out_msg) *out_msg = g_strdup(msg ? msg : "");
-  g_variant_unref(ret);
-  return ok;
+  if (times) g_variant_unref(times);
+  g_free(req->name);
+  g_free(req);
 }
 
-/* ------------------------- time formatting ------------------------- */
-
-static char* format_time_ms(gint64 ms) {
-  if (ms < 0) ms = 0;
-  gint64 total_sec = ms / 1000;
-  gint64 milli = ms % 1000;
-  gint64 sec = total_sec % 60;
-  gint64 min = (total_sec / 60) % 60;
-  gint64 hour = total_sec / 3600;
-
-  return g_strdup_printf("%02lld:%02lld:%02lld.%03lld",
-                         (long long)hour,
-                         (long long)min,
-                         (long long)sec,
-                         (long long)milli);
+// ComparisonTimesMs(name) into the model; empty if the comparison is unknown
+static void fetch_comparison_times(Ui *ui, const char *name, gboolean sum_of_best) {
+  LiveSpiffControl *proxy = ls_proxy(ui);
+  if (!proxy || !name) {
+    if (sum_of_best) {
+      layout_model_set_sum_of_best(&ui->model, LAYOUT_NO_TIME);
+    } else {
+      g_array_set_size(ui->model.comparison_ms, 0);
+      layout_model_touch(&ui->model, LAYOUT_DEP_SPLITS | LAYOUT_DEP_COMPARISON);
+    }
+    return;
+  }
+  ComparisonRequest *req = g_new0(ComparisonRequest, 1);
+  req->ui = ui;
+  req->name = g_strdup(name);
+  req->sum_of_best = sum_of_best;
+  live_spiff_control_call_comparison_times_ms(proxy, name, NULL, on_comparison_times, req);
 }
 
-/* ------------------------- main tick ------------------------- */
+static void refresh_sum_of_best(Ui *ui) {
+  if (!(layout_view_deps(ui->view) & LAYOUT_DEP_SUM_OF_BEST)) return;
+  fetch_comparison_times(ui, SUM_OF_BEST_COMPARISON, TRUE);
+}
 
-static gboolean ui_tick(gpointer user_data) {
+// Copies what the client reports changed into the layout model
+static void on_client_changed(LiveSpiffClient *c, guint changes, gpointer user_data) {
   Ui *ui = (Ui*)user_data;
+  LayoutModel *m = &ui->model;
 
-  if (!ui->proxy_ls) {
-    gtk_label_set_text(ui->state_label, "Daemon not running");
-    gtk_label_set_text(ui->time_label, "--:--:--.---");
-    gtk_label_set_text(ui->split_label, "Split: - / -");
-    return G_SOURCE_CONTINUE;
+  layout_model_set_connected(m, livespiff_client_is_connected(c));
+  if (changes & LIVESPIFF_CLIENT_STATE) layout_model_set_state(m, livespiff_client_get_state(c));
+  if (changes & LIVESPIFF_CLIENT_POSITION) {
+    layout_model_set_position(m, livespiff_client_get_current_split(c), livespiff_client_get_split_count(c));
   }
-
-  gint64 ms = 0;
-  if (ls_call_i64(ui, "ElapsedMs", &ms)) {
-    char *t = format_time_ms(ms);
-    gtk_label_set_text(ui->time_label, t);
-    g_free(t);
-  } else {
-    gtk_label_set_text(ui->time_label, "--:--:--.---");
+  if (changes & LIVESPIFF_CLIENT_CLOCK) {
+    gint64 elapsed = 0, mono = 0;
+    livespiff_client_get_clock(c, &elapsed, &mono);
+    layout_model_set_clock(m, elapsed, mono);
+  }
+  // Names and icons only re-render the split list when they changed
+  if (changes & LIVESPIFF_CLIENT_SEGMENTS) {
+    layout_model_set_segments(m, livespiff_client_get_segments(c), livespiff_client_get_icons(c));
   }
+  if (changes & LIVESPIFF_CLIENT_SPLITS) {
+    const GArray *split = livespiff_client_get_split_ms(c);
+    const GArray *delta = livespiff_client_get_delta_ms(c);
+    g_array_set_size(m->split_ms, 0);
+    g_array_append_vals(m->split_ms, split->data, split->len);
+    g_array_set_size(m->delta_ms, 0);
+    g_array_append_vals(m->delta_ms, delta->data, delta->len);
+    layout_model_touch(m, LAYOUT_DEP_SPLITS);
+  }
+  if (changes & LIVESPIFF_CLIENT_COMPARISON) layout_model_set_comparison(m, livespiff_client_get_comparison(c));
 
-  char *state = NULL;
-  if (ls_call_str(ui, "State", &state)) {
-    gtk_label_set_text(ui->state_label, state);
-    g_free(state);
-  } else {
-    gtk_label_set_text(ui->state_label, "Unknown");
+  if (changes & (LIVESPIFF_CLIENT_CONNECTION | LIVESPIFF_CLIENT_SEGMENTS | LIVESPIFF_CLIENT_COMPARISON)) {
+    fetch_comparison_times(ui, m->comparison, FALSE);
+    refresh_sum_of_best(ui);
   }
+}
 
-  gint32 cur = 0, count = 0;
-  if (ls_call_i32(ui, "CurrentSplit", &cur) && ls_call_i32(ui, "SplitCount", &count)) {
-    char *s = g_strdup_printf("Split: %d / %d", (int)(cur + 1), (int)count);
-    gtk_label_set_text(ui->split_label, s);
-    g_free(s);
-  } else {
-    gtk_label_set_text(ui->split_label, "Split: - / -");
+static void on_client_timer_event(LiveSpiffClient *c, const char *event, gpointer user_data) {
+  (void)c;
+  // Best segments may have improved when the run ended, or reverted with an undone finish
+  if (g_strcmp0(event, "finish") == 0 || g_strcmp0(event, "reset") == 0 || g_strcmp0(event, "undo") == 0) {
+    refresh_sum_of_best((Ui*)user_data);
   }
+}
 
+/* ------------------------- main tick ------------------------- */
+
+// No D-Bus traffic here: the mirror is signal-driven, the tick only advances
+// the clock while running and renders whatever changed.
+static gboolean ui_tick(gpointer user_data) {
+  Ui *ui = (Ui*)user_data;
+  if (g_strcmp0(ui->model.state, "Running") == 0) layout_model_touch(&ui->model, LAYOUT_DEP_CLOCK);
+  layout_view_update(ui->view, &ui->model);
   return G_SOURCE_CONTINUE;
 }
 
@@ -349,9 +355,31 @@ static void restart_tick(Ui *ui) {
 
 /* ------------------------- buttons ------------------------- */
 
-static void on_start_split_clicked(GtkButton *btn, gpointer user_data) { (void)btn; ls_call_void((Ui*)user_data, "StartOrSplit"); }
-static void on_pause_clicked(GtkButton *btn, gpointer user_data) { (void)btn; ls_call_void((Ui*)user_data, "TogglePause"); }
-static void on_reset_clicked(GtkButton *btn, gpointer user_data) { (void)btn; ls_call_void((Ui*)user_data, "Reset"); }
+static void on_start_split_clicked(GtkButton *btn, gpointer user_data) {
+  (void)btn;
+  Ui *ui = (Ui*)user_data;
+  if (ui->client) livespiff_client_start_or_split(ui->client, LS_INPUT_SOURCE);
+}
+static void on_pause_clicked(GtkButton *btn, gpointer user_data) {
+  (void)btn;
+  Ui *ui = (Ui*)user_data;
+  if (ui->client) livespiff_client_toggle_pause(ui->client, LS_INPUT_SOURCE);
+}
+static void on_reset_clicked(GtkButton *btn, gpointer user_data) {
+  (void)btn;
+  Ui *ui = (Ui*)user_data;
+  if (ui->client) livespiff_client_reset(ui->client);
+}
+static void on_undo_clicked(GtkButton *btn, gpointer user_data) {
+  (void)btn;
+  Ui *ui = (Ui*)user_data;
+  if (ui->client) livespiff_client_undo_split(ui->client);
+}
+static void on_skip_clicked(GtkButton *btn, gpointer user_data) {
+  (void)btn;
+  Ui *ui = (Ui*)user_data;
+  if (ui->client) livespiff_client_skip_split(ui->client);
+}
 
 /* ------------------------- settings window ------------------------- */
 
@@ -359,6 +387,7 @@ typedef struct {
   Ui *ui;
   GtkWindow *dlg;
   GtkSpinButton *spin_refresh;
+  GtkLabel *game_label;
 } SettingsCtx;
 
 static void on_settings_destroy(GtkWidget *w, gpointer user_data) { (void)w; g_free(user_data); }
@@ -386,9 +415,16 @@ typedef struct {
   GtkWindow *dlg;
   GtkListBox *list;
   GtkLabel *status;
+  GCancellable *cancellable; // LoadRun in flight
 } SplitsCtx;
 
-static void on_splits_destroy(GtkWidget *w, gpointer user_data) { (void)w; g_free(user_data); }
+static void on_splits_destroy(GtkWidget *w, gpointer user_data) {
+  (void)w;
+  SplitsCtx *ctx = (SplitsCtx*)user_data;
+  g_cancellable_cancel(ctx->cancellable);
+  g_object_unref(ctx->cancellable);
+  g_free(ctx);
+}
 
 static GtkWidget* make_split_row(const char *name) {
   GtkWidget *row = gtk_list_box_row_new();
@@ -445,6 +481,24 @@ static GPtrArray* splits_from_list(GtkListBox *list) {
   return arr;
 }
 
+static void on_splits_loaded(GObject *source, GAsyncResult *res, gpointer user_data) {
+  gboolean ok = FALSE;
+  gchar *msg = NULL;
+  GError *err = NULL;
+  if (!live_spiff_control_call_load_run_finish(LIVE_SPIFF_CONTROL(source), &ok, &msg, res, &err)) {
+    // Cancelled: the window is gone, and user_data with it
+    if (!g_error_matches(err, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+      gtk_label_set_text(((SplitsCtx*)user_data)->status, err->message);
+    }
+    g_error_free(err);
+    return;
+  }
+  SplitsCtx *ctx = (SplitsCtx*)user_data;
+  if (ok) gtk_label_set_text(ctx->status, "Applied. Daemon loaded run file.");
+  else gtk_label_set_text(ctx->status, (msg && msg[0]) ? msg : "Applied, but daemon failed to load run.");
+  g_free(msg);
+}
+
 static void on_splits_apply_clicked(GtkButton *btn, gpointer user_data) {
   (void)btn;
   SplitsCtx *ctx = (SplitsCtx*)user_data;
@@ -463,13 +517,14 @@ static void on_splits_apply_clicked(GtkButton *btn, gpointer user_data) {
     return;
   }
 
-  char *msg = NULL;
-  gboolean ok = ls_call_load_run(ctx->ui, run_path, &msg);
-
-  if (ok) gtk_label_set_text(ctx->status, "Applied. Daemon loaded run file.");
-  else gtk_label_set_text(ctx->status, (msg && msg[0]) ? msg : "Applied, but daemon failed to load run.");
+  LiveSpiffControl *proxy = ls_proxy(ctx->ui);
+  if (proxy) {
+    gtk_label_set_text(ctx->status, "Saved. Loading into the daemon…");
+    live_spiff_control_call_load_run(proxy, run_path, ctx->cancellable, on_splits_loaded, ctx);
+  } else {
+    gtk_label_set_text(ctx->status, "Saved, but the daemon is not connected.");
+  }
 
-  g_free(msg);
   g_free(run_path);
   g_ptr_array_free(spl, TRUE);
 }
@@ -529,6 +584,7 @@ static void open_splits_editor(Ui *ui) {
   ctx->dlg = dlg;
   ctx->list = list;
   ctx->status = GTK_LABEL(status);
+  ctx->cancellable = g_cancellable_new();
 
   g_signal_connect(dlg, "destroy", G_CALLBACK(on_splits_destroy), ctx);
   g_signal_connect(btn_add, "clicked", G_CALLBACK(on_splits_add_clicked), ctx);
@@ -547,9 +603,54 @@ typedef struct {
   GtkEntry *e_pause;
   GtkEntry *e_reset;
   GtkLabel *status;
+  GtkLabel *backend;
+  guint refresh_id;          // status poll after a rebind
+  GCancellable *cancellable; // ShortcutsStatus in flight
 } HotkeysCtx;
 
-static void on_hotkeys_destroy(GtkWidget *w, gpointer user_data) { (void)w; g_free(user_data); }
+static void on_hotkeys_destroy(GtkWidget *w, gpointer user_data) {
+  (void)w;
+  HotkeysCtx *ctx = (HotkeysCtx*)user_data;
+  if (ctx->refresh_id) g_source_remove(ctx->refresh_id);
+  g_cancellable_cancel(ctx->cancellable);
+  g_object_unref(ctx->cancellable);
+  g_free(ctx);
+}
+
+// ShortcutsStatus -> (s backend, s status), formatted for display
+static void on_hotkeys_status(GObject *source, GAsyncResult *res, gpointer user_data) {
+  gchar *backend = NULL, *status = NULL;
+  GError *err = NULL;
+  char *msg = NULL;
+  if (live_spiff_control_call_shortcuts_status_finish(LIVE_SPIFF_CONTROL(source), &backend, &status, res, &err)) {
+    msg = g_strdup_printf("Global shortcuts (%s): %s", backend, status);
+  } else if (!g_error_matches(err, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+    msg = g_strdup_printf("Global shortcuts: %s", err->message);
+  }
+  // Cancelled only when the window is gone
+  if (msg) gtk_label_set_text(((HotkeysCtx*)user_data)->backend, msg);
+  g_clear_error(&err);
+  g_free(backend);
+  g_free(status);
+  g_free(msg);
+}
+
+static void hotkeys_show_backend(HotkeysCtx *ctx) {
+  LiveSpiffControl *proxy = ls_proxy(ctx->ui);
+  if (!proxy) {
+    gtk_label_set_text(ctx->backend, "Daemon not connected");
+    return;
+  }
+  live_spiff_control_call_shortcuts_status(proxy, ctx->cancellable, on_hotkeys_status, ctx);
+}
+
+// Registration is asynchronous (the portal may ask the user to confirm)
+static gboolean on_hotkeys_refresh(gpointer user_data) {
+  HotkeysCtx *ctx = (HotkeysCtx*)user_data;
+  ctx->refresh_id = 0;
+  hotkeys_show_backend(ctx);
+  return G_SOURCE_REMOVE;
+}
 
 static const char* cmd_start(void) { return "qdbus6 com.livespiff.LiveSpiff /com/livespiff/LiveSpiff com.livespiff.LiveSpiff.Control.StartOrSplit"; }
 static const char* cmd_pause(void) { return "qdbus6 com.livespiff.LiveSpiff /com/livespiff/LiveSpiff com.livespiff.LiveSpiff.Control.TogglePause"; }
@@ -564,7 +665,11 @@ static void on_hotkeys_save_clicked(GtkButton *btn, gpointer user_data) {
   const char *r = gtk_editable_get_text(GTK_EDITABLE(ctx->e_reset));
 
   hotkeys_save(s, p, r);
-  gtk_label_set_text(ctx->status, "Saved. Bind commands in KDE: System Settings → Shortcuts → Custom Shortcuts.");
+  LiveSpiffControl *proxy = ls_proxy(ctx->ui);
+  if (proxy) live_spiff_control_call_rebind_shortcuts(proxy, NULL, NULL, NULL);
+  gtk_label_set_text(ctx->status, "Saved and sent to the daemon. The desktop may ask to confirm the keys.");
+  if (ctx->refresh_id) g_source_remove(ctx->refresh_id);
+  ctx->refresh_id = g_timeout_add(1500, on_hotkeys_refresh, ctx);
 }
 
 static void open_hotkeys_window(Ui *ui) {
@@ -582,13 +687,20 @@ static void open_hotkeys_window(Ui *ui) {
   gtk_window_set_child(dlg, root);
 
   GtkWidget *hint = gtk_label_new(
-    "Wayland note: LiveSpiff does not grab global hotkeys directly.\n"
-    "Use KDE Global Shortcuts to run the commands below."
+    "The daemon registers Start / Split, Pause and Reset as global shortcuts with the desktop "
+    "(GlobalShortcuts portal, or KDE's KGlobalAccel). The keys below are requests: the desktop "
+    "has the final say, and they can be changed in System Settings → Shortcuts → LiveSpiff.\n"
+    "Without either service, bind the commands below as custom shortcuts instead."
   );
   gtk_label_set_wrap(GTK_LABEL(hint), TRUE);
   gtk_label_set_xalign(GTK_LABEL(hint), 0.0f);
   gtk_box_append(GTK_BOX(root), hint);
 
+  GtkWidget *backend = gtk_label_new("");
+  gtk_label_set_wrap(GTK_LABEL(backend), TRUE);
+  gtk_label_set_xalign(GTK_LABEL(backend), 0.0f);
+  gtk_box_append(GTK_BOX(root), backend);
+
   char *hs = NULL, *hp = NULL, *hr = NULL;
   hotkeys_load(&hs, &hp, &hr);
 
@@ -629,7 +741,7 @@ static void open_hotkeys_window(Ui *ui) {
 
   g_free(hs); g_free(hp); g_free(hr);
 
-  GtkWidget *btn_save = gtk_button_new_with_label("Save labels");
+  GtkWidget *btn_save = gtk_button_new_with_label("Save and register");
   gtk_box_append(GTK_BOX(root), btn_save);
 
   GtkWidget *status = gtk_label_new("");
@@ -644,6 +756,9 @@ static void open_hotkeys_window(Ui *ui) {
   ctx->e_pause = GTK_ENTRY(e_pause);
   ctx->e_reset = GTK_ENTRY(e_reset);
   ctx->status = GTK_LABEL(status);
+  ctx->backend = GTK_LABEL(backend);
+  ctx->cancellable = g_cancellable_new();
+  hotkeys_show_backend(ctx);
 
   g_signal_connect(dlg, "destroy", G_CALLBACK(on_hotkeys_destroy), ctx);
   g_signal_connect(btn_save, "clicked", G_CALLBACK(on_hotkeys_save_clicked), ctx);
@@ -651,6 +766,724 @@ static void open_hotkeys_window(Ui *ui) {
   gtk_window_present(dlg);
 }
 
+/* ------------------------- game window picker ------------------------- */
+
+static char* describe_game_window(const LiveSpiffUiSettings *s) {
+  if (!s->picked_classname || !s->picked_classname[0]) return g_strdup("Game window: none selected");
+  if (s->picked_pid > 0) {
+    return g_strdup_printf("Game window: %s — %s (pid %d)",
+                           s->picked_window_title ? s->picked_window_title : "",
+                           s->picked_classname, s->picked_pid);
+  }
+  return g_strdup_printf("Game window: %s — %s (not running)",
+                         s->picked_window_title ? s->picked_window_title : "",
+                         s->picked_classname);
+}
+
+static void store_picked_window(const LiveSpiffWindowInfo *w) {
+  LiveSpiffUiSettings s = ui_settings_load();
+  g_free(s.picked_window_id);
+  g_free(s.picked_classname);
+  g_free(s.picked_window_title);
+  s.picked_window_id = g_strdup(w->window_id);
+  s.picked_classname = g_strdup(w->classname);
+  s.picked_window_title = g_strdup(w->title);
+  s.picked_pid = w->pid;
+  ui_settings_save(&s);
+  ui_settings_free_fields(&s);
+}
+
+typedef struct {
+  Ui *ui;
+  GtkWindow *dlg;
+  GtkListBox *list;
+  GtkLabel *status;
+  GtkLabel *game_label;      // in the settings window (destroyed with it)
+  GPtrArray *windows;        // LiveSpiffWindowInfo*, row index -> window
+  guint pending;             // picker callbacks still outstanding
+  gboolean closed;
+} PickerCtx;
+
+static void picker_ctx_unref(PickerCtx *ctx) {
+  if (!ctx->closed || ctx->pending > 0) return;
+  g_ptr_array_free(ctx->windows, TRUE);
+  g_free(ctx);
+}
+
+static void on_picker_destroy(GtkWidget *w, gpointer user_data) {
+  (void)w;
+  PickerCtx *ctx = (PickerCtx*)user_data;
+  ctx->closed = TRUE;
+  picker_ctx_unref(ctx);
+}
+
+static void on_picker_windows(GPtrArray *windows, const GError *error, gpointer user_data) {
+  PickerCtx *ctx = (PickerCtx*)user_data;
+  ctx->pending--;
+  if (ctx->closed) { picker_ctx_unref(ctx); return; }
+
+  GtkWidget *child;
+  while ((child = gtk_widget_get_first_child(GTK_WIDGET(ctx->list))) != NULL) {
+    gtk_list_box_remove(ctx->list, child);
+  }
+  g_ptr_array_set_size(ctx->windows, 0);
+
+  if (!windows) {
+    char *msg = g_strdup_printf("kdotool failed: %s", error ? error->message : "unknown error");
+    gtk_label_set_text(ctx->status, msg);
+    g_free(msg);
+    return;
+  }
+
+  for (guint i = 0; i < windows->len; i++) {
+    const LiveSpiffWindowInfo *w = g_ptr_array_index(windows, i);
+    g_ptr_array_add(ctx->windows, window_info_copy(w));
+
+    char *text = g_strdup_printf("%s — %s (pid %d)", w->title ? w->title : "", w->classname ? w->classname : "", w->pid);
+    GtkWidget *label = gtk_label_new(text);
+    gtk_label_set_xalign(GTK_LABEL(label), 0.0f);
+    gtk_label_set_ellipsize(GTK_LABEL(label), PANGO_ELLIPSIZE_END);
+    gtk_list_box_append(ctx->list, label);
+    g_free(text);
+  }
+
+  gtk_label_set_text(ctx->status, windows->len ? "Double-click a window to pick it." : "No windows found.");
+}
+
+static void picker_refresh(PickerCtx *ctx, gboolean force) {
+  gtk_label_set_text(ctx->status, "Looking for windows...");
+  ctx->pending++;
+  window_picker_list_async(ctx->ui->picker, force, on_picker_windows, ctx);
+}
+
+static void on_picker_refresh_clicked(GtkButton *btn, gpointer user_data) {
+  (void)btn;
+  picker_refresh((PickerCtx*)user_data, TRUE);
+}
+
+static void on_picker_row_activated(GtkListBox *list, GtkListBoxRow *row, gpointer user_data) {
+  (void)list;
+  PickerCtx *ctx = (PickerCtx*)user_data;
+  int idx = gtk_list_box_row_get_index(row);
+  if (idx < 0 || (guint)idx >= ctx->windows->len) return;
+
+  const LiveSpiffWindowInfo *w = g_ptr_array_index(ctx->windows, idx);
+  store_picked_window(w);
+  ls_watch_process(ctx->ui, w->classname);
+
+  LiveSpiffUiSettings s = ui_settings_load();
+  char *desc = describe_game_window(&s);
+  gtk_label_set_text(ctx->game_label, desc);
+  g_free(desc);
+  ui_settings_free_fields(&s);
+
+  gtk_window_destroy(ctx->dlg);
+}
+
+static void open_window_picker(Ui *ui, GtkWindow *parent, GtkLabel *game_label) {
+  GtkWindow *dlg = GTK_WINDOW(gtk_window_new());
+  gtk_window_set_title(dlg, "Pick game window");
+  gtk_window_set_transient_for(dlg, parent);
+  gtk_window_set_destroy_with_parent(dlg, TRUE);
+  gtk_window_set_modal(dlg, TRUE);
+  gtk_window_set_default_size(dlg, 560, 400);
+
+  GtkWidget *root = gtk_box_new(GTK_ORIENTATION_VERTICAL, 10);
+  gtk_widget_set_margin_top(root, 12);
+  gtk_widget_set_margin_bottom(root, 12);
+  gtk_widget_set_margin_start(root, 12);
+  gtk_widget_set_margin_end(root, 12);
+  gtk_window_set_child(dlg, root);
+
+  GtkWidget *sc = gtk_scrolled_window_new();
+  gtk_widget_set_vexpand(sc, TRUE);
+  gtk_box_append(GTK_BOX(root), sc);
+
+  GtkListBox *list = GTK_LIST_BOX(gtk_list_box_new());
+  gtk_list_box_set_selection_mode(list, GTK_SELECTION_SINGLE);
+  gtk_list_box_set_activate_on_single_click(list, FALSE);
+  gtk_scrolled_window_set_child(GTK_SCROLLED_WINDOW(sc), GTK_WIDGET(list));
+
+  GtkWidget *btn_refresh = gtk_button_new_with_label("Refresh");
+  gtk_box_append(GTK_BOX(root), btn_refresh);
+
+  GtkWidget *status = gtk_label_new("");
+  gtk_label_set_wrap(GTK_LABEL(status), TRUE);
+  gtk_label_set_xalign(GTK_LABEL(status), 0.0f);
+  gtk_box_append(GTK_BOX(root), status);
+
+  PickerCtx *ctx = g_new0(PickerCtx, 1);
+  ctx->ui = ui;
+  ctx->dlg = dlg;
+  ctx->list = list;
+  ctx->status = GTK_LABEL(status);
+  ctx->game_label = game_label;
+  ctx->windows = g_ptr_array_new_with_free_func((GDestroyNotify)window_info_free);
+
+  g_signal_connect(dlg, "destroy", G_CALLBACK(on_picker_destroy), ctx);
+  g_signal_connect(btn_refresh, "clicked", G_CALLBACK(on_picker_refresh_clicked), ctx);
+  g_signal_connect(list, "row-activated", G_CALLBACK(on_picker_row_activated), ctx);
+
+  gtk_window_present(dlg);
+  picker_refresh(ctx, FALSE);
+}
+
+static void on_pick_window_clicked(GtkButton *btn, gpointer user_data) {
+  (void)btn;
+  SettingsCtx *ctx = (SettingsCtx*)user_data;
+  open_window_picker(ctx->ui, ctx->dlg, ctx->game_label);
+}
+
+// Background: map the saved class name to the window/pid running right now
+static void on_saved_window_resolved(GPtrArray *windows, const GError *error, gpointer user_data) {
+  Ui *ui = (Ui*)user_data;
+  if (error || !windows || windows->len == 0) return;
+
+  const LiveSpiffWindowInfo *w = g_ptr_array_index(windows, 0);
+  LiveSpiffUiSettings s = ui_settings_load();
+  gboolean changed = s.picked_pid != w->pid || g_strcmp0(s.picked_window_id, w->window_id) != 0;
+  ui_settings_free_fields(&s);
+
+  if (changed) {
+    store_picked_window(w);
+    ls_watch_process(ui, w->classname);
+  }
+}
+
+static void resolve_saved_window(Ui *ui) {
+  LiveSpiffUiSettings s = ui_settings_load();
+  if (s.picked_classname && s.picked_classname[0]) {
+    window_picker_resolve_async(ui->picker, s.picked_classname, on_saved_window_resolved, ui);
+  }
+  ui_settings_free_fields(&s);
+}
+
+/* ------------------------- latency calibration ------------------------- */
+
+typedef struct {
+  Ui *ui;
+  GtkWindow *dlg;
+  GtkDropDown *source;
+  GtkLabel *beat_label;
+  GtkLabel *status;
+  GtkLabel *offsets;
+  GtkButton *btn_tap;
+  gulong signal_id;
+  guint beat_id;
+  gboolean running;
+  gboolean lit;
+  gint64 first_beat_us;
+  gint64 interval_us;
+  guint beats;
+  guint next_beat;
+  GCancellable *cancellable; // calls in flight
+} CalibCtx;
+
+static const char *calib_sources[] = { LS_INPUT_SOURCE, "dbus" };
+static const char *calib_source_labels[] = { "This window (Tap button)", "KDE shortcut / qdbus6", NULL };
+
+static const char* calib_selected_source(CalibCtx *ctx) {
+  guint i = gtk_drop_down_get_selected(ctx->source);
+  return calib_sources[i < G_N_ELEMENTS(calib_sources) ? i : 0];
+}
+
+static void on_calib_offsets(GObject *source, GAsyncResult *res, gpointer user_data) {
+  GVariant *offsets = NULL;
+  // Fails as cancelled once the window is gone, before user_data is touched
+  if (!live_spiff_control_call_latency_offsets_finish(LIVE_SPIFF_CONTROL(source), &offsets, res, NULL)) return;
+  CalibCtx *ctx = (CalibCtx*)user_data;
+
+  GString *txt = g_string_new("Current offsets:");
+  GVariantIter it;
+  const char *name = NULL;
+  gint64 offset = 0, jitter = 0;
+  g_variant_iter_init(&it, offsets);
+  while (g_variant_iter_next(&it, "(&sxx)", &name, &offset, &jitter)) {
+    g_string_append_printf(txt, "\n  %s: %.1f ms (jitter %.1f ms)", name, offset / 1000.0, jitter / 1000.0);
+  }
+  if (g_str_equal(txt->str, "Current offsets:")) g_string_append(txt, " none");
+  gtk_label_set_text(ctx->offsets, txt->str);
+  g_string_free(txt, TRUE);
+  g_variant_unref(offsets);
+}
+
+static void calib_show_offsets(CalibCtx *ctx) {
+  LiveSpiffControl *proxy = ls_proxy(ctx->ui);
+  if (proxy) live_spiff_control_call_latency_offsets(proxy, ctx->cancellable, on_calib_offsets, ctx);
+}
+
+// Metronome drawn from the daemon's schedule (same monotonic clock), so the
+// flashes are not delayed by signal delivery
+static gboolean on_calib_beat(gpointer user_data) {
+  CalibCtx *ctx = (CalibCtx*)user_data;
+  ctx->beat_id = 0;
+  gint64 now = g_get_monotonic_time();
+  gint64 wake;
+
+  if (ctx->lit) {
+    gtk_label_set_markup(ctx->beat_label, "<span size='xx-large'>○</span>");
+    ctx->lit = FALSE;
+    if (ctx->next_beat >= ctx->beats) return G_SOURCE_REMOVE;
+    wake = ctx->first_beat_us + (gint64)ctx->next_beat * ctx->interval_us;
+  } else {
+    gtk_label_set_markup(ctx->beat_label, "<span size='xx-large' foreground='#e5a50a'>●</span>");
+    ctx->lit = TRUE;
+    char *txt = g_strdup_printf("Beat %u / %u", ctx->next_beat + 1, ctx->beats);
+    gtk_label_set_text(ctx->status, txt);
+    g_free(txt);
+    ctx->next_beat++;
+    wake = now + 120000;
+  }
+
+  ctx->beat_id = g_timeout_add((guint)MAX((wake - now) / 1000, 0), on_calib_beat, ctx);
+  return G_SOURCE_REMOVE;
+}
+
+static void on_calib_signal(LiveSpiffClient *client, const gchar *signal_name, GVariant *params,
+                            gpointer user_data) {
+  (void)client;
+  CalibCtx *ctx = (CalibCtx*)user_data;
+  if (g_strcmp0(signal_name, "CalibrationFinished") != 0) return;
+
+  const char *source = NULL;
+  gboolean ok = FALSE;
+  gint64 offset = 0, jitter = 0;
+  guint32 taps = 0;
+  g_variant_get(params, "(&sbxxu)", &source, &ok, &offset, &jitter, &taps);
+
+  char *txt = ok
+    ? g_strdup_printf("%s: %.1f ms late on average, jitter %.1f ms (%u taps). Saved.",
+                      source, offset / 1000.0, jitter / 1000.0, taps)
+    : g_strdup_printf("%s: not enough taps on the beat, nothing saved.", source);
+  gtk_label_set_text(ctx->status, txt);
+  g_free(txt);
+
+  ctx->running = FALSE;
+  calib_show_offsets(ctx);
+}
+
+static void on_calib_started(GObject *source, GAsyncResult *res, gpointer user_data) {
+  gboolean ok = FALSE;
+  gchar *msg = NULL;
+  gint64 first_beat_us = 0, interval_us = 0;
+  guint beats = 0;
+  GError *err = NULL;
+  if (!live_spiff_control_call_calibration_start_finish(LIVE_SPIFF_CONTROL(source), &ok, &msg, &first_beat_us,
+                                                         &interval_us, &beats, res, &err)) {
+    // Cancelled: the window is gone, and user_data with it
+    if (!g_error_matches(err, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+      gtk_label_set_text(((CalibCtx*)user_data)->status, err->message);
+    }
+    g_error_free(err);
+    return;
+  }
+
+  CalibCtx *ctx = (CalibCtx*)user_data;
+  gtk_label_set_text(ctx->status, msg);
+  if (ok) {
+    ctx->running = TRUE;
+    ctx->first_beat_us = first_beat_us;
+    ctx->interval_us = interval_us;
+    ctx->beats = beats;
+    ctx->next_beat = 0;
+    ctx->lit = FALSE;
+    if (ctx->beat_id) g_source_remove(ctx->beat_id);
+    gint64 wait = ctx->first_beat_us - g_get_monotonic_time();
+    ctx->beat_id = g_timeout_add((guint)MAX(wait / 1000, 0), on_calib_beat, ctx);
+  }
+  g_free(msg);
+}
+
+static void on_calib_start_clicked(GtkButton *btn, gpointer user_data) {
+  (void)btn;
+  CalibCtx *ctx = (CalibCtx*)user_data;
+  LiveSpiffControl *proxy = ls_proxy(ctx->ui);
+  if (!proxy) {
+    gtk_label_set_text(ctx->status, "Daemon not connected");
+    return;
+  }
+  live_spiff_control_call_calibration_start(proxy, calib_selected_source(ctx), 500u, 24u, ctx->cancellable,
+                                            on_calib_started, ctx);
+}
+
+static void on_calib_tap_clicked(GtkButton *btn, gpointer user_data) {
+  (void)btn;
+  CalibCtx *ctx = (CalibCtx*)user_data;
+  if (ctx->ui->client) livespiff_client_start_or_split(ctx->ui->client, LS_INPUT_SOURCE);
+}
+
+static void on_calib_source_changed(GObject *obj, GParamSpec *pspec, gpointer user_data) {
+  (void)obj; (void)pspec;
+  CalibCtx *ctx = (CalibCtx*)user_data;
+  gtk_widget_set_sensitive(GTK_WIDGET(ctx->btn_tap), g_str_equal(calib_selected_source(ctx), LS_INPUT_SOURCE));
+}
+
+static void on_calib_destroy(GtkWidget *w, gpointer user_data) {
+  (void)w;
+  CalibCtx *ctx = (CalibCtx*)user_data;
+  if (ctx->beat_id) g_source_remove(ctx->beat_id);
+  g_cancellable_cancel(ctx->cancellable);
+  g_object_unref(ctx->cancellable);
+  if (ctx->ui->client && ctx->signal_id) {
+    g_signal_handler_disconnect(ctx->ui->client, ctx->signal_id);
+    LiveSpiffControl *proxy = ls_proxy(ctx->ui);
+    if (ctx->running && proxy) live_spiff_control_call_calibration_cancel(proxy, NULL, NULL, NULL);
+  }
+  g_free(ctx);
+}
+
+static void open_calibration_window(Ui *ui, GtkWindow *parent) {
+  GtkWindow *dlg = GTK_WINDOW(gtk_window_new());
+  gtk_window_set_title(dlg, "Input latency calibration");
+  gtk_window_set_transient_for(dlg, parent);
+  gtk_window_set_modal(dlg, TRUE);
+  gtk_window_set_default_size(dlg, 460, 320);
+
+  GtkWidget *root = gtk_box_new(GTK_ORIENTATION_VERTICAL, 10);
+  gtk_widget_set_margin_top(root, 12);
+  gtk_widget_set_margin_bottom(root, 12);
+  gtk_widget_set_margin_start(root, 12);
+  gtk_widget_set_margin_end(root, 12);
+  gtk_window_set_child(dlg, root);
+
+  GtkWidget *note = gtk_label_new(
+    "Choose the input to calibrate, press Start, then press that input in time with the flashing dot.\n"
+    "The average delay is subtracted from every split made with that input."
+  );
+  gtk_label_set_wrap(GTK_LABEL(note), TRUE);
+  gtk_label_set_xalign(GTK_LABEL(note), 0.0f);
+  gtk_box_append(GTK_BOX(root), note);
+
+  GtkWidget *source = gtk_drop_down_new_from_strings(calib_source_labels);
+  gtk_box_append(GTK_BOX(root), source);
+
+  GtkWidget *beat = gtk_label_new(NULL);
+  gtk_label_set_markup(GTK_LABEL(beat), "<span size='xx-large'>○</span>");
+  gtk_box_append(GTK_BOX(root), beat);
+
+  GtkWidget *status = gtk_label_new("");
+  gtk_label_set_wrap(GTK_LABEL(status), TRUE);
+  gtk_box_append(GTK_BOX(root), status);
+
+  GtkWidget *row = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 8);
+  GtkWidget *btn_start = gtk_button_new_with_label("Start");
+  GtkWidget *btn_tap = gtk_button_new_with_label("Tap");
+  gtk_widget_set_hexpand(btn_tap, TRUE);
+  gtk_box_append(GTK_BOX(row), btn_start);
+  gtk_box_append(GTK_BOX(row), btn_tap);
+  gtk_box_append(GTK_BOX(root), row);
+
+  GtkWidget *offsets = gtk_label_new("");
+  gtk_label_set_xalign(GTK_LABEL(offsets), 0.0f);
+  gtk_box_append(GTK_BOX(root), offsets);
+
+  CalibCtx *ctx = g_new0(CalibCtx, 1);
+  ctx->ui = ui;
+  ctx->dlg = dlg;
+  ctx->source = GTK_DROP_DOWN(source);
+  ctx->beat_label = GTK_LABEL(beat);
+  ctx->status = GTK_LABEL(status);
+  ctx->offsets = GTK_LABEL(offsets);
+  ctx->btn_tap = GTK_BUTTON(btn_tap);
+  ctx->cancellable = g_cancellable_new();
+
+  if (ui->client) ctx->signal_id = g_signal_connect(ui->client, "signal", G_CALLBACK(on_calib_signal), ctx);
+  g_signal_connect(dlg, "destroy", G_CALLBACK(on_calib_destroy), ctx);
+  g_signal_connect(source, "notify::selected", G_CALLBACK(on_calib_source_changed), ctx);
+  g_signal_connect(btn_start, "clicked", G_CALLBACK(on_calib_start_clicked), ctx);
+  g_signal_connect(btn_tap, "clicked", G_CALLBACK(on_calib_tap_clicked), ctx);
+
+  calib_show_offsets(ctx);
+  gtk_window_present(dlg);
+}
+
+static void on_calibrate_clicked(GtkButton *btn, gpointer user_data) {
+  (void)btn;
+  SettingsCtx *ctx = (SettingsCtx*)user_data;
+  open_calibration_window(ctx->ui, ctx->dlg);
+}
+
+/* ------------------------- attempt history ------------------------- */
+
+typedef struct {
+  Ui *ui;
+  GtkWindow *dlg;
+  GtkDropDown *sort;
+  GtkDropDown *filter;
+  GtkLabel *status;
+  LiveSpiffHistoryModel *model;
+  gulong signal_id;
+  GCancellable *cancellable; // AttemptSplits in flight
+} HistoryCtx;
+
+static const char *history_sorts[] = { "newest", "oldest", "fastest", "slowest" };
+static const char *history_sort_labels[] = { "Newest first", "Oldest first", "Fastest", "Slowest", NULL };
+static const char *history_filters[] = { "all", "finished", "reset", "pb" };
+static const char *history_filter_labels[] = { "All attempts", "Finished", "Reset", "PBs", NULL };
+
+static char* format_time_ms(gint64 ms) {
+  if (ms == G_MININT64) return g_strdup("-");
+  if (ms < 0) ms = 0;
+  gint64 total_sec = ms / 1000;
+  return g_strdup_printf("%02lld:%02lld:%02lld.%03lld",
+                         (long long)(total_sec / 3600),
+                         (long long)((total_sec / 60) % 60),
+                         (long long)(total_sec % 60),
+                         (long long)(ms % 1000));
+}
+
+static void history_show_status(HistoryCtx *ctx) {
+  const char *err = livespiff_history_model_get_error(ctx->model);
+  if (err) {
+    gtk_label_set_text(ctx->status, err);
+    return;
+  }
+  char *s = g_strdup_printf("%u attempts", g_list_model_get_n_items(G_LIST_MODEL(ctx->model)));
+  gtk_label_set_text(ctx->status, s);
+  g_free(s);
+}
+
+static void on_history_items_changed(GListModel *list, guint position, guint removed, guint added, gpointer user_data) {
+  (void)list; (void)position;
+  if (removed != added) history_show_status((HistoryCtx*)user_data);
+}
+
+static void on_history_query_changed(GObject *obj, GParamSpec *pspec, gpointer user_data) {
+  (void)obj; (void)pspec;
+  HistoryCtx *ctx = (HistoryCtx*)user_data;
+  guint s = gtk_drop_down_get_selected(ctx->sort), f = gtk_drop_down_get_selected(ctx->filter);
+  livespiff_history_model_set_query(ctx->model,
+                                    history_sorts[s < G_N_ELEMENTS(history_sorts) ? s : 0],
+                                    history_filters[f < G_N_ELEMENTS(history_filters) ? f : 0]);
+}
+
+// New attempts land in the history on finish and reset, an undone finish takes one
+// out again; load switches runs
+static void on_history_signal(LiveSpiffClient *client, const gchar *signal_name, GVariant *params,
+                              gpointer user_data) {
+  (void)client;
+  if (g_strcmp0(signal_name, "TimerEvent") != 0) return;
+  const char *event = NULL;
+  g_variant_get(params, "(&s&siiixxxx)", &event, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+  if (g_strcmp0(event, "finish") == 0 || g_strcmp0(event, "reset") == 0 || g_strcmp0(event, "load") == 0 ||
+      g_strcmp0(event, "undo") == 0) {
+    livespiff_history_model_refresh(((HistoryCtx*)user_data)->model);
+  }
+}
+
+static void on_history_setup(GtkSignalListItemFactory *f, GtkListItem *item, gpointer user_data) {
+  (void)f; (void)user_data;
+  GtkWidget *row = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 12);
+  const float xalign[] = { 0.0f, 1.0f, 0.0f, 0.5f };
+  for (guint i = 0; i < G_N_ELEMENTS(xalign); i++) {
+    GtkWidget *l = gtk_label_new("");
+    gtk_label_set_xalign(GTK_LABEL(l), xalign[i]);
+    if (i == 2) gtk_widget_set_hexpand(l, TRUE);
+    gtk_label_set_ellipsize(GTK_LABEL(l), PANGO_ELLIPSIZE_END);
+    gtk_box_append(GTK_BOX(row), l);
+  }
+  gtk_list_item_set_child(item, row);
+}
+
+static void on_history_bind(GtkSignalListItemFactory *f, GtkListItem *item, gpointer user_data) {
+  (void)f;
+  Ui *ui = (Ui*)user_data;
+  const LiveSpiffAttemptRow *row = livespiff_attempt_item_get_row(LIVESPIFF_ATTEMPT_ITEM(gtk_list_item_get_item(item)));
+  GtkWidget *date = gtk_widget_get_first_child(gtk_list_item_get_child(item));
+  GtkWidget *time = gtk_widget_get_next_sibling(date);
+  GtkWidget *result = gtk_widget_get_next_sibling(time);
+  GtkWidget *pb = gtk_widget_get_next_sibling(result);
+
+  if (!row->loaded) {
+    gtk_label_set_text(GTK_LABEL(date), "…");
+    gtk_label_set_text(GTK_LABEL(time), "");
+    gtk_label_set_text(GTK_LABEL(result), "");
+    gtk_label_set_text(GTK_LABEL(pb), "");
+    return;
+  }
+
+  GDateTime *dt = g_date_time_new_from_unix_local(row->started_at_us / G_USEC_PER_SEC);
+  char *ds = dt ? g_date_time_format(dt, "%Y-%m-%d %H:%M") : g_strdup("?");
+  char *ts = format_time_ms(row->time_ms);
+  char *rs = NULL;
+  if (row->finished) {
+    rs = g_strdup("Finished");
+  } else if (row->splits_reached < ui->model.segments->len) {
+    char *seg = split_name_display(g_ptr_array_index(ui->model.segments, row->splits_reached));
+    rs = g_strdup_printf("Reset in %s", seg);
+    g_free(seg);
+  } else {
+    rs = g_strdup_printf("Reset after split %u", row->splits_reached);
+  }
+
+  gtk_label_set_text(GTK_LABEL(date), ds);
+  gtk_label_set_text(GTK_LABEL(time), ts);
+  gtk_label_set_text(GTK_LABEL(result), rs);
+  gtk_label_set_text(GTK_LABEL(pb), row->pb ? "PB" : "");
+  if (dt) g_date_time_unref(dt);
+  g_free(ds);
+  g_free(ts);
+  g_free(rs);
+}
+
+static void on_attempt_splits(GObject *source, GAsyncResult *res, gpointer user_data) {
+  gboolean ok = FALSE;
+  GVariant *splits = NULL;
+  GError *err = NULL;
+  if (!live_spiff_control_call_attempt_splits_finish(LIVE_SPIFF_CONTROL(source), &ok, &splits, res, &err)) {
+    // Cancelled: the history window is gone, and user_data with it
+    if (!g_error_matches(err, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+      gtk_label_set_text(((HistoryCtx*)user_data)->status, err->message);
+    }
+    g_error_free(err);
+    return;
+  }
+  HistoryCtx *ctx = (HistoryCtx*)user_data;
+  if (!ok) {
+    gtk_label_set_text(ctx->status, "Attempt not found (history changed?)");
+    g_variant_unref(splits);
+    return;
+  }
+
+  GtkWindow *dlg = GTK_WINDOW(gtk_window_new());
+  gtk_window_set_title(dlg, "Attempt");
+  gtk_window_set_transient_for(dlg, ctx->dlg);
+  gtk_window_set_default_size(dlg, 420, 360);
+
+  GtkWidget *sc = gtk_scrolled_window_new();
+  gtk_window_set_child(dlg, sc);
+
+  GtkGrid *grid = GTK_GRID(gtk_grid_new());
+  gtk_grid_set_column_spacing(grid, 16);
+  gtk_grid_set_row_spacing(grid, 4);
+  gtk_widget_set_margin_top(GTK_WIDGET(grid), 12);
+  gtk_widget_set_margin_bottom(GTK_WIDGET(grid), 12);
+  gtk_widget_set_margin_start(GTK_WIDGET(grid), 12);
+  gtk_widget_set_margin_end(GTK_WIDGET(grid), 12);
+  gtk_scrolled_window_set_child(GTK_SCROLLED_WINDOW(sc), GTK_WIDGET(grid));
+
+  const char *headers[] = { "Segment", "Split", "Segment time" };
+  for (int c = 0; c < 3; c++) {
+    GtkWidget *h = gtk_label_new(headers[c]);
+    gtk_widget_add_css_class(h, "dim");
+    gtk_label_set_xalign(GTK_LABEL(h), c ? 1.0f : 0.0f);
+    gtk_grid_attach(grid, h, c, 0, 1, 1);
+  }
+
+  GVariantIter it;
+  const char *name = NULL;
+  gint64 split = 0, segment = 0;
+  int r = 1;
+  g_variant_iter_init(&it, splits);
+  while (g_variant_iter_next(&it, "(&sxx)", &name, &split, &segment)) {
+    char *ss = format_time_ms(split), *gs = format_time_ms(segment), *ns = split_name_display(name);
+    GtkWidget *cells[] = { gtk_label_new(ns), gtk_label_new(ss), gtk_label_new(gs) };
+    for (int c = 0; c < 3; c++) {
+      gtk_label_set_xalign(GTK_LABEL(cells[c]), c ? 1.0f : 0.0f);
+      gtk_grid_attach(grid, cells[c], c, r, 1, 1);
+    }
+    g_free(ss);
+    g_free(gs);
+    g_free(ns);
+    r++;
+  }
+  g_variant_unref(splits);
+
+  gtk_window_present(dlg);
+}
+
+static void open_attempt_window(HistoryCtx *ctx, const LiveSpiffAttemptRow *row) {
+  LiveSpiffControl *proxy = ls_proxy(ctx->ui);
+  if (!proxy) {
+    gtk_label_set_text(ctx->status, "Daemon not connected");
+    return;
+  }
+  live_spiff_control_call_attempt_splits(proxy, row->id, ctx->cancellable, on_attempt_splits, ctx);
+}
+
+static void on_history_activate(GtkListView *view, guint position, gpointer user_data) {
+  HistoryCtx *ctx = (HistoryCtx*)user_data;
+  LiveSpiffAttemptItem *item = g_list_model_get_item(G_LIST_MODEL(ctx->model), position);
+  (void)view;
+  if (!item) return;
+  const LiveSpiffAttemptRow *row = livespiff_attempt_item_get_row(item);
+  if (row->loaded) open_attempt_window(ctx, row);
+  g_object_unref(item);
+}
+
+static void on_history_destroy(GtkWidget *w, gpointer user_data) {
+  (void)w;
+  HistoryCtx *ctx = (HistoryCtx*)user_data;
+  g_cancellable_cancel(ctx->cancellable);
+  g_object_unref(ctx->cancellable);
+  if (ctx->ui->client && ctx->signal_id) g_signal_handler_disconnect(ctx->ui->client, ctx->signal_id);
+  g_signal_handlers_disconnect_by_data(ctx->model, ctx);
+  g_object_unref(ctx->model);
+  g_free(ctx);
+}
+
+static void open_history_window(Ui *ui) {
+  GtkWindow *dlg = GTK_WINDOW(gtk_window_new());
+  gtk_window_set_title(dlg, "History");
+  gtk_window_set_transient_for(dlg, ui->win);
+  gtk_window_set_default_size(dlg, 600, 520);
+
+  GtkWidget *root = gtk_box_new(GTK_ORIENTATION_VERTICAL, 10);
+  gtk_widget_set_margin_top(root, 12);
+  gtk_widget_set_margin_bottom(root, 12);
+  gtk_widget_set_margin_start(root, 12);
+  gtk_widget_set_margin_end(root, 12);
+  gtk_window_set_child(dlg, root);
+
+  GtkWidget *bar = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 8);
+  GtkWidget *sort = gtk_drop_down_new_from_strings(history_sort_labels);
+  GtkWidget *filter = gtk_drop_down_new_from_strings(history_filter_labels);
+  GtkWidget *status = gtk_label_new("Loading…");
+  gtk_widget_set_hexpand(status, TRUE);
+  gtk_label_set_xalign(GTK_LABEL(status), 1.0f);
+  gtk_box_append(GTK_BOX(bar), sort);
+  gtk_box_append(GTK_BOX(bar), filter);
+  gtk_box_append(GTK_BOX(bar), status);
+  gtk_box_append(GTK_BOX(root), bar);
+
+  HistoryCtx *ctx = g_new0(HistoryCtx, 1);
+  ctx->ui = ui;
+  ctx->dlg = dlg;
+  ctx->sort = GTK_DROP_DOWN(sort);
+  ctx->filter = GTK_DROP_DOWN(filter);
+  ctx->status = GTK_LABEL(status);
+  ctx->model = livespiff_history_model_new(G_DBUS_PROXY(ls_proxy(ui)));
+  ctx->cancellable = g_cancellable_new();
+
+  // The view only asks the model for the rows on screen, so opening is
+  // instant whatever the history size
+  GtkListItemFactory *factory = gtk_signal_list_item_factory_new();
+  g_signal_connect(factory, "setup", G_CALLBACK(on_history_setup), ui);
+  g_signal_connect(factory, "bind", G_CALLBACK(on_history_bind), ui);
+  GtkSingleSelection *sel = gtk_single_selection_new(G_LIST_MODEL(g_object_ref(ctx->model)));
+  GtkWidget *view = gtk_list_view_new(GTK_SELECTION_MODEL(sel), factory);
+
+  GtkWidget *sc = gtk_scrolled_window_new();
+  gtk_widget_set_vexpand(sc, TRUE);
+  gtk_scrolled_window_set_child(GTK_SCROLLED_WINDOW(sc), view);
+  gtk_box_append(GTK_BOX(root), sc);
+
+  GtkWidget *hint = gtk_label_new("Double-click an attempt to see its splits.");
+  gtk_widget_add_css_class(hint, "dim");
+  gtk_label_set_xalign(GTK_LABEL(hint), 0.0f);
+  gtk_box_append(GTK_BOX(root), hint);
+
+  if (ui->client) ctx->signal_id = g_signal_connect(ui->client, "signal", G_CALLBACK(on_history_signal), ctx);
+  g_signal_connect(ctx->model, "items-changed", G_CALLBACK(on_history_items_changed), ctx);
+  g_signal_connect(dlg, "destroy", G_CALLBACK(on_history_destroy), ctx);
+  g_signal_connect(sort, "notify::selected", G_CALLBACK(on_history_query_changed), ctx);
+  g_signal_connect(filter, "notify::selected", G_CALLBACK(on_history_query_changed), ctx);
+  g_signal_connect(view, "activate", G_CALLBACK(on_history_activate), ctx);
+
+  history_show_status(ctx);
+  gtk_window_present(dlg);
+}
+
 /* ------------------------- settings window UI ------------------------- */
 
 static void open_settings_window(Ui *ui) {
@@ -683,13 +1516,31 @@ static void open_settings_window(Ui *ui) {
   gtk_spin_button_set_value(GTK_SPIN_BUTTON(spin), ui->refresh_ms);
   gtk_box_append(GTK_BOX(root), spin);
 
+  LiveSpiffUiSettings gs = ui_settings_load();
+  char *game_desc = describe_game_window(&gs);
+  GtkWidget *game_label = gtk_label_new(game_desc);
+  gtk_label_set_wrap(GTK_LABEL(game_label), TRUE);
+  gtk_label_set_xalign(GTK_LABEL(game_label), 0.0f);
+  gtk_box_append(GTK_BOX(root), game_label);
+  g_free(game_desc);
+  ui_settings_free_fields(&gs);
+
+  GtkWidget *btn_pick = gtk_button_new_with_label("Pick game window...");
+  gtk_box_append(GTK_BOX(root), btn_pick);
+
+  GtkWidget *btn_calibrate = gtk_button_new_with_label("Calibrate input latency...");
+  gtk_box_append(GTK_BOX(root), btn_calibrate);
+
   SettingsCtx *ctx = g_new0(SettingsCtx, 1);
   ctx->ui = ui;
   ctx->dlg = dlg;
   ctx->spin_refresh = GTK_SPIN_BUTTON(spin);
+  ctx->game_label = GTK_LABEL(game_label);
 
   g_signal_connect(dlg, "destroy", G_CALLBACK(on_settings_destroy), ctx);
   g_signal_connect(spin, "value-changed", G_CALLBACK(on_refresh_changed), ctx);
+  g_signal_connect(btn_pick, "clicked", G_CALLBACK(on_pick_window_clicked), ctx);
+  g_signal_connect(btn_calibrate, "clicked", G_CALLBACK(on_calibrate_clicked), ctx);
 
   gtk_window_present(dlg);
 }
@@ -699,6 +1550,7 @@ static void open_settings_window(Ui *ui) {
 static void on_settings_clicked(GtkButton *btn, gpointer user_data) { (void)btn; open_settings_window((Ui*)user_data); }
 static void on_splits_clicked(GtkButton *btn, gpointer user_data) { (void)btn; open_splits_editor((Ui*)user_data); }
 static void on_hotkeys_clicked(GtkButton *btn, gpointer user_data) { (void)btn; open_hotkeys_window((Ui*)user_data); }
+static void on_history_clicked(GtkButton *btn, gpointer user_data) { (void)btn; open_history_window((Ui*)user_data); }
 
 static void ui_build(Ui *ui) {
   ui->win = GTK_WINDOW(gtk_application_window_new(ui->app));
@@ -711,6 +1563,11 @@ static void ui_build(Ui *ui) {
     gtk_css_provider_load_from_string(css,
       "label.time { font-size: 52px; font-weight: 700; }"
       "label.meta { font-size: 16px; opacity: 0.85; }"
+      ".dim { opacity: 0.55; }"
+      ".current { font-weight: 700; }"
+      ".section { opacity: 0.85; }"
+      ".ahead { color: #3ccf6e; }"
+      ".behind { color: #e0524a; }"
     );
     gtk_style_context_add_provider_for_display(
       disp, GTK_STYLE_PROVIDER(css), GTK_STYLE_PROVIDER_PRIORITY_APPLICATION
@@ -725,23 +1582,17 @@ static void ui_build(Ui *ui) {
   gtk_widget_set_margin_end(root, 16);
   gtk_window_set_child(ui->win, root);
 
-  ui->time_label = GTK_LABEL(gtk_label_new("--:--:--.---"));
-  gtk_widget_add_css_class(GTK_WIDGET(ui->time_label), "time");
-  gtk_widget_set_halign(GTK_WIDGET(ui->time_label), GTK_ALIGN_CENTER);
-  gtk_box_append(GTK_BOX(root), GTK_WIDGET(ui->time_label));
-
-  GtkWidget *meta = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 12);
-  gtk_widget_set_halign(meta, GTK_ALIGN_CENTER);
-
-  ui->state_label = GTK_LABEL(gtk_label_new("Connecting..."));
-  gtk_widget_add_css_class(GTK_WIDGET(ui->state_label), "meta");
+  char *layout_file = layout_path();
+  char *warnings = NULL;
+  ui->layout = layout_load(layout_file, &warnings);
+  if (warnings) g_printerr("%s\n", warnings);
+  g_free(warnings);
+  g_free(layout_file);
 
-  ui->split_label = GTK_LABEL(gtk_label_new("Split: - / -"));
-  gtk_widget_add_css_class(GTK_WIDGET(ui->split_label), "meta");
-
-  gtk_box_append(GTK_BOX(meta), GTK_WIDGET(ui->state_label));
-  gtk_box_append(GTK_BOX(meta), GTK_WIDGET(ui->split_label));
-  gtk_box_append(GTK_BOX(root), meta);
+  layout_model_init(&ui->model);
+  ui->view = layout_view_new(ui->layout);
+  gtk_widget_set_vexpand(layout_view_widget(ui->view), TRUE);
+  gtk_box_append(GTK_BOX(root), layout_view_widget(ui->view));
 
   GtkWidget *tools = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 8);
   gtk_widget_set_halign(tools, GTK_ALIGN_CENTER);
@@ -750,14 +1601,17 @@ static void ui_build(Ui *ui) {
   ui->btn_settings = GTK_BUTTON(gtk_button_new_with_label("Settings"));
   ui->btn_splits   = GTK_BUTTON(gtk_button_new_with_label("Splits"));
   ui->btn_hotkeys  = GTK_BUTTON(gtk_button_new_with_label("Hotkeys"));
+  ui->btn_history  = GTK_BUTTON(gtk_button_new_with_label("History"));
 
   gtk_box_append(GTK_BOX(tools), GTK_WIDGET(ui->btn_settings));
   gtk_box_append(GTK_BOX(tools), GTK_WIDGET(ui->btn_splits));
   gtk_box_append(GTK_BOX(tools), GTK_WIDGET(ui->btn_hotkeys));
+  gtk_box_append(GTK_BOX(tools), GTK_WIDGET(ui->btn_history));
 
   g_signal_connect(ui->btn_settings, "clicked", G_CALLBACK(on_settings_clicked), ui);
   g_signal_connect(ui->btn_splits,   "clicked", G_CALLBACK(on_splits_clicked), ui);
   g_signal_connect(ui->btn_hotkeys,  "clicked", G_CALLBACK(on_hotkeys_clicked), ui);
+  g_signal_connect(ui->btn_history,  "clicked", G_CALLBACK(on_history_clicked), ui);
 
   GtkWidget *row = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 10);
   gtk_widget_set_halign(row, GTK_ALIGN_CENTER);
@@ -766,14 +1620,20 @@ static void ui_build(Ui *ui) {
   ui->btn_start_split = GTK_BUTTON(gtk_button_new_with_label("Start / Split"));
   ui->btn_pause       = GTK_BUTTON(gtk_button_new_with_label("Pause / Resume"));
   ui->btn_reset       = GTK_BUTTON(gtk_button_new_with_label("Reset"));
+  ui->btn_undo        = GTK_BUTTON(gtk_button_new_with_label("Undo Split"));
+  ui->btn_skip        = GTK_BUTTON(gtk_button_new_with_label("Skip Split"));
 
   gtk_box_append(GTK_BOX(row), GTK_WIDGET(ui->btn_start_split));
   gtk_box_append(GTK_BOX(row), GTK_WIDGET(ui->btn_pause));
   gtk_box_append(GTK_BOX(row), GTK_WIDGET(ui->btn_reset));
+  gtk_box_append(GTK_BOX(row), GTK_WIDGET(ui->btn_undo));
+  gtk_box_append(GTK_BOX(row), GTK_WIDGET(ui->btn_skip));
 
   g_signal_connect(ui->btn_start_split, "clicked", G_CALLBACK(on_start_split_clicked), ui);
   g_signal_connect(ui->btn_pause,       "clicked", G_CALLBACK(on_pause_clicked), ui);
   g_signal_connect(ui->btn_reset,       "clicked", G_CALLBACK(on_reset_clicked), ui);
+  g_signal_connect(ui->btn_undo,        "clicked", G_CALLBACK(on_undo_clicked), ui);
+  g_signal_connect(ui->btn_skip,        "clicked", G_CALLBACK(on_skip_clicked), ui);
 }
 
 /* ------------------------- activate ------------------------- */
@@ -796,20 +1656,13 @@ static void on_activate(GtkApplication *app, gpointer user_data) {
   ui_build(ui);
 
   GError *err = NULL;
-  ui->proxy_ls = g_dbus_proxy_new_for_bus_sync(
-    G_BUS_TYPE_SESSION,
-    G_DBUS_PROXY_FLAGS_NONE,
-    NULL,
-    LS_BUS_NAME,
-    LS_OBJ_PATH,
-    LS_IFACE_NAME,
-    NULL,
-    &err
-  );
-
-  if (!ui->proxy_ls) {
-    gtk_label_set_text(ui->state_label, "Daemon not running");
+  ui->client = livespiff_client_new(&err);
+  if (!ui->client) {
     if (err) g_error_free(err);
+  } else {
+    g_signal_connect(ui->client, "changed", G_CALLBACK(on_client_changed), ui);
+    g_signal_connect(ui->client, "timer-event", G_CALLBACK(on_client_timer_event), ui);
+    on_client_changed(ui->client, G_MAXUINT, ui);
   }
 
   // ensure daemon has a run file
@@ -817,16 +1670,18 @@ static void on_activate(GtkApplication *app, gpointer user_data) {
     GPtrArray *spl = splits_load();
     char *run_path = livespiff_default_run_path();
     char *werr = NULL;
-    if (write_run_json(run_path, spl, &werr)) {
-      char *msg = NULL;
-      ls_call_load_run(ui, run_path, &msg);
-      g_free(msg);
+    LiveSpiffControl *proxy = ls_proxy(ui);
+    if (write_run_json(run_path, spl, &werr) && proxy) {
+      live_spiff_control_call_load_run(proxy, run_path, NULL, NULL, NULL);
     }
     g_free(werr);
     g_free(run_path);
     g_ptr_array_free(spl, TRUE);
   }
 
+  ui->picker = window_picker_new();
+  resolve_saved_window(ui);
+
   restart_tick(ui);
   gtk_window_present(ui->win);
 }
@@ -842,7 +1697,11 @@ int main(int argc, char **argv) {
   int status = g_application_run(G_APPLICATION(app), argc, argv);
 
   if (ui.tick_id) g_source_remove(ui.tick_id);
-  if (ui.proxy_ls) g_object_unref(ui.proxy_ls);
+  if (ui.client) g_object_unref(ui.client);
+  layout_view_free(ui.view);
+  layout_free(ui.layout);
+  if (ui.view) layout_model_clear(&ui.model);
+  window_picker_free(ui.picker);
   g_object_unref(app);
 
   return status;
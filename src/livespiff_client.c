@@ -0,0 +1,430 @@
+#include "livespiff_client.h"
+
+#define CALL_TIMEOUT_MS 2000 // nothing here waits on a reply; LoadRun reads the history
+#define PEER_RETRY_MS   1000  // without a session bus there is no name owner to wait for
+
+struct _LiveSpiffClient {
+  GObject parent_instance;
+  LiveSpiffControl *bus_proxy;  // NULL without a session bus
+  LiveSpiffControl *peer_proxy; // on the daemon's private socket, NULL if not connected
+  LiveSpiffControl *proxy;      // the one in use: peer_proxy if set, else bus_proxy
+  guint retry_id;
+
+  gboolean connected;
+  char *state;
+  gint current_split;
+  gint split_count;
+  gint64 elapsed_ms;           // at mono_us
+  gint64 mono_us;
+  GPtrArray *segments;         // char*
+  GPtrArray *icons;            // char*
+  GArray *split_ms;            // gint64
+  GArray *delta_ms;            // gint64, vs comparison
+  char *comparison;
+};
+
+enum {
+  SIGNAL_CHANGED,
+  SIGNAL_TIMER_EVENT,
+  SIGNAL_SIGNAL,
+  N_SIGNALS
+};
+static guint client_signals[N_SIGNALS];
+
+G_DEFINE_TYPE(LiveSpiffClient, livespiff_client, G_TYPE_OBJECT)
+
+static void set_string(char **dst, const char *src, guint *changes, guint flag) {
+  if (g_strcmp0(*dst, src) == 0) return;
+  g_free(*dst);
+  *dst = g_strdup(src);
+  *changes |= flag;
+}
+
+static void set_array_at(GArray *a, gint i, gint64 v) {
+  if (i < 0) return;
+  gint64 none = LIVESPIFF_NO_TIME_MS;
+  while (a->len <= (guint)i) g_array_append_val(a, none);
+  g_array_index(a, gint64, i) = v;
+}
+
+static void strv_into(GPtrArray *dst, gchar **src) {
+  g_ptr_array_set_size(dst, 0);
+  for (gchar **p = src; p && *p; p++) g_ptr_array_add(dst, g_strdup(*p));
+}
+
+static void times_into(GArray *dst, GVariant *ax) {
+  g_array_set_size(dst, 0);
+  if (!ax) return;
+  gsize n = 0;
+  const gint64 *v = g_variant_get_fixed_array(ax, &n, sizeof(gint64));
+  g_array_append_vals(dst, v, (guint)n);
+}
+
+static void emit_changed(LiveSpiffClient *c, guint changes) {
+  if (changes) g_signal_emit(c, client_signals[SIGNAL_CHANGED], 0, changes);
+}
+
+/* ------------------------- mirror ------------------------- */
+
+// Replies of a full fetch; each updates its part of the mirror as it lands.
+// Replies to the proxy in use arrive in order with its signals, so a
+// TimerEvent received meanwhile is not overwritten by older data. Replies
+// from a proxy the client has since dropped are ignored.
+static gboolean resync_current(GObject *source, LiveSpiffClient *c) {
+  return c->proxy && source == G_OBJECT(c->proxy);
+}
+
+static void on_snapshot(GObject *source, GAsyncResult *res, gpointer user_data) {
+  LiveSpiffClient *c = LIVESPIFF_CLIENT(user_data);
+  gchar *state = NULL;
+  gint current_split = 0, split_count = 0;
+  gint64 elapsed_ms = 0, mono_us = 0;
+  if (live_spiff_control_call_snapshot_finish(LIVE_SPIFF_CONTROL(source), &state, &current_split, &split_count,
+                                              &elapsed_ms, &mono_us, res, NULL) &&
+      resync_current(source, c)) {
+    g_free(c->state);
+    c->state = g_steal_pointer(&state);
+    c->current_split = current_split;
+    c->split_count = split_count;
+    c->elapsed_ms = elapsed_ms;
+    c->mono_us = mono_us;
+    emit_changed(c, LIVESPIFF_CLIENT_STATE | LIVESPIFF_CLIENT_POSITION | LIVESPIFF_CLIENT_CLOCK);
+  }
+  g_free(state);
+  g_object_unref(c);
+}
+
+static void on_segments(GObject *source, GAsyncResult *res, gpointer user_data) {
+  LiveSpiffClient *c = LIVESPIFF_CLIENT(user_data);
+  gchar **names = NULL;
+  if (live_spiff_control_call_segments_finish(LIVE_SPIFF_CONTROL(source), &names, res, NULL) &&
+      resync_current(source, c)) {
+    strv_into(c->segments, names);
+    emit_changed(c, LIVESPIFF_CLIENT_SEGMENTS);
+  }
+  g_strfreev(names);
+  g_object_unref(c);
+}
+
+static void on_segment_icons(GObject *source, GAsyncResult *res, gpointer user_data) {
+  LiveSpiffClient *c = LIVESPIFF_CLIENT(user_data);
+  gchar **paths = NULL;
+  if (live_spiff_control_call_segment_icons_finish(LIVE_SPIFF_CONTROL(source), &paths, res, NULL) &&
+      resync_current(source, c)) {
+    strv_into(c->icons, paths);
+    emit_changed(c, LIVESPIFF_CLIENT_SEGMENTS);
+  }
+  g_strfreev(paths);
+  g_object_unref(c);
+}
+
+static void on_split_times(GObject *source, GAsyncResult *res, gpointer user_data) {
+  LiveSpiffClient *c = LIVESPIFF_CLIENT(user_data);
+  GVariant *times = NULL;
+  if (live_spiff_control_call_split_times_ms_finish(LIVE_SPIFF_CONTROL(source), &times, res, NULL) &&
+      resync_current(source, c)) {
+    times_into(c->split_ms, times);
+    emit_changed(c, LIVESPIFF_CLIENT_SPLITS);
+  }
+  if (times) g_variant_unref(times);
+  g_object_unref(c);
+}
+
+static void on_comparisons(GObject *source, GAsyncResult *res, gpointer user_data) {
+  LiveSpiffClient *c = LIVESPIFF_CLIENT(user_data);
+  gchar **names = NULL, *active = NULL;
+  if (live_spiff_control_call_list_comparisons_finish(LIVE_SPIFF_CONTROL(source), &names, &active, res, NULL) &&
+      resync_current(source, c)) {
+    g_free(c->comparison);
+    c->comparison = g_steal_pointer(&active);
+    emit_changed(c, LIVESPIFF_CLIENT_COMPARISON);
+  }
+  g_strfreev(names);
+  g_free(active);
+  g_object_unref(c);
+}
+
+// Requested after ListComparisons, so c->comparison is already the active one
+static void on_deltas(GObject *source, GAsyncResult *res, gpointer user_data) {
+  LiveSpiffClient *c = LIVESPIFF_CLIENT(user_data);
+  GVariant *deltas = NULL;
+  if (live_spiff_control_call_deltas_finish(LIVE_SPIFF_CONTROL(source), &deltas, res, NULL) &&
+      resync_current(source, c)) {
+    GVariantIter it;
+    const char *name = NULL;
+    GVariant *splits = NULL;
+    gint64 live = 0;
+    g_array_set_size(c->delta_ms, 0);
+    g_variant_iter_init(&it, deltas);
+    while (g_variant_iter_next(&it, "(&s@axx)", &name, &splits, &live)) {
+      if (g_strcmp0(name, c->comparison) == 0) times_into(c->delta_ms, splits);
+      g_variant_unref(splits);
+    }
+    emit_changed(c, LIVESPIFF_CLIENT_SPLITS);
+  }
+  if (deltas) g_variant_unref(deltas);
+  g_object_unref(c);
+}
+
+// Full state fetch: on connect, run load, comparison and timing method change.
+// Never blocks: the calls go out together and the replies land through
+// "changed" like signals do.
+static void resync(LiveSpiffClient *c) {
+  LiveSpiffControl *p = c->proxy;
+  if (!p) return;
+  live_spiff_control_call_snapshot(p, NULL, on_snapshot, g_object_ref(c));
+  live_spiff_control_call_segments(p, NULL, on_segments, g_object_ref(c));
+  live_spiff_control_call_segment_icons(p, NULL, on_segment_icons, g_object_ref(c));
+  live_spiff_control_call_split_times_ms(p, NULL, on_split_times, g_object_ref(c));
+  live_spiff_control_call_list_comparisons(p, NULL, on_comparisons, g_object_ref(c));
+  live_spiff_control_call_deltas(p, NULL, on_deltas, g_object_ref(c));
+}
+
+static void on_timer_event(LiveSpiffControl *proxy, const gchar *event, const gchar *state, gint split_index,
+                           gint current_split, gint split_count, gint64 elapsed_ms, gint64 monotonic_us,
+                           gint64 split_ms, gint64 delta_ms, gpointer user_data) {
+  (void)proxy;
+  LiveSpiffClient *c = LIVESPIFF_CLIENT(user_data);
+  guint changes = 0;
+
+  set_string(&c->state, state, &changes, LIVESPIFF_CLIENT_STATE);
+  if (c->current_split != current_split || c->split_count != split_count) changes |= LIVESPIFF_CLIENT_POSITION;
+  c->current_split = current_split;
+  c->split_count = split_count;
+  c->elapsed_ms = elapsed_ms;
+  c->mono_us = monotonic_us;
+  changes |= LIVESPIFF_CLIENT_CLOCK;
+
+  if (g_strcmp0(event, "load") == 0 || g_strcmp0(event, "comparison") == 0 || g_strcmp0(event, "timing") == 0) {
+    resync(c);
+  } else if (g_strcmp0(event, "start") == 0 || g_strcmp0(event, "reset") == 0) {
+    g_array_set_size(c->split_ms, 0);
+    g_array_set_size(c->delta_ms, 0);
+    changes |= LIVESPIFF_CLIENT_SPLITS;
+  } else if (g_strcmp0(event, "split") == 0 || g_strcmp0(event, "finish") == 0 || g_strcmp0(event, "skip") == 0) {
+    set_array_at(c->split_ms, split_index, split_ms);
+    set_array_at(c->delta_ms, split_index, delta_ms);
+    changes |= LIVESPIFF_CLIENT_SPLITS;
+  } else if (g_strcmp0(event, "undo") == 0 && split_index >= 0) {
+    g_array_set_size(c->split_ms, MIN(c->split_ms->len, (guint)split_index));
+    g_array_set_size(c->delta_ms, MIN(c->delta_ms->len, (guint)split_index));
+    changes |= LIVESPIFF_CLIENT_SPLITS;
+  }
+
+  emit_changed(c, changes);
+  g_signal_emit(c, client_signals[SIGNAL_TIMER_EVENT], 0, event);
+}
+
+static void on_proxy_signal(GDBusProxy *proxy, const gchar *sender, const gchar *signal_name,
+                            GVariant *params, gpointer user_data) {
+  (void)proxy; (void)sender;
+  g_signal_emit(user_data, client_signals[SIGNAL_SIGNAL], 0, signal_name, params);
+}
+
+/* ------------------------- transport ------------------------- */
+
+static gboolean bus_has_owner(LiveSpiffClient *c) {
+  if (!c->bus_proxy) return FALSE;
+  char *owner = g_dbus_proxy_get_name_owner(G_DBUS_PROXY(c->bus_proxy));
+  g_free(owner);
+  return owner != NULL;
+}
+
+// Signals are only taken from the proxy in use, so nothing arrives twice
+static void use_proxy(LiveSpiffClient *c, LiveSpiffControl *proxy) {
+  if (c->proxy) g_signal_handlers_disconnect_by_data(c->proxy, c);
+  c->proxy = proxy;
+  if (proxy) {
+    g_signal_connect(proxy, "timer-event", G_CALLBACK(on_timer_event), c);
+    // After the class handler, which emits "timer-event": the mirror is current by then
+    g_signal_connect_after(proxy, "g-signal", G_CALLBACK(on_proxy_signal), c);
+  }
+
+  c->connected = (proxy && proxy == c->peer_proxy) || bus_has_owner(c);
+  emit_changed(c, LIVESPIFF_CLIENT_CONNECTION);
+  if (c->connected) resync(c);
+}
+
+static gboolean try_peer(LiveSpiffClient *c);
+
+static gboolean on_peer_retry(gpointer user_data) {
+  LiveSpiffClient *c = LIVESPIFF_CLIENT(user_data);
+  if (!try_peer(c)) return G_SOURCE_CONTINUE;
+  c->retry_id = 0;
+  return G_SOURCE_REMOVE;
+}
+
+static void schedule_peer_retry(LiveSpiffClient *c) {
+  if (!c->bus_proxy && !c->retry_id) c->retry_id = g_timeout_add(PEER_RETRY_MS, on_peer_retry, c);
+}
+
+static void on_peer_closed(GDBusConnection *connection, gboolean remote_peer_vanished, GError *error,
+                           gpointer user_data) {
+  (void)remote_peer_vanished; (void)error;
+  LiveSpiffClient *c = LIVESPIFF_CLIENT(user_data);
+  g_signal_handlers_disconnect_by_data(connection, c);
+  if (!c->peer_proxy) return;
+  LiveSpiffControl *peer = g_steal_pointer(&c->peer_proxy);
+  if (c->proxy == peer) use_proxy(c, c->bus_proxy);
+  g_object_unref(peer);
+  schedule_peer_retry(c);
+}
+
+// Peer-to-peer to the daemon's socket, skipping the bus broker. Local and
+// synchronous: it either answers right away or is not there.
+static gboolean try_peer(LiveSpiffClient *c) {
+  if (c->peer_proxy) return TRUE;
+  char *address = livespiff_client_peer_address();
+  GDBusConnection *connection = address ? g_dbus_connection_new_for_address_sync(
+    address, G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT, NULL, NULL, NULL) : NULL;
+  g_free(address);
+  if (!connection) return FALSE;
+
+  LiveSpiffControl *peer = live_spiff_control_proxy_new_sync(
+    connection, G_DBUS_PROXY_FLAGS_DO_NOT_LOAD_PROPERTIES, NULL, LIVESPIFF_OBJECT_PATH, NULL, NULL);
+  if (peer) {
+    g_dbus_proxy_set_default_timeout(G_DBUS_PROXY(peer), CALL_TIMEOUT_MS);
+    g_signal_connect(connection, "closed", G_CALLBACK(on_peer_closed), c);
+    c->peer_proxy = peer;
+    use_proxy(c, peer);
+  }
+  g_object_unref(connection);
+  return peer != NULL;
+}
+
+static void on_name_owner(GObject *obj, GParamSpec *pspec, gpointer user_data) {
+  (void)obj; (void)pspec;
+  LiveSpiffClient *c = LIVESPIFF_CLIENT(user_data);
+  if (c->peer_proxy) return; // its "closed" tells us when the daemon goes away
+  // The daemon opens its socket before taking the bus name
+  if (bus_has_owner(c) && try_peer(c)) return;
+  use_proxy(c, c->bus_proxy);
+}
+
+/* ------------------------- GObject ------------------------- */
+
+static void livespiff_client_finalize(GObject *obj) {
+  LiveSpiffClient *c = LIVESPIFF_CLIENT(obj);
+  if (c->retry_id) g_source_remove(c->retry_id);
+  if (c->proxy) g_signal_handlers_disconnect_by_data(c->proxy, c);
+  if (c->peer_proxy) {
+    g_signal_handlers_disconnect_by_data(g_dbus_proxy_get_connection(G_DBUS_PROXY(c->peer_proxy)), c);
+    g_object_unref(c->peer_proxy);
+  }
+  if (c->bus_proxy) {
+    g_signal_handlers_disconnect_by_data(c->bus_proxy, c);
+    g_object_unref(c->bus_proxy);
+  }
+  g_free(c->state);
+  g_free(c->comparison);
+  g_ptr_array_free(c->segments, TRUE);
+  g_ptr_array_free(c->icons, TRUE);
+  g_array_free(c->split_ms, TRUE);
+  g_array_free(c->delta_ms, TRUE);
+  G_OBJECT_CLASS(livespiff_client_parent_class)->finalize(obj);
+}
+
+static void livespiff_client_class_init(LiveSpiffClientClass *klass) {
+  G_OBJECT_CLASS(klass)->finalize = livespiff_client_finalize;
+  client_signals[SIGNAL_CHANGED] = g_signal_new("changed", G_TYPE_FROM_CLASS(klass), G_SIGNAL_RUN_LAST,
+                                                0, NULL, NULL, NULL, G_TYPE_NONE, 1, G_TYPE_UINT);
+  client_signals[SIGNAL_TIMER_EVENT] = g_signal_new("timer-event", G_TYPE_FROM_CLASS(klass), G_SIGNAL_RUN_LAST,
+                                                    0, NULL, NULL, NULL, G_TYPE_NONE, 1, G_TYPE_STRING);
+  client_signals[SIGNAL_SIGNAL] = g_signal_new("signal", G_TYPE_FROM_CLASS(klass), G_SIGNAL_RUN_LAST,
+                                               0, NULL, NULL, NULL, G_TYPE_NONE, 2, G_TYPE_STRING, G_TYPE_VARIANT);
+}
+
+static void livespiff_client_init(LiveSpiffClient *c) {
+  c->segments = g_ptr_array_new_with_free_func(g_free);
+  c->icons = g_ptr_array_new_with_free_func(g_free);
+  c->split_ms = g_array_new(FALSE, FALSE, sizeof(gint64));
+  c->delta_ms = g_array_new(FALSE, FALSE, sizeof(gint64));
+}
+
+char* livespiff_client_peer_address(void) {
+  const char *env = g_getenv("LIVESPIFF_ADDRESS");
+  if (env) return *env ? g_strdup(env) : NULL; // empty: bus only
+  char *path = g_build_filename(g_get_user_runtime_dir(), LIVESPIFF_PEER_SOCKET, NULL);
+  char *address = NULL;
+  if (g_file_test(path, G_FILE_TEST_EXISTS)) {
+    char *escaped = g_dbus_address_escape_value(path);
+    address = g_strdup_printf("unix:path=%s", escaped);
+    g_free(escaped);
+  }
+  g_free(path);
+  return address;
+}
+
+LiveSpiffClient* livespiff_client_new(GError **error) {
+  GError *bus_error = NULL;
+  LiveSpiffControl *bus_proxy = live_spiff_control_proxy_new_for_bus_sync(
+    G_BUS_TYPE_SESSION, G_DBUS_PROXY_FLAGS_DO_NOT_LOAD_PROPERTIES,
+    LIVESPIFF_BUS_NAME, LIVESPIFF_OBJECT_PATH, NULL, &bus_error);
+
+  LiveSpiffClient *c = g_object_new(LIVESPIFF_TYPE_CLIENT, NULL);
+  c->bus_proxy = bus_proxy;
+  if (bus_proxy) {
+    g_dbus_proxy_set_default_timeout(G_DBUS_PROXY(bus_proxy), CALL_TIMEOUT_MS);
+    g_signal_connect(bus_proxy, "notify::g-name-owner", G_CALLBACK(on_name_owner), c);
+  }
+
+  if (try_peer(c)) {
+    g_clear_error(&bus_error);
+    return c;
+  }
+  if (!bus_proxy && g_strcmp0(g_getenv("LIVESPIFF_ADDRESS"), "") == 0) {
+    // No bus, and the socket was turned off
+    g_propagate_error(error, bus_error);
+    g_object_unref(c);
+    return NULL;
+  }
+  g_clear_error(&bus_error);
+  use_proxy(c, bus_proxy);
+  schedule_peer_retry(c);
+  return c;
+}
+
+/* ------------------------- accessors ------------------------- */
+
+LiveSpiffControl* livespiff_client_get_proxy(LiveSpiffClient *c) { return c->proxy; }
+gboolean livespiff_client_is_connected(LiveSpiffClient *c) { return c->connected; }
+const char* livespiff_client_get_state(LiveSpiffClient *c) { return c->state; }
+gint livespiff_client_get_current_split(LiveSpiffClient *c) { return c->current_split; }
+gint livespiff_client_get_split_count(LiveSpiffClient *c) { return c->split_count; }
+const GPtrArray* livespiff_client_get_segments(LiveSpiffClient *c) { return c->segments; }
+const GPtrArray* livespiff_client_get_icons(LiveSpiffClient *c) { return c->icons; }
+const GArray* livespiff_client_get_split_ms(LiveSpiffClient *c) { return c->split_ms; }
+const GArray* livespiff_client_get_delta_ms(LiveSpiffClient *c) { return c->delta_ms; }
+const char* livespiff_client_get_comparison(LiveSpiffClient *c) { return c->comparison; }
+
+gint64 livespiff_client_get_elapsed_ms(LiveSpiffClient *c) {
+  if (g_strcmp0(c->state, "Running") != 0) return c->elapsed_ms;
+  return c->elapsed_ms + (g_get_monotonic_time() - c->mono_us) / 1000;
+}
+
+void livespiff_client_get_clock(LiveSpiffClient *c, gint64 *elapsed_ms, gint64 *monotonic_us) {
+  if (elapsed_ms) *elapsed_ms = c->elapsed_ms;
+  if (monotonic_us) *monotonic_us = c->mono_us;
+}
+
+/* ------------------------- input ------------------------- */
+
+void livespiff_client_start_or_split(LiveSpiffClient *c, const char *source) {
+  if (c->proxy) live_spiff_control_call_start_or_split_from(c->proxy, source, NULL, NULL, NULL);
+}
+
+void livespiff_client_toggle_pause(LiveSpiffClient *c, const char *source) {
+  if (c->proxy) live_spiff_control_call_toggle_pause_from(c->proxy, source, NULL, NULL, NULL);
+}
+
+void livespiff_client_reset(LiveSpiffClient *c) {
+  if (c->proxy) live_spiff_control_call_reset(c->proxy, NULL, NULL, NULL);
+}
+
+void livespiff_client_undo_split(LiveSpiffClient *c) {
+  if (c->proxy) live_spiff_control_call_undo_split(c->proxy, NULL, NULL, NULL);
+}
+
+void livespiff_client_skip_split(LiveSpiffClient *c) {
+  if (c->proxy) live_spiff_control_call_skip_split(c->proxy, NULL, NULL, NULL);
+}
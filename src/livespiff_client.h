@@ -0,0 +1,83 @@
+#pragma once
+#include <gio/gio.h>
+
+#include "livespiff-dbus.h" // LiveSpiffControl, generated from data/com.livespiff.LiveSpiff.Control.xml
+
+G_BEGIN_DECLS
+
+#define LIVESPIFF_BUS_NAME    "com.livespiff.LiveSpiff"
+#define LIVESPIFF_OBJECT_PATH "/com/livespiff/LiveSpiff"
+// Peer-to-peer D-Bus socket of livespiffd, under $XDG_RUNTIME_DIR
+#define LIVESPIFF_PEER_SOCKET "livespiff/control.sock"
+#define LIVESPIFF_NO_TIME_MS  G_MININT64
+
+// What a "changed" emission touched
+typedef enum {
+  LIVESPIFF_CLIENT_CONNECTION = 1 << 0, // daemon appeared or vanished
+  LIVESPIFF_CLIENT_STATE      = 1 << 1, // state string
+  LIVESPIFF_CLIENT_POSITION   = 1 << 2, // current split, split count
+  LIVESPIFF_CLIENT_CLOCK      = 1 << 3, // elapsed time anchor
+  LIVESPIFF_CLIENT_SEGMENTS   = 1 << 4, // segment names, icons
+  LIVESPIFF_CLIENT_SPLITS     = 1 << 5, // split and delta times
+  LIVESPIFF_CLIENT_COMPARISON = 1 << 6  // active comparison (deltas are against it)
+} LiveSpiffClientChange;
+
+// A local mirror of livespiffd's timer, kept current by TimerEvent signals
+// (and a full fetch when the daemon appears, a run is loaded or the
+// comparison or timing method changes, whose replies arrive as further
+// "changed" emissions). Reads never touch the bus and nothing blocks on it;
+// the running clock is extrapolated from the last event.
+//
+// The daemon is reached peer-to-peer on its private socket when there is
+// one (no broker hop, and it works without a session bus, e.g. under
+// gamescope), otherwise through the session bus; the client switches
+// between the two as the daemon comes and goes.
+//
+// Signals:
+//   changed(guint LiveSpiffClientChange)  after the mirror was updated
+//   timer-event(const char *event)        each TimerEvent, after "changed" (for "load",
+//                                         "comparison" and "timing" before the refetch lands)
+//   signal(const char *name, GVariant *)  every daemon signal, whichever the transport;
+//                                         TimerEvent after the two above
+#define LIVESPIFF_TYPE_CLIENT (livespiff_client_get_type())
+G_DECLARE_FINAL_TYPE(LiveSpiffClient, livespiff_client, LIVESPIFF, CLIENT, GObject)
+
+// Follows the daemon whether or not it is running yet. NULL (and error)
+// only if there is no session bus and LIVESPIFF_ADDRESS is set empty.
+LiveSpiffClient* livespiff_client_new(GError **error);
+
+// D-Bus address of the daemon's socket: $LIVESPIFF_ADDRESS if set (empty =
+// bus only), else the socket under $XDG_RUNTIME_DIR if it exists; NULL if
+// none (caller frees)
+char* livespiff_client_peer_address(void);
+
+// The generated proxy in use, for calls the mirror does not cover (use the
+// _call_ variants with a callback to stay off the main loop). It changes
+// when the transport does, so fetch it per call rather than keeping it;
+// NULL while there is neither. Subscribe to "signal" instead of its
+// "g-signal".
+LiveSpiffControl* livespiff_client_get_proxy(LiveSpiffClient *c);
+
+gboolean livespiff_client_is_connected(LiveSpiffClient *c);
+const char* livespiff_client_get_state(LiveSpiffClient *c);   // "Idle", "Running", ...; NULL if unknown
+gint livespiff_client_get_current_split(LiveSpiffClient *c);
+gint livespiff_client_get_split_count(LiveSpiffClient *c);
+gint64 livespiff_client_get_elapsed_ms(LiveSpiffClient *c); // now, extrapolated while running
+// Elapsed time as of the daemon's monotonic_us (for callers that extrapolate themselves)
+void livespiff_client_get_clock(LiveSpiffClient *c, gint64 *elapsed_ms, gint64 *monotonic_us);
+const GPtrArray* livespiff_client_get_segments(LiveSpiffClient *c); // char*
+const GPtrArray* livespiff_client_get_icons(LiveSpiffClient *c);    // char* absolute path, "" = none
+const GArray* livespiff_client_get_split_ms(LiveSpiffClient *c);    // gint64 per completed split
+const GArray* livespiff_client_get_delta_ms(LiveSpiffClient *c);    // gint64 per completed split
+const char* livespiff_client_get_comparison(LiveSpiffClient *c);
+
+// Timer input; fire-and-forget, the daemon timestamps on arrival and
+// corrects by the latency measured for source (see CalibrationStart)
+void livespiff_client_start_or_split(LiveSpiffClient *c, const char *source);
+void livespiff_client_toggle_pause(LiveSpiffClient *c, const char *source);
+void livespiff_client_reset(LiveSpiffClient *c);
+// Take back the last split or skip / pass the current split without a time
+void livespiff_client_undo_split(LiveSpiffClient *c);
+void livespiff_client_skip_split(LiveSpiffClient *c);
+
+G_END_DECLS
@@ -0,0 +1,72 @@
+#pragma once
+// LiveSpiff plugin ABI
+//
+// A plugin is a shared object in ~/.local/share/livespiff/plugins/ that
+// exports livespiff_plugin_describe(). livespiffd loads it at startup and
+// gives it a thread of its own: init, every event and shutdown are called on
+// that thread, never on the timing path. Events reach the thread through a
+// bounded queue; when the plugin falls behind, new events are dropped (and
+// counted) instead of waiting for it.
+//
+// Only fixed-size C types cross this boundary, so plugins need no GLib.
+// Bump LIVESPIFF_PLUGIN_ABI_VERSION on any incompatible change; the daemon
+// refuses plugins built against another version.
+
+#include <stdint.h>
+
+#define LIVESPIFF_PLUGIN_ABI_VERSION 1u
+#define LIVESPIFF_PLUGIN_ENTRY "livespiff_plugin_describe"
+
+typedef enum {
+  LIVESPIFF_EVENT_START = 1,
+  LIVESPIFF_EVENT_SPLIT,
+  LIVESPIFF_EVENT_FINISH,
+  LIVESPIFF_EVENT_PAUSE,
+  LIVESPIFF_EVENT_RESUME,
+  LIVESPIFF_EVENT_RESET,
+  LIVESPIFF_EVENT_LOAD,          // another run was loaded
+  LIVESPIFF_EVENT_COMPARISON,    // the active comparison changed
+  LIVESPIFF_EVENT_OTHER          // added in a later daemon; see name
+} LiveSpiffEventKind;
+
+typedef enum {
+  LIVESPIFF_STATE_IDLE = 0,
+  LIVESPIFF_STATE_RUNNING,
+  LIVESPIFF_STATE_PAUSED,
+  LIVESPIFF_STATE_FINISHED
+} LiveSpiffTimerState;
+
+#define LIVESPIFF_EVENT_NO_TIME INT64_MIN
+
+// Mirrors the TimerEvent D-Bus signal. Times are microseconds; monotonic_us
+// is CLOCK_MONOTONIC, so a running timer can be extrapolated locally.
+typedef struct {
+  uint32_t size;                 // sizeof(LiveSpiffPluginEvent) of the daemon
+  uint32_t kind;                 // LiveSpiffEventKind
+  uint32_t state;                // LiveSpiffTimerState after the event
+  int32_t split_index;           // split the event refers to, else -1
+  int32_t current_split;
+  int32_t split_count;
+  int64_t elapsed_us;
+  int64_t monotonic_us;
+  int64_t split_us;              // LIVESPIFF_EVENT_NO_TIME if none
+  int64_t delta_us;              // vs the active comparison, or NO_TIME
+  uint64_t sequence;             // per plugin; gaps mean dropped events
+  char name[16];                 // event name as in TimerEvent, NUL-terminated
+} LiveSpiffPluginEvent;
+
+typedef struct {
+  uint32_t abi_version;          // LIVESPIFF_PLUGIN_ABI_VERSION
+  const char *name;
+
+  // All optional. init returns 0 on success; *state is passed back to the others.
+  int (*init)(void **state);
+  // ev points into the queue and is only valid during the call
+  void (*on_event)(void *state, const LiveSpiffPluginEvent *ev);
+  void (*shutdown)(void *state);
+} LiveSpiffPluginDesc;
+
+typedef const LiveSpiffPluginDesc* (*LiveSpiffPluginDescribeFunc)(void);
+
+// Each plugin defines:
+//   const LiveSpiffPluginDesc* livespiff_plugin_describe(void);
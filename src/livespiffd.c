@@ -2,17 +2,40 @@
 // LiveSpiff D-Bus timer daemon (Wayland-first, KDE-friendly)
 // Service:   com.livespiff.LiveSpiff
 // Path:      /com/livespiff/LiveSpiff
-// Interface: com.livespiff.LiveSpiff.Control
+// Interface: com.livespiff.LiveSpiff.Control (data/com.livespiff.LiveSpiff.Control.xml)
 
 #include <gio/gio.h>
+#include <glib/gstdio.h>
 #include <stdint.h>
+#include <string.h>
+#include <unistd.h>
 
+#include "calibration.h"
+#include "comparisons.h"
+#include "daemon_config.h"
+#include "evdev_hotkeys.h"
+#include "global_shortcuts.h"
+#ifdef LIVESPIFF_HAVE_SQLITE
+#include "history_db.h"
+#endif
+#include "history_export.h"
+#include "history_view.h"
+#include "library.h"
+#include "livespiff-dbus.h"
+#include "livespiff_client.h" // LIVESPIFF_PEER_SOCKET
+#include "plugin_host.h"
+#include "practice.h"
+#include "proctrack.h"
+#include "state_cache.h"
+#include "stats.h"
 #include "storage.h"
+#include "ui_settings.h"
 
 #define BUS_NAME   "com.livespiff.LiveSpiff"
 #define OBJ_PATH   "/com/livespiff/LiveSpiff"
 #define IFACE_NAME "com.livespiff.LiveSpiff.Control"
 
+// Same values as LiveSpiffTimerState in the plugin ABI
 typedef enum {
   STATE_IDLE = 0,
   STATE_RUNNING,
@@ -20,14 +43,46 @@ typedef enum {
   STATE_FINISHED
 } TimerState;
 
+// Forward moves of the current attempt that UndoSplit can take back
+#define TRANSITION_RING_SIZE 64
+
+typedef enum {
+  TRANSITION_SPLIT = 0,
+  TRANSITION_SKIP
+} TransitionKind;
+
+typedef struct {
+  TransitionKind kind;
+  int split_index;               // split it completed or skipped
+} Transition;
+
 typedef struct {
   TimerState state;
   gint64 start_monotonic_us;     // g_get_monotonic_time() at start
   gint64 paused_at_us;           // time when paused
   gint64 total_paused_us;        // accumulated paused time
   gint64 paused_elapsed_us;      // snapshot when paused or finished
+  gint64 started_at_us;          // g_get_real_time() at start (history)
+  GArray *split_us;              // cumulative split times of the current attempt
   int current_split;
   int split_count;
+
+  // Game time: real elapsed time minus the stretches the game loaded or game
+  // time was paused (pausing the timer stops both clocks). Until the first
+  // such stretch of an attempt the two are equal and nothing is tracked.
+  gboolean loading;              // SetLoading, kept across attempts
+  gboolean game_time_paused;     // PauseGameTime, cleared on reset
+  gboolean game_time_used;       // game time differs from real time this attempt
+  gint64 game_offset_us;         // real elapsed time not counted as game time
+  gint64 game_stopped_at_us;     // real elapsed when game time stopped, -1 while it runs
+  GArray *split_game_us;         // game time per split, parallel to split_us once used
+
+  // Splits and skips of this attempt, oldest at transition_head; once the
+  // ring is full the oldest drop out and can no longer be undone. The split
+  // arrays only ever grow at the end, so an undo truncates them.
+  Transition transitions[TRANSITION_RING_SIZE];
+  guint transition_head;
+  guint transition_count;
 } Timer;
 
 static Timer g_timer = {
@@ -36,12 +91,95 @@ static Timer g_timer = {
   .paused_at_us = 0,
   .total_paused_us = 0,
   .paused_elapsed_us = 0,
+  .started_at_us = 0,
+  .split_us = NULL,
   .current_split = 0,
   .split_count = 3, // will be updated from run data
+  .game_stopped_at_us = -1,
 };
 
 // Current run (segments, metadata)
 static LiveSpiffRun *g_run = NULL;
+static char *g_run_path = NULL;     // NULL until a run file is loaded
+
+// Attempt history of the current run + comparisons derived from it
+static GPtrArray *g_history = NULL; // LiveSpiffAttempt*
+static LiveSpiffComparisons *g_comparisons = NULL;      // of g_timing: one of the two below
+static LiveSpiffComparisons *g_real_comparisons = NULL;
+static LiveSpiffComparisons *g_game_comparisons = NULL; // NULL until game time is selected
+// Clock that queries, deltas and comparisons use
+static TimingMethod g_timing = TIMING_REAL;
+// Bumped whenever g_history changes; paging clients restart when it moves
+static guint g_history_revision = 0;
+// Last ListAttempts ordering, reused while query and revision match
+static LiveSpiffHistoryView *g_history_view = NULL;
+#ifdef LIVESPIFF_HAVE_SQLITE
+// SQLite copy of every run's history for ad-hoc queries (NULL unless
+// [history] sqlite); the JSON log stays the one the rest of LiveSpiff reads
+static LiveSpiffHistoryDb *g_history_db = NULL;
+#endif
+// Segment practice results of the current run (kept apart from g_history)
+static LiveSpiffPractice *g_practice = NULL;
+
+// Index of every run file in livespiff_runs_dir()
+static LiveSpiffLibrary *g_library = NULL;
+
+#define SEARCH_RUNS_LIMIT 500
+#define LIST_ATTEMPTS_LIMIT 1000
+
+static LiveSpiffDaemonConfig g_config;
+static GDBusConnection *g_connection = NULL;
+
+// The same object served peer-to-peer on a socket in $XDG_RUNTIME_DIR:
+// clients skip the broker hop, and it works where there is no session bus
+static GDBusServer *g_peer_server = NULL;
+static char *g_peer_socket_path = NULL;
+static GPtrArray *g_peers = NULL;      // GDBusConnection*
+
+// Watched game process (auto start / pause hooks)
+static LiveSpiffProcTracker *g_tracker = NULL;
+
+// Latency calibration in progress (NULL otherwise); while it runs, inputs
+// are taps and never reach the timer
+static LiveSpiffCalibration *g_calibration = NULL;
+static guint g_calibration_beat = 0;    // next beat to announce
+static guint g_calibration_tick_id = 0;
+
+// Last accepted start/split and pause input (compensated monotonic time),
+// for the double-press guard
+static gint64 g_last_split_input_us = 0;
+static gint64 g_last_pause_input_us = 0;
+
+// Input source used by the argument-less control methods (e.g. qdbus6 from a KDE shortcut)
+#define DEFAULT_INPUT_SOURCE "dbus"
+
+// Keys read straight from /dev/input on a dedicated thread (optional)
+static LiveSpiffHotkeyReader *g_hotkeys = NULL;
+#define EVDEV_INPUT_SOURCE "evdev"
+
+// Desktop-wide shortcuts through the GlobalShortcuts portal or KGlobalAccel
+static LiveSpiffGlobalShortcuts *g_shortcuts = NULL;
+#define SHORTCUT_INPUT_SOURCE "shortcut"
+
+// In-process event consumers, each on its own thread (NULL when disabled)
+static LiveSpiffPluginHost *g_plugins = NULL;
+
+// Warm start: the last run is restored before the bus name is taken, so
+// activation (D-Bus or systemd) hands callers a daemon that is ready.
+// Times are from main() entry, for StartupInfo and the startup log line.
+static gint64 g_start_us = 0;
+static const char *g_restored_from = "default"; // "cache", "json" or "default"
+static gint64 g_restore_us = 0;
+static gint64 g_ready_us = 0;
+static guint g_state_save_id = 0;
+// What the pending save writes
+typedef enum {
+  STATE_SAVE_RUN = 1 << 0,        // run and attempts
+  STATE_SAVE_COMPARISON = 1 << 1  // active comparison name
+} StateSaveParts;
+static guint g_state_save_parts = 0;
+// state_cache_attempt() of a prefix of g_history, extended when a save needs it
+static GPtrArray *g_history_cached = NULL;
 
 static const char* state_to_string(TimerState s) {
   switch (s) {
@@ -53,7 +191,25 @@ static const char* state_to_string(TimerState s) {
   }
 }
 
-static gint64 timer_elapsed_us(void) {
+// "Loading" while game time is shown and stopped, so that clients, which
+// extrapolate only a "Running" clock, hold it still
+static const char* timer_state_string(void) {
+  if (g_timer.state == STATE_RUNNING && g_timing == TIMING_GAME && g_timer.game_stopped_at_us >= 0) return "Loading";
+  return state_to_string(g_timer.state);
+}
+
+// Broadcast on the bus and to every peer connection
+static void emit_signal(const char *signal_name, GVariant *params) {
+  if (params) g_variant_ref_sink(params);
+  if (g_connection) g_dbus_connection_emit_signal(g_connection, NULL, OBJ_PATH, IFACE_NAME, signal_name, params, NULL);
+  for (guint i = 0; g_peers && i < g_peers->len; i++) {
+    g_dbus_connection_emit_signal(g_ptr_array_index(g_peers, i), NULL, OBJ_PATH, IFACE_NAME, signal_name, params, NULL);
+  }
+  if (params) g_variant_unref(params);
+}
+
+// Elapsed time as of the monotonic time now_us
+static gint64 timer_elapsed_at_us(gint64 now_us) {
   if (g_timer.state == STATE_IDLE) return 0;
 
   if (g_timer.state == STATE_PAUSED) return g_timer.paused_elapsed_us;
@@ -63,60 +219,451 @@ static gint64 timer_elapsed_us(void) {
   }
 
   // Running
-  gint64 now = g_get_monotonic_time();
-  gint64 raw = now - g_timer.start_monotonic_us;
+  gint64 raw = now_us - g_timer.start_monotonic_us;
   gint64 adj = raw - g_timer.total_paused_us;
   if (adj < 0) adj = 0;
   return adj;
 }
 
-static void timer_start(void) {
-  if (g_timer.state != STATE_IDLE) return;
+static gint64 timer_elapsed_us(void) {
+  return timer_elapsed_at_us(g_get_monotonic_time());
+}
+
+// Game time at real elapsed time real_us
+static gint64 game_time_at_real_us(gint64 real_us) {
+  if (!g_timer.game_time_used) return real_us;
+  gint64 until = g_timer.game_stopped_at_us >= 0 ? MIN(real_us, g_timer.game_stopped_at_us) : real_us;
+  return MAX(until - g_timer.game_offset_us, 0);
+}
+
+// Elapsed time on the selected clock
+static gint64 timer_time_at_us(gint64 now_us) {
+  gint64 real_us = timer_elapsed_at_us(now_us);
+  return g_timing == TIMING_GAME ? game_time_at_real_us(real_us) : real_us;
+}
+
+static gint64 timer_time_us(void) {
+  return timer_time_at_us(g_get_monotonic_time());
+}
 
-  g_timer.start_monotonic_us = g_get_monotonic_time();
+// Split times of the current attempt on the selected clock
+static const GArray* timer_splits(void) {
+  return g_timing == TIMING_GAME && g_timer.game_time_used ? g_timer.split_game_us : g_timer.split_us;
+}
+
+// When an input from source actually happened: its arrival (or kernel) time
+// minus the calibrated latency of that path. Never in the future.
+static gint64 input_time_us(const char *source, gint64 arrival_us) {
+  gint64 now = g_get_monotonic_time();
+  gint64 at = arrival_us - daemon_config_latency_offset(&g_config, source);
+  return MIN(at, now);
+}
+
+static gint64 us_to_ms(gint64 us) {
+  return us == LIVESPIFF_NO_TIME ? LIVESPIFF_NO_TIME : us / 1000;
+}
+
+// Change notification for clients that mirror the timer instead of polling.
+// split_index is the split the event refers to (split/finish/reset), else -1;
+// monotonic_us lets clients extrapolate the running time locally.
+static void emit_timer_event(const char *event, gint64 elapsed_us, int split_index, gint64 split_us) {
+  gint64 delta_us = LIVESPIFF_NO_TIME;
+  if (split_us != LIVESPIFF_NO_TIME && split_index >= 0) {
+    delta_us = comparisons_delta_us(g_comparisons, g_comparisons->active, (guint)split_index, split_us);
+  }
+
+  // While running, report the time as of the emission instant: inputs may be
+  // back-dated by latency compensation, and clients extrapolate from mono
+  gint64 mono = g_get_monotonic_time();
+  if (g_timer.state == STATE_RUNNING) elapsed_us = timer_time_at_us(mono);
+
+  if (g_plugins) {
+    static const char *kinds[] = { NULL, "start", "split", "finish", "pause", "resume", "reset", "load", "comparison" };
+    LiveSpiffPluginEvent pe = {0};
+    pe.kind = LIVESPIFF_EVENT_OTHER;
+    for (guint k = 1; k < G_N_ELEMENTS(kinds); k++) {
+      if (g_strcmp0(event, kinds[k]) == 0) pe.kind = k;
+    }
+    pe.state = (guint32)g_timer.state;
+    pe.split_index = split_index;
+    pe.current_split = g_timer.current_split;
+    pe.split_count = g_timer.split_count;
+    pe.elapsed_us = elapsed_us;
+    pe.monotonic_us = mono;
+    pe.split_us = split_us;
+    pe.delta_us = delta_us;
+    g_strlcpy(pe.name, event, sizeof(pe.name));
+    plugin_host_publish(g_plugins, &pe);
+  }
+
+  emit_signal("TimerEvent", g_variant_new("(ssiiixxxx)",
+                                          event,
+                                          timer_state_string(),
+                                          (gint32)split_index,
+                                          (gint32)g_timer.current_split,
+                                          (gint32)g_timer.split_count,
+                                          us_to_ms(elapsed_us),
+                                          mono,
+                                          us_to_ms(split_us),
+                                          us_to_ms(delta_us)));
+}
+
+/* ------------------------- state cache ------------------------- */
+
+typedef struct {
+  GVariant *state;        // NULL: unchanged
+  char *comparison;
+  gboolean save_comparison;
+} StateSave;
+
+static void state_save_free(StateSave *save) {
+  if (save->state) g_variant_unref(save->state);
+  g_free(save->comparison);
+  g_free(save);
+}
+
+static void state_save_thread(GTask *task, gpointer source, gpointer task_data, GCancellable *cancellable) {
+  (void)source; (void)cancellable;
+  StateSave *save = (StateSave*)task_data;
+  char *path = state_cache_path();
+  char *err_str = NULL;
+  if (save->state && !state_cache_write(path, save->state, &err_str)) {
+    g_printerr("%s\n", err_str ? err_str : "Failed to write state cache");
+    g_clear_pointer(&err_str, g_free);
+  }
+  if (save->save_comparison && !state_cache_write_comparison(path, save->comparison, &err_str)) {
+    g_printerr("%s\n", err_str ? err_str : "Failed to write state cache");
+    g_free(err_str);
+  }
+  g_free(path);
+  g_task_return_boolean(task, TRUE);
+}
+
+// Snapshot here (it stamps the files as they are now), serialized and written
+// off the loop. Only attempts not cached yet are converted.
+static gboolean on_state_save_idle(gpointer user_data) {
+  (void)user_data;
+  g_state_save_id = 0;
+  guint parts = g_state_save_parts;
+  g_state_save_parts = 0;
+  if (!g_run_path) return G_SOURCE_REMOVE;
+
+  StateSave *save = g_new0(StateSave, 1);
+  if (parts & STATE_SAVE_RUN) {
+    for (guint i = g_history_cached->len; i < g_history->len; i++) {
+      g_ptr_array_add(g_history_cached, state_cache_attempt(g_ptr_array_index(g_history, i)));
+    }
+    save->state = state_cache_snapshot(g_run_path, g_run, g_history_cached);
+  }
+  if (parts & STATE_SAVE_COMPARISON) {
+    save->comparison = g_strdup(comparisons_active_name(g_comparisons));
+    save->save_comparison = TRUE;
+  }
+  GTask *task = g_task_new(NULL, NULL, NULL, NULL);
+  g_task_set_task_data(task, save, (GDestroyNotify)state_save_free);
+  g_task_run_in_thread(task, state_save_thread);
+  g_object_unref(task);
+  return G_SOURCE_REMOVE;
+}
+
+// Coalesced: a finish, its history append and a comparison switch write once
+static void schedule_state_save(guint parts) {
+  g_state_save_parts |= parts;
+  if (!g_state_save_id) g_state_save_id = g_idle_add_full(G_PRIORITY_LOW, on_state_save_idle, NULL, NULL);
+}
+
+// Store the current attempt in history and fold it into the comparisons
+static void record_attempt(gboolean finished) {
+  LiveSpiffAttempt *a = attempt_new();
+  a->started_at_us = g_timer.started_at_us;
+  a->finished = finished;
+  if (!finished) {
+    a->reset_us = timer_elapsed_us();
+    if (g_timer.game_time_used) a->reset_game_us = game_time_at_real_us(a->reset_us);
+  }
+  if (g_timer.split_us) g_array_append_vals(a->split_us, g_timer.split_us->data, g_timer.split_us->len);
+  if (g_timer.game_time_used) {
+    a->game_us = g_array_sized_new(FALSE, FALSE, sizeof(gint64), g_timer.split_game_us->len);
+    g_array_append_vals(a->game_us, g_timer.split_game_us->data, g_timer.split_game_us->len);
+  }
+
+  if (g_run_path) {
+    char *hist_path = run_history_path(g_run_path);
+    char *err_str = NULL;
+    if (!history_append(hist_path, a, &err_str)) {
+      g_printerr("%s\n", err_str ? err_str : "Failed to append history");
+      g_free(err_str);
+    }
+#ifdef LIVESPIFF_HAVE_SQLITE
+    history_db_append(g_history_db, hist_path, a);
+#endif
+    g_free(hist_path);
+  }
+
+  comparisons_add_attempt(g_real_comparisons, a);
+  comparisons_add_attempt(g_game_comparisons, a);
+  g_ptr_array_add(g_history, a);
+  g_history_revision++;
+  schedule_state_save(STATE_SAVE_RUN);
+}
+
+static void build_comparisons(const GPtrArray *attempts, const char *active_name);
+static void load_practice(const char *run_path);
+
+// Undo of the finishing split: the attempt record_attempt(TRUE) just added
+// leaves the log and the comparisons again
+static void unrecord_attempt(void) {
+  if (!g_history->len) return;
+  const LiveSpiffAttempt *last = g_ptr_array_index(g_history, g_history->len - 1);
+  if (g_run_path) {
+    char *hist_path = run_history_path(g_run_path);
+    char *err_str = NULL;
+    if (!history_remove_last(hist_path, last->started_at_us, &err_str)) {
+      g_printerr("%s\n", err_str ? err_str : "Failed to rewrite history");
+      g_free(err_str);
+    }
+#ifdef LIVESPIFF_HAVE_SQLITE
+    history_db_remove_last(g_history_db, hist_path, last->started_at_us);
+#endif
+    g_free(hist_path);
+  }
+
+  g_ptr_array_remove_index(g_history, g_history->len - 1);
+  if (g_history_cached->len > g_history->len) g_ptr_array_set_size(g_history_cached, g_history->len);
+  g_history_revision++;
+  // Each set takes back what the finish changed. Rebuilt (with the practice
+  // results fed in again) only if one cannot: built or practised since.
+  gboolean undone = comparisons_remove_last_attempt(g_real_comparisons);
+  if (g_game_comparisons) undone = comparisons_remove_last_attempt(g_game_comparisons) && undone;
+  if (!undone) {
+    char *active = g_strdup(comparisons_active_name(g_comparisons));
+    build_comparisons(g_history, active);
+    g_free(active);
+    if (g_run_path) load_practice(g_run_path);
+  }
+  schedule_state_save(STATE_SAVE_RUN);
+}
+
+static void transition_push(TransitionKind kind, int split_index) {
+  guint slot = (g_timer.transition_head + g_timer.transition_count) % TRANSITION_RING_SIZE;
+  if (g_timer.transition_count == TRANSITION_RING_SIZE) {
+    g_timer.transition_head = (g_timer.transition_head + 1) % TRANSITION_RING_SIZE;
+  } else {
+    g_timer.transition_count++;
+  }
+  g_timer.transitions[slot] = (Transition){ kind, split_index };
+}
+
+static gboolean transition_pop(Transition *out) {
+  if (g_timer.transition_count == 0) return FALSE;
+  g_timer.transition_count--;
+  *out = g_timer.transitions[(g_timer.transition_head + g_timer.transition_count) % TRANSITION_RING_SIZE];
+  return TRUE;
+}
+
+static void transitions_clear(void) {
+  g_timer.transition_head = 0;
+  g_timer.transition_count = 0;
+}
+
+// Latest known time in a split array (skipped splits have none), 0 if none
+static gint64 last_split_time(const GArray *times) {
+  for (guint i = times->len; i > 0; i--) {
+    gint64 t = g_array_index(times, gint64, i - 1);
+    if (t != LIVESPIFF_NO_TIME) return t;
+  }
+  return 0;
+}
+
+static gboolean practice_active(void) {
+  return g_practice && g_practice->phase != PRACTICE_OFF;
+}
+
+// From here on the attempt tracks game time apart; earlier splits equal real time
+static void game_time_begin(void) {
+  if (g_timer.game_time_used) return;
+  if (!g_timer.split_game_us) g_timer.split_game_us = g_array_new(FALSE, FALSE, sizeof(gint64));
+  g_array_set_size(g_timer.split_game_us, 0);
+  g_array_append_vals(g_timer.split_game_us, g_timer.split_us->data, g_timer.split_us->len);
+  g_timer.game_time_used = TRUE;
+}
+
+// Stop or restart game time after loading or game_time_paused changed
+static void game_time_update(gint64 at_us) {
+  if (g_timer.state != STATE_RUNNING && g_timer.state != STATE_PAUSED) return;
+
+  gboolean stop = g_timer.loading || g_timer.game_time_paused;
+  gint64 real_us = timer_elapsed_at_us(at_us);
+  if (stop && g_timer.game_stopped_at_us < 0) {
+    game_time_begin();
+    g_timer.game_stopped_at_us = real_us;
+    emit_timer_event("game-pause", timer_time_us(), -1, LIVESPIFF_NO_TIME);
+  } else if (!stop && g_timer.game_stopped_at_us >= 0) {
+    g_timer.game_offset_us += MAX(real_us - g_timer.game_stopped_at_us, 0);
+    g_timer.game_stopped_at_us = -1;
+    emit_timer_event("game-resume", timer_time_us(), -1, LIVESPIFF_NO_TIME);
+  }
+}
+
+static void timer_set_loading(gboolean loading, gint64 at_us) {
+  g_timer.loading = loading;
+  game_time_update(at_us);
+}
+
+static void timer_pause_game_time(gboolean paused, gint64 at_us) {
+  g_timer.game_time_paused = paused;
+  game_time_update(at_us);
+}
+
+static void timer_start(gint64 at_us) {
+  if (g_timer.state != STATE_IDLE || practice_active()) return;
+
+  g_timer.start_monotonic_us = at_us;
+  g_timer.started_at_us = g_get_real_time();
   g_timer.total_paused_us = 0;
   g_timer.paused_elapsed_us = 0;
   g_timer.paused_at_us = 0;
   g_timer.current_split = 0;
+  if (!g_timer.split_us) g_timer.split_us = g_array_new(FALSE, FALSE, sizeof(gint64));
+  g_array_set_size(g_timer.split_us, 0);
+  transitions_clear();
+  g_timer.game_time_used = FALSE;
+  g_timer.game_offset_us = 0;
+  g_timer.game_stopped_at_us = -1;
+  // A start during a load begins with game time stopped
+  if (g_timer.loading || g_timer.game_time_paused) {
+    game_time_begin();
+    g_timer.game_stopped_at_us = 0;
+  }
   g_timer.state = STATE_RUNNING;
+  emit_timer_event("start", 0, -1, LIVESPIFF_NO_TIME);
 }
 
-static void timer_split(void) {
+static void timer_split(gint64 at_us) {
   if (g_timer.state != STATE_RUNNING) return;
 
+  gint64 now_us = timer_elapsed_at_us(at_us);
+  // Compensation must not move a split before the previous one
+  now_us = MAX(now_us, last_split_time(g_timer.split_us));
+  g_array_append_val(g_timer.split_us, now_us);
+
+  gint64 split_time = now_us;
+  if (g_timer.game_time_used) {
+    gint64 game_us = MAX(game_time_at_real_us(now_us), last_split_time(g_timer.split_game_us));
+    g_array_append_val(g_timer.split_game_us, game_us);
+    if (g_timing == TIMING_GAME) split_time = game_us;
+  }
+
+  int split_index = g_timer.current_split;
   g_timer.current_split++;
+  transition_push(TRANSITION_SPLIT, split_index);
   if (g_timer.current_split >= g_timer.split_count) {
     // Mark finished
-    g_timer.paused_elapsed_us = timer_elapsed_us(); // snapshot final time
+    g_timer.paused_elapsed_us = now_us; // snapshot final time
     g_timer.state = STATE_FINISHED;
+    // The delta is taken against the comparisons before this attempt joins them
+    emit_timer_event("finish", split_time, split_index, split_time);
+    record_attempt(TRUE);
+    return;
+  }
+  emit_timer_event("split", split_time, split_index, split_time);
+}
+
+// The split is passed without a time; the last split cannot be skipped
+static gboolean timer_skip_split(char **out_msg) {
+  if (g_timer.state != STATE_RUNNING && g_timer.state != STATE_PAUSED) {
+    *out_msg = g_strdup("No attempt in progress");
+    return FALSE;
+  }
+  if (g_timer.current_split >= g_timer.split_count - 1) {
+    *out_msg = g_strdup("The last split cannot be skipped");
+    return FALSE;
+  }
+
+  gint64 none = LIVESPIFF_NO_TIME;
+  g_array_append_val(g_timer.split_us, none);
+  if (g_timer.game_time_used) g_array_append_val(g_timer.split_game_us, none);
+  int split_index = g_timer.current_split;
+  g_timer.current_split++;
+  transition_push(TRANSITION_SKIP, split_index);
+  emit_timer_event("skip", timer_time_us(), split_index, LIVESPIFF_NO_TIME);
+  *out_msg = g_strdup_printf("Skipped split %d", split_index + 1);
+  return TRUE;
+}
+
+// Takes back the last split or skip of the attempt in progress. Undoing the
+// finishing split takes the attempt back out of the history, and the timer
+// runs on as if it had never stopped.
+static gboolean timer_undo_split(char **out_msg) {
+  if (g_timer.state == STATE_IDLE) {
+    *out_msg = g_strdup("No attempt in progress");
+    return FALSE;
+  }
+  Transition t;
+  if (!transition_pop(&t)) {
+    *out_msg = g_timer.current_split > 0
+      ? g_strdup_printf("Only the last %d splits can be undone", TRANSITION_RING_SIZE)
+      : g_strdup("No split to undo");
+    return FALSE;
+  }
+
+  if (g_timer.state == STATE_FINISHED) {
+    unrecord_attempt();
+    g_timer.state = STATE_RUNNING;
   }
+  g_array_set_size(g_timer.split_us, (guint)t.split_index);
+  if (g_timer.game_time_used) g_array_set_size(g_timer.split_game_us, (guint)t.split_index);
+  g_timer.current_split = t.split_index;
+  // A split pressed again right away is meant, not a bounce of the undone one
+  g_last_split_input_us = 0;
+  emit_timer_event("undo", timer_time_us(), t.split_index, LIVESPIFF_NO_TIME);
+  *out_msg = g_strdup_printf(t.kind == TRANSITION_SKIP ? "Undid the skip of split %d" : "Undid split %d",
+                             t.split_index + 1);
+  return TRUE;
 }
 
-static void timer_start_or_split(void) {
-  if (g_timer.state == STATE_IDLE) timer_start();
-  else if (g_timer.state == STATE_RUNNING) timer_split();
+static void timer_start_or_split(gint64 at_us) {
+  if (g_timer.state == STATE_IDLE) timer_start(at_us);
+  else if (g_timer.state == STATE_RUNNING) timer_split(at_us);
 }
 
-static void timer_toggle_pause(void) {
+static void timer_toggle_pause(gint64 at_us) {
   if (g_timer.state == STATE_RUNNING) {
-    g_timer.paused_elapsed_us = timer_elapsed_us();
-    g_timer.paused_at_us = g_get_monotonic_time();
+    g_timer.paused_elapsed_us = timer_elapsed_at_us(at_us);
+    g_timer.paused_at_us = at_us;
     g_timer.state = STATE_PAUSED;
+    emit_timer_event("pause", timer_time_us(), -1, LIVESPIFF_NO_TIME);
   } else if (g_timer.state == STATE_PAUSED) {
-    gint64 now = g_get_monotonic_time();
+    gint64 now = MAX(at_us, g_timer.paused_at_us);
     g_timer.total_paused_us += (now - g_timer.paused_at_us);
     g_timer.paused_at_us = 0;
     g_timer.state = STATE_RUNNING;
+    emit_timer_event("resume", timer_time_us(), -1, LIVESPIFF_NO_TIME);
   }
 }
 
 static void timer_reset(void) {
+  if (g_timer.state == STATE_IDLE) return;
+
+  // A finished attempt was already recorded when it finished
+  if (g_timer.state == STATE_RUNNING || g_timer.state == STATE_PAUSED) record_attempt(FALSE);
+  gint64 reset_at_us = timer_time_us();
+  int reset_split = g_timer.current_split;
+
   g_timer.state = STATE_IDLE;
   g_timer.start_monotonic_us = 0;
   g_timer.paused_at_us = 0;
   g_timer.total_paused_us = 0;
   g_timer.paused_elapsed_us = 0;
   g_timer.current_split = 0;
+  if (g_timer.split_us) g_array_set_size(g_timer.split_us, 0);
+  transitions_clear();
+  // Loading follows the game and outlives the attempt; a manual pause does not
+  g_timer.game_time_paused = FALSE;
+  g_timer.game_time_used = FALSE;
+  g_timer.game_offset_us = 0;
+  g_timer.game_stopped_at_us = -1;
+  emit_timer_event("reset", reset_at_us, reset_split, LIVESPIFF_NO_TIME);
 }
 
 // Apply run data (segments length) to timer
@@ -127,41 +674,662 @@ static void apply_run_to_timer(void) {
   if (g_timer.current_split > g_timer.split_count) g_timer.current_split = 0;
 }
 
-static const gchar introspection_xml[] =
-  "<node>"
-  "  <interface name='com.livespiff.LiveSpiff.Control'>"
-  "    <method name='StartOrSplit'/>"
-  "    <method name='TogglePause'/>"
-  "    <method name='Reset'/>"
-  "    <method name='ElapsedMs'>"
-  "      <arg type='x' name='ms' direction='out'/>"
-  "    </method>"
-  "    <method name='State'>"
-  "      <arg type='s' name='state' direction='out'/>"
-  "    </method>"
-  "    <method name='CurrentSplit'>"
-  "      <arg type='i' name='index' direction='out'/>"
-  "    </method>"
-  "    <method name='SplitCount'>"
-  "      <arg type='i' name='count' direction='out'/>"
-  "    </method>"
-  "    <method name='LoadRun'>"
-  "      <arg type='s' name='path' direction='in'/>"
-  "      <arg type='b' name='ok' direction='out'/>"
-  "      <arg type='s' name='message' direction='out'/>"
-  "    </method>"
-  "    <method name='SaveRun'>"
-  "      <arg type='s' name='path' direction='in'/>"
-  "      <arg type='b' name='ok' direction='out'/>"
-  "      <arg type='s' name='message' direction='out'/>"
-  "    </method>"
-  "    <method name='GetRunJson'>"
-  "      <arg type='s' name='json' direction='out'/>"
-  "    </method>"
-  "  </interface>"
-  "</node>";
-
-static GDBusNodeInfo *introspection_data = NULL;
+// Practice tries are timed in real time only
+static void feed_practice_time(guint segment, gint64 time_us, gpointer user_data) {
+  (void)user_data;
+  comparisons_add_segment_time(g_real_comparisons, segment, time_us);
+}
+
+// Both sets from scratch; the game one only if game time is selected
+static void build_comparisons(const GPtrArray *attempts, const char *active_name) {
+  comparisons_free(g_real_comparisons);
+  comparisons_free(g_game_comparisons);
+  g_real_comparisons = comparisons_build(g_run, attempts, active_name, TIMING_REAL);
+  g_game_comparisons = g_timing == TIMING_GAME ? comparisons_build(g_run, attempts, active_name, TIMING_GAME) : NULL;
+  g_comparisons = g_timing == TIMING_GAME ? g_game_comparisons : g_real_comparisons;
+}
+
+// Switch the clock; the game set is built from history on first use, and
+// the active comparison is kept by name
+static void set_timing_method(TimingMethod method) {
+  if (method == g_timing) return;
+  char *active = g_strdup(comparisons_active_name(g_comparisons));
+  g_timing = method;
+  if (method == TIMING_GAME && !g_game_comparisons) {
+    g_game_comparisons = comparisons_build(g_run, g_history, active, TIMING_GAME);
+  }
+  g_comparisons = method == TIMING_GAME ? g_game_comparisons : g_real_comparisons;
+  comparisons_set_active(g_comparisons, active);
+  g_free(active);
+
+  g_free(g_config.timing_method);
+  g_config.timing_method = g_strdup(timing_method_to_string(method));
+  daemon_config_save(&g_config);
+  emit_timer_event("timing", timer_time_us(), -1, LIVESPIFF_NO_TIME);
+}
+
+// Practice results of run_path; opted-in ones go into the fresh comparisons
+static void load_practice(const char *run_path) {
+  practice_free(g_practice);
+  g_practice = practice_new(g_comparisons->n_segments, g_config.practice_ring_size);
+
+  char *path = practice_log_path(run_path);
+  char *err_str = NULL;
+  if (!practice_load(g_practice, path, feed_practice_time, NULL, &err_str)) {
+    g_printerr("%s\n", err_str ? err_str : "Failed to load practice log");
+    g_free(err_str);
+  }
+  g_free(path);
+}
+
+// (Re)load the history for run_path and rebuild all comparisons from it
+static void load_history(const char *run_path) {
+  GPtrArray *attempts = NULL;
+  char *hist_path = run_history_path(run_path);
+  char *err_str = NULL;
+
+  if (!history_load(hist_path, &attempts, &err_str)) {
+    g_printerr("%s\n", err_str ? err_str : "Failed to load history");
+    g_free(err_str);
+    attempts = g_ptr_array_new_with_free_func((GDestroyNotify)attempt_free);
+  }
+  g_free(hist_path);
+
+  char *active = g_comparisons ? g_strdup(comparisons_active_name(g_comparisons)) : NULL;
+  build_comparisons(attempts, active);
+  g_free(active);
+
+  if (g_history) g_ptr_array_free(g_history, TRUE);
+  g_history = attempts;
+  g_ptr_array_set_size(g_history_cached, 0);
+  g_history_revision++;
+#ifdef LIVESPIFF_HAVE_SQLITE
+  history_db_sync_run(g_history_db, run_path, g_run, g_history);
+#endif
+  load_practice(run_path);
+}
+
+// Last run from the state cache, or from its files if the cache is stale;
+// the built-in default run if there was none
+static void restore_last_run(void) {
+  gint64 t0 = g_get_monotonic_time();
+  char *path = state_cache_path();
+  LiveSpiffWarmState warm;
+  StateCacheResult result = state_cache_load(path, &warm);
+  g_free(path);
+
+  if (result == STATE_CACHE_FRESH) {
+    run_free(g_run);
+    g_run = g_steal_pointer(&warm.run);
+    g_run_path = g_strdup(warm.run_path);
+    apply_run_to_timer();
+    build_comparisons(warm.attempts, warm.active_comparison);
+    g_ptr_array_free(g_history, TRUE);
+    g_history = g_steal_pointer(&warm.attempts);
+    g_ptr_array_set_size(g_history_cached, 0);
+    g_history_revision++;
+#ifdef LIVESPIFF_HAVE_SQLITE
+    history_db_sync_run(g_history_db, g_run_path, g_run, g_history);
+#endif
+    load_practice(g_run_path);
+    g_restored_from = "cache";
+  } else if (result == STATE_CACHE_STALE) {
+    LiveSpiffRun *loaded = NULL;
+    char *err_str = NULL;
+    if (run_load_json(warm.run_path, &loaded, &err_str)) {
+      run_free(g_run);
+      g_run = loaded;
+      g_run_path = g_strdup(warm.run_path);
+      apply_run_to_timer();
+      load_history(g_run_path);
+      if (warm.active_comparison) comparisons_set_active(g_comparisons, warm.active_comparison);
+      schedule_state_save(STATE_SAVE_RUN | STATE_SAVE_COMPARISON);
+      g_restored_from = "json";
+    } else {
+      g_printerr("Not restoring last run: %s\n", err_str ? err_str : warm.run_path);
+      g_free(err_str);
+    }
+  }
+  state_cache_clear(&warm);
+  g_restore_us = g_get_monotonic_time() - t0;
+}
+
+// History export runs on a worker thread with its own copies of the inputs,
+// so the timer and D-Bus stay responsive while large logs are written.
+typedef struct {
+  char *history_path;
+  char **segments;
+  char *out_path;
+  HistoryExportFormat format;
+  guint64 rows;
+} ExportJob;
+
+static void export_job_free(gpointer data) {
+  ExportJob *job = (ExportJob*)data;
+  g_free(job->history_path);
+  g_strfreev(job->segments);
+  g_free(job->out_path);
+  g_free(job);
+}
+
+static void export_history_thread(GTask *task, gpointer source, gpointer task_data, GCancellable *cancellable) {
+  (void)source; (void)cancellable;
+  ExportJob *job = (ExportJob*)task_data;
+  char *err_str = NULL;
+  if (history_export(job->history_path, (const char * const *)job->segments, g_strv_length(job->segments),
+                     job->out_path, job->format, &job->rows, &err_str)) {
+    g_task_return_boolean(task, TRUE);
+  } else {
+    g_task_return_new_error(task, G_IO_ERROR, G_IO_ERROR_FAILED, "%s", err_str ? err_str : "Export failed");
+    g_free(err_str);
+  }
+}
+
+static void on_export_history_done(GObject *source, GAsyncResult *res, gpointer user_data) {
+  (void)source;
+  GDBusMethodInvocation *invocation = (GDBusMethodInvocation*)user_data;
+  ExportJob *job = (ExportJob*)g_task_get_task_data(G_TASK(res));
+  GError *err = NULL;
+
+  if (g_task_propagate_boolean(G_TASK(res), &err)) {
+    char *msg = g_strdup_printf("Exported %" G_GUINT64_FORMAT " attempts to %s", job->rows, job->out_path);
+    g_dbus_method_invocation_return_value(invocation, g_variant_new("(bs)", TRUE, msg));
+    g_free(msg);
+  } else {
+    g_dbus_method_invocation_return_value(invocation, g_variant_new("(bs)", FALSE, err->message));
+    g_error_free(err);
+  }
+}
+
+static void export_history_async(const char *out_path, HistoryExportFormat format, GDBusMethodInvocation *invocation) {
+  ExportJob *job = g_new0(ExportJob, 1);
+  job->history_path = run_history_path(g_run_path);
+  job->segments = g_new0(char*, g_run->segments->len + 1);
+  for (guint i = 0; i < g_run->segments->len; i++) {
+    job->segments[i] = g_strdup(g_ptr_array_index(g_run->segments, i));
+  }
+  job->out_path = g_strdup(out_path);
+  job->format = format;
+
+  GTask *task = g_task_new(NULL, NULL, on_export_history_done, invocation);
+  g_task_set_task_data(task, job, export_job_free);
+  g_task_run_in_thread(task, export_history_thread);
+  g_object_unref(task);
+}
+
+// Library statistics: the whole collection runs on a worker thread, which
+// fans the files out over stats_collect()'s thread pool.
+static void library_stats_thread(GTask *task, gpointer source, gpointer task_data, GCancellable *cancellable) {
+  (void)source; (void)cancellable;
+  g_task_return_pointer(task, stats_collect((const char*)task_data, 0), (GDestroyNotify)stats_free);
+}
+
+// (uutttuua(ssstttuux)): files, errors, attempts, finished, play time ms, pbs, golds;
+// per run: path, game, category, attempts, finished, play time ms, pbs, golds, pb ms
+static void on_library_stats_done(GObject *source, GAsyncResult *res, gpointer user_data) {
+  (void)source;
+  GDBusMethodInvocation *invocation = (GDBusMethodInvocation*)user_data;
+  GError *err = NULL;
+  LiveSpiffStats *stats = g_task_propagate_pointer(G_TASK(res), &err);
+  if (!stats) {
+    g_dbus_method_invocation_return_dbus_error(invocation, "com.livespiff.LiveSpiff.Error.Failed",
+                                               err ? err->message : "Failed to collect statistics");
+    g_clear_error(&err);
+    return;
+  }
+
+  GVariantBuilder runs;
+  g_variant_builder_init(&runs, G_VARIANT_TYPE("a(ssstttuux)"));
+  for (guint i = 0; i < stats->runs->len; i++) {
+    const LiveSpiffRunStats *rs = g_ptr_array_index(stats->runs, i);
+    g_variant_builder_add(&runs, "(ssstttuux)",
+                          rs->path, rs->game ? rs->game : "", rs->category ? rs->category : "",
+                          (guint64)rs->totals.attempts, (guint64)rs->totals.finished,
+                          (guint64)(rs->totals.play_time_us / 1000),
+                          (guint32)rs->totals.pbs, (guint32)rs->totals.golds, us_to_ms(rs->pb_us));
+  }
+
+  const LiveSpiffStatsTotals *t = &stats->totals;
+  g_dbus_method_invocation_return_value(invocation,
+    g_variant_new("(uutttuua(ssstttuux))", (guint32)stats->files, (guint32)stats->errors,
+                  (guint64)t->attempts, (guint64)t->finished, (guint64)(t->play_time_us / 1000),
+                  (guint32)t->pbs, (guint32)t->golds, &runs));
+  stats_free(stats);
+}
+
+// a(saxx): per comparison -> name, delta per completed split, live delta
+static GVariant* build_deltas_variant(void) {
+  GVariantBuilder b;
+  g_variant_builder_init(&b, G_VARIANT_TYPE("a(saxx)"));
+
+  gint64 elapsed = timer_time_us();
+  const GArray *times = timer_splits();
+  guint done = times ? times->len : 0;
+  gboolean live = (g_timer.state == STATE_RUNNING || g_timer.state == STATE_PAUSED);
+
+  for (guint k = 0; k < g_comparisons->names->len; k++) {
+    GVariantBuilder splits;
+    g_variant_builder_init(&splits, G_VARIANT_TYPE("ax"));
+    for (guint i = 0; i < done; i++) {
+      gint64 t = g_array_index(times, gint64, i);
+      g_variant_builder_add(&splits, "x", us_to_ms(comparisons_delta_us(g_comparisons, k, i, t)));
+    }
+
+    gint64 live_delta = live
+      ? comparisons_delta_us(g_comparisons, k, (guint)g_timer.current_split, elapsed)
+      : LIVESPIFF_NO_TIME;
+
+    g_variant_builder_add(&b, "(saxx)",
+                          (const char*)g_ptr_array_index(g_comparisons->names, k),
+                          &splits,
+                          us_to_ms(live_delta));
+  }
+
+  return g_variant_builder_end(&b);
+}
+
+// ListAttempts: (bsuua(uxbxub)) ok, message, revision, total; per row: attempt id,
+// started at (unix us), finished, final or reset ms, splits reached, PB
+static void list_attempts(const char *sort_name, const char *filter_name, guint32 offset, guint32 limit,
+                          GDBusMethodInvocation *invocation) {
+  HistorySort sort;
+  HistoryFilter filter;
+  GVariantBuilder rows;
+  g_variant_builder_init(&rows, G_VARIANT_TYPE("a(uxbxub)"));
+
+  const char *err = NULL;
+  if (!history_sort_from_string(sort_name, &sort)) err = "Unknown sort (expected newest, oldest, fastest or slowest)";
+  else if (!history_filter_from_string(filter_name, &filter)) err = "Unknown filter (expected all, finished, reset or pb)";
+  if (err) {
+    g_dbus_method_invocation_return_value(invocation,
+      g_variant_new("(bsuua(uxbxub))", FALSE, err, (guint32)g_history_revision, 0u, &rows));
+    return;
+  }
+
+  LiveSpiffHistoryView *v = g_history_view;
+  guint n_segments = g_run->segments->len;
+  if (!v || v->revision != g_history_revision || v->sort != sort || v->filter != filter || v->method != g_timing ||
+      v->n_segments != n_segments) {
+    history_view_free(g_history_view);
+    g_history_view = v = history_view_build(g_history, g_history_revision, sort, filter, g_timing, n_segments);
+  }
+
+  limit = MIN(limit, LIST_ATTEMPTS_LIMIT);
+  for (guint r = offset; r < v->order->len && r - offset < limit; r++) {
+    guint id = g_array_index(v->order, guint, r);
+    const LiveSpiffAttempt *a = (const LiveSpiffAttempt*)g_ptr_array_index(g_history, id);
+    g_variant_builder_add(&rows, "(uxbxub)", (guint32)id, a->started_at_us, a->finished,
+                          us_to_ms(history_attempt_time_us(a, g_timing)), (guint32)a->split_us->len,
+                          g_array_index(v->pb, gboolean, id));
+  }
+  g_dbus_method_invocation_return_value(invocation,
+    g_variant_new("(bsuua(uxbxub))", TRUE, "", (guint32)g_history_revision, (guint32)v->order->len, &rows));
+}
+
+// AttemptSplits: (ba(sxx)) per segment: name, split ms, segment ms
+static GVariant* build_attempt_splits_variant(guint32 id) {
+  GVariantBuilder b;
+  g_variant_builder_init(&b, G_VARIANT_TYPE("a(sxx)"));
+  if (id >= g_history->len) return g_variant_new("(ba(sxx))", FALSE, &b);
+
+  const LiveSpiffAttempt *a = (const LiveSpiffAttempt*)g_ptr_array_index(g_history, id);
+  gint64 prev = 0;
+  for (guint i = 0; i < a->split_us->len; i++) {
+    gint64 t = attempt_time_us(a, g_timing, i);
+    const char *name = g_run && i < g_run->segments->len ? (const char*)g_ptr_array_index(g_run->segments, i) : "";
+    gint64 seg = (t == LIVESPIFF_NO_TIME || prev == LIVESPIFF_NO_TIME) ? LIVESPIFF_NO_TIME : t - prev;
+    g_variant_builder_add(&b, "(sxx)", name, us_to_ms(t), us_to_ms(seg));
+    prev = t;
+  }
+  return g_variant_new("(ba(sxx))", TRUE, &b);
+}
+
+// a(sssuxux): path, game, category, segments, pb ms, attempts, mtime (unix us)
+static GVariant* build_runs_variant(GPtrArray *entries) {
+  GVariantBuilder b;
+  g_variant_builder_init(&b, G_VARIANT_TYPE("a(sssuxux)"));
+  for (guint i = 0; i < entries->len; i++) {
+    const LiveSpiffLibraryEntry *e = g_ptr_array_index(entries, i);
+    g_variant_builder_add(&b, "(sssuxux)",
+                          e->path, e->game, e->category,
+                          (guint32)e->segment_count, us_to_ms(e->pb_us),
+                          (guint32)e->attempt_count, e->mtime_us);
+  }
+  return g_variant_builder_end(&b);
+}
+
+static gboolean on_library_sync_idle(gpointer user_data) {
+  (void)user_data;
+  library_sync(g_library);
+  return G_SOURCE_REMOVE;
+}
+
+static void on_game_process(gboolean running, int pid, const char *name, gpointer user_data) {
+  (void)user_data;
+  g_print("Game process %s: %s (pid %d)\n", running ? "started" : "exited", name, pid);
+
+  if (running && g_config.auto_start && g_timer.state == STATE_IDLE) timer_start(g_get_monotonic_time());
+  if (!running && g_config.auto_pause_on_exit && g_timer.state == STATE_RUNNING) timer_toggle_pause(g_get_monotonic_time());
+
+  // Autosplitters attach on this signal
+  emit_signal("GameProcessChanged", g_variant_new("(bis)", running, (gint32)pid, name ? name : ""));
+}
+
+// The tracker can find the game before the bus is up, when a signal would be
+// dropped; repeated once the connection exists
+static void emit_game_process_state(void) {
+  if (!g_tracker || !g_tracker->target) return;
+  emit_signal("GameProcessChanged",
+              g_variant_new("(bis)", g_tracker->pid > 0, (gint32)g_tracker->pid, g_tracker->target));
+}
+
+// daemon.ini [process] name wins, then the window picked in the UI
+static void start_process_tracking(void) {
+  LiveSpiffUiSettings ui = ui_settings_load();
+  const char *name = (g_config.process_name && g_config.process_name[0]) ? g_config.process_name : ui.picked_classname;
+  proctrack_set_target(g_tracker, name, ui.picked_pid);
+  ui_settings_free_fields(&ui);
+}
+
+/* ------------------------- latency calibration ------------------------- */
+
+// Source names become daemon.ini keys
+static gboolean is_valid_source(const char *source) {
+  if (!source || !*source || strlen(source) > 64) return FALSE;
+  for (const char *p = source; *p; p++) {
+    if (!g_ascii_isalnum(*p) && *p != '-' && *p != '_' && *p != '.') return FALSE;
+  }
+  return TRUE;
+}
+
+static void calibration_stop(gboolean cancelled) {
+  if (!g_calibration) return;
+  if (g_calibration_tick_id) g_source_remove(g_calibration_tick_id);
+  g_calibration_tick_id = 0;
+
+  gint64 offset = 0, jitter = 0;
+  guint taps = 0;
+  gboolean ok = !cancelled && calibration_result(g_calibration, &offset, &jitter, &taps);
+  if (ok) {
+    daemon_config_set_latency(&g_config, g_calibration->source, offset, jitter);
+    daemon_config_save(&g_config);
+  }
+
+  emit_signal("CalibrationFinished",
+              g_variant_new("(sbxxu)", g_calibration->source, ok, offset, jitter, (guint32)taps));
+  calibration_free(g_calibration);
+  g_calibration = NULL;
+}
+
+// Announces each beat as its time comes, then finishes half a beat after the last.
+// Beat times are fixed by the schedule, so late wakeups do not skew the taps.
+static gboolean on_calibration_tick(gpointer user_data) {
+  (void)user_data;
+  g_calibration_tick_id = 0;
+  LiveSpiffCalibration *c = g_calibration;
+  gint64 now = g_get_monotonic_time();
+
+  while (g_calibration_beat < c->beats && calibration_beat_us(c, g_calibration_beat) <= now + 500) {
+    emit_signal("CalibrationTick", g_variant_new("(uux)", (guint32)g_calibration_beat, (guint32)c->beats,
+                                                 calibration_beat_us(c, g_calibration_beat)));
+    g_calibration_beat++;
+  }
+
+  gint64 next = g_calibration_beat < c->beats ? calibration_beat_us(c, g_calibration_beat) : calibration_end_us(c);
+  if (g_calibration_beat >= c->beats && now >= next) {
+    calibration_stop(FALSE);
+    return G_SOURCE_REMOVE;
+  }
+
+  g_calibration_tick_id = g_timeout_add((guint)MAX((next - now) / 1000, 0), on_calibration_tick, NULL);
+  return G_SOURCE_REMOVE;
+}
+
+static gboolean calibration_begin(const char *source, guint interval_ms, guint beats, char **out_msg) {
+  if (!is_valid_source(source)) {
+    *out_msg = g_strdup("Invalid source name (letters, digits, '-', '_', '.')");
+    return FALSE;
+  }
+  if (g_timer.state == STATE_RUNNING || g_timer.state == STATE_PAUSED) {
+    *out_msg = g_strdup("Reset the timer before calibrating");
+    return FALSE;
+  }
+  if (practice_active()) {
+    *out_msg = g_strdup("Stop practising before calibrating");
+    return FALSE;
+  }
+  calibration_stop(TRUE);
+
+  gint64 interval_us = (gint64)CLAMP(interval_ms ? interval_ms : 500, 250, 2000) * 1000;
+  beats = CLAMP(beats ? beats : 24, 8, 128);
+
+  // Two beats of lead-in before the first one
+  gint64 first = g_get_monotonic_time() + 2 * interval_us;
+  g_calibration = calibration_new(source, first, interval_us, beats);
+  g_calibration_beat = 0;
+  g_calibration_tick_id = g_timeout_add((guint)(2 * interval_us / 1000), on_calibration_tick, NULL);
+
+  *out_msg = g_strdup_printf("Tap along with %u beats using input '%s'", beats, source);
+  return TRUE;
+}
+
+/* ------------------------- segment practice ------------------------- */
+
+static const char* practice_phase_to_string(PracticePhase phase) {
+  switch (phase) {
+    case PRACTICE_ARMED: return "armed";
+    case PRACTICE_TIMING: return "timing";
+    case PRACTICE_OFF:
+    default: return "off";
+  }
+}
+
+// (suuux): phase, first, last, current segment, monotonic start of current
+static GVariant* build_practice_state_variant(void) {
+  PracticePhase phase = g_practice ? g_practice->phase : PRACTICE_OFF;
+  return g_variant_new("(suuux)", practice_phase_to_string(phase),
+                       (guint32)(g_practice ? g_practice->first : 0), (guint32)(g_practice ? g_practice->last : 0),
+                       (guint32)(g_practice ? g_practice->current : 0),
+                       phase == PRACTICE_TIMING ? g_practice->segment_start_us : (gint64)0);
+}
+
+static void emit_practice_state(void) {
+  emit_signal("PracticeState", build_practice_state_variant());
+}
+
+// One finished (time) or abandoned (LIVESPIFF_NO_TIME) try of a segment
+static void practice_result(guint segment, gint64 time_us) {
+  practice_record(g_practice, segment, time_us);
+
+  if (g_run_path) {
+    char *path = practice_log_path(g_run_path);
+    char *err_str = NULL;
+    if (!practice_append(path, g_get_real_time(), segment, time_us, g_practice->feed, &err_str)) {
+      g_printerr("%s\n", err_str ? err_str : "Failed to append practice log");
+      g_free(err_str);
+    }
+    g_free(path);
+  }
+
+  const PracticeSegment *ps = &g_practice->segments[segment];
+  emit_signal("PracticeResult", g_variant_new("(uxuuxx)", (guint32)segment, us_to_ms(time_us),
+                                              (guint32)ps->count, (guint32)ps->ring_successes,
+                                              us_to_ms(ps->best_us), us_to_ms(practice_recent_average_us(ps))));
+
+  if (g_practice->feed && time_us != LIVESPIFF_NO_TIME) {
+    comparisons_add_segment_time(g_real_comparisons, segment, time_us);
+    emit_timer_event("comparison", timer_time_us(), -1, LIVESPIFF_NO_TIME);
+  }
+}
+
+static void practice_input_split(gint64 at_us) {
+  guint segment = 0;
+  gint64 time_us = 0;
+  if (practice_split(g_practice, at_us, &segment, &time_us)) practice_result(segment, time_us);
+  emit_practice_state();
+}
+
+// Instant reset: the try counts as failed and the range is armed again
+static void practice_input_reset(void) {
+  guint segment = 0;
+  if (practice_abort(g_practice, &segment)) practice_result(segment, LIVESPIFF_NO_TIME);
+  emit_practice_state();
+}
+
+static gboolean practice_start(guint first, guint last, gboolean feed, char **out_msg) {
+  if (g_calibration) {
+    *out_msg = g_strdup("Finish calibrating first");
+    return FALSE;
+  }
+  if (g_timer.state != STATE_IDLE) {
+    *out_msg = g_strdup("Reset the timer before practising");
+    return FALSE;
+  }
+  if (first > last || last >= g_practice->n_segments) {
+    *out_msg = g_strdup_printf("Segment range must lie within 0..%u", g_practice->n_segments ? g_practice->n_segments - 1 : 0);
+    return FALSE;
+  }
+
+  // Switching ranges mid-try abandons the try
+  if (practice_active()) practice_input_reset();
+  practice_begin(g_practice, first, last, feed);
+  emit_practice_state();
+  *out_msg = first == last
+    ? g_strdup_printf("Practising segment %u", first + 1)
+    : g_strdup_printf("Practising segments %u-%u", first + 1, last + 1);
+  return TRUE;
+}
+
+static void practice_stop(void) {
+  if (!practice_active()) return;
+  practice_input_reset();
+  practice_end(g_practice);
+  emit_practice_state();
+}
+
+// Double-press guard: an input closer than [timer] double_press_guard_ms to
+// the last accepted one of the same action is a bounce (a chattering key, or
+// two input paths for one press) whatever its source, and is dropped
+static gboolean input_bounced(gint64 *last_at_us, gint64 at_us, const char *source) {
+  gint64 guard_us = (gint64)g_config.double_press_guard_ms * 1000;
+  if (guard_us <= 0) return FALSE;
+  if (*last_at_us && at_us - *last_at_us < guard_us) {
+    g_print("Dropped input from %s %.1f ms after the previous one\n", source, (at_us - *last_at_us) / 1000.0);
+    return TRUE;
+  }
+  *last_at_us = at_us;
+  return FALSE;
+}
+
+// Timestamped inputs: taps while calibrating, practice tries while
+// practising, timer transitions otherwise
+static void input_start_or_split(const char *source, gint64 arrival_us) {
+  if (g_calibration) {
+    if (g_strcmp0(source, g_calibration->source) == 0) calibration_tap(g_calibration, arrival_us);
+    return;
+  }
+  gint64 at_us = input_time_us(source, arrival_us);
+  if (input_bounced(&g_last_split_input_us, at_us, source)) return;
+  if (practice_active()) {
+    practice_input_split(at_us);
+    return;
+  }
+  timer_start_or_split(at_us);
+}
+
+// Pause has no meaning for a practice try
+static void input_toggle_pause(const char *source, gint64 arrival_us) {
+  if (g_calibration || practice_active()) return;
+  gint64 at_us = input_time_us(source, arrival_us);
+  if (input_bounced(&g_last_pause_input_us, at_us, source)) return;
+  timer_toggle_pause(at_us);
+}
+
+static void input_reset(void) {
+  if (practice_active()) practice_input_reset();
+  else timer_reset();
+}
+
+/* ------------------------- evdev hotkeys ------------------------- */
+
+static void on_evdev_hotkey(HotkeyAction action, gint64 timestamp_us, gpointer user_data) {
+  (void)user_data;
+  switch (action) {
+    case HOTKEY_START_SPLIT: input_start_or_split(EVDEV_INPUT_SOURCE, timestamp_us); break;
+    case HOTKEY_PAUSE: input_toggle_pause(EVDEV_INPUT_SOURCE, timestamp_us); break;
+    case HOTKEY_RESET: if (!g_calibration) input_reset(); break;
+    default: break;
+  }
+}
+
+static void start_evdev_hotkeys(void) {
+  if (!g_config.hotkey_devices || !g_config.hotkey_devices[0]) return;
+
+  HotkeyChord chords[HOTKEY_ACTION_COUNT] = {0};
+  const char *bindings[HOTKEY_ACTION_COUNT] = {
+    [HOTKEY_START_SPLIT] = g_config.hotkey_start_split,
+    [HOTKEY_PAUSE] = g_config.hotkey_pause,
+    [HOTKEY_RESET] = g_config.hotkey_reset,
+  };
+  gboolean any = FALSE;
+  for (guint a = HOTKEY_NONE + 1; a < HOTKEY_ACTION_COUNT; a++) {
+    if (!bindings[a] || !*bindings[a]) continue;
+    if (hotkey_chord_parse(bindings[a], &chords[a])) any = TRUE;
+    else g_printerr("evdev hotkeys: unknown key in %s=%s\n", hotkey_action_name((HotkeyAction)a), bindings[a]);
+  }
+  if (!any) return;
+
+  char *err_str = NULL;
+  g_hotkeys = hotkey_reader_start(g_config.hotkey_devices, chords, on_evdev_hotkey, NULL, &err_str);
+  if (err_str) g_printerr("evdev hotkeys: %s\n", err_str);
+  g_free(err_str);
+}
+
+/* ------------------------- global shortcuts ------------------------- */
+
+static void on_global_shortcut(HotkeyAction action, gint64 timestamp_us, gpointer user_data) {
+  (void)user_data;
+  switch (action) {
+    case HOTKEY_START_SPLIT: input_start_or_split(SHORTCUT_INPUT_SOURCE, timestamp_us); break;
+    case HOTKEY_PAUSE: input_toggle_pause(SHORTCUT_INPUT_SOURCE, timestamp_us); break;
+    case HOTKEY_RESET: if (!g_calibration) input_reset(); break;
+    default: break;
+  }
+}
+
+// Preferred keys come from the UI's Hotkeys window (ui.ini [hotkeys])
+static void load_shortcut_triggers(LiveSpiffUiSettings *ui, const char *triggers[HOTKEY_ACTION_COUNT]) {
+  *ui = ui_settings_load();
+  triggers[HOTKEY_NONE] = NULL;
+  triggers[HOTKEY_START_SPLIT] = ui->hotkey_start_split;
+  triggers[HOTKEY_PAUSE] = ui->hotkey_pause;
+  triggers[HOTKEY_RESET] = ui->hotkey_reset;
+}
+
+static void start_global_shortcuts(GDBusConnection *connection) {
+  LiveSpiffShortcutsBackend backend = shortcuts_backend_from_string(g_config.shortcuts_backend);
+  if (backend == SHORTCUTS_NONE || g_shortcuts) return;
+
+  LiveSpiffUiSettings ui;
+  const char *triggers[HOTKEY_ACTION_COUNT];
+  load_shortcut_triggers(&ui, triggers);
+  g_shortcuts = global_shortcuts_new(connection, backend, triggers, on_global_shortcut, NULL);
+  ui_settings_free_fields(&ui);
+}
+
+// a(sxx): source, offset us, jitter us
+static GVariant* build_latency_variant(void) {
+  GVariantBuilder b;
+  g_variant_builder_init(&b, G_VARIANT_TYPE("a(sxx)"));
+  GHashTableIter it;
+  gpointer key, value;
+  g_hash_table_iter_init(&it, g_config.latency);
+  while (g_hash_table_iter_next(&it, &key, &value)) {
+    const LiveSpiffLatency *l = (const LiveSpiffLatency*)value;
+    g_variant_builder_add(&b, "(sxx)", (const char*)key, l->offset_us, l->jitter_us);
+  }
+  return g_variant_builder_end(&b);
+}
 
 static void on_method_call(GDBusConnection *connection,
                            const gchar *sender,
@@ -175,30 +1343,56 @@ static void on_method_call(GDBusConnection *connection,
 
   // Timer controls
   if (g_strcmp0(method_name, "StartOrSplit") == 0) {
-    timer_start_or_split();
+    input_start_or_split(DEFAULT_INPUT_SOURCE, g_get_monotonic_time());
     g_dbus_method_invocation_return_value(invocation, NULL);
     return;
   }
   if (g_strcmp0(method_name, "TogglePause") == 0) {
-    timer_toggle_pause();
+    input_toggle_pause(DEFAULT_INPUT_SOURCE, g_get_monotonic_time());
+    g_dbus_method_invocation_return_value(invocation, NULL);
+    return;
+  }
+  if (g_strcmp0(method_name, "StartOrSplitFrom") == 0) {
+    const char *source = NULL;
+    g_variant_get(parameters, "(&s)", &source);
+    input_start_or_split(source, g_get_monotonic_time());
+    g_dbus_method_invocation_return_value(invocation, NULL);
+    return;
+  }
+  if (g_strcmp0(method_name, "TogglePauseFrom") == 0) {
+    const char *source = NULL;
+    g_variant_get(parameters, "(&s)", &source);
+    input_toggle_pause(source, g_get_monotonic_time());
     g_dbus_method_invocation_return_value(invocation, NULL);
     return;
   }
   if (g_strcmp0(method_name, "Reset") == 0) {
-    timer_reset();
+    input_reset();
     g_dbus_method_invocation_return_value(invocation, NULL);
     return;
   }
+  if (g_strcmp0(method_name, "UndoSplit") == 0 || g_strcmp0(method_name, "SkipSplit") == 0) {
+    char *msg = NULL;
+    gboolean ok;
+    if (practice_active()) {
+      ok = FALSE;
+      msg = g_strdup("Not while practising");
+    } else {
+      ok = g_strcmp0(method_name, "UndoSplit") == 0 ? timer_undo_split(&msg) : timer_skip_split(&msg);
+    }
+    g_dbus_method_invocation_return_value(invocation, g_variant_new("(bs)", ok, msg));
+    g_free(msg);
+    return;
+  }
 
   // Queries
   if (g_strcmp0(method_name, "ElapsedMs") == 0) {
-    gint64 ms = timer_elapsed_us() / 1000;
+    gint64 ms = timer_time_us() / 1000;
     g_dbus_method_invocation_return_value(invocation, g_variant_new("(x)", ms));
     return;
   }
   if (g_strcmp0(method_name, "State") == 0) {
-    const char *s = state_to_string(g_timer.state);
-    g_dbus_method_invocation_return_value(invocation, g_variant_new("(s)", s));
+    g_dbus_method_invocation_return_value(invocation, g_variant_new("(s)", timer_state_string()));
     return;
   }
   if (g_strcmp0(method_name, "CurrentSplit") == 0) {
@@ -209,6 +1403,83 @@ static void on_method_call(GDBusConnection *connection,
     g_dbus_method_invocation_return_value(invocation, g_variant_new("(i)", (gint32)g_timer.split_count));
     return;
   }
+  if (g_strcmp0(method_name, "Snapshot") == 0) {
+    // Both read at the same instant so clients can extrapolate from here
+    gint64 mono = g_get_monotonic_time();
+    gint64 ms = timer_time_at_us(mono) / 1000;
+    g_dbus_method_invocation_return_value(invocation, g_variant_new("(siixx)",
+      timer_state_string(), (gint32)g_timer.current_split, (gint32)g_timer.split_count, ms, mono));
+    return;
+  }
+  if (g_strcmp0(method_name, "Segments") == 0) {
+    GVariantBuilder names;
+    g_variant_builder_init(&names, G_VARIANT_TYPE("as"));
+    for (guint i = 0; g_run && i < g_run->segments->len; i++) {
+      g_variant_builder_add(&names, "s", (const char*)g_ptr_array_index(g_run->segments, i));
+    }
+    g_dbus_method_invocation_return_value(invocation, g_variant_new("(as)", &names));
+    return;
+  }
+  // Absolute icon path per segment, "" where there is none
+  if (g_strcmp0(method_name, "SegmentIcons") == 0) {
+    GVariantBuilder paths;
+    g_variant_builder_init(&paths, G_VARIANT_TYPE("as"));
+    char *run_dir = g_run_path ? g_path_get_dirname(g_run_path) : NULL;
+    for (guint i = 0; g_run && i < g_run->segments->len; i++) {
+      const char *icon = run_segment_icon(g_run, i);
+      char *path = !icon ? g_strdup("")
+        : (g_path_is_absolute(icon) || !run_dir) ? g_strdup(icon)
+        : g_build_filename(run_dir, icon, NULL);
+      g_variant_builder_add(&paths, "s", path);
+      g_free(path);
+    }
+    g_free(run_dir);
+    g_dbus_method_invocation_return_value(invocation, g_variant_new("(as)", &paths));
+    return;
+  }
+  if (g_strcmp0(method_name, "SplitTimesMs") == 0) {
+    GVariantBuilder times;
+    g_variant_builder_init(&times, G_VARIANT_TYPE("ax"));
+    const GArray *splits = timer_splits();
+    for (guint i = 0; splits && i < splits->len; i++) {
+      g_variant_builder_add(&times, "x", us_to_ms(g_array_index(splits, gint64, i)));
+    }
+    g_dbus_method_invocation_return_value(invocation, g_variant_new("(ax)", &times));
+    return;
+  }
+
+  // Game time
+  if (g_strcmp0(method_name, "SetLoading") == 0) {
+    gboolean loading = FALSE;
+    g_variant_get(parameters, "(b)", &loading);
+    timer_set_loading(loading, g_get_monotonic_time());
+    g_dbus_method_invocation_return_value(invocation, NULL);
+    return;
+  }
+  if (g_strcmp0(method_name, "PauseGameTime") == 0) {
+    gboolean paused = FALSE;
+    g_variant_get(parameters, "(b)", &paused);
+    timer_pause_game_time(paused, g_get_monotonic_time());
+    g_dbus_method_invocation_return_value(invocation, NULL);
+    return;
+  }
+  if (g_strcmp0(method_name, "SetTimingMethod") == 0) {
+    const char *name = NULL;
+    TimingMethod method;
+    g_variant_get(parameters, "(&s)", &name);
+    gboolean ok = timing_method_from_string(name, &method);
+    if (ok) set_timing_method(method);
+    g_dbus_method_invocation_return_value(invocation, g_variant_new("(b)", ok));
+    return;
+  }
+  // (sxxbb): method, real ms, game ms, loading, game time paused; read at one instant
+  if (g_strcmp0(method_name, "Clocks") == 0) {
+    gint64 real_us = timer_elapsed_us();
+    g_dbus_method_invocation_return_value(invocation, g_variant_new("(sxxbb)",
+      timing_method_to_string(g_timing), real_us / 1000, game_time_at_real_us(real_us) / 1000,
+      g_timer.loading, g_timer.game_time_paused));
+    return;
+  }
 
   // Run save/load
   if (g_strcmp0(method_name, "LoadRun") == 0) {
@@ -220,10 +1491,16 @@ static void on_method_call(GDBusConnection *connection,
 
     gboolean ok = run_load_json(path, &loaded, &err_str);
     if (ok) {
+      timer_reset(); // records a running attempt against the old run
+      practice_stop();
       run_free(g_run);
       g_run = loaded;
+      g_free(g_run_path);
+      g_run_path = g_strdup(path);
       apply_run_to_timer();
-      timer_reset();
+      load_history(g_run_path);
+      schedule_state_save(STATE_SAVE_RUN | STATE_SAVE_COMPARISON);
+      emit_timer_event("load", 0, -1, LIVESPIFF_NO_TIME);
       g_dbus_method_invocation_return_value(invocation, g_variant_new("(bs)", TRUE, "Run loaded"));
     } else {
       const char *msg = err_str ? err_str : "Failed to load run";
@@ -259,6 +1536,244 @@ static void on_method_call(GDBusConnection *connection,
     return;
   }
 
+  // History export (replied from the worker's completion callback)
+  if (g_strcmp0(method_name, "ExportHistory") == 0) {
+    const char *path = NULL, *format_name = NULL;
+    HistoryExportFormat format;
+    g_variant_get(parameters, "(&s&s)", &path, &format_name);
+
+    if (!g_run_path) {
+      g_dbus_method_invocation_return_value(invocation, g_variant_new("(bs)", FALSE, "No run file loaded"));
+    } else if (!history_export_format_from_string(format_name, &format)) {
+      g_dbus_method_invocation_return_value(invocation,
+        g_variant_new("(bs)", FALSE, "Unknown format (expected csv or columnar)"));
+    } else if (!path || !*path) {
+      g_dbus_method_invocation_return_value(invocation, g_variant_new("(bs)", FALSE, "No output path"));
+    } else {
+      export_history_async(path, format, invocation);
+    }
+    return;
+  }
+
+  // Comparisons
+  if (g_strcmp0(method_name, "SetComparison") == 0) {
+    const char *name = NULL;
+    g_variant_get(parameters, "(&s)", &name);
+    gboolean ok = comparisons_set_active(g_comparisons, name);
+    if (ok) {
+      schedule_state_save(STATE_SAVE_COMPARISON);
+      emit_timer_event("comparison", timer_time_us(), -1, LIVESPIFF_NO_TIME);
+    }
+    g_dbus_method_invocation_return_value(invocation, g_variant_new("(b)", ok));
+    return;
+  }
+
+  if (g_strcmp0(method_name, "ListComparisons") == 0) {
+    GVariantBuilder names;
+    g_variant_builder_init(&names, G_VARIANT_TYPE("as"));
+    for (guint i = 0; i < g_comparisons->names->len; i++) {
+      g_variant_builder_add(&names, "s", (const char*)g_ptr_array_index(g_comparisons->names, i));
+    }
+    g_dbus_method_invocation_return_value(invocation,
+      g_variant_new("(ass)", &names, comparisons_active_name(g_comparisons)));
+    return;
+  }
+
+  if (g_strcmp0(method_name, "ComparisonTimesMs") == 0) {
+    const char *name = NULL;
+    g_variant_get(parameters, "(&s)", &name);
+    int k = comparisons_find(g_comparisons, name);
+    GVariantBuilder times;
+    g_variant_builder_init(&times, G_VARIANT_TYPE("ax"));
+    for (guint i = 0; k >= 0 && i < g_comparisons->n_segments; i++) {
+      g_variant_builder_add(&times, "x", us_to_ms(comparisons_time_us(g_comparisons, (guint)k, i)));
+    }
+    g_dbus_method_invocation_return_value(invocation, g_variant_new("(bax)", k >= 0, &times));
+    return;
+  }
+
+  if (g_strcmp0(method_name, "Deltas") == 0) {
+    GVariant *deltas = build_deltas_variant();
+    g_dbus_method_invocation_return_value(invocation, g_variant_new_tuple(&deltas, 1));
+    return;
+  }
+
+  // Run library
+  if (g_strcmp0(method_name, "ListRuns") == 0) {
+    guint32 offset = 0, limit = 0;
+    g_variant_get(parameters, "(uu)", &offset, &limit);
+    GPtrArray *entries = library_list(g_library, offset, limit);
+    g_dbus_method_invocation_return_value(invocation,
+      g_variant_new("(u@a(sssuxux))", (guint32)library_count(g_library), build_runs_variant(entries)));
+    g_ptr_array_free(entries, TRUE);
+    return;
+  }
+
+  if (g_strcmp0(method_name, "SearchRuns") == 0) {
+    const char *query = NULL;
+    g_variant_get(parameters, "(&s)", &query);
+    GPtrArray *entries = library_search(g_library, query, SEARCH_RUNS_LIMIT);
+    g_dbus_method_invocation_return_value(invocation,
+      g_variant_new("(@a(sssuxux))", build_runs_variant(entries)));
+    g_ptr_array_free(entries, TRUE);
+    return;
+  }
+
+  // Attempt history of the loaded run
+  if (g_strcmp0(method_name, "ListAttempts") == 0) {
+    const char *sort = NULL, *filter = NULL;
+    guint32 offset = 0, limit = 0;
+    g_variant_get(parameters, "(&s&suu)", &sort, &filter, &offset, &limit);
+    list_attempts(sort, filter, offset, limit, invocation);
+    return;
+  }
+
+  if (g_strcmp0(method_name, "AttemptSplits") == 0) {
+    guint32 id = 0;
+    g_variant_get(parameters, "(u)", &id);
+    g_dbus_method_invocation_return_value(invocation, build_attempt_splits_variant(id));
+    return;
+  }
+
+  if (g_strcmp0(method_name, "LibraryStats") == 0) {
+    GTask *task = g_task_new(NULL, NULL, on_library_stats_done, invocation);
+    g_task_set_task_data(task, livespiff_runs_dir(), g_free);
+    g_task_run_in_thread(task, library_stats_thread);
+    g_object_unref(task);
+    return;
+  }
+
+  // Latency calibration
+  if (g_strcmp0(method_name, "CalibrationStart") == 0) {
+    const char *source = NULL;
+    guint32 interval_ms = 0, beats = 0;
+    g_variant_get(parameters, "(&suu)", &source, &interval_ms, &beats);
+    char *msg = NULL;
+    gboolean ok = calibration_begin(source, interval_ms, beats, &msg);
+    g_dbus_method_invocation_return_value(invocation, g_variant_new("(bsxxu)", ok, msg,
+      ok ? g_calibration->first_beat_us : (gint64)0,
+      ok ? g_calibration->interval_us : (gint64)0,
+      ok ? (guint32)g_calibration->beats : 0u));
+    g_free(msg);
+    return;
+  }
+
+  // Segment practice
+  if (g_strcmp0(method_name, "PracticeStart") == 0) {
+    guint32 first = 0, last = 0;
+    gboolean feed = FALSE;
+    g_variant_get(parameters, "(uub)", &first, &last, &feed);
+    char *msg = NULL;
+    gboolean ok = practice_start(first, last, feed, &msg);
+    g_dbus_method_invocation_return_value(invocation, g_variant_new("(bs)", ok, msg));
+    g_free(msg);
+    return;
+  }
+
+  if (g_strcmp0(method_name, "PracticeStop") == 0) {
+    practice_stop();
+    g_dbus_method_invocation_return_value(invocation, NULL);
+    return;
+  }
+
+  if (g_strcmp0(method_name, "PracticeStatus") == 0) {
+    g_dbus_method_invocation_return_value(invocation, build_practice_state_variant());
+    return;
+  }
+
+  // a(suuttxxx): name, tries and successes in the ring, lifetime tries and
+  // successes, best, average of the last PRACTICE_AVERAGE_OF, last (ms)
+  if (g_strcmp0(method_name, "PracticeStats") == 0) {
+    GVariantBuilder b;
+    g_variant_builder_init(&b, G_VARIANT_TYPE("a(suuttxxx)"));
+    for (guint i = 0; i < g_practice->n_segments; i++) {
+      const PracticeSegment *ps = &g_practice->segments[i];
+      const char *name = g_run && i < g_run->segments->len ? (const char*)g_ptr_array_index(g_run->segments, i) : "";
+      g_variant_builder_add(&b, "(suuttxxx)", name, (guint32)ps->count, (guint32)ps->ring_successes,
+                            (guint64)ps->tries, (guint64)ps->successes, us_to_ms(ps->best_us),
+                            us_to_ms(practice_recent_average_us(ps)), us_to_ms(ps->last_us));
+    }
+    g_dbus_method_invocation_return_value(invocation, g_variant_new("(a(suuttxxx))", &b));
+    return;
+  }
+
+  if (g_strcmp0(method_name, "CalibrationCancel") == 0) {
+    calibration_stop(TRUE);
+    g_dbus_method_invocation_return_value(invocation, NULL);
+    return;
+  }
+
+  if (g_strcmp0(method_name, "PluginStats") == 0) {
+    GArray *stats = plugin_host_stats(g_plugins);
+    GVariantBuilder b;
+    g_variant_builder_init(&b, G_VARIANT_TYPE("a(sssuuuttx)"));
+    for (guint i = 0; i < stats->len; i++) {
+      const LiveSpiffPluginStats *ps = &g_array_index(stats, LiveSpiffPluginStats, i);
+      g_variant_builder_add(&b, "(sssuuuttx)", ps->name, ps->path, ps->state, ps->capacity, ps->depth,
+                            ps->high_water, (guint64)ps->delivered, (guint64)ps->dropped, ps->busy_us / 1000);
+    }
+    plugin_host_stats_free(stats);
+    g_dbus_method_invocation_return_value(invocation, g_variant_new("(a(sssuuuttx))", &b));
+    return;
+  }
+  if (g_strcmp0(method_name, "RebindShortcuts") == 0) {
+    LiveSpiffUiSettings ui;
+    const char *triggers[HOTKEY_ACTION_COUNT];
+    load_shortcut_triggers(&ui, triggers);
+    global_shortcuts_rebind(g_shortcuts, triggers);
+    ui_settings_free_fields(&ui);
+    g_dbus_method_invocation_return_value(invocation, NULL);
+    return;
+  }
+  if (g_strcmp0(method_name, "ShortcutsStatus") == 0) {
+    g_dbus_method_invocation_return_value(invocation, g_variant_new("(ss)",
+      g_shortcuts ? g_shortcuts->active : "none",
+      g_shortcuts && g_shortcuts->status ? g_shortcuts->status : "Global shortcuts disabled in daemon.ini"));
+    return;
+  }
+  if (g_strcmp0(method_name, "LatencyOffsets") == 0) {
+    GVariant *offsets = build_latency_variant();
+    g_dbus_method_invocation_return_value(invocation, g_variant_new_tuple(&offsets, 1));
+    return;
+  }
+
+  if (g_strcmp0(method_name, "SetLatencyOffset") == 0) {
+    const char *source = NULL;
+    gint64 offset_us = 0;
+    g_variant_get(parameters, "(&sx)", &source, &offset_us);
+    gboolean ok = is_valid_source(source) && ABS(offset_us) <= G_USEC_PER_SEC;
+    if (ok) {
+      daemon_config_set_latency(&g_config, source, offset_us, 0);
+      daemon_config_save(&g_config);
+    }
+    g_dbus_method_invocation_return_value(invocation, g_variant_new("(b)", ok));
+    return;
+  }
+
+  // Game process
+  if (g_strcmp0(method_name, "WatchProcess") == 0) {
+    const char *name = NULL;
+    g_variant_get(parameters, "(&s)", &name);
+    g_free(g_config.process_name);
+    g_config.process_name = g_strdup(name);
+    daemon_config_save(&g_config);
+    proctrack_set_target(g_tracker, name, -1);
+    g_dbus_method_invocation_return_value(invocation, NULL);
+    return;
+  }
+
+  if (g_strcmp0(method_name, "GameProcess") == 0) {
+    g_dbus_method_invocation_return_value(invocation,
+      g_variant_new("(is)", (gint32)g_tracker->pid, g_tracker->target ? g_tracker->target : ""));
+    return;
+  }
+
+  if (g_strcmp0(method_name, "StartupInfo") == 0) {
+    g_dbus_method_invocation_return_value(invocation,
+      g_variant_new("(sxx)", g_restored_from, g_restore_us, g_ready_us));
+    return;
+  }
+
   // Unknown method
   g_dbus_method_invocation_return_dbus_error(
     invocation,
@@ -273,13 +1788,97 @@ static const GDBusInterfaceVTable interface_vtable = {
   .set_property = NULL
 };
 
+/* ------------------------- peer-to-peer socket ------------------------- */
+
+static void on_peer_closed(GDBusConnection *connection, gboolean remote_peer_vanished, GError *error,
+                           gpointer user_data) {
+  (void)remote_peer_vanished; (void)error; (void)user_data;
+  g_ptr_array_remove(g_peers, connection);
+}
+
+static gboolean on_new_peer(GDBusServer *server, GDBusConnection *connection, gpointer user_data) {
+  (void)server; (void)user_data;
+  guint reg_id = g_dbus_connection_register_object(connection, OBJ_PATH, live_spiff_control_interface_info(),
+                                                   &interface_vtable, NULL, NULL, NULL);
+  if (reg_id == 0) return FALSE;
+  g_ptr_array_add(g_peers, g_object_ref(connection));
+  g_signal_connect(connection, "closed", G_CALLBACK(on_peer_closed), NULL);
+  return TRUE;
+}
+
+// Only processes of the same user (the socket's directory is 0700 as well)
+static gboolean on_authorize_peer(GDBusAuthObserver *observer, GIOStream *stream, GCredentials *credentials,
+                                  gpointer user_data) {
+  (void)observer; (void)stream; (void)user_data;
+  return credentials && g_credentials_get_unix_user(credentials, NULL) == getuid();
+}
+
+static void start_peer_server(void) {
+  char *dir = g_build_filename(g_get_user_runtime_dir(), "livespiff", NULL);
+  char *path = g_build_filename(g_get_user_runtime_dir(), LIVESPIFF_PEER_SOCKET, NULL);
+  char *escaped = g_dbus_address_escape_value(path);
+  char *address = g_strdup_printf("unix:path=%s", escaped);
+  g_free(escaped);
+
+  // A socket that still answers belongs to a running daemon (which also
+  // holds the bus name); one that does not is left over from a crash
+  GDBusConnection *probe = g_file_test(path, G_FILE_TEST_EXISTS)
+    ? g_dbus_connection_new_for_address_sync(address, G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT, NULL, NULL, NULL)
+    : NULL;
+  if (probe) {
+    g_dbus_connection_close_sync(probe, NULL, NULL);
+    g_object_unref(probe);
+    g_printerr("%s is in use, not serving peer-to-peer\n", path);
+    goto out;
+  }
+  g_unlink(path);
+  if (g_mkdir_with_parents(dir, 0700) != 0) {
+    g_printerr("Cannot create %s, not serving peer-to-peer\n", dir);
+    goto out;
+  }
+
+  GError *err = NULL;
+  char *guid = g_dbus_generate_guid();
+  GDBusAuthObserver *observer = g_dbus_auth_observer_new();
+  g_signal_connect(observer, "authorize-authenticated-peer", G_CALLBACK(on_authorize_peer), NULL);
+  g_peer_server = g_dbus_server_new_sync(address, G_DBUS_SERVER_FLAGS_NONE, guid, observer, NULL, &err);
+  g_object_unref(observer);
+  g_free(guid);
+  if (!g_peer_server) {
+    g_printerr("Peer-to-peer socket %s: %s\n", path, err->message);
+    g_error_free(err);
+    goto out;
+  }
+
+  g_peers = g_ptr_array_new_with_free_func(g_object_unref);
+  g_signal_connect(g_peer_server, "new-connection", G_CALLBACK(on_new_peer), NULL);
+  g_dbus_server_start(g_peer_server);
+  g_peer_socket_path = g_steal_pointer(&path);
+  g_print("LiveSpiff peer-to-peer socket: %s\n", g_dbus_server_get_client_address(g_peer_server));
+
+out:
+  g_free(address);
+  g_free(path);
+  g_free(dir);
+}
+
+static void stop_peer_server(void) {
+  if (!g_peer_server) return;
+  g_dbus_server_stop(g_peer_server);
+  g_clear_object(&g_peer_server);
+  g_ptr_array_free(g_peers, TRUE);
+  g_peers = NULL;
+  g_unlink(g_peer_socket_path);
+  g_free(g_peer_socket_path);
+}
+
 static void on_bus_acquired(GDBusConnection *connection, const gchar *name, gpointer user_data) {
   (void)name; (void)user_data;
 
   guint reg_id = g_dbus_connection_register_object(
     connection,
     OBJ_PATH,
-    introspection_data->interfaces[0],
+    live_spiff_control_interface_info(),
     &interface_vtable,
     NULL, NULL, NULL
   );
@@ -289,31 +1888,86 @@ static void on_bus_acquired(GDBusConnection *connection, const gchar *name, gpoi
     exit(1);
   }
 
+  g_connection = connection;
+  start_global_shortcuts(connection);
+  emit_game_process_state();
   g_print("LiveSpiff D-Bus service online: %s %s %s\n", BUS_NAME, OBJ_PATH, IFACE_NAME);
 }
 
+static void mark_ready(void) {
+  g_ready_us = g_get_monotonic_time() - g_start_us;
+  g_print("Ready in %.1f ms (run from %s in %.1f ms)\n", g_ready_us / 1000.0, g_restored_from, g_restore_us / 1000.0);
+}
+
+// Activation requests queued by the bus are delivered from here on
 static void on_name_acquired(GDBusConnection *connection, const gchar *name, gpointer user_data) {
   (void)connection; (void)name; (void)user_data;
+  mark_ready();
 }
 
 static void on_name_lost(GDBusConnection *connection, const gchar *name, gpointer user_data) {
-  (void)connection; (void)name; (void)user_data;
+  (void)name; (void)user_data;
+  // No session bus at all (e.g. a gamescope session): the socket is enough
+  if (!connection && g_peer_server) {
+    g_printerr("No session bus, serving on %s only\n", g_peer_socket_path);
+    if (!g_ready_us) mark_ready();
+    g_connection = NULL;
+    return;
+  }
   g_printerr("Lost D-Bus name '%s'. Is another LiveSpiff running?\n", BUS_NAME);
   exit(1);
 }
 
 int main(void) {
   GMainLoop *loop = NULL;
-
-  introspection_data = g_dbus_node_info_new_for_xml(introspection_xml, NULL);
-  if (!introspection_data) {
-    g_printerr("Failed to parse introspection XML.\n");
-    return 1;
-  }
+  g_start_us = g_get_monotonic_time();
 
   // Initialize default run and apply its segment count
   g_run = run_new_default();
   apply_run_to_timer();
+  g_history = g_ptr_array_new_with_free_func((GDestroyNotify)attempt_free);
+  g_history_cached = g_ptr_array_new_with_free_func((GDestroyNotify)g_variant_unref);
+
+  {
+    char *runs_dir = livespiff_runs_dir();
+    char *data_dir = livespiff_data_dir();
+    char *index_path = g_build_filename(data_dir, "library.json", NULL);
+    g_library = library_open(runs_dir, index_path);
+    g_idle_add(on_library_sync_idle, NULL);
+    g_free(index_path);
+    g_free(data_dir);
+    g_free(runs_dir);
+  }
+
+  g_config = daemon_config_load();
+  if (!timing_method_from_string(g_config.timing_method, &g_timing)) g_timing = TIMING_REAL;
+  build_comparisons(g_history, NULL);
+  g_practice = practice_new(g_comparisons->n_segments, g_config.practice_ring_size);
+  if (g_config.history_sqlite) {
+#ifdef LIVESPIFF_HAVE_SQLITE
+    char *db_path = history_db_default_path();
+    char *err_str = NULL;
+    g_history_db = history_db_open(db_path, &err_str);
+    if (!g_history_db) g_printerr("%s\n", err_str ? err_str : "Failed to open the history database");
+    g_free(err_str);
+    g_free(db_path);
+#else
+    g_printerr("[history] sqlite: built without SQLite support, no history database\n");
+#endif
+  }
+  restore_last_run();
+  start_peer_server();
+  g_tracker = proctrack_new(on_game_process, NULL);
+  start_process_tracking();
+  start_evdev_hotkeys();
+
+  if (g_config.plugins_enabled) {
+    char *data_dir = livespiff_data_dir();
+    char *plugin_dir = g_build_filename(data_dir, "plugins", NULL);
+    g_plugins = plugin_host_load(plugin_dir, g_config.plugin_queue_depth);
+    g_free(plugin_dir);
+    g_free(data_dir);
+  }
 
   guint owner_id = g_bus_own_name(
     G_BUS_TYPE_SESSION,
@@ -330,8 +1984,27 @@ int main(void) {
 
   // Cleanup (not reached unless loop quits)
   g_bus_unown_name(owner_id);
+  stop_peer_server();
   g_main_loop_unref(loop);
+  hotkey_reader_stop(g_hotkeys);
+  global_shortcuts_free(g_shortcuts);
+  plugin_host_free(g_plugins);
+  if (g_calibration_tick_id) g_source_remove(g_calibration_tick_id);
+  if (g_state_save_id) g_source_remove(g_state_save_id);
+  calibration_free(g_calibration);
+  proctrack_free(g_tracker);
+  daemon_config_free_fields(&g_config);
+  library_close(g_library);
+#ifdef LIVESPIFF_HAVE_SQLITE
+  history_db_close(g_history_db);
+#endif
+  comparisons_free(g_real_comparisons);
+  comparisons_free(g_game_comparisons);
+  history_view_free(g_history_view);
+  practice_free(g_practice);
+  g_ptr_array_free(g_history, TRUE);
+  g_ptr_array_free(g_history_cached, TRUE);
+  g_free(g_run_path);
   run_free(g_run);
-  g_dbus_node_info_unref(introspection_data);
   return 0;
 }
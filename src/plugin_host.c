@@ -0,0 +1,293 @@
+#define _GNU_SOURCE
+#include "plugin_host.h"
+
+#include <dlfcn.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#define QUEUE_MIN 8u
+#define QUEUE_MAX 65536u
+#define CACHE_LINE 64
+// How long shutdown waits for a plugin thread before leaving it behind
+#define PLUGIN_STOP_TIMEOUT_US (2 * G_USEC_PER_SEC)
+
+enum { PLUGIN_STARTING, PLUGIN_RUNNING, PLUGIN_FAILED, PLUGIN_STOPPED };
+
+typedef struct {
+  char *path;
+  void *handle;
+  const LiveSpiffPluginDesc *desc;
+  GThread *thread;
+  void *state;               // plugin's own, only touched by its thread
+
+  LiveSpiffPluginEvent *ring;
+  guint capacity;            // power of two
+
+  // Producer side (main thread). Padding keeps the two sides' counters off
+  // each other's cache lines without needing an over-aligned allocation.
+  char pad_producer[CACHE_LINE];
+  _Atomic guint64 head;
+  guint64 sequence;
+  guint64 dropped;
+  guint high_water;
+
+  // Consumer side (plugin thread)
+  char pad_consumer[CACHE_LINE];
+  _Atomic guint64 tail;
+  _Atomic gint64 busy_since_us;
+
+  // Shared
+  char pad_shared[CACHE_LINE];
+  _Atomic int status;
+  _Atomic int sleeping;      // consumer is (about to be) blocked on wake_fd
+  _Atomic int stop;
+  int wake_fd;
+
+  // Set by the thread as it returns, so close can wait with a timeout
+  GMutex done_lock;
+  GCond done_cond;
+  gboolean done;
+} Plugin;
+
+struct LiveSpiffPluginHost {
+  GPtrArray *plugins;        // Plugin*
+};
+
+static guint round_capacity(guint n) {
+  guint c = QUEUE_MIN;
+  while (c < n && c < QUEUE_MAX) c <<= 1;
+  return c;
+}
+
+static void wake(Plugin *p) {
+  guint64 one = 1;
+  if (write(p->wake_fd, &one, sizeof(one)) < 0) { /* counter saturated: already awake */ }
+}
+
+static void plugin_run(Plugin *p) {
+  if (p->desc->init && p->desc->init(&p->state) != 0) {
+    g_printerr("plugin %s: init failed\n", p->desc->name);
+    atomic_store(&p->status, PLUGIN_FAILED);
+    return;
+  }
+  atomic_store(&p->status, PLUGIN_RUNNING);
+
+  for (;;) {
+    guint64 tail = atomic_load_explicit(&p->tail, memory_order_relaxed);
+    if (tail != atomic_load_explicit(&p->head, memory_order_acquire)) {
+      // The slot stays ours until tail moves past it: no copy needed
+      const LiveSpiffPluginEvent *ev = &p->ring[tail & (p->capacity - 1)];
+      if (p->desc->on_event) {
+        atomic_store_explicit(&p->busy_since_us, g_get_monotonic_time(), memory_order_relaxed);
+        p->desc->on_event(p->state, ev);
+        atomic_store_explicit(&p->busy_since_us, 0, memory_order_relaxed);
+      }
+      atomic_store_explicit(&p->tail, tail + 1, memory_order_release);
+      continue;
+    }
+    if (atomic_load(&p->stop)) break;
+
+    // Announce the sleep, then look again: either we see the new head here,
+    // or the producer sees sleeping and writes wake_fd
+    atomic_store(&p->sleeping, 1);
+    if (atomic_load(&p->head) != tail || atomic_load(&p->stop)) {
+      atomic_store(&p->sleeping, 0);
+      continue;
+    }
+    guint64 count;
+    if (read(p->wake_fd, &count, sizeof(count)) < 0) { /* EINTR: loop re-checks */ }
+  }
+
+  if (p->desc->shutdown) p->desc->shutdown(p->state);
+  atomic_store(&p->status, PLUGIN_STOPPED);
+}
+
+static gpointer plugin_thread(gpointer data) {
+  Plugin *p = (Plugin*)data;
+  plugin_run(p);
+  g_mutex_lock(&p->done_lock);
+  p->done = TRUE;
+  g_cond_signal(&p->done_cond);
+  g_mutex_unlock(&p->done_lock);
+  return NULL;
+}
+
+static Plugin* plugin_open(const char *path, guint capacity) {
+  void *handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+  if (!handle) {
+    g_printerr("plugin %s: %s\n", path, dlerror());
+    return NULL;
+  }
+
+  LiveSpiffPluginDescribeFunc describe = (LiveSpiffPluginDescribeFunc)dlsym(handle, LIVESPIFF_PLUGIN_ENTRY);
+  const LiveSpiffPluginDesc *desc = describe ? describe() : NULL;
+  if (!desc) {
+    g_printerr("plugin %s: no %s()\n", path, LIVESPIFF_PLUGIN_ENTRY);
+    dlclose(handle);
+    return NULL;
+  }
+  if (desc->abi_version != LIVESPIFF_PLUGIN_ABI_VERSION) {
+    g_printerr("plugin %s: built for ABI %u, daemon has %u\n", path, desc->abi_version, LIVESPIFF_PLUGIN_ABI_VERSION);
+    dlclose(handle);
+    return NULL;
+  }
+
+  Plugin *p = g_new0(Plugin, 1);
+  p->path = g_strdup(path);
+  p->handle = handle;
+  p->desc = desc;
+  p->capacity = capacity;
+  p->ring = g_new0(LiveSpiffPluginEvent, capacity);
+  p->wake_fd = eventfd(0, EFD_CLOEXEC);
+  atomic_init(&p->head, 0);
+  atomic_init(&p->tail, 0);
+  atomic_init(&p->busy_since_us, 0);
+  atomic_init(&p->status, PLUGIN_STARTING);
+  atomic_init(&p->sleeping, 0);
+  atomic_init(&p->stop, 0);
+  g_mutex_init(&p->done_lock);
+  g_cond_init(&p->done_cond);
+
+  char *thread_name = g_strdup_printf("lsplug-%.8s", desc->name ? desc->name : "anon");
+  p->thread = g_thread_new(thread_name, plugin_thread, p);
+  g_free(thread_name);
+  return p;
+}
+
+static void plugin_stop(Plugin *p) {
+  atomic_store(&p->stop, 1);
+  wake(p);
+}
+
+// After plugin_stop(). A callback that never returns must not hold up the
+// daemon's exit: past the deadline the thread is detached and its plugin left
+// loaded (it may still run code in it).
+static void plugin_close(Plugin *p, gint64 deadline) {
+  g_mutex_lock(&p->done_lock);
+  while (!p->done && g_cond_wait_until(&p->done_cond, &p->done_lock, deadline)) {}
+  gboolean done = p->done;
+  g_mutex_unlock(&p->done_lock);
+  if (!done) {
+    g_printerr("plugin %s: still busy after %d s, not waiting for it\n", p->desc->name ? p->desc->name : p->path,
+               (int)(PLUGIN_STOP_TIMEOUT_US / G_USEC_PER_SEC));
+    g_thread_unref(p->thread);
+    return;
+  }
+
+  g_thread_join(p->thread);
+  g_mutex_clear(&p->done_lock);
+  g_cond_clear(&p->done_cond);
+  close(p->wake_fd);
+  dlclose(p->handle);
+  g_free(p->ring);
+  g_free(p->path);
+  g_free(p);
+}
+
+static gint compare_names(gconstpointer a, gconstpointer b) {
+  return g_strcmp0(*(const char* const*)a, *(const char* const*)b);
+}
+
+LiveSpiffPluginHost* plugin_host_load(const char *dir, guint queue_depth) {
+  LiveSpiffPluginHost *h = g_new0(LiveSpiffPluginHost, 1);
+  h->plugins = g_ptr_array_new();
+
+  GDir *d = g_dir_open(dir, 0, NULL);
+  if (!d) return h;
+
+  GPtrArray *names = g_ptr_array_new_with_free_func(g_free);
+  const char *name;
+  while ((name = g_dir_read_name(d)) != NULL) {
+    if (g_str_has_suffix(name, ".so")) g_ptr_array_add(names, g_strdup(name));
+  }
+  g_dir_close(d);
+  g_ptr_array_sort(names, compare_names);
+
+  guint capacity = round_capacity(queue_depth);
+  for (guint i = 0; i < names->len; i++) {
+    char *path = g_build_filename(dir, (const char*)names->pdata[i], NULL);
+    Plugin *p = plugin_open(path, capacity);
+    if (p) {
+      g_ptr_array_add(h->plugins, p);
+      g_print("plugin %s loaded from %s\n", p->desc->name ? p->desc->name : "(unnamed)", path);
+    }
+    g_free(path);
+  }
+  g_ptr_array_free(names, TRUE);
+  return h;
+}
+
+void plugin_host_free(LiveSpiffPluginHost *h) {
+  if (!h) return;
+  // All stop together, so hung plugins share one timeout
+  for (guint i = 0; i < h->plugins->len; i++) plugin_stop((Plugin*)h->plugins->pdata[i]);
+  gint64 deadline = g_get_monotonic_time() + PLUGIN_STOP_TIMEOUT_US;
+  for (guint i = 0; i < h->plugins->len; i++) plugin_close((Plugin*)h->plugins->pdata[i], deadline);
+  g_ptr_array_free(h->plugins, TRUE);
+  g_free(h);
+}
+
+void plugin_host_publish(LiveSpiffPluginHost *h, const LiveSpiffPluginEvent *ev) {
+  if (!h) return;
+
+  for (guint i = 0; i < h->plugins->len; i++) {
+    Plugin *p = (Plugin*)h->plugins->pdata[i];
+    p->sequence++;
+
+    int status = atomic_load_explicit(&p->status, memory_order_relaxed);
+    guint64 head = atomic_load_explicit(&p->head, memory_order_relaxed);
+    guint64 depth = head - atomic_load_explicit(&p->tail, memory_order_acquire);
+    if (status == PLUGIN_FAILED || status == PLUGIN_STOPPED || depth >= p->capacity) {
+      p->dropped++;
+      continue;
+    }
+
+    LiveSpiffPluginEvent *slot = &p->ring[head & (p->capacity - 1)];
+    *slot = *ev;
+    slot->size = sizeof(LiveSpiffPluginEvent);
+    slot->sequence = p->sequence;
+    atomic_store(&p->head, head + 1);
+    if (depth + 1 > p->high_water) p->high_water = (guint)(depth + 1);
+
+    if (atomic_exchange(&p->sleeping, 0)) wake(p);
+  }
+}
+
+GArray* plugin_host_stats(LiveSpiffPluginHost *h) {
+  GArray *out = g_array_new(FALSE, TRUE, sizeof(LiveSpiffPluginStats));
+  if (!h) return out;
+
+  static const char *status_names[] = { "starting", "running", "failed", "stopped" };
+  gint64 now = g_get_monotonic_time();
+  for (guint i = 0; i < h->plugins->len; i++) {
+    Plugin *p = (Plugin*)h->plugins->pdata[i];
+    guint64 head = atomic_load(&p->head);
+    guint64 tail = atomic_load(&p->tail);
+    gint64 busy_since = atomic_load(&p->busy_since_us);
+
+    LiveSpiffPluginStats s = {0};
+    s.name = g_strdup(p->desc->name ? p->desc->name : "");
+    s.path = g_strdup(p->path);
+    s.state = status_names[atomic_load(&p->status)];
+    s.capacity = p->capacity;
+    s.depth = (guint)(head - tail);
+    s.high_water = p->high_water;
+    s.delivered = tail;
+    s.dropped = p->dropped;
+    s.busy_us = busy_since ? now - busy_since : 0;
+    g_array_append_val(out, s);
+  }
+  return out;
+}
+
+void plugin_host_stats_free(GArray *stats) {
+  if (!stats) return;
+  for (guint i = 0; i < stats->len; i++) {
+    LiveSpiffPluginStats *s = &g_array_index(stats, LiveSpiffPluginStats, i);
+    g_free(s->name);
+    g_free(s->path);
+  }
+  g_array_free(stats, TRUE);
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <glib.h>
+
+#include "livespiff_plugin.h"
+
+// Loads plugins (see livespiff_plugin.h) and feeds them timer events.
+// plugin_host_publish() is the only call on the timing path: it copies the
+// event into each plugin's single-producer/single-consumer ring and never
+// blocks, allocates or waits for a plugin.
+//
+// Isolation covers slow and hung plugins only: a plugin that crashes still
+// takes the daemon down with it, as it shares the address space.
+typedef struct LiveSpiffPluginHost LiveSpiffPluginHost;
+
+typedef struct {
+  char *name;
+  char *path;
+  const char *state;         // "starting", "running", "failed", "stopped"
+  guint capacity;
+  guint depth;               // events queued right now
+  guint high_water;          // deepest the queue has been
+  guint64 delivered;
+  guint64 dropped;           // queue full, or the plugin failed to start
+  gint64 busy_us;            // time spent in the current callback, 0 if idle
+} LiveSpiffPluginStats;
+
+// Every *.so in dir, in name order. Plugins that fail to load are reported
+// on stderr and skipped. queue_depth is rounded up to a power of two.
+LiveSpiffPluginHost* plugin_host_load(const char *dir, guint queue_depth);
+// Stops every plugin and waits up to 2 s for them; a plugin still busy in a
+// callback then is left running (detached and never unloaded)
+void plugin_host_free(LiveSpiffPluginHost *h);
+
+// Main thread only (single producer)
+void plugin_host_publish(LiveSpiffPluginHost *h, const LiveSpiffPluginEvent *ev);
+
+// LiveSpiffPluginStats, one per loaded plugin; free with plugin_host_stats_free()
+GArray* plugin_host_stats(LiveSpiffPluginHost *h);
+void plugin_host_stats_free(GArray *stats);
@@ -0,0 +1,176 @@
+#include "practice.h"
+#include <glib/gstdio.h>
+#include <json-glib/json-glib.h>
+#include <stdio.h>
+#include <string.h>
+
+LiveSpiffPractice* practice_new(guint n_segments, guint capacity) {
+  LiveSpiffPractice *p = g_new0(LiveSpiffPractice, 1);
+  p->n_segments = n_segments;
+  p->capacity = MAX(capacity, 1u);
+  p->segments = g_new0(PracticeSegment, n_segments > 0 ? n_segments : 1);
+  for (guint i = 0; i < n_segments; i++) {
+    p->segments[i].ring = g_new(gint64, p->capacity);
+    p->segments[i].best_us = LIVESPIFF_NO_TIME;
+    p->segments[i].last_us = LIVESPIFF_NO_TIME;
+  }
+  return p;
+}
+
+void practice_free(LiveSpiffPractice *p) {
+  if (!p) return;
+  for (guint i = 0; i < p->n_segments; i++) g_free(p->segments[i].ring);
+  g_free(p->segments);
+  g_free(p);
+}
+
+void practice_record(LiveSpiffPractice *p, guint segment, gint64 time_us) {
+  if (!p || segment >= p->n_segments) return;
+  PracticeSegment *s = &p->segments[segment];
+  gboolean ok = time_us != LIVESPIFF_NO_TIME;
+
+  // The slot being overwritten leaves the ring window
+  if (s->count == p->capacity) {
+    if (s->ring[s->head] != LIVESPIFF_NO_TIME) s->ring_successes--;
+  } else {
+    s->count++;
+  }
+  s->ring[s->head] = time_us;
+  s->head = (s->head + 1) % p->capacity;
+  if (ok) s->ring_successes++;
+
+  s->tries++;
+  s->last_us = time_us;
+  if (!ok) return;
+
+  s->successes++;
+  if (s->best_us == LIVESPIFF_NO_TIME || time_us < s->best_us) s->best_us = time_us;
+
+  if (s->recent_count == PRACTICE_AVERAGE_OF) s->recent_sum_us -= s->recent[s->recent_head];
+  else s->recent_count++;
+  s->recent[s->recent_head] = time_us;
+  s->recent_head = (s->recent_head + 1) % PRACTICE_AVERAGE_OF;
+  s->recent_sum_us += time_us;
+}
+
+gint64 practice_recent_average_us(const PracticeSegment *s) {
+  return s->recent_count ? s->recent_sum_us / s->recent_count : LIVESPIFF_NO_TIME;
+}
+
+/* ------------------------- session ------------------------- */
+
+void practice_begin(LiveSpiffPractice *p, guint first, guint last, gboolean feed) {
+  p->feed = feed;
+  p->first = first;
+  p->last = last;
+  p->current = first;
+  p->phase = PRACTICE_ARMED;
+}
+
+void practice_end(LiveSpiffPractice *p) {
+  p->phase = PRACTICE_OFF;
+}
+
+gboolean practice_split(LiveSpiffPractice *p, gint64 at_us, guint *out_segment, gint64 *out_time_us) {
+  if (p->phase == PRACTICE_ARMED) {
+    p->phase = PRACTICE_TIMING;
+    p->current = p->first;
+    p->segment_start_us = at_us;
+    return FALSE;
+  }
+  if (p->phase != PRACTICE_TIMING) return FALSE;
+
+  *out_segment = p->current;
+  *out_time_us = MAX(at_us - p->segment_start_us, 0);
+  p->segment_start_us = at_us;
+  if (p->current >= p->last) {
+    p->phase = PRACTICE_ARMED;
+    p->current = p->first;
+  } else {
+    p->current++;
+  }
+  return TRUE;
+}
+
+gboolean practice_abort(LiveSpiffPractice *p, guint *out_segment) {
+  if (p->phase != PRACTICE_TIMING) return FALSE;
+  *out_segment = p->current;
+  p->phase = PRACTICE_ARMED;
+  p->current = p->first;
+  return TRUE;
+}
+
+/* ------------------------- log ------------------------- */
+
+char* practice_log_path(const char *run_path) {
+  if (!run_path || !run_path[0]) return NULL;
+  if (g_str_has_suffix(run_path, ".json")) {
+    char *stem = g_strndup(run_path, strlen(run_path) - strlen(".json"));
+    char *path = g_strconcat(stem, ".practice.jsonl", NULL);
+    g_free(stem);
+    return path;
+  }
+  return g_strconcat(run_path, ".practice.jsonl", NULL);
+}
+
+gboolean practice_load(LiveSpiffPractice *p, const char *path, PracticeResultFunc func, gpointer user_data,
+                       char **out_error) {
+  if (!path || !g_file_test(path, G_FILE_TEST_EXISTS)) return TRUE;
+
+  FILE *f = g_fopen(path, "r");
+  if (!f) {
+    if (out_error) *out_error = g_strdup_printf("Failed to read practice log: %s", path);
+    return FALSE;
+  }
+
+  // Lines are short and fixed-shape; a torn last line is skipped
+  JsonParser *parser = json_parser_new();
+  char line[512];
+  while (fgets(line, sizeof(line), f)) {
+    if (!json_parser_load_from_data(parser, line, -1, NULL)) continue;
+    JsonNode *root = json_parser_get_root(parser);
+    if (!root || !JSON_NODE_HOLDS_OBJECT(root)) continue;
+
+    JsonObject *obj = json_node_get_object(root);
+    gint64 segment = json_object_get_int_member_with_default(obj, "segment", -1);
+    JsonNode *us = json_object_get_member(obj, "us");
+    gint64 time_us = (us && JSON_NODE_HOLDS_VALUE(us)) ? json_node_get_int(us) : LIVESPIFF_NO_TIME;
+    gboolean feed = json_object_get_boolean_member_with_default(obj, "feed", FALSE);
+    if (segment < 0 || (guint64)segment >= p->n_segments) continue;
+
+    practice_record(p, (guint)segment, time_us);
+    if (func && feed && time_us != LIVESPIFF_NO_TIME) func((guint)segment, time_us, user_data);
+  }
+
+  g_object_unref(parser);
+  fclose(f);
+  return TRUE;
+}
+
+gboolean practice_append(const char *path, gint64 at_us, guint segment, gint64 time_us, gboolean feed,
+                         char **out_error) {
+  if (!path) return FALSE;
+
+  char *dir = g_path_get_dirname(path);
+  if (g_mkdir_with_parents(dir, 0700) != 0) {
+    if (out_error) *out_error = g_strdup_printf("Failed to create directory: %s", dir);
+    g_free(dir);
+    return FALSE;
+  }
+  g_free(dir);
+
+  char *us = time_us == LIVESPIFF_NO_TIME ? g_strdup("null") : g_strdup_printf("%" G_GINT64_FORMAT, time_us);
+  char *line = g_strdup_printf("{\"at\":%" G_GINT64_FORMAT ",\"segment\":%u,\"us\":%s,\"feed\":%s}\n",
+                               at_us, segment, us, feed ? "true" : "false");
+  g_free(us);
+
+  gboolean ok = FALSE;
+  FILE *f = g_fopen(path, "a");
+  if (f) {
+    ok = fputs(line, f) >= 0;
+    ok = (fclose(f) == 0) && ok;
+  }
+  if (!ok && out_error) *out_error = g_strdup_printf("Failed to append practice log: %s", path);
+  g_free(line);
+  return ok;
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <glib.h>
+
+#include "storage.h"
+
+#define PRACTICE_AVERAGE_OF 10 // "average of last N" successful tries
+
+// Results of one segment: a bounded ring of tries plus rolling stats that
+// are updated per result in O(1), never recomputed from the ring.
+typedef struct {
+  gint64 *ring;              // segment time per try, LIVESPIFF_NO_TIME = failed (reset)
+  guint head;                // next slot to write
+  guint count;               // tries in the ring (<= capacity)
+  guint ring_successes;      // successful tries among the ring's entries
+
+  guint64 tries;             // lifetime
+  guint64 successes;
+  gint64 best_us;            // lifetime best, LIVESPIFF_NO_TIME if none
+  gint64 last_us;            // most recent try (LIVESPIFF_NO_TIME if it failed)
+
+  gint64 recent[PRACTICE_AVERAGE_OF]; // last successful times
+  guint recent_head;
+  guint recent_count;
+  gint64 recent_sum_us;
+} PracticeSegment;
+
+typedef enum {
+  PRACTICE_OFF = 0,
+  PRACTICE_ARMED,            // waiting for start/split to begin the range
+  PRACTICE_TIMING            // timing segment `current`
+} PracticePhase;
+
+// Practice results of one run, kept apart from its attempt history. A
+// session times segments first..last over and over; every finished or
+// abandoned segment becomes one result of that segment.
+typedef struct {
+  guint n_segments;
+  guint capacity;            // ring size per segment
+  PracticeSegment *segments;
+
+  PracticePhase phase;
+  guint first, last;         // segment range of the session
+  guint current;             // segment being timed (PRACTICE_TIMING)
+  gboolean feed;             // results also count towards the comparisons
+  gint64 segment_start_us;   // monotonic start of `current`
+} LiveSpiffPractice;
+
+LiveSpiffPractice* practice_new(guint n_segments, guint capacity);
+void practice_free(LiveSpiffPractice *p);
+
+// Fold one result into the segment's ring and stats
+void practice_record(LiveSpiffPractice *p, guint segment, gint64 time_us);
+// Average of the last PRACTICE_AVERAGE_OF successful tries, LIVESPIFF_NO_TIME if none
+gint64 practice_recent_average_us(const PracticeSegment *s);
+
+// Session. practice_split() begins the range when armed (returns FALSE) or
+// ends the current segment (returns TRUE with its index and time); after
+// the last segment of the range the session re-arms. practice_abort()
+// returns the segment that was being timed, if any, and re-arms.
+void practice_begin(LiveSpiffPractice *p, guint first, guint last, gboolean feed);
+void practice_end(LiveSpiffPractice *p);
+gboolean practice_split(LiveSpiffPractice *p, gint64 at_us, guint *out_segment, gint64 *out_time_us);
+gboolean practice_abort(LiveSpiffPractice *p, guint *out_segment);
+
+// Log next to the run file: foo.json -> foo.practice.jsonl (caller frees).
+// One {"at": unix us, "segment": i, "us": time or null, "feed": bool} object
+// per line; "feed" marks results the user let count towards the comparisons.
+char* practice_log_path(const char *run_path);
+// Replays the log into p; func (may be NULL) sees every successful result
+// marked "feed", to fold it into the comparisons again.
+typedef void (*PracticeResultFunc)(guint segment, gint64 time_us, gpointer user_data);
+gboolean practice_load(LiveSpiffPractice *p, const char *path, PracticeResultFunc func, gpointer user_data,
+                       char **out_error);
+gboolean practice_append(const char *path, gint64 at_us, guint segment, gint64 time_us, gboolean feed,
+                         char **out_error);
@@ -0,0 +1,297 @@
+#define _GNU_SOURCE
+#include "proctrack.h"
+
+#include <glib-unix.h>
+#include <errno.h>
+#include <linux/cn_proc.h>
+#include <linux/connector.h>
+#include <linux/netlink.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#ifndef SYS_pidfd_open
+#define SYS_pidfd_open 434
+#endif
+
+#define LAUNCH_RESCAN_S 2
+#define EXIT_RESCAN_S   1
+
+static void start_waiting(LiveSpiffProcTracker *t);
+static void stop_waiting(LiveSpiffProcTracker *t);
+
+/* ------------------------- /proc matching ------------------------- */
+
+static char* read_proc_file(int pid, const char *name, gsize *out_len) {
+  char *path = g_strdup_printf("/proc/%d/%s", pid, name);
+  char *contents = NULL;
+  if (!g_file_get_contents(path, &contents, out_len, NULL)) contents = NULL;
+  g_free(path);
+  return contents;
+}
+
+// Basename for both Unix and Windows (Wine/Proton) paths
+static gboolean basename_matches(const char *path, const char *target) {
+  if (!path || !path[0]) return FALSE;
+  const char *slash = strrchr(path, '/');
+  const char *bslash = strrchr(path, '\\');
+  const char *base = path;
+  if (slash && slash + 1 > base) base = slash + 1;
+  if (bslash && bslash + 1 > base) base = bslash + 1;
+
+  char *folded = g_utf8_casefold(base, -1);
+  gboolean match = g_strcmp0(folded, target) == 0;
+  // Window classes usually drop the extension ("game" for "Game.exe")
+  if (!match && g_str_has_suffix(folded, ".exe")) {
+    folded[strlen(folded) - 4] = '\0';
+    match = g_strcmp0(folded, target) == 0;
+  }
+  g_free(folded);
+  return match;
+}
+
+// Exited-but-unreaped processes keep their comm; never attach to those
+static gboolean pid_is_zombie(int pid) {
+  gsize len = 0;
+  char *stat = read_proc_file(pid, "stat", &len);
+  if (!stat) return TRUE;
+  const char *paren = strrchr(stat, ')');
+  gboolean zombie = !paren || paren[1] == '\0' || paren[2] == 'Z' || paren[2] == 'X';
+  g_free(stat);
+  return zombie;
+}
+
+static gboolean pid_matches(int pid, const char *target) {
+  if (pid <= 0 || !target) return FALSE;
+  if (pid_is_zombie(pid)) return FALSE;
+
+  gsize len = 0;
+  char *comm = read_proc_file(pid, "comm", &len);
+  if (!comm) return FALSE; // gone or not ours to read
+  g_strchomp(comm);
+
+  // comm is truncated to 15 bytes
+  char *folded = g_utf8_casefold(comm, -1);
+  gboolean match = g_strcmp0(folded, target) == 0 ||
+                   (strlen(folded) == 15 && g_str_has_prefix(target, folded));
+  g_free(folded);
+  g_free(comm);
+  if (match) return TRUE;
+
+  char *exe_link = g_strdup_printf("/proc/%d/exe", pid);
+  char *exe = g_file_read_link(exe_link, NULL);
+  g_free(exe_link);
+  match = basename_matches(exe, target);
+  g_free(exe);
+  if (match) return TRUE;
+
+  char *cmdline = read_proc_file(pid, "cmdline", &len);
+  match = cmdline && len > 0 && basename_matches(cmdline, target); // argv[0] is NUL-terminated
+  g_free(cmdline);
+  return match;
+}
+
+static int scan_proc(const char *target) {
+  GDir *d = g_dir_open("/proc", 0, NULL);
+  if (!d) return -1;
+
+  int found = -1;
+  const char *name;
+  while (found < 0 && (name = g_dir_read_name(d)) != NULL) {
+    if (!g_ascii_isdigit(name[0])) continue;
+    int pid = (int)g_ascii_strtoll(name, NULL, 10);
+    if (pid != getpid() && pid_matches(pid, target)) found = pid;
+  }
+  g_dir_close(d);
+  return found;
+}
+
+/* ------------------------- exit tracking ------------------------- */
+
+static void detach(LiveSpiffProcTracker *t) {
+  if (t->pidfd_source) { g_source_remove(t->pidfd_source); t->pidfd_source = 0; }
+  if (t->exit_scan_source) { g_source_remove(t->exit_scan_source); t->exit_scan_source = 0; }
+  if (t->pidfd >= 0) { close(t->pidfd); t->pidfd = -1; }
+  t->pid = -1;
+}
+
+static void on_exited(LiveSpiffProcTracker *t) {
+  int pid = t->pid;
+  detach(t);
+  if (t->callback) t->callback(FALSE, pid, t->target, t->user_data);
+  if (t->target) start_waiting(t);
+}
+
+static gboolean on_pidfd_ready(gint fd, GIOCondition cond, gpointer user_data) {
+  (void)fd; (void)cond;
+  LiveSpiffProcTracker *t = (LiveSpiffProcTracker*)user_data;
+  t->pidfd_source = 0;
+  on_exited(t);
+  return G_SOURCE_REMOVE;
+}
+
+static gboolean on_exit_scan(gpointer user_data) {
+  LiveSpiffProcTracker *t = (LiveSpiffProcTracker*)user_data;
+  char *path = g_strdup_printf("/proc/%d", t->pid);
+  gboolean alive = g_file_test(path, G_FILE_TEST_IS_DIR);
+  g_free(path);
+  if (alive) return G_SOURCE_CONTINUE;
+
+  t->exit_scan_source = 0;
+  on_exited(t);
+  return G_SOURCE_REMOVE;
+}
+
+static void attach(LiveSpiffProcTracker *t, int pid) {
+  stop_waiting(t);
+  detach(t);
+
+  int fd = (int)syscall(SYS_pidfd_open, pid, 0);
+  if (fd < 0 && errno == ESRCH) {
+    // Exited between the exec event and now
+    start_waiting(t);
+    return;
+  }
+
+  t->pid = pid;
+  if (fd >= 0) {
+    t->pidfd = fd;
+    t->pidfd_source = g_unix_fd_add(fd, G_IO_IN, on_pidfd_ready, t);
+  } else {
+    // Kernel < 5.3
+    t->exit_scan_source = g_timeout_add_seconds(EXIT_RESCAN_S, on_exit_scan, t);
+  }
+
+  if (t->callback) t->callback(TRUE, pid, t->target, t->user_data);
+}
+
+/* ------------------------- launch detection ------------------------- */
+
+static int proc_connector_open(void) {
+  int fd = socket(PF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, NETLINK_CONNECTOR);
+  if (fd < 0) return -1;
+
+  struct sockaddr_nl addr = {0};
+  addr.nl_family = AF_NETLINK;
+  addr.nl_groups = CN_IDX_PROC;
+  addr.nl_pid = 0;
+  if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+    close(fd);
+    return -1;
+  }
+
+  struct {
+    struct nlmsghdr nl;
+    struct cn_msg cn;
+    enum proc_cn_mcast_op op;
+  } __attribute__((packed)) req;
+  memset(&req, 0, sizeof(req));
+  req.nl.nlmsg_len = sizeof(req);
+  req.nl.nlmsg_type = NLMSG_DONE;
+  req.nl.nlmsg_pid = 0;
+  req.cn.id.idx = CN_IDX_PROC;
+  req.cn.id.val = CN_VAL_PROC;
+  req.cn.len = sizeof(enum proc_cn_mcast_op);
+  req.op = PROC_CN_MCAST_LISTEN;
+
+  // Fails with EPERM without CAP_NET_ADMIN
+  if (send(fd, &req, sizeof(req), 0) < 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+static gboolean on_proc_event(gint fd, GIOCondition cond, gpointer user_data) {
+  (void)cond;
+  LiveSpiffProcTracker *t = (LiveSpiffProcTracker*)user_data;
+  char buf[4096] __attribute__((aligned(NLMSG_ALIGNTO)));
+
+  for (;;) {
+    ssize_t len = recv(fd, buf, sizeof(buf), 0);
+    if (len <= 0) break; // EAGAIN: drained (ENOBUFS: overrun, next exec still arrives)
+
+    for (struct nlmsghdr *nl = (struct nlmsghdr*)buf; NLMSG_OK(nl, (size_t)len); nl = NLMSG_NEXT(nl, len)) {
+      struct cn_msg *cn = (struct cn_msg*)NLMSG_DATA(nl);
+      if (cn->id.idx != CN_IDX_PROC || cn->id.val != CN_VAL_PROC) continue;
+
+      struct proc_event *ev = (struct proc_event*)cn->data;
+      int pid = -1;
+      if (ev->what == PROC_EVENT_EXEC) pid = ev->event_data.exec.process_tgid;
+      else if (ev->what == PROC_EVENT_COMM) pid = ev->event_data.comm.process_tgid;
+
+      if (pid > 0 && pid_matches(pid, t->target)) {
+        t->nl_source = 0; // attach() -> stop_waiting() closes fd
+        attach(t, pid);
+        return G_SOURCE_REMOVE;
+      }
+    }
+  }
+  return G_SOURCE_CONTINUE;
+}
+
+static gboolean on_launch_scan(gpointer user_data) {
+  LiveSpiffProcTracker *t = (LiveSpiffProcTracker*)user_data;
+  int pid = scan_proc(t->target);
+  if (pid < 0) return G_SOURCE_CONTINUE;
+
+  t->launch_scan_source = 0;
+  attach(t, pid);
+  return G_SOURCE_REMOVE;
+}
+
+static void stop_waiting(LiveSpiffProcTracker *t) {
+  if (t->nl_source) { g_source_remove(t->nl_source); t->nl_source = 0; }
+  if (t->nl_fd >= 0) { close(t->nl_fd); t->nl_fd = -1; }
+  if (t->launch_scan_source) { g_source_remove(t->launch_scan_source); t->launch_scan_source = 0; }
+}
+
+static void start_waiting(LiveSpiffProcTracker *t) {
+  stop_waiting(t);
+
+  t->nl_fd = proc_connector_open();
+  if (t->nl_fd >= 0) {
+    t->nl_source = g_unix_fd_add(t->nl_fd, G_IO_IN, on_proc_event, t);
+  } else {
+    t->launch_scan_source = g_timeout_add_seconds(LAUNCH_RESCAN_S, on_launch_scan, t);
+  }
+
+  // Subscribing first closes the race with a launch that happens right now
+  int pid = scan_proc(t->target);
+  if (pid > 0) attach(t, pid);
+}
+
+/* ------------------------- public API ------------------------- */
+
+LiveSpiffProcTracker* proctrack_new(ProcTrackCallback callback, gpointer user_data) {
+  LiveSpiffProcTracker *t = g_new0(LiveSpiffProcTracker, 1);
+  t->pid = -1;
+  t->pidfd = -1;
+  t->nl_fd = -1;
+  t->callback = callback;
+  t->user_data = user_data;
+  return t;
+}
+
+void proctrack_free(LiveSpiffProcTracker *t) {
+  if (!t) return;
+  stop_waiting(t);
+  detach(t);
+  g_free(t->target);
+  g_free(t);
+}
+
+void proctrack_set_target(LiveSpiffProcTracker *t, const char *name, int pid_hint) {
+  if (!t) return;
+  stop_waiting(t);
+  detach(t);
+  g_free(t->target);
+  t->target = NULL;
+
+  if (!name || !name[0]) return;
+  t->target = g_utf8_casefold(name, -1);
+
+  if (pid_hint > 0 && pid_matches(pid_hint, t->target)) attach(t, pid_hint);
+  else start_waiting(t);
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <glib.h>
+
+// Called on the main loop when the watched game starts (running=TRUE) or exits
+typedef void (*ProcTrackCallback)(gboolean running, int pid, const char *name, gpointer user_data);
+
+// Event-driven game process tracking:
+// - launch: netlink proc connector exec events (needs CAP_NET_ADMIN), otherwise
+//   a coarse /proc rescan, since inotify/fanotify on /proc report no new processes
+// - exit: pidfd_open() + poll on the main loop, no /proc polling
+// Nothing runs while the game is up except the idle pidfd watch.
+typedef struct {
+  char *target;          // casefolded process name / window class to match
+  int pid;               // tracked pid, -1 if not running
+  int pidfd;
+  guint pidfd_source;
+  guint exit_scan_source; // only if pidfd_open() is unavailable
+
+  int nl_fd;             // proc connector socket, -1 if not listening
+  guint nl_source;
+  guint launch_scan_source;
+
+  ProcTrackCallback callback;
+  gpointer user_data;
+} LiveSpiffProcTracker;
+
+LiveSpiffProcTracker* proctrack_new(ProcTrackCallback callback, gpointer user_data);
+void proctrack_free(LiveSpiffProcTracker *t);
+
+// Watch for name (matched against comm, exe and argv[0] basenames, case-insensitive).
+// pid_hint is tried first (e.g. the pid saved by the window picker). NULL/"" stops tracking.
+void proctrack_set_target(LiveSpiffProcTracker *t, const char *name, int pid_hint);
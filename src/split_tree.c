@@ -0,0 +1,129 @@
+#include "split_tree.h"
+#include <string.h>
+
+typedef enum {
+  NAME_PLAIN = 0,
+  NAME_SUB,                  // "-Name"
+  NAME_CLOSE                 // "{Section} Name"
+} NameKind;
+
+// For NAME_CLOSE, *section is the text between the braces (caller frees)
+static NameKind name_kind(const char *raw, char **section, const char **rest) {
+  if (section) *section = NULL;
+  if (rest) *rest = raw;
+  if (!raw) return NAME_PLAIN;
+  if (raw[0] == '-') {
+    if (rest) *rest = raw + 1;
+    return NAME_SUB;
+  }
+  if (raw[0] == '{') {
+    const char *close = strchr(raw, '}');
+    if (close) {
+      if (section) *section = g_strstrip(g_strndup(raw + 1, (gsize)(close - raw - 1)));
+      if (rest) {
+        *rest = close + 1;
+        while (**rest == ' ') (*rest)++;
+      }
+      return NAME_CLOSE;
+    }
+  }
+  return NAME_PLAIN;
+}
+
+char* split_name_display(const char *raw) {
+  char *section = NULL;
+  const char *rest = NULL;
+  name_kind(raw, &section, &rest);
+  // "{Boss}" alone names the subsplit after its section
+  char *out = g_strdup(rest && *rest ? rest : (section ? section : ""));
+  g_free(section);
+  return out;
+}
+
+static void add_node(GArray *nodes, char *name, gboolean section, gint parent, guint first, guint count) {
+  SplitNode n = {
+    .name = name,
+    .section = section,
+    .parent = parent,
+    .depth = parent < 0 ? 0 : g_array_index(nodes, SplitNode, parent).depth + 1,
+    .span = 1,
+    .first_segment = first,
+    .n_segments = count,
+  };
+  g_array_append_val(nodes, n);
+}
+
+LiveSpiffSplitTree* split_tree_new(const GPtrArray *segment_names) {
+  guint n = segment_names ? segment_names->len : 0;
+  LiveSpiffSplitTree *t = g_new0(LiveSpiffSplitTree, 1);
+  t->n_segments = n;
+  t->segment_node = g_new0(guint, MAX(n, 1));
+
+  GArray *nodes = g_array_sized_new(FALSE, TRUE, sizeof(SplitNode), n);
+  guint i = 0;
+  while (i < n) {
+    const char *raw = (const char*)g_ptr_array_index(segment_names, i);
+    if (name_kind(raw, NULL, NULL) == NAME_PLAIN) {
+      t->segment_node[i] = nodes->len;
+      add_node(nodes, g_strdup(raw ? raw : ""), FALSE, -1, i, 1);
+      i++;
+      continue;
+    }
+
+    // A section: "-" names up to and including the closing name
+    guint last = i;
+    while (last < n && name_kind(g_ptr_array_index(segment_names, last), NULL, NULL) == NAME_SUB) last++;
+    if (last == n) last = n - 1; // unclosed at the end of the run
+
+    char *section = NULL;
+    const char *closing = (const char*)g_ptr_array_index(segment_names, last);
+    NameKind kind = name_kind(closing, &section, NULL);
+    if (kind != NAME_CLOSE || !section || !*section) {
+      g_free(section);
+      section = split_name_display(closing);
+    }
+
+    guint head = nodes->len;
+    add_node(nodes, section, TRUE, -1, i, last - i + 1);
+    for (guint s = i; s <= last; s++) {
+      t->segment_node[s] = nodes->len;
+      add_node(nodes, split_name_display(g_ptr_array_index(segment_names, s)), FALSE, (gint)head, s, 1);
+    }
+    g_array_index(nodes, SplitNode, head).span = nodes->len - head;
+    t->n_sections++;
+    i = last + 1;
+  }
+
+  t->n_nodes = nodes->len;
+  t->nodes = (SplitNode*)g_array_free(nodes, FALSE);
+  return t;
+}
+
+void split_tree_free(LiveSpiffSplitTree *t) {
+  if (!t) return;
+  for (guint i = 0; i < t->n_nodes; i++) g_free(t->nodes[i].name);
+  g_free(t->nodes);
+  g_free(t->segment_node);
+  g_free(t);
+}
+
+gint split_tree_section_of(const LiveSpiffSplitTree *t, guint segment) {
+  if (segment >= t->n_segments) return -1;
+  return t->nodes[t->segment_node[segment]].parent;
+}
+
+static gint64 at(const GArray *a, gint i) {
+  if (i < 0) return 0; // before the first segment
+  return (guint)i < a->len ? g_array_index(a, gint64, i) : G_MININT64;
+}
+
+gint64 split_tree_node_split(const SplitNode *n, const GArray *cumulative) {
+  return at(cumulative, (gint)(n->first_segment + n->n_segments) - 1);
+}
+
+gint64 split_tree_node_time(const SplitNode *n, const GArray *cumulative) {
+  gint64 end = at(cumulative, (gint)(n->first_segment + n->n_segments) - 1);
+  gint64 start = at(cumulative, (gint)n->first_segment - 1);
+  if (end == G_MININT64 || start == G_MININT64) return G_MININT64;
+  return end - start;
+}
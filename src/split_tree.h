@@ -0,0 +1,51 @@
+#pragma once
+#include <glib.h>
+
+// Subsplits, encoded in the run's flat segment names the way .lss files do:
+//
+//   "-Forsaken City A"      subsplit of the section that continues below
+//   "-Crossing"
+//   "{Chapter 1} Summit"    last subsplit, closing section "Chapter 1"
+//   "Old Site"              ordinary top-level segment
+//
+// The names stay the timing units everywhere (one split each), so runs,
+// histories and comparisons are unchanged by grouping. A run of "-" names
+// closed by a plain name takes that name as the section name.
+//
+// The tree is a flat preorder array: each section is directly followed by
+// its subsplits. span skips a whole subtree; [first_segment, +n_segments)
+// is the segment range a node covers, so section totals and deltas are
+// differences of the cumulative (prefix sum) arrays, not tree walks.
+typedef struct {
+  char *name;                // display name, markers stripped
+  gboolean section;
+  gint parent;               // node index of the section, -1 at top level
+  guint depth;
+  guint span;                // nodes in the subtree, itself included
+  guint first_segment;
+  guint n_segments;
+} SplitNode;
+
+typedef struct {
+  SplitNode *nodes;
+  guint n_nodes;
+  guint n_segments;
+  guint *segment_node;       // segment index -> node index of its leaf
+  guint n_sections;
+} LiveSpiffSplitTree;
+
+LiveSpiffSplitTree* split_tree_new(const GPtrArray *segment_names);
+void split_tree_free(LiveSpiffSplitTree *t);
+
+// Innermost section containing segment, -1 if it is top level
+gint split_tree_section_of(const LiveSpiffSplitTree *t, guint segment);
+
+// From cumulative arrays (one gint64 per segment, G_MININT64 = unknown):
+// the split at the node's end and the time spent in it; on a delta array
+// the latter is the time gained or lost across it. G_MININT64 if an end
+// is unknown.
+gint64 split_tree_node_split(const SplitNode *n, const GArray *cumulative);
+gint64 split_tree_node_time(const SplitNode *n, const GArray *cumulative);
+
+// Display name of one raw segment name (caller frees)
+char* split_name_display(const char *raw);
@@ -0,0 +1,237 @@
+#include "state_cache.h"
+#include <glib/gstdio.h>
+#include <string.h>
+
+#define STATE_CACHE_VERSION 4
+
+// (version, run path, run size, run mtime, history size, history mtime,
+//  game, category, segments, icons ("" = none), custom comparisons,
+//  attempts (started at, finished, reset, game time reset, splits,
+//  game time splits (empty = none)))
+#define STATE_CACHE_TYPE "(usxxxxssasasa(sax)a(xbxxaxax))"
+#define STATE_CACHE_ATTEMPT_TYPE "(xbxxaxax)"
+
+char* state_cache_path(void) {
+  return g_build_filename(g_get_user_cache_dir(), "livespiff", "daemon-state.gvariant", NULL);
+}
+
+// daemon-state.gvariant -> daemon-state.comparison: the active comparison,
+// kept apart so that switching it does not rewrite the attempts
+static char* comparison_path(const char *path) {
+  const char *dot = strrchr(path, '.');
+  const char *slash = strrchr(path, G_DIR_SEPARATOR);
+  gsize stem = dot && (!slash || dot > slash) ? (gsize)(dot - path) : strlen(path);
+  char *base = g_strndup(path, stem);
+  char *out = g_strconcat(base, ".comparison", NULL);
+  g_free(base);
+  return out;
+}
+
+// -1, -1 if the file does not exist (a run without history yet)
+static void file_stamp(const char *path, gint64 *size, gint64 *mtime) {
+  GStatBuf st;
+  if (path && g_stat(path, &st) == 0) {
+    *size = (gint64)st.st_size;
+    *mtime = (gint64)st.st_mtime;
+  } else {
+    *size = -1;
+    *mtime = -1;
+  }
+}
+
+static GVariant* times_variant(const GArray *times) {
+  return g_variant_new_fixed_array(G_VARIANT_TYPE_INT64, times ? times->data : NULL,
+                                   times ? times->len : 0, sizeof(gint64));
+}
+
+static GArray* times_from_variant(GVariant *ax) {
+  gsize n = 0;
+  const gint64 *v = g_variant_get_fixed_array(ax, &n, sizeof(gint64));
+  GArray *times = g_array_sized_new(FALSE, FALSE, sizeof(gint64), (guint)n);
+  g_array_append_vals(times, v, (guint)n);
+  return times;
+}
+
+GVariant* state_cache_attempt(const LiveSpiffAttempt *a) {
+  return g_variant_ref_sink(g_variant_new("(xbxx@ax@ax)", a->started_at_us, a->finished, a->reset_us,
+                                          a->reset_game_us, times_variant(a->split_us), times_variant(a->game_us)));
+}
+
+GVariant* state_cache_snapshot(const char *run_path, const LiveSpiffRun *run, const GPtrArray *attempts) {
+  gint64 run_size, run_mtime, hist_size, hist_mtime;
+  char *hist_path = run_history_path(run_path);
+  file_stamp(run_path, &run_size, &run_mtime);
+  file_stamp(hist_path, &hist_size, &hist_mtime);
+  g_free(hist_path);
+
+  GVariantBuilder segments, icons, comparisons;
+  g_variant_builder_init(&segments, G_VARIANT_TYPE("as"));
+  g_variant_builder_init(&icons, G_VARIANT_TYPE("as"));
+  for (guint i = 0; i < run->segments->len; i++) {
+    const char *icon = run_segment_icon(run, i);
+    g_variant_builder_add(&segments, "s", (const char*)g_ptr_array_index(run->segments, i));
+    g_variant_builder_add(&icons, "s", icon ? icon : "");
+  }
+
+  g_variant_builder_init(&comparisons, G_VARIANT_TYPE("a(sax)"));
+  for (guint i = 0; run->comparisons && i < run->comparisons->len; i++) {
+    const LiveSpiffCustomComparison *cc = g_ptr_array_index(run->comparisons, i);
+    g_variant_builder_add(&comparisons, "(s@ax)", cc->name, times_variant(cc->split_us));
+  }
+
+  // Takes references to the entries, nothing is serialized yet
+  GVariant *history = g_variant_new_array(G_VARIANT_TYPE(STATE_CACHE_ATTEMPT_TYPE),
+                                          (GVariant* const*)attempts->pdata, attempts->len);
+
+  return g_variant_ref_sink(g_variant_new(STATE_CACHE_TYPE, (guint32)STATE_CACHE_VERSION, run_path,
+                                          run_size, run_mtime, hist_size, hist_mtime,
+                                          run->game ? run->game : "", run->category ? run->category : "",
+                                          &segments, &icons, &comparisons, history));
+}
+
+static gboolean write_file(const char *path, const char *bytes, gsize len, char **out_error) {
+  char *dir = g_path_get_dirname(path);
+  g_mkdir_with_parents(dir, 0700);
+  g_free(dir);
+
+  GError *err = NULL;
+  if (!g_file_set_contents(path, bytes, (gssize)len, &err)) {
+    if (out_error) *out_error = g_strdup_printf("State cache %s: %s", path, err->message);
+    g_error_free(err);
+    return FALSE;
+  }
+  return TRUE;
+}
+
+gboolean state_cache_write(const char *path, GVariant *state, char **out_error) {
+  // The first g_variant_get_data() of a snapshot serializes it: here, not where it was taken
+  GBytes *data = g_variant_get_data_as_bytes(state);
+  gsize len = 0;
+  const char *bytes = g_bytes_get_data(data, &len);
+  gboolean ok = write_file(path, bytes, len, out_error);
+  g_bytes_unref(data);
+  return ok;
+}
+
+gboolean state_cache_write_comparison(const char *path, const char *active_comparison, char **out_error) {
+  char *cpath = comparison_path(path);
+  const char *name = active_comparison ? active_comparison : "";
+  gboolean ok = write_file(cpath, name, strlen(name), out_error);
+  g_free(cpath);
+  return ok;
+}
+
+StateCacheResult state_cache_load(const char *path, LiveSpiffWarmState *out) {
+  memset(out, 0, sizeof(*out));
+
+  GMappedFile *mf = g_mapped_file_new(path, FALSE, NULL);
+  if (!mf) return STATE_CACHE_MISSING;
+  GBytes *bytes = g_mapped_file_get_bytes(mf);
+  g_mapped_file_unref(mf);
+
+  // Not trusted: a truncated or foreign file must not be walked unchecked
+  GVariant *v = g_variant_ref_sink(g_variant_new_from_bytes(G_VARIANT_TYPE(STATE_CACHE_TYPE), bytes, FALSE));
+  g_bytes_unref(bytes);
+  if (!g_variant_is_normal_form(v)) {
+    g_variant_unref(v);
+    return STATE_CACHE_MISSING;
+  }
+
+  guint32 version = 0;
+  const char *run_path = NULL, *game = NULL, *category = NULL;
+  gint64 run_size, run_mtime, hist_size, hist_mtime;
+  GVariant *segments = NULL, *icons = NULL, *comparisons = NULL, *history = NULL;
+  g_variant_get(v, "(u&sxxxx&s&s@as@as@a(sax)@a(xbxxaxax))", &version, &run_path, &run_size, &run_mtime,
+                &hist_size, &hist_mtime, &game, &category, &segments, &icons, &comparisons, &history);
+
+  StateCacheResult result = STATE_CACHE_MISSING;
+  if (version != STATE_CACHE_VERSION || !*run_path) goto out;
+
+  out->run_path = g_strdup(run_path);
+  char *cpath = comparison_path(path);
+  char *active = NULL;
+  if (g_file_get_contents(cpath, &active, NULL, NULL) && *active) out->active_comparison = active;
+  else g_free(active);
+  g_free(cpath);
+  result = STATE_CACHE_STALE;
+
+  gint64 now_size, now_mtime;
+  char *hist_path = run_history_path(run_path);
+  file_stamp(run_path, &now_size, &now_mtime);
+  gboolean same = now_size == run_size && now_mtime == run_mtime;
+  file_stamp(hist_path, &now_size, &now_mtime);
+  same = same && now_size == hist_size && now_mtime == hist_mtime;
+  g_free(hist_path);
+  if (!same || run_size < 0) goto out;
+
+  LiveSpiffRun *run = g_new0(LiveSpiffRun, 1);
+  run->game = g_strdup(game);
+  run->category = g_strdup(category);
+  run->segments = g_ptr_array_new_with_free_func(g_free);
+  run->comparisons = g_ptr_array_new_with_free_func(custom_comparison_free);
+
+  GVariantIter it;
+  const char *s = NULL;
+  g_variant_iter_init(&it, segments);
+  while (g_variant_iter_next(&it, "&s", &s)) g_ptr_array_add(run->segments, g_strdup(s));
+  // Icons stay NULL unless at least one segment has one
+  gsize n_icons = g_variant_n_children(icons);
+  for (gsize i = 0; i < n_icons; i++) {
+    g_variant_get_child(icons, i, "&s", &s);
+    if (!*s) continue;
+    if (!run->icons) {
+      run->icons = g_ptr_array_new_with_free_func(g_free);
+      g_ptr_array_set_size(run->icons, (guint)n_icons);
+    }
+    g_ptr_array_index(run->icons, i) = g_strdup(s);
+  }
+
+  GVariant *times = NULL, *game_times = NULL;
+  g_variant_iter_init(&it, comparisons);
+  while (g_variant_iter_next(&it, "(&s@ax)", &s, &times)) {
+    LiveSpiffCustomComparison *cc = g_new0(LiveSpiffCustomComparison, 1);
+    cc->name = g_strdup(s);
+    cc->split_us = times_from_variant(times);
+    g_ptr_array_add(run->comparisons, cc);
+    g_variant_unref(times);
+  }
+
+  GPtrArray *attempts = g_ptr_array_new_full((guint)g_variant_n_children(history), (GDestroyNotify)attempt_free);
+  gint64 started_at = 0;
+  gint64 reset_us = 0, reset_game_us = 0;
+  gboolean finished = FALSE;
+  g_variant_iter_init(&it, history);
+  while (g_variant_iter_next(&it, "(xbxx@ax@ax)", &started_at, &finished, &reset_us, &reset_game_us,
+                             &times, &game_times)) {
+    LiveSpiffAttempt *a = g_new0(LiveSpiffAttempt, 1);
+    a->started_at_us = started_at;
+    a->finished = finished;
+    a->reset_us = reset_us;
+    a->reset_game_us = reset_game_us;
+    a->split_us = times_from_variant(times);
+    if (g_variant_n_children(game_times) > 0) a->game_us = times_from_variant(game_times);
+    g_ptr_array_add(attempts, a);
+    g_variant_unref(times);
+    g_variant_unref(game_times);
+  }
+
+  out->run = run;
+  out->attempts = attempts;
+  result = STATE_CACHE_FRESH;
+
+out:
+  g_variant_unref(segments);
+  g_variant_unref(icons);
+  g_variant_unref(comparisons);
+  g_variant_unref(history);
+  g_variant_unref(v);
+  return result;
+}
+
+void state_cache_clear(LiveSpiffWarmState *s) {
+  g_free(s->run_path);
+  run_free(s->run);
+  if (s->attempts) g_ptr_array_free(s->attempts, TRUE);
+  g_free(s->active_comparison);
+  memset(s, 0, sizeof(*s));
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <glib.h>
+
+#include "storage.h"
+
+// What livespiffd needs to be ready after (bus or systemd) activation: the
+// last loaded run and its attempts as one serialized GVariant, and the
+// active comparison beside it. Loading maps the file and walks the variant in
+// place, so a cold start costs a stat of the run and history files and a
+// copy of the numbers, not a JSON parse of the whole history.
+//
+// The cache is stamped with the size and mtime of the run file and of its
+// history log; if either changed behind the daemon's back (an edit, a
+// sync from another machine) it is stale and the files are loaded instead.
+typedef struct {
+  char *run_path;
+  LiveSpiffRun *run;          // NULL unless fresh
+  GPtrArray *attempts;        // LiveSpiffAttempt*, NULL unless fresh
+  char *active_comparison;
+} LiveSpiffWarmState;
+
+typedef enum {
+  STATE_CACHE_MISSING = 0,    // nothing cached (or unreadable); out is empty
+  STATE_CACHE_STALE,          // only run_path and active_comparison are set
+  STATE_CACHE_FRESH
+} StateCacheResult;
+
+// ~/.cache/livespiff/daemon-state.gvariant (caller frees)
+char* state_cache_path(void);
+
+// One entry of the attempts, as state_cache_snapshot() takes them (a ref).
+// Entries never change once built, so a caller can keep them next to its
+// history and only build the ones for new attempts.
+GVariant* state_cache_attempt(const LiveSpiffAttempt *a);
+// Taken on the caller's thread (stamps the files now) from run and the
+// state_cache_attempt() entries (GVariant*), without serializing them
+GVariant* state_cache_snapshot(const char *run_path, const LiveSpiffRun *run, const GPtrArray *attempts);
+// Serializes and writes a snapshot; meant for a worker thread
+gboolean state_cache_write(const char *path, GVariant *state, char **out_error);
+// The active comparison goes to a small file next to path, on its own
+gboolean state_cache_write_comparison(const char *path, const char *active_comparison, char **out_error);
+
+StateCacheResult state_cache_load(const char *path, LiveSpiffWarmState *out);
+void state_cache_clear(LiveSpiffWarmState *s);
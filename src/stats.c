@@ -0,0 +1,167 @@
+#include "stats.h"
+#include "storage.h"
+
+// Workers never share state: task i writes only slots[i], so no locking is
+// needed until the merge, which happens after the pool has drained.
+typedef struct {
+  GPtrArray *paths;      // char*, task index -> run file
+  LiveSpiffRunStats **slots;
+} StatsJob;
+
+typedef struct {
+  LiveSpiffRunStats *rs;
+  GArray *best_segment_us; // gint64 per segment, LIVESPIFF_NO_TIME until known
+} FileScan;
+
+static void run_stats_free(gpointer data) {
+  LiveSpiffRunStats *rs = (LiveSpiffRunStats*)data;
+  if (!rs) return;
+  g_free(rs->path);
+  g_free(rs->game);
+  g_free(rs->category);
+  g_free(rs);
+}
+
+static void totals_merge(LiveSpiffStatsTotals *into, const LiveSpiffStatsTotals *from) {
+  into->attempts += from->attempts;
+  into->finished += from->finished;
+  into->play_time_us += from->play_time_us;
+  into->pbs += from->pbs;
+  into->golds += from->golds;
+  if (from->first_attempt_us && (!into->first_attempt_us || from->first_attempt_us < into->first_attempt_us)) {
+    into->first_attempt_us = from->first_attempt_us;
+  }
+  into->last_attempt_us = MAX(into->last_attempt_us, from->last_attempt_us);
+}
+
+static gboolean scan_attempt(const LiveSpiffAttempt *a, gpointer user_data) {
+  FileScan *scan = (FileScan*)user_data;
+  LiveSpiffStatsTotals *t = &scan->rs->totals;
+
+  t->attempts++;
+  if (a->started_at_us) {
+    if (!t->first_attempt_us || a->started_at_us < t->first_attempt_us) t->first_attempt_us = a->started_at_us;
+    t->last_attempt_us = MAX(t->last_attempt_us, a->started_at_us);
+  }
+
+  gint64 prev = 0;
+  gint64 last = 0;
+  for (guint i = 0; i < a->split_us->len; i++) {
+    gint64 split = g_array_index(a->split_us, gint64, i);
+    if (split == LIVESPIFF_NO_TIME) {
+      prev = LIVESPIFF_NO_TIME;
+      continue;
+    }
+    last = split;
+
+    if (prev != LIVESPIFF_NO_TIME && i < scan->best_segment_us->len) {
+      gint64 seg = split - prev;
+      gint64 *best = &g_array_index(scan->best_segment_us, gint64, i);
+      if (*best == LIVESPIFF_NO_TIME) {
+        *best = seg;
+      } else if (seg < *best) {
+        *best = seg;
+        t->golds++;
+      }
+    }
+    prev = split;
+  }
+  t->play_time_us += a->reset_us != LIVESPIFF_NO_TIME ? MAX(a->reset_us, last) : last;
+
+  if (a->finished && a->split_us->len > 0) {
+    gint64 final_us = g_array_index(a->split_us, gint64, a->split_us->len - 1);
+    t->finished++;
+    // Only runs of the current layout count as PBs, as in comparisons.c and library.c
+    gboolean full = a->split_us->len == scan->best_segment_us->len;
+    if (full && final_us != LIVESPIFF_NO_TIME && (scan->rs->pb_us == LIVESPIFF_NO_TIME || final_us < scan->rs->pb_us)) {
+      scan->rs->pb_us = final_us;
+      t->pbs++;
+    }
+  }
+  return TRUE;
+}
+
+static void stats_worker(gpointer data, gpointer user_data) {
+  StatsJob *job = (StatsJob*)user_data;
+  guint index = GPOINTER_TO_UINT(data) - 1;
+  const char *path = g_ptr_array_index(job->paths, index);
+
+  LiveSpiffRun *run = NULL;
+  if (!run_load_json(path, &run, NULL)) return; // slot stays NULL: counted as an error
+
+  LiveSpiffRunStats *rs = g_new0(LiveSpiffRunStats, 1);
+  rs->path = g_strdup(path);
+  rs->game = g_strdup(run->game ? run->game : "");
+  rs->category = g_strdup(run->category ? run->category : "");
+  rs->pb_us = LIVESPIFF_NO_TIME;
+
+  FileScan scan = { rs, g_array_sized_new(FALSE, FALSE, sizeof(gint64), run->segments->len) };
+  gint64 none = LIVESPIFF_NO_TIME;
+  for (guint i = 0; i < run->segments->len; i++) g_array_append_val(scan.best_segment_us, none);
+
+  char *hist_path = run_history_path(path);
+  history_foreach(hist_path, scan_attempt, &scan, NULL);
+  g_free(hist_path);
+
+  g_array_free(scan.best_segment_us, TRUE);
+  run_free(run);
+  job->slots[index] = rs;
+}
+
+static gint compare_paths(gconstpointer a, gconstpointer b) {
+  return g_strcmp0(*(char * const *)a, *(char * const *)b);
+}
+
+LiveSpiffStats* stats_collect(const char *dir, guint n_threads) {
+  LiveSpiffStats *stats = g_new0(LiveSpiffStats, 1);
+  stats->runs = g_ptr_array_new_with_free_func(run_stats_free);
+
+  StatsJob job = { g_ptr_array_new_with_free_func(g_free), NULL };
+  GDir *d = dir ? g_dir_open(dir, 0, NULL) : NULL;
+  if (d) {
+    const char *name;
+    while ((name = g_dir_read_name(d)) != NULL) {
+      if (g_str_has_suffix(name, ".json")) g_ptr_array_add(job.paths, g_build_filename(dir, name, NULL));
+    }
+    g_dir_close(d);
+  }
+  if (job.paths->len == 0) {
+    g_ptr_array_free(job.paths, TRUE);
+    return stats;
+  }
+  // Sorted input keeps the result order stable without sorting partials
+  g_ptr_array_sort(job.paths, compare_paths);
+  job.slots = g_new0(LiveSpiffRunStats*, job.paths->len);
+
+  if (n_threads == 0) n_threads = g_get_num_processors();
+  n_threads = MIN(n_threads, job.paths->len);
+
+  GThreadPool *pool = g_thread_pool_new(stats_worker, &job, (gint)n_threads, FALSE, NULL);
+  if (pool) {
+    for (guint i = 0; i < job.paths->len; i++) g_thread_pool_push(pool, GUINT_TO_POINTER(i + 1), NULL);
+    g_thread_pool_free(pool, FALSE, TRUE); // waits for every queued file
+  } else {
+    for (guint i = 0; i < job.paths->len; i++) stats_worker(GUINT_TO_POINTER(i + 1), &job);
+  }
+
+  for (guint i = 0; i < job.paths->len; i++) {
+    LiveSpiffRunStats *rs = job.slots[i];
+    if (!rs) {
+      stats->errors++;
+      continue;
+    }
+    stats->files++;
+    totals_merge(&stats->totals, &rs->totals);
+    g_ptr_array_add(stats->runs, rs);
+  }
+
+  g_free(job.slots);
+  g_ptr_array_free(job.paths, TRUE);
+  return stats;
+}
+
+void stats_free(LiveSpiffStats *stats) {
+  if (!stats) return;
+  g_ptr_array_free(stats->runs, TRUE);
+  g_free(stats);
+}
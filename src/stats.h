@@ -0,0 +1,34 @@
+#pragma once
+#include <glib.h>
+
+// Aggregates over one run file (partial) or the whole library (merged)
+typedef struct {
+  guint64 attempts;
+  guint64 finished;
+  gint64 play_time_us;   // per attempt: reset time, else the last split reached
+  guint pbs;             // finished attempts that set a new PB (the first finish included)
+  guint golds;           // segment times that beat an earlier best of that segment
+  gint64 first_attempt_us; // wall clock, 0 if no attempts
+  gint64 last_attempt_us;
+} LiveSpiffStatsTotals;
+
+typedef struct {
+  char *path;
+  char *game;
+  char *category;
+  gint64 pb_us;          // LIVESPIFF_NO_TIME if never finished
+  LiveSpiffStatsTotals totals;
+} LiveSpiffRunStats;
+
+typedef struct {
+  guint files;           // run files parsed successfully
+  guint errors;          // run files that could not be read
+  LiveSpiffStatsTotals totals;
+  GPtrArray *runs;       // LiveSpiffRunStats*, ordered by path
+} LiveSpiffStats;
+
+// Parses every run file in dir and its history on a GThreadPool
+// (n_threads 0 = one per core); each file yields a partial that is
+// merged once all workers are done. Blocks until finished.
+LiveSpiffStats* stats_collect(const char *dir, guint n_threads);
+void stats_free(LiveSpiffStats *stats);
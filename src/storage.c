@@ -1,4 +1,8 @@
 #include "storage.h"
+#include <glib/gstdio.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
 #include <json-glib/json-glib.h>
 
 static gboolean ensure_dir(const char *path, char **out_error) {
@@ -27,6 +31,14 @@ char* livespiff_runs_dir(void) {
   return runs;
 }
 
+void custom_comparison_free(gpointer data) {
+  LiveSpiffCustomComparison *c = (LiveSpiffCustomComparison*)data;
+  if (!c) return;
+  g_free(c->name);
+  if (c->split_us) g_array_free(c->split_us, TRUE);
+  g_free(c);
+}
+
 LiveSpiffRun* run_new_default(void) {
   LiveSpiffRun *r = g_new0(LiveSpiffRun, 1);
   r->game = g_strdup("Game");
@@ -35,6 +47,7 @@ LiveSpiffRun* run_new_default(void) {
   g_ptr_array_add(r->segments, g_strdup("Split 1"));
   g_ptr_array_add(r->segments, g_strdup("Split 2"));
   g_ptr_array_add(r->segments, g_strdup("Split 3"));
+  r->comparisons = g_ptr_array_new_with_free_func(custom_comparison_free);
   return r;
 }
 
@@ -43,9 +56,36 @@ void run_free(LiveSpiffRun *run) {
   g_free(run->game);
   g_free(run->category);
   if (run->segments) g_ptr_array_free(run->segments, TRUE);
+  if (run->comparisons) g_ptr_array_free(run->comparisons, TRUE);
+  if (run->icons) g_ptr_array_free(run->icons, TRUE);
   g_free(run);
 }
 
+/* ------------------------- split time arrays ------------------------- */
+
+// JSON stores unknown times as null
+static void add_times_array(JsonBuilder *b, const GArray *times, gint64 divisor) {
+  json_builder_begin_array(b);
+  for (guint i = 0; times && i < times->len; i++) {
+    gint64 t = g_array_index(times, gint64, i);
+    if (t == LIVESPIFF_NO_TIME) json_builder_add_null_value(b);
+    else json_builder_add_int_value(b, t / divisor);
+  }
+  json_builder_end_array(b);
+}
+
+static GArray* times_from_json_array(JsonArray *arr, gint64 multiplier) {
+  guint n = arr ? json_array_get_length(arr) : 0;
+  GArray *times = g_array_sized_new(FALSE, FALSE, sizeof(gint64), n);
+  for (guint i = 0; i < n; i++) {
+    JsonNode *node = json_array_get_element(arr, i);
+    gint64 t = LIVESPIFF_NO_TIME;
+    if (node && JSON_NODE_HOLDS_VALUE(node)) t = json_node_get_int(node) * multiplier;
+    g_array_append_val(times, t);
+  }
+  return times;
+}
+
 static JsonNode* run_to_json_node(const LiveSpiffRun *run) {
   JsonBuilder *b = json_builder_new();
 
@@ -65,6 +105,35 @@ static JsonNode* run_to_json_node(const LiveSpiffRun *run) {
   }
   json_builder_end_array(b);
 
+  // Parallel to "segments"; null where a segment has no icon
+  gboolean any_icon = FALSE;
+  for (guint i = 0; i < run->segments->len && !any_icon; i++) any_icon = run_segment_icon(run, i) != NULL;
+  if (any_icon) {
+    json_builder_set_member_name(b, "icons");
+    json_builder_begin_array(b);
+    for (guint i = 0; i < run->segments->len; i++) {
+      const char *icon = run_segment_icon(run, i);
+      if (icon) json_builder_add_string_value(b, icon);
+      else json_builder_add_null_value(b);
+    }
+    json_builder_end_array(b);
+  }
+
+  if (run->comparisons && run->comparisons->len > 0) {
+    json_builder_set_member_name(b, "comparisons");
+    json_builder_begin_array(b);
+    for (guint i = 0; i < run->comparisons->len; i++) {
+      const LiveSpiffCustomComparison *c = g_ptr_array_index(run->comparisons, i);
+      json_builder_begin_object(b);
+      json_builder_set_member_name(b, "name");
+      json_builder_add_string_value(b, c->name ? c->name : "");
+      json_builder_set_member_name(b, "splits_ms");
+      add_times_array(b, c->split_us, 1000);
+      json_builder_end_object(b);
+    }
+    json_builder_end_array(b);
+  }
+
   json_builder_end_object(b);
 
   JsonNode *root = json_builder_get_root(b);
@@ -72,6 +141,11 @@ static JsonNode* run_to_json_node(const LiveSpiffRun *run) {
   return root;
 }
 
+const char* run_segment_icon(const LiveSpiffRun *run, guint index) {
+  if (!run || !run->icons || index >= run->icons->len) return NULL;
+  return (const char*)g_ptr_array_index(run->icons, index);
+}
+
 char* run_to_json_string(const LiveSpiffRun *run) {
   JsonNode *root = run_to_json_node(run);
   JsonGenerator *gen = json_generator_new();
@@ -110,6 +184,25 @@ gboolean run_save_json(const char *path, const LiveSpiffRun *run, char **out_err
   return ok;
 }
 
+// {"name": "Chapter 1", "subsplits": ["Start", "Crossing", "Summit"]}, the
+// readable form of a section, becomes the .lss-style names the run keeps:
+// "-Start", "-Crossing", "{Chapter 1} Summit" (see split_tree.h)
+static void add_section_segments(GPtrArray *segments, JsonObject *section) {
+  const char *name = json_object_get_string_member_with_default(section, "name", "");
+  JsonArray *subs = json_object_has_member(section, "subsplits") ? json_object_get_array_member(section, "subsplits") : NULL;
+  guint n = subs ? json_array_get_length(subs) : 0;
+  if (n == 0) {
+    g_ptr_array_add(segments, g_strdup(name));
+    return;
+  }
+  for (guint i = 0; i < n; i++) {
+    const char *sub = json_array_get_string_element(subs, i);
+    if (!sub) sub = "";
+    if (i + 1 < n) g_ptr_array_add(segments, g_strconcat("-", sub, NULL));
+    else g_ptr_array_add(segments, g_strdup_printf("{%s} %s", name, sub));
+  }
+}
+
 gboolean run_load_json(const char *path, LiveSpiffRun **out_run, char **out_error) {
   if (!out_run) return FALSE;
 
@@ -136,11 +229,17 @@ gboolean run_load_json(const char *path, LiveSpiffRun **out_run, char **out_erro
   r->game = g_strdup(json_object_get_string_member_with_default(obj, "game", "Game"));
   r->category = g_strdup(json_object_get_string_member_with_default(obj, "category", "Any%"));
   r->segments = g_ptr_array_new_with_free_func(g_free);
+  r->comparisons = g_ptr_array_new_with_free_func(custom_comparison_free);
 
   if (json_object_has_member(obj, "segments")) {
     JsonArray *arr = json_object_get_array_member(obj, "segments");
     guint n = json_array_get_length(arr);
     for (guint i = 0; i < n; i++) {
+      JsonNode *el = json_array_get_element(arr, i);
+      if (JSON_NODE_HOLDS_OBJECT(el)) {
+        add_section_segments(r->segments, json_node_get_object(el));
+        continue;
+      }
       const char *s = json_array_get_string_element(arr, i);
       g_ptr_array_add(r->segments, g_strdup(s ? s : ""));
     }
@@ -151,7 +250,329 @@ gboolean run_load_json(const char *path, LiveSpiffRun **out_run, char **out_erro
     g_ptr_array_add(r->segments, g_strdup("Split 1"));
   }
 
+  if (json_object_has_member(obj, "icons")) {
+    JsonArray *arr = json_object_get_array_member(obj, "icons");
+    guint n = arr ? json_array_get_length(arr) : 0;
+    r->icons = g_ptr_array_new_with_free_func(g_free);
+    for (guint i = 0; i < r->segments->len; i++) {
+      JsonNode *el = i < n ? json_array_get_element(arr, i) : NULL;
+      const char *icon = el && JSON_NODE_HOLDS_VALUE(el) ? json_node_get_string(el) : NULL;
+      g_ptr_array_add(r->icons, icon && *icon ? g_strdup(icon) : NULL);
+    }
+  }
+
+  if (json_object_has_member(obj, "comparisons")) {
+    JsonArray *arr = json_object_get_array_member(obj, "comparisons");
+    guint n = arr ? json_array_get_length(arr) : 0;
+    for (guint i = 0; i < n; i++) {
+      JsonObject *co = json_array_get_object_element(arr, i);
+      if (!co) continue;
+      const char *name = json_object_get_string_member_with_default(co, "name", "");
+      if (!name[0]) continue;
+
+      LiveSpiffCustomComparison *c = g_new0(LiveSpiffCustomComparison, 1);
+      c->name = g_strdup(name);
+      c->split_us = times_from_json_array(
+        json_object_has_member(co, "splits_ms") ? json_object_get_array_member(co, "splits_ms") : NULL,
+        1000
+      );
+      g_ptr_array_add(r->comparisons, c);
+    }
+  }
+
   *out_run = r;
   g_object_unref(parser);
   return TRUE;
 }
+
+/* ------------------------- attempts + history log ------------------------- */
+
+static const char *timing_names[TIMING_COUNT] = { "real", "game" };
+
+const char* timing_method_to_string(TimingMethod method) {
+  return method < TIMING_COUNT ? timing_names[method] : timing_names[TIMING_REAL];
+}
+
+gboolean timing_method_from_string(const char *s, TimingMethod *out) {
+  if (!s || !*s) {
+    *out = TIMING_REAL;
+    return TRUE;
+  }
+  for (guint i = 0; i < TIMING_COUNT; i++) {
+    if (g_strcmp0(s, timing_names[i]) == 0) {
+      *out = (TimingMethod)i;
+      return TRUE;
+    }
+  }
+  return FALSE;
+}
+
+LiveSpiffAttempt* attempt_new(void) {
+  LiveSpiffAttempt *a = g_new0(LiveSpiffAttempt, 1);
+  a->split_us = g_array_new(FALSE, FALSE, sizeof(gint64));
+  a->reset_us = LIVESPIFF_NO_TIME;
+  a->reset_game_us = LIVESPIFF_NO_TIME;
+  return a;
+}
+
+void attempt_free(LiveSpiffAttempt *attempt) {
+  if (!attempt) return;
+  if (attempt->split_us) g_array_free(attempt->split_us, TRUE);
+  if (attempt->game_us) g_array_free(attempt->game_us, TRUE);
+  g_free(attempt);
+}
+
+gint64 attempt_split_us(const LiveSpiffAttempt *attempt, guint index) {
+  if (!attempt || !attempt->split_us || index >= attempt->split_us->len) return LIVESPIFF_NO_TIME;
+  return g_array_index(attempt->split_us, gint64, index);
+}
+
+gint64 attempt_time_us(const LiveSpiffAttempt *attempt, TimingMethod method, guint index) {
+  if (method != TIMING_GAME || !attempt || !attempt->game_us) return attempt_split_us(attempt, index);
+  if (index >= attempt->game_us->len) return LIVESPIFF_NO_TIME;
+  return g_array_index(attempt->game_us, gint64, index);
+}
+
+gint64 attempt_reset_time_us(const LiveSpiffAttempt *attempt, TimingMethod method) {
+  if (!attempt) return LIVESPIFF_NO_TIME;
+  return method == TIMING_GAME && attempt->game_us ? attempt->reset_game_us : attempt->reset_us;
+}
+
+char* run_history_path(const char *run_path) {
+  if (!run_path || !run_path[0]) return NULL;
+  if (g_str_has_suffix(run_path, ".json")) {
+    char *stem = g_strndup(run_path, strlen(run_path) - strlen(".json"));
+    char *path = g_strconcat(stem, ".history.jsonl", NULL);
+    g_free(stem);
+    return path;
+  }
+  return g_strconcat(run_path, ".history.jsonl", NULL);
+}
+
+// JSON array of integers (null = unknown) into times, resized to fit
+static GArray* read_times(JsonArray *arr, GArray *times) {
+  guint n = arr ? json_array_get_length(arr) : 0;
+  g_array_set_size(times, n);
+  for (guint i = 0; i < n; i++) {
+    JsonNode *node = json_array_get_element(arr, i);
+    g_array_index(times, gint64, i) = (node && JSON_NODE_HOLDS_VALUE(node)) ? json_node_get_int(node) : LIVESPIFF_NO_TIME;
+  }
+  return times;
+}
+
+gboolean history_foreach(const char *path, HistoryAttemptFunc func, gpointer user_data, char **out_error) {
+  if (!func) return FALSE;
+
+  // No log yet: nothing to visit
+  if (!path || !g_file_test(path, G_FILE_TEST_EXISTS)) return TRUE;
+
+  FILE *f = g_fopen(path, "r");
+  if (!f) {
+    if (out_error) *out_error = g_strdup_printf("Failed to read history: %s", path);
+    return FALSE;
+  }
+
+  // One attempt and one line buffer are reused for every record, so memory
+  // stays bounded by the longest line, not by the size of the log.
+  JsonParser *parser = json_parser_new();
+  GString *line = g_string_sized_new(256);
+  LiveSpiffAttempt attempt = { 0, FALSE, g_array_new(FALSE, FALSE, sizeof(gint64)), NULL,
+                               LIVESPIFF_NO_TIME, LIVESPIFF_NO_TIME };
+  GArray *game_us = g_array_new(FALSE, FALSE, sizeof(gint64));
+  char chunk[4096];
+  gboolean eof = FALSE;
+  gboolean keep_going = TRUE;
+
+  while (keep_going && !eof) {
+    g_string_truncate(line, 0);
+    for (;;) {
+      if (!fgets(chunk, sizeof(chunk), f)) { eof = TRUE; break; }
+      g_string_append(line, chunk);
+      if (line->len && line->str[line->len - 1] == '\n') break;
+    }
+    if (line->len && line->str[line->len - 1] == '\n') g_string_truncate(line, line->len - 1);
+
+    // A torn last line (crash mid-append) is skipped, not fatal
+    if (line->len == 0 || !json_parser_load_from_data(parser, line->str, (gssize)line->len, NULL)) continue;
+    JsonNode *root = json_parser_get_root(parser);
+    if (!root || !JSON_NODE_HOLDS_OBJECT(root)) continue;
+
+    JsonObject *obj = json_node_get_object(root);
+    JsonArray *arr = json_object_has_member(obj, "splits_us") ? json_object_get_array_member(obj, "splits_us") : NULL;
+    attempt.started_at_us = json_object_get_int_member_with_default(obj, "started_at", 0);
+    attempt.finished = json_object_get_boolean_member_with_default(obj, "finished", FALSE);
+    read_times(arr, attempt.split_us);
+    // Only attempts that stopped game time carry it
+    JsonArray *game = json_object_has_member(obj, "game_us") ? json_object_get_array_member(obj, "game_us") : NULL;
+    attempt.game_us = game ? read_times(game, game_us) : NULL;
+    // Resets logged before reset times were kept have none
+    attempt.reset_us = json_object_get_int_member_with_default(obj, "reset_us", LIVESPIFF_NO_TIME);
+    attempt.reset_game_us = json_object_get_int_member_with_default(obj, "reset_game_us", LIVESPIFF_NO_TIME);
+
+    keep_going = func(&attempt, user_data);
+  }
+
+  gboolean ok = !ferror(f);
+  if (!ok && out_error) *out_error = g_strdup_printf("Failed to read history: %s", path);
+
+  fclose(f);
+  g_array_free(attempt.split_us, TRUE);
+  g_array_free(game_us, TRUE);
+  g_string_free(line, TRUE);
+  g_object_unref(parser);
+  return ok;
+}
+
+static gboolean collect_attempt(const LiveSpiffAttempt *attempt, gpointer user_data) {
+  LiveSpiffAttempt *a = attempt_new();
+  a->started_at_us = attempt->started_at_us;
+  a->finished = attempt->finished;
+  a->reset_us = attempt->reset_us;
+  a->reset_game_us = attempt->reset_game_us;
+  g_array_append_vals(a->split_us, attempt->split_us->data, attempt->split_us->len);
+  if (attempt->game_us) {
+    a->game_us = g_array_sized_new(FALSE, FALSE, sizeof(gint64), attempt->game_us->len);
+    g_array_append_vals(a->game_us, attempt->game_us->data, attempt->game_us->len);
+  }
+  g_ptr_array_add((GPtrArray*)user_data, a);
+  return TRUE;
+}
+
+gboolean history_load(const char *path, GPtrArray **out_attempts, char **out_error) {
+  if (!out_attempts) return FALSE;
+
+  GPtrArray *attempts = g_ptr_array_new_with_free_func((GDestroyNotify)attempt_free);
+  if (!history_foreach(path, collect_attempt, attempts, out_error)) {
+    g_ptr_array_free(attempts, TRUE);
+    return FALSE;
+  }
+
+  *out_attempts = attempts;
+  return TRUE;
+}
+
+gboolean history_append(const char *path, const LiveSpiffAttempt *attempt, char **out_error) {
+  if (!path || !attempt) return FALSE;
+
+  char *dir = g_path_get_dirname(path);
+  if (!ensure_dir(dir, out_error)) {
+    g_free(dir);
+    return FALSE;
+  }
+  g_free(dir);
+
+  JsonBuilder *b = json_builder_new();
+  json_builder_begin_object(b);
+  json_builder_set_member_name(b, "started_at");
+  json_builder_add_int_value(b, attempt->started_at_us);
+  json_builder_set_member_name(b, "finished");
+  json_builder_add_boolean_value(b, attempt->finished);
+  json_builder_set_member_name(b, "splits_us");
+  add_times_array(b, attempt->split_us, 1);
+  if (attempt->game_us) {
+    json_builder_set_member_name(b, "game_us");
+    add_times_array(b, attempt->game_us, 1);
+  }
+  if (attempt->reset_us != LIVESPIFF_NO_TIME) {
+    json_builder_set_member_name(b, "reset_us");
+    json_builder_add_int_value(b, attempt->reset_us);
+  }
+  if (attempt->reset_game_us != LIVESPIFF_NO_TIME) {
+    json_builder_set_member_name(b, "reset_game_us");
+    json_builder_add_int_value(b, attempt->reset_game_us);
+  }
+  json_builder_end_object(b);
+
+  JsonNode *root = json_builder_get_root(b);
+  JsonGenerator *gen = json_generator_new();
+  json_generator_set_root(gen, root);
+  char *line = json_generator_to_data(gen, NULL);
+  g_object_unref(gen);
+  json_node_free(root);
+  g_object_unref(b);
+
+  gboolean ok = FALSE;
+  FILE *f = g_fopen(path, "a");
+  if (f) {
+    ok = fputs(line, f) >= 0 && fputc('\n', f) != EOF;
+    ok = (fclose(f) == 0) && ok;
+  }
+  if (!ok && out_error) *out_error = g_strdup_printf("Failed to append history: %s", path);
+
+  g_free(line);
+  return ok;
+}
+
+// "started_at" of one JSON record, G_MININT64 if it is not a record
+static gint64 record_started_at(const char *text, gsize len) {
+  JsonParser *parser = json_parser_new();
+  gint64 started = G_MININT64;
+  if (json_parser_load_from_data(parser, text, (gssize)len, NULL)) {
+    JsonNode *root = json_parser_get_root(parser);
+    if (root && JSON_NODE_HOLDS_OBJECT(root)) {
+      started = json_object_get_int_member_with_default(json_node_get_object(root), "started_at", G_MININT64);
+    }
+  }
+  g_object_unref(parser);
+  return started;
+}
+
+gboolean history_remove_last(const char *path, gint64 started_at_us, char **out_error) {
+  if (!path) return FALSE;
+  int fd = g_open(path, O_RDWR, 0);
+  if (fd < 0) {
+    if (out_error) *out_error = g_strdup_printf("Failed to open history: %s", path);
+    return FALSE;
+  }
+
+  // A log that does not end in a newline ends in a torn record: the append
+  // being undone never completed, and the line before it is another attempt
+  off_t end = lseek(fd, 0, SEEK_END);
+  char last = 0;
+  if (end <= 0 || pread(fd, &last, 1, end - 1) != 1 || last != '\n') {
+    close(fd);
+    if (out_error) *out_error = g_strdup_printf("Last attempt of %s is incomplete, history left as is", path);
+    return FALSE;
+  }
+
+  // Back from the end (past the record's own newline) to the newline before it
+  off_t pos = end - 1;
+  off_t cut = 0;
+  gboolean ok = TRUE;
+  char chunk[4096];
+  while (pos > 0) {
+    off_t from = MAX(pos - (off_t)sizeof(chunk), 0);
+    if (pread(fd, chunk, (size_t)(pos - from), from) != pos - from) {
+      ok = FALSE;
+      break;
+    }
+    off_t i = pos - from;
+    while (i > 0 && chunk[i - 1] != '\n') i--;
+    if (i > 0) {
+      cut = from + i;
+      break;
+    }
+    pos = from;
+  }
+
+  // Only the attempt that was just appended goes
+  gboolean matches = FALSE;
+  if (ok) {
+    gsize len = (gsize)(end - 1 - cut);
+    char *record = g_malloc(len + 1);
+    ok = pread(fd, record, len, cut) == (ssize_t)len;
+    matches = ok && record_started_at(record, len) == started_at_us;
+    g_free(record);
+  }
+  ok = ok && (!matches || ftruncate(fd, cut) == 0);
+  ok = (close(fd) == 0) && ok;
+  if (!ok) {
+    if (out_error) *out_error = g_strdup_printf("Failed to rewrite history: %s", path);
+    return FALSE;
+  }
+  if (!matches) {
+    if (out_error) *out_error = g_strdup_printf("Last attempt of %s is not the undone one, history left as is", path);
+    return FALSE;
+  }
+  return TRUE;
+}
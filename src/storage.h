@@ -1,12 +1,44 @@
 #pragma once
 #include <glib.h>
 
+// Sentinel for a split time that is unknown (not reached, skipped, no data)
+#define LIVESPIFF_NO_TIME G_MININT64
+
+// Which clock a time was taken on: real time (RTA) or game time, which
+// leaves out loads and other periods the game or an autosplitter excludes
+typedef enum {
+  TIMING_REAL = 0,
+  TIMING_GAME,
+  TIMING_COUNT
+} TimingMethod;
+
+const char* timing_method_to_string(TimingMethod method);             // "real", "game"
+gboolean timing_method_from_string(const char *s, TimingMethod *out); // "" = real
+
+// Imported comparison stored in the run file (e.g. "World Record")
+typedef struct {
+  char *name;
+  GArray *split_us; // gint64 cumulative split times, LIVESPIFF_NO_TIME if unknown
+} LiveSpiffCustomComparison;
+
 typedef struct {
   char *game;
   char *category;
-  GPtrArray *segments; // array of char*
+  GPtrArray *segments;    // array of char*, subsplits named as in .lss files (split_tree.h)
+  GPtrArray *comparisons; // array of LiveSpiffCustomComparison*
+  GPtrArray *icons;       // char* image path per segment (NULL = none, relative to the run file), NULL if no icons
 } LiveSpiffRun;
 
+// One attempt (finished or reset), as recorded in the history log
+typedef struct {
+  gint64 started_at_us; // wall clock (g_get_real_time) at start
+  gboolean finished;    // TRUE if the last split was reached
+  GArray *split_us;     // gint64 cumulative split times, one per reached split
+  GArray *game_us;      // game time per split like split_us; NULL if the attempt never stopped game time
+  gint64 reset_us;      // elapsed time when it was reset; LIVESPIFF_NO_TIME if finished or logged without it
+  gint64 reset_game_us; // the same on the game clock; LIVESPIFF_NO_TIME unless game_us is set
+} LiveSpiffAttempt;
+
 // Paths (XDG)
 char* livespiff_config_dir(void);   // ~/.config/livespiff
 char* livespiff_data_dir(void);     // ~/.local/share/livespiff
@@ -15,6 +47,7 @@ char* livespiff_runs_dir(void);     // ~/.local/share/livespiff/runs
 // Run lifecycle
 LiveSpiffRun* run_new_default(void);
 void run_free(LiveSpiffRun *run);
+void custom_comparison_free(gpointer data); // LiveSpiffCustomComparison*, for run->comparisons
 
 // Save / load
 gboolean run_load_json(const char *path, LiveSpiffRun **out_run, char **out_error);
@@ -22,3 +55,25 @@ gboolean run_save_json(const char *path, const LiveSpiffRun *run, char **out_err
 
 // Helpers
 char* run_to_json_string(const LiveSpiffRun *run); // caller frees
+const char* run_segment_icon(const LiveSpiffRun *run, guint index); // as written in the run file, NULL if none
+
+// Attempts
+LiveSpiffAttempt* attempt_new(void);
+void attempt_free(LiveSpiffAttempt *attempt);
+gint64 attempt_split_us(const LiveSpiffAttempt *attempt, guint index); // LIVESPIFF_NO_TIME if missing
+// Split time on method's clock; game time falls back to real time when it equals it
+gint64 attempt_time_us(const LiveSpiffAttempt *attempt, TimingMethod method, guint index);
+// Reset time on method's clock, with the same fallback; LIVESPIFF_NO_TIME if unknown
+gint64 attempt_reset_time_us(const LiveSpiffAttempt *attempt, TimingMethod method);
+
+// History log (one JSON object per line, next to the run file)
+char* run_history_path(const char *run_path); // foo.json -> foo.history.jsonl (caller frees)
+gboolean history_load(const char *path, GPtrArray **out_attempts, char **out_error);
+// Streams the log one attempt at a time; the attempt is borrowed and only
+// valid during the call. Return FALSE from func to stop early.
+typedef gboolean (*HistoryAttemptFunc)(const LiveSpiffAttempt *attempt, gpointer user_data);
+gboolean history_foreach(const char *path, HistoryAttemptFunc func, gpointer user_data, char **out_error);
+gboolean history_append(const char *path, const LiveSpiffAttempt *attempt, char **out_error);
+// Drops the last attempt of the log (an undone finish) if it is the one
+// started at started_at_us and was written whole; only the tail is read
+gboolean history_remove_last(const char *path, gint64 started_at_us, char **out_error);
@@ -22,6 +22,12 @@ void ui_settings_free_fields(LiveSpiffUiSettings *s) {
   s->picked_window_id = NULL;
   s->picked_classname = NULL;
   s->picked_window_title = NULL;
+  g_free(s->hotkey_start_split);
+  g_free(s->hotkey_pause);
+  g_free(s->hotkey_reset);
+  s->hotkey_start_split = NULL;
+  s->hotkey_pause = NULL;
+  s->hotkey_reset = NULL;
 }
 
 LiveSpiffUiSettings ui_settings_load(void) {
@@ -51,6 +57,10 @@ LiveSpiffUiSettings ui_settings_load(void) {
 
     if (g_key_file_has_key(kf, "game", "pid", NULL))
       s.picked_pid = g_key_file_get_integer(kf, "game", "pid", NULL);
+
+    s.hotkey_start_split = g_key_file_get_string(kf, "hotkeys", "start_split", NULL);
+    s.hotkey_pause = g_key_file_get_string(kf, "hotkeys", "pause", NULL);
+    s.hotkey_reset = g_key_file_get_string(kf, "hotkeys", "reset", NULL);
   }
 
   g_key_file_free(kf);
@@ -68,7 +78,9 @@ void ui_settings_save(const LiveSpiffUiSettings *s) {
   char *path = ui_settings_path();
   ensure_parent_dir(path);
 
+  // Start from the file on disk so splits/hotkeys stored by the UI survive
   GKeyFile *kf = g_key_file_new();
+  g_key_file_load_from_file(kf, path, G_KEY_FILE_KEEP_COMMENTS, NULL);
   g_key_file_set_boolean(kf, "ui", "always_on_top", s->always_on_top);
   g_key_file_set_integer(kf, "ui", "refresh_ms", s->refresh_ms);
 
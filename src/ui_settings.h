@@ -10,6 +10,12 @@ typedef struct {
   char *picked_classname;     // kdotool getwindowclassname
   char *picked_window_title;  // kdotool getwindowname
   gint picked_pid;            // kdotool getwindowpid (optional)
+
+  // Hotkey labels from the Hotkeys window ("Ctrl+Alt+S"); written by the UI
+  // directly, read by the daemon as preferred global shortcut triggers
+  char *hotkey_start_split;
+  char *hotkey_pause;
+  char *hotkey_reset;
 } LiveSpiffUiSettings;
 
 LiveSpiffUiSettings ui_settings_load(void);
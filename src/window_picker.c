@@ -0,0 +1,228 @@
+#include "window_picker.h"
+#include <string.h>
+
+#define WINDOW_CACHE_TTL_US (3 * G_USEC_PER_SEC)
+
+typedef struct {
+  WindowPickerCallback callback;
+  gpointer user_data;
+  char *resolve_class; // casefolded, NULL for a plain list request
+} Waiter;
+
+// One refresh: "kdotool search" + one detail call per window, all in flight at once
+typedef struct {
+  LiveSpiffWindowPicker *picker;
+  GCancellable *cancellable;
+  GPtrArray *windows;
+  guint pending;
+  gboolean failed;
+} Refresh;
+
+typedef struct {
+  Refresh *refresh;
+  LiveSpiffWindowInfo *info;
+} DetailCall;
+
+LiveSpiffWindowInfo* window_info_copy(const LiveSpiffWindowInfo *w) {
+  LiveSpiffWindowInfo *c = g_new0(LiveSpiffWindowInfo, 1);
+  c->window_id = g_strdup(w->window_id);
+  c->classname = g_strdup(w->classname);
+  c->title = g_strdup(w->title);
+  c->pid = w->pid;
+  return c;
+}
+
+void window_info_free(LiveSpiffWindowInfo *w) {
+  if (!w) return;
+  g_free(w->window_id);
+  g_free(w->classname);
+  g_free(w->title);
+  g_free(w);
+}
+
+static void waiter_free(gpointer data) {
+  Waiter *w = (Waiter*)data;
+  g_free(w->resolve_class);
+  g_free(w);
+}
+
+LiveSpiffWindowPicker* window_picker_new(void) {
+  LiveSpiffWindowPicker *p = g_new0(LiveSpiffWindowPicker, 1);
+  p->ttl_us = WINDOW_CACHE_TTL_US;
+  p->waiters = g_ptr_array_new_with_free_func(waiter_free);
+  p->cancellable = g_cancellable_new();
+  return p;
+}
+
+void window_picker_free(LiveSpiffWindowPicker *p) {
+  if (!p) return;
+  // In-flight callbacks see the cancellation and no longer touch p
+  g_cancellable_cancel(p->cancellable);
+  g_object_unref(p->cancellable);
+  if (p->cache) g_ptr_array_free(p->cache, TRUE);
+  g_ptr_array_free(p->waiters, TRUE);
+  g_free(p);
+}
+
+/* ------------------------- delivery ------------------------- */
+
+static void deliver(Waiter *w, GPtrArray *windows, const GError *error) {
+  if (error || !w->resolve_class) {
+    w->callback(error ? NULL : windows, error, w->user_data);
+    return;
+  }
+
+  GPtrArray *match = g_ptr_array_new();
+  for (guint i = 0; i < windows->len; i++) {
+    LiveSpiffWindowInfo *info = g_ptr_array_index(windows, i);
+    char *folded = g_utf8_casefold(info->classname ? info->classname : "", -1);
+    gboolean same = g_strcmp0(folded, w->resolve_class) == 0;
+    g_free(folded);
+    if (same) { g_ptr_array_add(match, info); break; }
+  }
+  w->callback(match, NULL, w->user_data);
+  g_ptr_array_free(match, TRUE);
+}
+
+static void refresh_finish(Refresh *r, const GError *error) {
+  LiveSpiffWindowPicker *p = r->picker;
+
+  if (!g_cancellable_is_cancelled(r->cancellable)) {
+    if (!error) {
+      if (p->cache) g_ptr_array_free(p->cache, TRUE);
+      p->cache = r->windows;
+      p->cache_time_us = g_get_monotonic_time();
+      r->windows = NULL;
+    }
+    p->refreshing = FALSE;
+
+    // Callbacks may queue new requests; deliver from a detached list
+    GPtrArray *waiters = p->waiters;
+    p->waiters = g_ptr_array_new_with_free_func(waiter_free);
+    for (guint i = 0; i < waiters->len; i++) deliver(g_ptr_array_index(waiters, i), p->cache, error);
+    g_ptr_array_free(waiters, TRUE);
+  }
+
+  if (r->windows) g_ptr_array_free(r->windows, TRUE);
+  g_object_unref(r->cancellable);
+  g_free(r);
+}
+
+/* ------------------------- kdotool calls ------------------------- */
+
+static GSubprocess* kdotool_spawn(const char * const *argv, GError **error) {
+  return g_subprocess_newv(argv, G_SUBPROCESS_FLAGS_STDOUT_PIPE | G_SUBPROCESS_FLAGS_STDERR_SILENCE, error);
+}
+
+static void on_detail_done(GObject *source, GAsyncResult *res, gpointer user_data) {
+  DetailCall *call = (DetailCall*)user_data;
+  Refresh *r = call->refresh;
+  char *out = NULL;
+
+  // Output: class, title, pid (one line each); windows that vanished are dropped
+  if (g_subprocess_communicate_utf8_finish(G_SUBPROCESS(source), res, &out, NULL, NULL) &&
+      g_subprocess_get_successful(G_SUBPROCESS(source)) && out) {
+    gchar **lines = g_strsplit(out, "\n", 4);
+    guint n = g_strv_length(lines);
+    if (n >= 2) {
+      call->info->classname = g_strdup(lines[0]);
+      call->info->title = g_strdup(lines[1]);
+      call->info->pid = (n >= 3 && lines[2][0]) ? (int)g_ascii_strtoll(lines[2], NULL, 10) : -1;
+      g_ptr_array_add(r->windows, call->info);
+      call->info = NULL;
+    }
+    g_strfreev(lines);
+  }
+
+  g_free(out);
+  window_info_free(call->info);
+  g_free(call);
+
+  if (--r->pending == 0) refresh_finish(r, NULL);
+}
+
+static void on_search_done(GObject *source, GAsyncResult *res, gpointer user_data) {
+  Refresh *r = (Refresh*)user_data;
+  char *out = NULL;
+  GError *err = NULL;
+
+  if (!g_subprocess_communicate_utf8_finish(G_SUBPROCESS(source), res, &out, NULL, &err)) {
+    refresh_finish(r, err);
+    g_error_free(err);
+    return;
+  }
+
+  gchar **ids = g_strsplit(out ? out : "", "\n", -1);
+  g_free(out);
+
+  r->pending = 1; // guard: finish only after every call was started
+  for (gchar **id = ids; *id; id++) {
+    g_strstrip(*id);
+    if (!(*id)[0]) continue;
+
+    const char *argv[] = {
+      "kdotool", "getwindowclassname", *id, "getwindowname", *id, "getwindowpid", *id, NULL
+    };
+    GSubprocess *proc = kdotool_spawn(argv, NULL);
+    if (!proc) continue;
+
+    DetailCall *call = g_new0(DetailCall, 1);
+    call->refresh = r;
+    call->info = g_new0(LiveSpiffWindowInfo, 1);
+    call->info->window_id = g_strdup(*id);
+    call->info->pid = -1;
+    r->pending++;
+    g_subprocess_communicate_utf8_async(proc, NULL, r->cancellable, on_detail_done, call);
+    g_object_unref(proc);
+  }
+  g_strfreev(ids);
+
+  if (--r->pending == 0) refresh_finish(r, NULL);
+}
+
+static void start_refresh(LiveSpiffWindowPicker *p) {
+  if (p->refreshing) return;
+
+  Refresh *r = g_new0(Refresh, 1);
+  r->picker = p;
+  r->cancellable = g_object_ref(p->cancellable);
+  r->windows = g_ptr_array_new_with_free_func((GDestroyNotify)window_info_free);
+  p->refreshing = TRUE;
+
+  const char *argv[] = { "kdotool", "search", "--class", ".", NULL };
+  GError *err = NULL;
+  GSubprocess *proc = kdotool_spawn(argv, &err);
+  if (!proc) {
+    refresh_finish(r, err); // e.g. kdotool not installed
+    g_error_free(err);
+    return;
+  }
+  g_subprocess_communicate_utf8_async(proc, NULL, r->cancellable, on_search_done, r);
+  g_object_unref(proc);
+}
+
+/* ------------------------- public API ------------------------- */
+
+static void enqueue(LiveSpiffWindowPicker *p, WindowPickerCallback callback, gpointer user_data, const char *resolve_class) {
+  Waiter *w = g_new0(Waiter, 1);
+  w->callback = callback;
+  w->user_data = user_data;
+  w->resolve_class = resolve_class ? g_utf8_casefold(resolve_class, -1) : NULL;
+  g_ptr_array_add(p->waiters, w);
+  start_refresh(p);
+}
+
+void window_picker_list_async(LiveSpiffWindowPicker *p, gboolean force_refresh,
+                              WindowPickerCallback callback, gpointer user_data) {
+  gboolean fresh = p->cache && (g_get_monotonic_time() - p->cache_time_us) < p->ttl_us;
+  if (fresh && !force_refresh) {
+    callback(p->cache, NULL, user_data);
+    return;
+  }
+  enqueue(p, callback, user_data, NULL);
+}
+
+void window_picker_resolve_async(LiveSpiffWindowPicker *p, const char *classname,
+                                 WindowPickerCallback callback, gpointer user_data) {
+  enqueue(p, callback, user_data, classname ? classname : "");
+}
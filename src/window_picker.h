@@ -0,0 +1,40 @@
+#pragma once
+#include <gio/gio.h>
+
+// One top-level window as reported by kdotool
+typedef struct {
+  char *window_id;  // KWin internal id (UUID-like)
+  char *classname;  // kdotool getwindowclassname
+  char *title;      // kdotool getwindowname
+  int pid;          // kdotool getwindowpid, -1 if unknown
+} LiveSpiffWindowInfo;
+
+LiveSpiffWindowInfo* window_info_copy(const LiveSpiffWindowInfo *w);
+void window_info_free(LiveSpiffWindowInfo *w);
+
+// windows: borrowed LiveSpiffWindowInfo*, NULL on error.
+// For resolve, windows holds at most one entry (empty: no match).
+typedef void (*WindowPickerCallback)(GPtrArray *windows, const GError *error, gpointer user_data);
+
+// kdotool-backed window enumeration that never blocks the main loop:
+// every kdotool call is an async GSubprocess, results are cached for a
+// short TTL and concurrent requests share one refresh.
+typedef struct {
+  GPtrArray *cache;       // LiveSpiffWindowInfo*, NULL until first refresh
+  gint64 cache_time_us;   // g_get_monotonic_time() of the last refresh
+  gint64 ttl_us;
+  gboolean refreshing;
+  GPtrArray *waiters;     // pending callbacks for the running refresh
+  GCancellable *cancellable;
+} LiveSpiffWindowPicker;
+
+LiveSpiffWindowPicker* window_picker_new(void);
+void window_picker_free(LiveSpiffWindowPicker *p); // cancels running kdotool calls
+
+// Cached list if fresh (callback runs immediately), otherwise refresh first
+void window_picker_list_async(LiveSpiffWindowPicker *p, gboolean force_refresh,
+                              WindowPickerCallback callback, gpointer user_data);
+
+// Find a live window for a saved class name (case-insensitive), always refreshing
+void window_picker_resolve_async(LiveSpiffWindowPicker *p, const char *classname,
+                                 WindowPickerCallback callback, gpointer user_data);
@@ -0,0 +1,454 @@
+// File: tests/test-global-shortcuts.c
+// Global shortcut registration against mock services on a private bus.
+//
+// Run under dbus-run-session with tests/data/session.conf, which has no
+// service directories, so nothing real can be activated. The mocks live in
+// this process on their own connection:
+// - org.freedesktop.portal.Desktop: GlobalShortcuts CreateSession and
+//   BindShortcuts with Request::Response, Activated on demand
+// - org.kde.kglobalaccel: doRegister, setShortcut, getComponent and
+//   globalShortcutPressed from the component
+
+#include <gio/gio.h>
+#include <string.h>
+
+#include "global_shortcuts.h"
+
+#define PORTAL_BUS_NAME "org.freedesktop.portal.Desktop"
+#define PORTAL_OBJ_PATH "/org/freedesktop/portal/desktop"
+#define PORTAL_IFACE    "org.freedesktop.portal.GlobalShortcuts"
+#define KDE_BUS_NAME    "org.kde.kglobalaccel"
+#define KDE_OBJ_PATH    "/kglobalaccel"
+#define KDE_IFACE       "org.kde.KGlobalAccel"
+#define KDE_COMPONENT   "org.kde.kglobalaccel.Component"
+#define KDE_COMPONENT_PATH "/component/livespiff"
+
+#define WAIT_US (5 * G_USEC_PER_SEC)
+
+static const gchar mock_xml[] =
+  "<node>"
+  "  <interface name='org.freedesktop.portal.GlobalShortcuts'>"
+  "    <method name='CreateSession'>"
+  "      <arg type='a{sv}' name='options' direction='in'/>"
+  "      <arg type='o' name='handle' direction='out'/>"
+  "    </method>"
+  "    <method name='BindShortcuts'>"
+  "      <arg type='o' name='session_handle' direction='in'/>"
+  "      <arg type='a(sa{sv})' name='shortcuts' direction='in'/>"
+  "      <arg type='s' name='parent_window' direction='in'/>"
+  "      <arg type='a{sv}' name='options' direction='in'/>"
+  "      <arg type='o' name='handle' direction='out'/>"
+  "    </method>"
+  "    <signal name='Activated'>"
+  "      <arg type='o' name='session_handle'/>"
+  "      <arg type='s' name='shortcut_id'/>"
+  "      <arg type='t' name='timestamp'/>"
+  "      <arg type='a{sv}' name='options'/>"
+  "    </signal>"
+  "    <property name='version' type='u' access='read'/>"
+  "  </interface>"
+  "  <interface name='org.kde.KGlobalAccel'>"
+  "    <method name='doRegister'>"
+  "      <arg type='as' name='action_id' direction='in'/>"
+  "    </method>"
+  "    <method name='setShortcut'>"
+  "      <arg type='as' name='action_id' direction='in'/>"
+  "      <arg type='ai' name='keys' direction='in'/>"
+  "      <arg type='u' name='flags' direction='in'/>"
+  "      <arg type='ai' name='keys' direction='out'/>"
+  "    </method>"
+  "    <method name='getComponent'>"
+  "      <arg type='s' name='component_unique' direction='in'/>"
+  "      <arg type='o' name='path' direction='out'/>"
+  "    </method>"
+  "  </interface>"
+  "</node>";
+
+typedef struct {
+  GDBusConnection *conn;     // the services' side
+  GDBusNodeInfo *info;
+  guint portal_reg, kde_reg;
+  gboolean fail_bind;        // BindShortcuts answers with response 2
+  char *session_path;
+  guint binds;
+  char *preferred[HOTKEY_ACTION_COUNT];
+  guint kde_registered;
+  gint32 kde_keys[HOTKEY_ACTION_COUNT];
+} MockBus;
+
+typedef struct {
+  HotkeyAction action;
+  gint64 timestamp_us;
+} Hit;
+
+/* ------------------------- helpers ------------------------- */
+
+static GDBusConnection* connect_private(void) {
+  GError *err = NULL;
+  char *address = g_dbus_address_get_for_bus_sync(G_BUS_TYPE_SESSION, NULL, &err);
+  g_assert_no_error(err);
+  GDBusConnection *conn = g_dbus_connection_new_for_address_sync(
+    address, G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT | G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION,
+    NULL, NULL, &err);
+  g_assert_no_error(err);
+  g_free(address);
+  return conn;
+}
+
+static void request_name(GDBusConnection *conn, const char *name) {
+  GError *err = NULL;
+  GVariant *ret = g_dbus_connection_call_sync(conn, "org.freedesktop.DBus", "/org/freedesktop/DBus",
+                                              "org.freedesktop.DBus", "RequestName",
+                                              g_variant_new("(su)", name, 0x4 /* DO_NOT_QUEUE */),
+                                              G_VARIANT_TYPE("(u)"), G_DBUS_CALL_FLAGS_NONE, -1, NULL, &err);
+  g_assert_no_error(err);
+  guint32 reply = 0;
+  g_variant_get(ret, "(u)", &reply);
+  g_assert_cmpuint(reply, ==, 1); // PRIMARY_OWNER
+  g_variant_unref(ret);
+}
+
+typedef gboolean (*Predicate)(gpointer data);
+
+static gboolean wait_until(Predicate done, gpointer data) {
+  gint64 until = g_get_monotonic_time() + WAIT_US;
+  while (!done(data) && g_get_monotonic_time() < until) {
+    if (!g_main_context_iteration(NULL, FALSE)) g_usleep(1000);
+  }
+  return done(data);
+}
+
+// Lets queued messages arrive, for checks that something did not happen
+static void settle(void) {
+  gint64 until = g_get_monotonic_time() + 200 * 1000;
+  while (g_get_monotonic_time() < until) {
+    if (!g_main_context_iteration(NULL, FALSE)) g_usleep(1000);
+  }
+}
+
+static void on_hit(HotkeyAction action, gint64 timestamp_us, gpointer user_data) {
+  Hit hit = { action, timestamp_us };
+  g_array_append_val((GArray*)user_data, hit);
+}
+
+static const char * const triggers[HOTKEY_ACTION_COUNT] = {
+  [HOTKEY_START_SPLIT] = "Ctrl+Alt+S",
+  [HOTKEY_PAUSE] = "Ctrl+Alt+P",
+  [HOTKEY_RESET] = "Ctrl+Alt+R",
+};
+
+/* ------------------------- mock portal ------------------------- */
+
+// Request and session paths as the portal derives them from the caller
+static char* portal_path(const char *kind, const char *sender, const char *token) {
+  char *s = g_strdup(sender + 1);
+  g_strdelimit(s, ".", '_');
+  char *path = g_strdup_printf("%s/%s/%s/%s", PORTAL_OBJ_PATH, kind, s, token);
+  g_free(s);
+  return path;
+}
+
+static void portal_respond(MockBus *m, const char *request_path, guint32 response, GVariant *results) {
+  g_dbus_connection_emit_signal(m->conn, NULL, request_path, "org.freedesktop.portal.Request", "Response",
+                                g_variant_new("(u@a{sv})", response, results), NULL);
+}
+
+static void on_portal_call(GDBusConnection *connection, const gchar *sender, const gchar *object_path,
+                           const gchar *interface_name, const gchar *method_name, GVariant *parameters,
+                           GDBusMethodInvocation *invocation, gpointer user_data) {
+  (void)connection; (void)object_path; (void)interface_name;
+  MockBus *m = (MockBus*)user_data;
+
+  if (g_strcmp0(method_name, "CreateSession") == 0) {
+    GVariant *options = NULL;
+    g_variant_get(parameters, "(@a{sv})", &options);
+    const char *token = NULL, *session_token = NULL;
+    g_assert_true(g_variant_lookup(options, "handle_token", "&s", &token));
+    g_assert_true(g_variant_lookup(options, "session_handle_token", "&s", &session_token));
+    char *request = portal_path("request", sender, token);
+    g_free(m->session_path);
+    m->session_path = portal_path("session", sender, session_token);
+    g_dbus_method_invocation_return_value(invocation, g_variant_new("(o)", request));
+
+    GVariantBuilder results;
+    g_variant_builder_init(&results, G_VARIANT_TYPE("a{sv}"));
+    g_variant_builder_add(&results, "{sv}", "session_handle", g_variant_new_string(m->session_path));
+    portal_respond(m, request, 0, g_variant_builder_end(&results));
+    g_free(request);
+    g_variant_unref(options);
+    return;
+  }
+
+  if (g_strcmp0(method_name, "BindShortcuts") == 0) {
+    const char *session = NULL, *parent = NULL;
+    GVariant *shortcuts = NULL, *options = NULL;
+    g_variant_get(parameters, "(&o@a(sa{sv})&s@a{sv})", &session, &shortcuts, &parent, &options);
+    g_assert_cmpstr(session, ==, m->session_path);
+    const char *token = NULL;
+    g_assert_true(g_variant_lookup(options, "handle_token", "&s", &token));
+    char *request = portal_path("request", sender, token);
+    g_dbus_method_invocation_return_value(invocation, g_variant_new("(o)", request));
+    m->binds++;
+
+    // Grant every preferred trigger, reported back as its description
+    GVariantBuilder granted;
+    g_variant_builder_init(&granted, G_VARIANT_TYPE("a(sa{sv})"));
+    GVariantIter it;
+    const char *id = NULL;
+    GVariant *props = NULL;
+    g_variant_iter_init(&it, shortcuts);
+    while (g_variant_iter_next(&it, "(&s@a{sv})", &id, &props)) {
+      const char *trigger = "";
+      g_variant_lookup(props, "preferred_trigger", "&s", &trigger);
+      for (guint a = HOTKEY_NONE + 1; a < HOTKEY_ACTION_COUNT; a++) {
+        if (g_strcmp0(id, hotkey_action_name((HotkeyAction)a)) != 0) continue;
+        g_free(m->preferred[a]);
+        m->preferred[a] = g_strdup(trigger);
+      }
+      GVariantBuilder out;
+      g_variant_builder_init(&out, G_VARIANT_TYPE("a{sv}"));
+      g_variant_builder_add(&out, "{sv}", "trigger_description", g_variant_new_string(trigger));
+      g_variant_builder_add(&granted, "(sa{sv})", id, &out);
+      g_variant_unref(props);
+    }
+
+    GVariantBuilder results;
+    g_variant_builder_init(&results, G_VARIANT_TYPE("a{sv}"));
+    if (m->fail_bind) {
+      g_variant_builder_clear(&granted);
+    } else {
+      g_variant_builder_add(&results, "{sv}", "shortcuts", g_variant_builder_end(&granted));
+    }
+    portal_respond(m, request, m->fail_bind ? 2 : 0, g_variant_builder_end(&results));
+    g_free(request);
+    g_variant_unref(shortcuts);
+    g_variant_unref(options);
+    return;
+  }
+
+  g_dbus_method_invocation_return_dbus_error(invocation, "org.freedesktop.DBus.Error.UnknownMethod", method_name);
+}
+
+static GVariant* on_portal_get_property(GDBusConnection *connection, const gchar *sender, const gchar *object_path,
+                                        const gchar *interface_name, const gchar *property_name,
+                                        GError **error, gpointer user_data) {
+  (void)connection; (void)sender; (void)object_path; (void)interface_name; (void)error; (void)user_data;
+  return g_strcmp0(property_name, "version") == 0 ? g_variant_new_uint32(1) : NULL;
+}
+
+static void portal_activate(MockBus *m, const char *id, guint64 timestamp_ms) {
+  g_dbus_connection_emit_signal(m->conn, NULL, PORTAL_OBJ_PATH, PORTAL_IFACE, "Activated",
+                                g_variant_new("(ost@a{sv})", m->session_path, id, timestamp_ms,
+                                              g_variant_new_array(G_VARIANT_TYPE("{sv}"), NULL, 0)),
+                                NULL);
+}
+
+/* ------------------------- mock KGlobalAccel ------------------------- */
+
+static void on_kde_call(GDBusConnection *connection, const gchar *sender, const gchar *object_path,
+                        const gchar *interface_name, const gchar *method_name, GVariant *parameters,
+                        GDBusMethodInvocation *invocation, gpointer user_data) {
+  (void)connection; (void)sender; (void)object_path; (void)interface_name;
+  MockBus *m = (MockBus*)user_data;
+
+  if (g_strcmp0(method_name, "doRegister") == 0) {
+    m->kde_registered++;
+    g_dbus_method_invocation_return_value(invocation, NULL);
+    return;
+  }
+  if (g_strcmp0(method_name, "setShortcut") == 0) {
+    const gchar **action_id = NULL;
+    GVariant *keys = NULL;
+    guint32 flags = 0;
+    g_variant_get(parameters, "(^a&s@aiu)", &action_id, &keys, &flags);
+    g_assert_cmpstr(action_id[0], ==, "livespiff");
+    for (guint a = HOTKEY_NONE + 1; a < HOTKEY_ACTION_COUNT; a++) {
+      if (g_strcmp0(action_id[1], hotkey_action_name((HotkeyAction)a)) == 0 && g_variant_n_children(keys) > 0) {
+        g_variant_get_child(keys, 0, "i", &m->kde_keys[a]);
+      }
+    }
+    g_dbus_method_invocation_return_value(invocation, g_variant_new("(@ai)", keys));
+    g_free(action_id);
+    return;
+  }
+  if (g_strcmp0(method_name, "getComponent") == 0) {
+    g_dbus_method_invocation_return_value(invocation, g_variant_new("(o)", KDE_COMPONENT_PATH));
+    return;
+  }
+  g_dbus_method_invocation_return_dbus_error(invocation, "org.freedesktop.DBus.Error.UnknownMethod", method_name);
+}
+
+static void kde_press(MockBus *m, const char *id, gint64 timestamp_ms) {
+  g_dbus_connection_emit_signal(m->conn, NULL, KDE_COMPONENT_PATH, KDE_COMPONENT, "globalShortcutPressed",
+                                g_variant_new("(ssx)", "livespiff", id, timestamp_ms), NULL);
+}
+
+/* ------------------------- fixture ------------------------- */
+
+static const GDBusInterfaceVTable portal_vtable = { on_portal_call, on_portal_get_property, NULL, { 0 } };
+static const GDBusInterfaceVTable kde_vtable = { on_kde_call, NULL, NULL, { 0 } };
+
+static MockBus* mock_new(gboolean portal, gboolean kde) {
+  MockBus *m = g_new0(MockBus, 1);
+  GError *err = NULL;
+  m->conn = connect_private();
+  m->info = g_dbus_node_info_new_for_xml(mock_xml, &err);
+  g_assert_no_error(err);
+
+  if (portal) {
+    m->portal_reg = g_dbus_connection_register_object(m->conn, PORTAL_OBJ_PATH,
+                                                      g_dbus_node_info_lookup_interface(m->info, PORTAL_IFACE),
+                                                      &portal_vtable, m, NULL, &err);
+    g_assert_no_error(err);
+    request_name(m->conn, PORTAL_BUS_NAME);
+  }
+  if (kde) {
+    m->kde_reg = g_dbus_connection_register_object(m->conn, KDE_OBJ_PATH,
+                                                   g_dbus_node_info_lookup_interface(m->info, KDE_IFACE),
+                                                   &kde_vtable, m, NULL, &err);
+    g_assert_no_error(err);
+    request_name(m->conn, KDE_BUS_NAME);
+  }
+  return m;
+}
+
+static void mock_free(MockBus *m) {
+  if (m->portal_reg) g_dbus_connection_unregister_object(m->conn, m->portal_reg);
+  if (m->kde_reg) g_dbus_connection_unregister_object(m->conn, m->kde_reg);
+  // Closing drops the names too, so the next case starts from an empty bus
+  g_dbus_connection_close_sync(m->conn, NULL, NULL);
+  g_object_unref(m->conn);
+  g_dbus_node_info_unref(m->info);
+  for (guint a = 0; a < HOTKEY_ACTION_COUNT; a++) g_free(m->preferred[a]);
+  g_free(m->session_path);
+  g_free(m);
+}
+
+static gboolean gs_settled(gpointer data) {
+  LiveSpiffGlobalShortcuts *gs = (LiveSpiffGlobalShortcuts*)data;
+  return g_strcmp0(gs->active, "none") != 0;
+}
+
+static gboolean gs_failed(gpointer data) {
+  LiveSpiffGlobalShortcuts *gs = (LiveSpiffGlobalShortcuts*)data;
+  return g_strcmp0(gs->active, "none") == 0 && gs->status && g_str_has_prefix(gs->status, "No global shortcut");
+}
+
+static gboolean has_hit(gpointer data) {
+  return ((GArray*)data)->len > 0;
+}
+
+/* ------------------------- cases ------------------------- */
+
+static void test_portal_bind_and_activate(void) {
+  MockBus *m = mock_new(TRUE, FALSE);
+  GDBusConnection *client = connect_private();
+  GArray *hits = g_array_new(FALSE, FALSE, sizeof(Hit));
+
+  LiveSpiffGlobalShortcuts *gs = global_shortcuts_new(client, SHORTCUTS_AUTO, triggers, on_hit, hits);
+  g_assert_true(wait_until(gs_settled, gs));
+  g_assert_cmpstr(gs->active, ==, "portal");
+  g_assert_cmpuint(m->binds, ==, 1);
+  g_assert_cmpstr(gs->session_handle, ==, m->session_path);
+
+  // Preferred triggers in the XDG shortcuts spec form
+  g_assert_cmpstr(m->preferred[HOTKEY_START_SPLIT], ==, "CTRL+ALT+s");
+  g_assert_cmpstr(m->preferred[HOTKEY_PAUSE], ==, "CTRL+ALT+p");
+  g_assert_cmpstr(m->preferred[HOTKEY_RESET], ==, "CTRL+ALT+r");
+  g_assert_nonnull(strstr(gs->status, "Pause / Resume: CTRL+ALT+p"));
+
+  // The compositor's monotonic timestamp is passed through
+  guint64 ts_ms = (guint64)(g_get_monotonic_time() / 1000) - 5;
+  portal_activate(m, "pause", ts_ms);
+  g_assert_true(wait_until(has_hit, hits));
+  g_assert_cmpuint(hits->len, ==, 1);
+  g_assert_cmpint(g_array_index(hits, Hit, 0).action, ==, HOTKEY_PAUSE);
+  g_assert_cmpint(g_array_index(hits, Hit, 0).timestamp_us, ==, (gint64)ts_ms * 1000);
+
+  // Unknown ids are ignored
+  portal_activate(m, "not-an-action", ts_ms);
+  settle();
+  g_assert_cmpuint(hits->len, ==, 1);
+
+  global_shortcuts_free(gs);
+  g_array_free(hits, TRUE);
+  g_object_unref(client);
+  mock_free(m);
+}
+
+static void test_kglobalaccel_fallback(void) {
+  MockBus *m = mock_new(FALSE, TRUE);
+  GDBusConnection *client = connect_private();
+  GArray *hits = g_array_new(FALSE, FALSE, sizeof(Hit));
+
+  LiveSpiffGlobalShortcuts *gs = global_shortcuts_new(client, SHORTCUTS_AUTO, triggers, on_hit, hits);
+  g_assert_true(wait_until(gs_settled, gs));
+  g_assert_cmpstr(gs->active, ==, "kglobalaccel");
+  g_assert_cmpuint(m->kde_registered, ==, HOTKEY_ACTION_COUNT - 1);
+  // Qt::CTRL | Qt::ALT | Qt::Key_R
+  g_assert_cmpint(m->kde_keys[HOTKEY_RESET], ==, 0x04000000 | 0x08000000 | 'R');
+
+  // A stale timestamp falls back to the arrival time
+  gint64 before = g_get_monotonic_time();
+  kde_press(m, "reset", 1);
+  g_assert_true(wait_until(has_hit, hits));
+  g_assert_cmpint(g_array_index(hits, Hit, 0).action, ==, HOTKEY_RESET);
+  g_assert_cmpint(g_array_index(hits, Hit, 0).timestamp_us, >=, before);
+
+  global_shortcuts_free(gs);
+  g_array_free(hits, TRUE);
+  g_object_unref(client);
+  mock_free(m);
+}
+
+// A portal that fails in BindShortcuts: KGlobalAccel takes over and the
+// half-made portal session is dropped, so it can no longer fire
+static void test_portal_failure_falls_back(void) {
+  MockBus *m = mock_new(TRUE, TRUE);
+  m->fail_bind = TRUE;
+  GDBusConnection *client = connect_private();
+  GArray *hits = g_array_new(FALSE, FALSE, sizeof(Hit));
+
+  LiveSpiffGlobalShortcuts *gs = global_shortcuts_new(client, SHORTCUTS_AUTO, triggers, on_hit, hits);
+  g_assert_true(wait_until(gs_settled, gs));
+  g_assert_cmpstr(gs->active, ==, "kglobalaccel");
+  g_assert_cmpuint(m->binds, ==, 1);
+  g_assert_null(gs->session_handle);
+  g_assert_cmpuint(gs->activated_sub, ==, 0);
+
+  portal_activate(m, "start_split", (guint64)(g_get_monotonic_time() / 1000));
+  settle();
+  g_assert_cmpuint(hits->len, ==, 0);
+
+  global_shortcuts_free(gs);
+  g_array_free(hits, TRUE);
+  g_object_unref(client);
+  mock_free(m);
+}
+
+// Neither service: reported, nothing registered
+static void test_no_service(void) {
+  MockBus *m = mock_new(FALSE, FALSE);
+  GDBusConnection *client = connect_private();
+
+  LiveSpiffGlobalShortcuts *gs = global_shortcuts_new(client, SHORTCUTS_AUTO, triggers, on_hit, NULL);
+  g_assert_true(wait_until(gs_failed, gs));
+  g_assert_null(gs->session_handle);
+
+  global_shortcuts_free(gs);
+  g_object_unref(client);
+  mock_free(m);
+}
+
+int main(int argc, char **argv) {
+  g_test_init(&argc, &argv, NULL);
+  if (!g_getenv("DBUS_SESSION_BUS_ADDRESS")) {
+    g_printerr("Run under dbus-run-session (see meson.build)\n");
+    return 77;
+  }
+  g_test_add_func("/global-shortcuts/portal/bind-and-activate", test_portal_bind_and_activate);
+  g_test_add_func("/global-shortcuts/portal/failure-falls-back", test_portal_failure_falls_back);
+  g_test_add_func("/global-shortcuts/kglobalaccel/fallback", test_kglobalaccel_fallback);
+  g_test_add_func("/global-shortcuts/none", test_no_service);
+  return g_test_run();
+}